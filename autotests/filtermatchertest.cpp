@@ -0,0 +1,202 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include <QStandardPaths>
+#include <QTest>
+
+#include "choqoktypes.h"
+#include "filter.h"
+#include "filtermatcher.h"
+
+Q_DECLARE_METATYPE(FilterMatcher::Outcomes)
+
+class FilterMatcherTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void match_data();
+    void match();
+    void overlappingPatterns();
+    void invalidRegExp();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    static FilterMatcher::Outcomes matchPost(const QList<Filter *> &filters, const QString &content,
+                                             const QString &userName = QString());
+};
+
+void FilterMatcherTest::initTestCase()
+{
+    // Filter opens a group of the configuration, keep it away from the user's one
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+FilterMatcher::Outcomes FilterMatcherTest::matchPost(const QList<Filter *> &filters, const QString &content,
+                                                     const QString &userName)
+{
+    FilterMatcher matcher;
+    matcher.compile(filters);
+    Choqok::Post post;
+    post.content = content;
+    post.author.userName = userName;
+    return matcher.match(&post);
+}
+
+void FilterMatcherTest::match_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("field");
+    QTest::addColumn<int>("type");
+    QTest::addColumn<QString>("content");
+    QTest::addColumn<QString>("userName");
+    QTest::addColumn<FilterMatcher::Outcomes>("outcomes");
+
+    const FilterMatcher::Outcomes remove(FilterMatcher::Remove);
+    const FilterMatcher::Outcomes none(FilterMatcher::NoMatch);
+
+    QTest::newRow("contain") << QStringLiteral("Choqok") << int(Filter::Content) << int(Filter::Contain)
+                             << QStringLiteral("I use choqok every day") << QString() << remove;
+    QTest::newRow("does not contain") << QStringLiteral("Choqok") << int(Filter::Content) << int(Filter::Contain)
+                                      << QStringLiteral("I use kmail every day") << QString() << none;
+    QTest::newRow("does not contain, missing") << QStringLiteral("kde") << int(Filter::Content)
+                                               << int(Filter::DoesNotContain)
+                                               << QStringLiteral("hello world") << QString() << remove;
+    QTest::newRow("does not contain, found") << QStringLiteral("kde") << int(Filter::Content)
+                                             << int(Filter::DoesNotContain)
+                                             << QStringLiteral("KDE rocks") << QString() << none;
+    QTest::newRow("exact match") << QStringLiteral("spammer") << int(Filter::AuthorUsername) << int(Filter::ExactMatch)
+                                 << QStringLiteral("buy now") << QStringLiteral("SpAmMeR") << remove;
+    QTest::newRow("exact match, longer") << QStringLiteral("spammer") << int(Filter::AuthorUsername)
+                                         << int(Filter::ExactMatch)
+                                         << QStringLiteral("buy now") << QStringLiteral("spammer2") << none;
+    QTest::newRow("other field") << QStringLiteral("spammer") << int(Filter::AuthorUsername) << int(Filter::Contain)
+                                 << QStringLiteral("spammer") << QStringLiteral("someone") << none;
+    QTest::newRow("regexp") << QStringLiteral("^RT\\b") << int(Filter::Content) << int(Filter::RegExp)
+                            << QStringLiteral("RT @someone: hello") << QString() << remove;
+    QTest::newRow("regexp, case sensitive") << QStringLiteral("^RT\\b") << int(Filter::Content) << int(Filter::RegExp)
+                                            << QStringLiteral("rt @someone: hello") << QString() << none;
+    QTest::newRow("regexp, unicode word") << QStringLiteral("^\\w+$") << int(Filter::Content) << int(Filter::RegExp)
+                                          << QString::fromUtf8("naïve") << QString() << remove;
+}
+
+void FilterMatcherTest::match()
+{
+    QFETCH(QString, text);
+    QFETCH(int, field);
+    QFETCH(int, type);
+    QFETCH(QString, content);
+    QFETCH(QString, userName);
+    QFETCH(FilterMatcher::Outcomes, outcomes);
+
+    Filter filter(text, Filter::FilterField(field), Filter::FilterType(type), Filter::Remove);
+    QCOMPARE(matchPost(QList<Filter *>() << &filter, content, userName), outcomes);
+}
+
+void FilterMatcherTest::overlappingPatterns()
+{
+    // Every pattern ends inside another one, the automaton has to follow its fail links
+    Filter he(QStringLiteral("he"), Filter::Content, Filter::Contain, Filter::Highlight);
+    Filter she(QStringLiteral("she"), Filter::Content, Filter::Contain, Filter::Remove);
+    Filter hers(QStringLiteral("hers"), Filter::Content, Filter::Contain, Filter::Remove, true);
+    Filter notHis(QStringLiteral("his"), Filter::Content, Filter::DoesNotContain, Filter::Highlight);
+    const QList<Filter *> filters = QList<Filter *>() << &he << &she << &hers << &notHis;
+
+    QCOMPARE(matchPost(filters, QStringLiteral("ushers")),
+             FilterMatcher::Highlight | FilterMatcher::Remove | FilterMatcher::RemoveUnlessRelated);
+    QCOMPARE(matchPost(filters, QStringLiteral("hers")),
+             FilterMatcher::Highlight | FilterMatcher::RemoveUnlessRelated);
+    QCOMPARE(matchPost(filters, QStringLiteral("this")), FilterMatcher::Outcomes(FilterMatcher::NoMatch));
+    QCOMPARE(matchPost(filters, QStringLiteral("abc")), FilterMatcher::Outcomes(FilterMatcher::Highlight));
+}
+
+void FilterMatcherTest::invalidRegExp()
+{
+    Filter invalid(QStringLiteral("(unclosed"), Filter::Content, Filter::RegExp);
+    Filter valid(QStringLiteral("closed"), Filter::Content, Filter::Contain);
+
+    FilterMatcher matcher;
+    matcher.compile(QList<Filter *>() << &invalid << &valid);
+    QCOMPARE(matcher.filterCount(), 1);
+}
+
+void FilterMatcherTest::benchmark_data()
+{
+    QTest::addColumn<int>("rules");
+
+    for (const int rules: {10, 100, 1000, 10000}) {
+        QTest::newRow(QByteArray::number(rules).constData()) << rules;
+    }
+}
+
+void FilterMatcherTest::benchmark()
+{
+    QFETCH(int, rules);
+
+    QList<Filter *> filters;
+    for (int i = 0; i < rules; ++i) {
+        const QString text = QStringLiteral("word%1").arg(i);
+        switch (i % 10) {
+        case 0:
+            filters << new Filter(text, Filter::AuthorUsername, Filter::ExactMatch);
+            break;
+        case 1:
+            filters << new Filter(QStringLiteral("^%1\\b").arg(text), Filter::Content, Filter::RegExp);
+            break;
+        default:
+            filters << new Filter(text, Filter::Content, Filter::Contain);
+            break;
+        }
+    }
+    FilterMatcher matcher;
+    matcher.compile(filters);
+    QCOMPARE(matcher.filterCount(), rules);
+
+    QList<Choqok::Post *> posts;
+    for (int i = 0; i < 100; ++i) {
+        Choqok::Post *post = new Choqok::Post;
+        post->content = QStringLiteral("Post number %1 about the words word%2 and choqok, with a link "
+                                       "https://kde.org/applications/ and a #hashtag").arg(i).arg(i * 7);
+        post->author.userName = QStringLiteral("user%1").arg(i);
+        posts << post;
+    }
+
+    int matched = 0;
+    QBENCHMARK {
+        for (const Choqok::Post *post: posts) {
+            if (matcher.match(post)) {
+                ++matched;
+            }
+        }
+    }
+    QVERIFY(matched > 0);
+
+    qDeleteAll(posts);
+    qDeleteAll(filters);
+}
+
+QTEST_GUILESS_MAIN(FilterMatcherTest)
+
+#include "filtermatchertest.moc"
@@ -0,0 +1,159 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include <QStringList>
+#include <QTest>
+#include <QTextDocument>
+
+#include "htmltext.h"
+
+using namespace Choqok;
+
+/**
+Statuses as Mastodon renders them, see https://docs.joinmastodon.org/spec/activitypub/#sanitization
+*/
+static QList<QPair<QByteArray, QString> > corpus()
+{
+    QList<QPair<QByteArray, QString> > statuses;
+    statuses << qMakePair(QByteArray("paragraph"), QStringLiteral("<p>Hello world</p>"))
+             << qMakePair(QByteArray("paragraphs"), QStringLiteral("<p>First paragraph</p><p>Second paragraph</p>"))
+             << qMakePair(QByteArray("line breaks"), QStringLiteral("<p>Line one<br />Line two<br>Line three</p>"))
+             << qMakePair(QByteArray("entities"), QStringLiteral("<p>Fish &amp; chips &lt;3 &gt; &quot;quoted&quot; "
+                                                                 "&#39;single&#39; &#x1F600; a&nbsp;&nbsp;b</p>"))
+             << qMakePair(QByteArray("white space"), QStringLiteral("<p>Some   text\n with \t spaces</p>\n<p>\n  and more</p>"))
+             << qMakePair(QByteArray("mention"), QStringLiteral("<p><span class=\"h-card\"><a href=\"https://mastodon.social/@Gargron\" "
+                                                                "class=\"u-url mention\">@<span>Gargron</span></a></span> hello</p>"))
+             << qMakePair(QByteArray("hashtag"), QStringLiteral("<p>Released <a href=\"https://mastodon.social/tags/kde\" "
+                                                                "class=\"mention hashtag\" rel=\"tag\">#<span>kde</span></a></p>"))
+             << qMakePair(QByteArray("link"), QStringLiteral("<p>See <a href=\"https://kde.org/applications/\" rel=\"nofollow noopener\" "
+                                                             "target=\"_blank\"><span class=\"invisible\">https://</span>"
+                                                             "<span class=\"\">kde.org/applications/</span>"
+                                                             "<span class=\"invisible\"></span></a></p>"))
+             << qMakePair(QByteArray("nested spans"), QStringLiteral("<p><strong>Bold</strong> and <em>italic "
+                                                                     "<span>nested <span>twice</span></span></em></p>"))
+             << qMakePair(QByteArray("spoiler"), QStringLiteral("Content warning<br /><p>Hidden text</p>"))
+             << qMakePair(QByteArray("no spoiler"), QStringLiteral("<br /><p>Visible text</p>"))
+             << qMakePair(QByteArray("reply"), QStringLiteral("<p><span class=\"h-card\"><a href=\"https://kde.social/@choqok\" "
+                                                              "class=\"u-url mention\">@<span>choqok</span></a></span> "
+                                                              "<span class=\"h-card\"><a href=\"https://mastodon.example/@someone\" "
+                                                              "class=\"u-url mention\">@<span>someone</span></a></span> "
+                                                              "Thanks! It works &amp; looks good.</p><p>Another paragraph "
+                                                              "with a <a href=\"https://invent.kde.org/network/choqok\">link</a>"
+                                                              "</p>"));
+    return statuses;
+}
+
+static QString documentPlainText(const QString &html)
+{
+    QTextDocument document;
+    document.setHtml(html);
+    return document.toPlainText().trimmed();
+}
+
+class HtmlTextTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void toPlainText_data();
+    void toPlainText();
+    void entities();
+    void benchmark_data();
+    void benchmark();
+};
+
+void HtmlTextTest::toPlainText_data()
+{
+    QTest::addColumn<QString>("html");
+
+    for (const QPair<QByteArray, QString> &status: corpus()) {
+        QTest::newRow(status.first.constData()) << status.second;
+    }
+}
+
+void HtmlTextTest::toPlainText()
+{
+    QFETCH(QString, html);
+
+    QCOMPARE(HtmlText::toPlainText(html), documentPlainText(html));
+}
+
+void HtmlTextTest::entities()
+{
+    const QString html = QStringLiteral("<p><span class=\"h-card\"><a href=\"https://mastodon.social/@Gargron\" "
+                                        "class=\"u-url mention\">@<span>Gargron</span></a></span> likes "
+                                        "<a href=\"https://mastodon.social/tags/kde\" class=\"mention hashtag\">#<span>kde</span></a>"
+                                        "<br />and <a href=\"https://kde.org/?a=1&amp;b=2\">kde.org</a></p>");
+    QList<Entity> entities;
+    const QString text = HtmlText::toPlainText(html, &entities);
+    QCOMPARE(text, QStringLiteral("@Gargron likes #kde\nand kde.org"));
+    QCOMPARE(entities.count(), 3);
+
+    QCOMPARE(int(entities.at(0).type), int(Entity::Mention));
+    QCOMPARE(text.mid(entities.at(0).start, entities.at(0).length), QStringLiteral("@Gargron"));
+    QCOMPARE(entities.at(0).target, QStringLiteral("https://mastodon.social/@Gargron"));
+
+    QCOMPARE(int(entities.at(1).type), int(Entity::Hashtag));
+    QCOMPARE(text.mid(entities.at(1).start, entities.at(1).length), QStringLiteral("#kde"));
+
+    QCOMPARE(int(entities.at(2).type), int(Entity::Url));
+    QCOMPARE(text.mid(entities.at(2).start, entities.at(2).length), QStringLiteral("kde.org"));
+    QCOMPARE(entities.at(2).target, QStringLiteral("https://kde.org/?a=1&b=2"));
+}
+
+void HtmlTextTest::benchmark_data()
+{
+    QTest::addColumn<bool>("document");
+
+    QTest::newRow("HtmlText") << false;
+    QTest::newRow("QTextDocument") << true;
+}
+
+void HtmlTextTest::benchmark()
+{
+    QFETCH(bool, document);
+
+    QStringList statuses;
+    for (const QPair<QByteArray, QString> &status: corpus()) {
+        statuses << status.second;
+    }
+    int length = 0;
+    if (document) {
+        QBENCHMARK {
+            for (const QString &html: statuses) {
+                length += documentPlainText(html).size();
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (const QString &html: statuses) {
+                length += HtmlText::toPlainText(html).size();
+            }
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+QTEST_MAIN(HtmlTextTest)
+
+#include "htmltexttest.moc"
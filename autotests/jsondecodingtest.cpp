@@ -0,0 +1,645 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTest>
+
+#include "choqoktypes.h"
+
+/**
+Decoding of Mastodon statuses and pump.io activities, as the backends do it, through
+QVariantMap like they used to and straight from QJsonObject like they do now.
+The HTML of the content is left as it is in both, HtmlText has its own benchmark.
+*/
+
+static std::atomic<qint64> allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+class PumpIOPost : public Choqok::Post
+{
+public:
+    QStringList to;
+    QStringList cc;
+    QStringList shares;
+    QString replies;
+};
+
+namespace
+{
+
+const QLatin1String accountKey("account");
+const QLatin1String acctKey("acct");
+const QLatin1String applicationKey("application");
+const QLatin1String avatarKey("avatar");
+const QLatin1String contentKey("content");
+const QLatin1String createdAtKey("created_at");
+const QLatin1String displayNameKey("display_name");
+const QLatin1String favouritedKey("favourited");
+const QLatin1String followersCountKey("followers_count");
+const QLatin1String idKey("id");
+const QLatin1String inReplyToAccountIdKey("in_reply_to_account_id");
+const QLatin1String inReplyToIdKey("in_reply_to_id");
+const QLatin1String nameKey("name");
+const QLatin1String noteKey("note");
+const QLatin1String reblogKey("reblog");
+const QLatin1String spoilerTextKey("spoiler_text");
+const QLatin1String urlKey("url");
+const QLatin1String usernameKey("username");
+const QLatin1String visibilityKey("visibility");
+
+void readMastodonPost(const QVariantMap &var, Choqok::Post *p)
+{
+    QVariantMap reblog = var[QLatin1String("reblog")].toMap();
+    QVariantMap status;
+    if (reblog.isEmpty()) {
+        status = var;
+    } else {
+        status = reblog;
+    }
+
+    p->content += status[QLatin1String("spoiler_text")].toString() + QLatin1String("<br />") + status[QLatin1String("content")].toString();
+
+    p->creationDateTime = QDateTime::fromString(var[QLatin1String("created_at")].toString(),
+                          Qt::ISODate);
+    p->creationDateTime.setTimeSpec(Qt::UTC);
+
+    p->link = var[QLatin1String("url")].toString();
+    p->isFavorited = var[QLatin1String("favourited")].toBool();
+    if (p->isFavorited) {
+        p->isRead = true;
+    }
+    p->postId = var[QLatin1String("id")].toString();
+
+    p->conversationId = var[QLatin1String("id")].toString();
+
+    QVariantMap application = var[QLatin1String("application")].toMap();
+    if (!application.isEmpty()) {
+        p->source = application[QLatin1String("name")].toString();
+    }
+
+    if (var[QLatin1String("visibility")].toString().compare(QLatin1String("direct")) == 0) {
+        p->isPrivate = true;
+    }
+
+    QVariantMap account = status[QLatin1Literal("account")].toMap();
+
+    p->author.userId = account[QLatin1String("acct")].toString();
+    p->author.userName = account[QLatin1String("username")].toString();
+    p->author.realName = account[QLatin1String("display_name")].toString();
+    p->author.homePageUrl = account[QLatin1String("url")].toString();
+    p->author.followersCount = account[QLatin1String("followers_count")].toUInt();
+    p->author.description = account[QLatin1String("note")].toString();
+    p->author.profileImageUrl = account[QLatin1String("avatar")].toString();
+
+    p->replyToPostId = var[QLatin1String("in_reply_to_id")].toString();
+    p->replyToUserId = var[QLatin1String("in_reply_to_account_id")].toString();
+
+    if (!reblog.isEmpty()) {
+        p->repeatedDateTime = QDateTime::fromString(var[QLatin1String("created_at")].toString(),
+                              Qt::ISODate);
+        p->repeatedDateTime.setTimeSpec(Qt::UTC);
+
+        p->repeatedPostId = var[QLatin1String("id")].toString();
+        p->repeatedFromUsername = var[QLatin1Literal("account")].toMap()[QLatin1String("acct")].toString();
+    }
+}
+
+void readMastodonUser(const QJsonObject &account, Choqok::User *user)
+{
+    user->userId = account.value(acctKey).toString();
+    user->userName = account.value(usernameKey).toString();
+    user->realName = account.value(displayNameKey).toString();
+    user->homePageUrl = account.value(urlKey).toString();
+    user->followersCount = uint(account.value(followersCountKey).toDouble());
+    user->description = account.value(noteKey).toString();
+    user->profileImageUrl = account.value(avatarKey).toString();
+}
+
+void readMastodonPost(const QJsonObject &var, Choqok::Post *p)
+{
+    const QJsonObject reblog = var.value(reblogKey).toObject();
+    const QJsonObject status = reblog.isEmpty() ? var : reblog;
+
+    p->content += status.value(spoilerTextKey).toString() + QLatin1String("<br />") + status.value(contentKey).toString();
+
+    p->creationDateTime = QDateTime::fromString(var.value(createdAtKey).toString(), Qt::ISODate);
+    p->creationDateTime.setTimeSpec(Qt::UTC);
+
+    p->link = var.value(urlKey).toString();
+    p->isFavorited = var.value(favouritedKey).toBool();
+    if (p->isFavorited) {
+        p->isRead = true;
+    }
+    p->postId = var.value(idKey).toString();
+
+    p->conversationId = p->postId;
+
+    const QJsonObject application = var.value(applicationKey).toObject();
+    if (!application.isEmpty()) {
+        p->source = application.value(nameKey).toString();
+    }
+
+    if (var.value(visibilityKey).toString() == QLatin1String("direct")) {
+        p->isPrivate = true;
+    }
+
+    readMastodonUser(status.value(accountKey).toObject(), &p->author);
+
+    p->replyToPostId = var.value(inReplyToIdKey).toString();
+    p->replyToUserId = var.value(inReplyToAccountIdKey).toString();
+
+    if (!reblog.isEmpty()) {
+        p->repeatedDateTime = p->creationDateTime;
+        p->repeatedPostId = p->postId;
+        p->repeatedFromUsername = var.value(accountKey).toObject().value(acctKey).toString();
+    }
+}
+
+void readPumpIORecipients(const QVariantList &recipients, QStringList *ids)
+{
+    for (const QVariant &element: recipients) {
+        QVariantMap elementMap = element.toMap();
+        QString elementType = elementMap.value(QLatin1String("objectType")).toString();
+        if (elementType == QLatin1String("person") || elementType == QLatin1String("collection")) {
+            const QString id = elementMap.value(QLatin1String("id")).toString();
+
+            if (id.compare(QLatin1String("acct:")) != 0) {
+                ids->append(id);
+            }
+        }
+    }
+}
+
+void readPumpIOPost(const QVariantMap &var, PumpIOPost *p)
+{
+    QVariantMap object;
+    if (var.value(QLatin1String("verb")).toString() == QLatin1String("post") ||
+            var.value(QLatin1String("verb")).toString() == QLatin1String("share")) {
+        object = var[QLatin1String("object")].toMap();
+    } else {
+        object = var;
+    }
+
+    if (!object[QLatin1String("displayName")].isNull()) {
+        p->content = object[QLatin1String("displayName")].toString();
+        p->content += QLatin1Char('\n');
+    }
+    p->content += object[QLatin1String("content")].toString();
+
+    if (!object[QLatin1String("fullImage")].isNull()) {
+        const QVariantMap fullImage = object[QLatin1String("fullImage")].toMap();
+        if (!fullImage.isEmpty()) {
+            p->media = fullImage[QLatin1String("url")].toString();
+        }
+    }
+    p->creationDateTime = QDateTime::fromString(var[QLatin1String("published")].toString(),
+                          Qt::ISODate);
+    p->creationDateTime.setTimeSpec(Qt::UTC);
+    if (object[QLatin1String("pump_io")].isNull()) {
+        p->link = object[QLatin1String("id")].toString();
+    } else {
+        p->link = object[QLatin1String("pump_io")].toMap().value(QLatin1String("proxyURL")).toString();
+    }
+    p->type = object[QLatin1String("objectType")].toString();
+    p->isFavorited = object[QLatin1String("liked")].toBool();
+    if (p->isFavorited) {
+        p->isRead = true;
+    }
+    p->postId = object[QLatin1String("id")].toString();
+    p->conversationId = var[QLatin1String("id")].toString();
+
+    QString author;
+    var[QLatin1String("author")].isNull() ? author = QLatin1String("actor") : author = QLatin1String("author");
+    QVariantMap actor;
+    if (var.value(QLatin1String("verb")).toString() == QLatin1String("share")) {
+        actor = object[QLatin1String("author")].toMap();
+        const QVariantList shares = object[QLatin1String("shares")].toMap().value(QLatin1String("items")).toList();
+        for (const QVariant &element: shares) {
+            p->shares.append(element.toMap().value(QLatin1String("id")).toString());
+        }
+    } else {
+        actor = var[author].toMap();
+    }
+    p->author.userId = actor[QLatin1String("id")].toString();
+    p->author.userName = actor[QLatin1String("preferredUsername")].toString();
+    p->author.realName = actor[QLatin1String("displayName")].toString();
+    p->author.homePageUrl = actor[QLatin1String("url")].toString();
+    p->author.location = actor[QLatin1String("location")].toMap().value(QLatin1String("displayName")).toString();
+    p->author.description = actor[QLatin1String("summary")].toString();
+    p->author.profileImageUrl = actor[QLatin1String("image")].toMap().value(QLatin1String("url")).toString();
+
+    if (!var[QLatin1String("generator")].isNull()) {
+        p->source = var[QLatin1String("generator")].toMap().value(QLatin1String("displayName")).toString();
+    }
+
+    readPumpIORecipients(var[QLatin1String("to")].toList(), &p->to);
+    readPumpIORecipients(var[QLatin1String("cc")].toList(), &p->cc);
+
+    const QVariantMap replies = object[QLatin1String("replies")].toMap();
+    if (replies.value(QLatin1String("pump_io")).isNull()) {
+        p->replies = replies[QLatin1String("url")].toString();
+    } else {
+        p->replies = replies[QLatin1String("pump_io")].toMap().value(QLatin1String("proxyURL")).toString();
+    }
+}
+
+bool isMissing(const QJsonValue &value)
+{
+    return value.isUndefined() || value.isNull();
+}
+
+void readPumpIORecipients(const QJsonArray &recipients, QStringList *ids)
+{
+    for (const QJsonValue &element: recipients) {
+        const QJsonObject recipient = element.toObject();
+        const QString type = recipient.value(QLatin1String("objectType")).toString();
+        if (type == QLatin1String("person") || type == QLatin1String("collection")) {
+            const QString id = recipient.value(QLatin1String("id")).toString();
+
+            if (id.compare(QLatin1String("acct:")) != 0) {
+                ids->append(id);
+            }
+        }
+    }
+}
+
+void readPumpIOPost(const QJsonObject &var, PumpIOPost *p)
+{
+    const QString verb = var.value(QLatin1String("verb")).toString();
+    QJsonObject object;
+    if (verb == QLatin1String("post") || verb == QLatin1String("share")) {
+        object = var.value(QLatin1String("object")).toObject();
+    } else {
+        object = var;
+    }
+
+    const QJsonValue displayName = object.value(QLatin1String("displayName"));
+    if (!isMissing(displayName)) {
+        p->content = displayName.toString();
+        p->content += QLatin1Char('\n');
+    }
+    p->content += object.value(QLatin1String("content")).toString();
+
+    const QJsonObject fullImage = object.value(QLatin1String("fullImage")).toObject();
+    if (!fullImage.isEmpty()) {
+        p->media = fullImage.value(QLatin1String("url")).toString();
+    }
+    p->creationDateTime = QDateTime::fromString(var.value(QLatin1String("published")).toString(),
+                          Qt::ISODate);
+    p->creationDateTime.setTimeSpec(Qt::UTC);
+    const QJsonValue pumpIo = object.value(QLatin1String("pump_io"));
+    if (isMissing(pumpIo)) {
+        p->link = object.value(QLatin1String("id")).toString();
+    } else {
+        p->link = pumpIo.toObject().value(QLatin1String("proxyURL")).toString();
+    }
+    p->type = object.value(QLatin1String("objectType")).toString();
+    p->isFavorited = object.value(QLatin1String("liked")).toBool();
+    if (p->isFavorited) {
+        p->isRead = true;
+    }
+    p->postId = object.value(QLatin1String("id")).toString();
+    p->conversationId = var.value(QLatin1String("id")).toString();
+
+    QJsonObject actor;
+    if (verb == QLatin1String("share")) {
+        actor = object.value(QLatin1String("author")).toObject();
+        const QJsonArray shares = object.value(QLatin1String("shares")).toObject().value(QLatin1String("items")).toArray();
+        for (const QJsonValue &element: shares) {
+            p->shares.append(element.toObject().value(QLatin1String("id")).toString());
+        }
+    } else {
+        const QJsonValue author = var.value(QLatin1String("author"));
+        actor = isMissing(author) ? var.value(QLatin1String("actor")).toObject() : author.toObject();
+    }
+    p->author.userId = actor.value(QLatin1String("id")).toString();
+    p->author.userName = actor.value(QLatin1String("preferredUsername")).toString();
+    p->author.realName = actor.value(QLatin1String("displayName")).toString();
+    p->author.homePageUrl = actor.value(QLatin1String("url")).toString();
+    p->author.location = actor.value(QLatin1String("location")).toObject().value(QLatin1String("displayName")).toString();
+    p->author.description = actor.value(QLatin1String("summary")).toString();
+    p->author.profileImageUrl = actor.value(QLatin1String("image")).toObject().value(QLatin1String("url")).toString();
+
+    const QJsonValue generator = var.value(QLatin1String("generator"));
+    if (!isMissing(generator)) {
+        p->source = generator.toObject().value(QLatin1String("displayName")).toString();
+    }
+
+    readPumpIORecipients(var.value(QLatin1String("to")).toArray(), &p->to);
+    readPumpIORecipients(var.value(QLatin1String("cc")).toArray(), &p->cc);
+
+    const QJsonObject replies = object.value(QLatin1String("replies")).toObject();
+    const QJsonValue repliesPumpIo = replies.value(QLatin1String("pump_io"));
+    if (isMissing(repliesPumpIo)) {
+        p->replies = replies.value(QLatin1String("url")).toString();
+    } else {
+        p->replies = repliesPumpIo.toObject().value(QLatin1String("proxyURL")).toString();
+    }
+}
+
+/// A home timeline reply of Mastodon, every fourth status is a reblog
+QByteArray mastodonTimeline(int count)
+{
+    QJsonArray statuses;
+    for (int i = 0; i < count; ++i) {
+        const QString id = QString::number(100000 + i);
+        QJsonObject account;
+        account.insert(idKey, QString::number(i % 7));
+        account.insert(usernameKey, QStringLiteral("user%1").arg(i % 7));
+        account.insert(acctKey, QStringLiteral("user%1@mastodon.example").arg(i % 7));
+        account.insert(displayNameKey, QStringLiteral("User %1").arg(i % 7));
+        account.insert(noteKey, QStringLiteral("<p>Writes about KDE and Qt</p>"));
+        account.insert(urlKey, QStringLiteral("https://mastodon.example/@user%1").arg(i % 7));
+        account.insert(avatarKey, QStringLiteral("https://mastodon.example/avatars/%1.png").arg(i % 7));
+        account.insert(followersCountKey, 42 * i);
+
+        QJsonObject status;
+        status.insert(idKey, id);
+        status.insert(createdAtKey, QStringLiteral("2026-10-17T12:%1:00.000Z").arg(i % 60, 2, 10, QLatin1Char('0')));
+        status.insert(inReplyToIdKey, QJsonValue());
+        status.insert(inReplyToAccountIdKey, QJsonValue());
+        status.insert(visibilityKey, QStringLiteral("public"));
+        status.insert(spoilerTextKey, QString());
+        status.insert(urlKey, QStringLiteral("https://mastodon.example/@user%1/%2").arg(i % 7).arg(id));
+        status.insert(favouritedKey, i % 5 == 0);
+        status.insert(contentKey, QStringLiteral("<p>Status %1 with a <a href=\"https://kde.org/\">link</a> and "
+                                                 "<a href=\"https://mastodon.example/tags/kde\" class=\"mention hashtag\">"
+                                                 "#<span>kde</span></a></p>").arg(i));
+        QJsonObject application;
+        application.insert(nameKey, QStringLiteral("Choqok"));
+        application.insert(QStringLiteral("website"), QStringLiteral("https://choqok.kde.org"));
+        status.insert(applicationKey, application);
+        status.insert(accountKey, account);
+        status.insert(QStringLiteral("media_attachments"), QJsonArray());
+        status.insert(QStringLiteral("mentions"), QJsonArray());
+        status.insert(QStringLiteral("tags"), QJsonArray());
+
+        if (i % 4 == 3) {
+            QJsonObject reblog = status;
+            reblog.insert(idKey, QString::number(900000 + i));
+            status.insert(reblogKey, reblog);
+        } else {
+            status.insert(reblogKey, QJsonValue());
+        }
+        statuses.append(status);
+    }
+    return QJsonDocument(statuses).toJson(QJsonDocument::Compact);
+}
+
+QJsonObject pumpIOPerson(int i)
+{
+    QJsonObject image;
+    image.insert(QStringLiteral("url"), QStringLiteral("https://pump.example/uploads/user%1/avatar.png").arg(i));
+    QJsonObject location;
+    location.insert(QStringLiteral("displayName"), QStringLiteral("Somewhere"));
+    QJsonObject person;
+    person.insert(QStringLiteral("id"), QStringLiteral("acct:user%1@pump.example").arg(i));
+    person.insert(QStringLiteral("objectType"), QStringLiteral("person"));
+    person.insert(QStringLiteral("preferredUsername"), QStringLiteral("user%1").arg(i));
+    person.insert(QStringLiteral("displayName"), QStringLiteral("User %1").arg(i));
+    person.insert(QStringLiteral("url"), QStringLiteral("https://pump.example/user%1").arg(i));
+    person.insert(QStringLiteral("summary"), QStringLiteral("Writes about KDE and Qt"));
+    person.insert(QStringLiteral("image"), image);
+    person.insert(QStringLiteral("location"), location);
+    return person;
+}
+
+/// An inbox reply of pump.io, every fourth activity is a share
+QByteArray pumpIOTimeline(int count)
+{
+    QJsonArray items;
+    for (int i = 0; i < count; ++i) {
+        const bool share = i % 4 == 3;
+        QJsonObject replies;
+        replies.insert(QStringLiteral("url"), QStringLiteral("https://pump.example/api/note/%1/replies").arg(i));
+        QJsonObject object;
+        object.insert(QStringLiteral("id"), QStringLiteral("https://pump.example/api/note/%1").arg(i));
+        object.insert(QStringLiteral("objectType"), QStringLiteral("note"));
+        object.insert(QStringLiteral("content"), QStringLiteral("Note %1 with a <a href=\"https://kde.org/\">link</a>").arg(i));
+        object.insert(QStringLiteral("liked"), i % 5 == 0);
+        object.insert(QStringLiteral("replies"), replies);
+        if (share) {
+            object.insert(QStringLiteral("author"), pumpIOPerson(i % 7 + 1));
+            QJsonObject shares;
+            shares.insert(QStringLiteral("items"), QJsonArray() << pumpIOPerson(i % 3));
+            object.insert(QStringLiteral("shares"), shares);
+        }
+
+        QJsonObject publicCollection;
+        publicCollection.insert(QStringLiteral("id"), QStringLiteral("http://activityschema.org/collection/public"));
+        publicCollection.insert(QStringLiteral("objectType"), QStringLiteral("collection"));
+        QJsonObject generator;
+        generator.insert(QStringLiteral("displayName"), QStringLiteral("Choqok"));
+
+        QJsonObject activity;
+        activity.insert(QStringLiteral("id"), QStringLiteral("https://pump.example/api/activity/%1").arg(i));
+        activity.insert(QStringLiteral("verb"), share ? QStringLiteral("share") : QStringLiteral("post"));
+        activity.insert(QStringLiteral("published"), QStringLiteral("2026-10-17T12:%1:00Z").arg(i % 60, 2, 10, QLatin1Char('0')));
+        activity.insert(QStringLiteral("actor"), pumpIOPerson(i % 7));
+        activity.insert(QStringLiteral("object"), object);
+        activity.insert(QStringLiteral("generator"), generator);
+        activity.insert(QStringLiteral("to"), QJsonArray() << publicCollection);
+        activity.insert(QStringLiteral("cc"), QJsonArray() << pumpIOPerson(i % 5));
+        items.append(activity);
+    }
+    QJsonObject timeline;
+    timeline.insert(QStringLiteral("items"), items);
+    return QJsonDocument(timeline).toJson(QJsonDocument::Compact);
+}
+
+enum Backend { Mastodon, PumpIO };
+
+/// Decode @p buffer the way the backend used to, or does now with @p json
+QList<Choqok::Post *> readTimeline(Backend backend, bool json, const QByteArray &buffer)
+{
+    QList<Choqok::Post *> posts;
+    const QJsonDocument document = QJsonDocument::fromJson(buffer);
+    if (backend == Mastodon) {
+        if (json) {
+            for (const QJsonValue &element: document.array()) {
+                Choqok::Post *post = new Choqok::Post;
+                readMastodonPost(element.toObject(), post);
+                posts.prepend(post);
+            }
+        } else {
+            for (const QVariant &element: document.array().toVariantList()) {
+                Choqok::Post *post = new Choqok::Post;
+                readMastodonPost(element.toMap(), post);
+                posts.prepend(post);
+            }
+        }
+    } else {
+        if (json) {
+            for (const QJsonValue &element: document.object().value(QLatin1String("items")).toArray()) {
+                PumpIOPost *post = new PumpIOPost;
+                readPumpIOPost(element.toObject(), post);
+                posts.prepend(post);
+            }
+        } else {
+            for (const QVariant &element: document.toVariant().toMap().value(QLatin1String("items")).toList()) {
+                PumpIOPost *post = new PumpIOPost;
+                readPumpIOPost(element.toMap(), post);
+                posts.prepend(post);
+            }
+        }
+    }
+    return posts;
+}
+
+const int postCount = 40;
+
+}
+
+class JsonDecodingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void sameResult_data();
+    void sameResult();
+    void allocations_data();
+    void allocations();
+    void benchmark_data();
+    void benchmark();
+};
+
+static void addRows()
+{
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<QByteArray>("buffer");
+
+    QTest::newRow("mastodon") << int(Mastodon) << mastodonTimeline(postCount);
+    QTest::newRow("pump.io") << int(PumpIO) << pumpIOTimeline(postCount);
+}
+
+void JsonDecodingTest::sameResult_data()
+{
+    addRows();
+}
+
+void JsonDecodingTest::sameResult()
+{
+    QFETCH(int, backend);
+    QFETCH(QByteArray, buffer);
+
+    const QList<Choqok::Post *> variantPosts = readTimeline(Backend(backend), false, buffer);
+    const QList<Choqok::Post *> jsonPosts = readTimeline(Backend(backend), true, buffer);
+    QCOMPARE(jsonPosts.count(), postCount);
+    QCOMPARE(variantPosts.count(), postCount);
+    for (int i = 0; i < postCount; ++i) {
+        const Choqok::Post *variant = variantPosts.at(i);
+        const Choqok::Post *json = jsonPosts.at(i);
+        QCOMPARE(json->postId, variant->postId);
+        QCOMPARE(json->content, variant->content);
+        QCOMPARE(json->creationDateTime, variant->creationDateTime);
+        QCOMPARE(json->link, variant->link);
+        QCOMPARE(json->source, variant->source);
+        QCOMPARE(json->isFavorited, variant->isFavorited);
+        QCOMPARE(json->author.userId, variant->author.userId);
+        QCOMPARE(json->author.followersCount, variant->author.followersCount);
+        QCOMPARE(json->author.profileImageUrl, variant->author.profileImageUrl);
+        QCOMPARE(json->repeatedFromUsername, variant->repeatedFromUsername);
+        if (backend == PumpIO) {
+            QCOMPARE(static_cast<const PumpIOPost *>(json)->to, static_cast<const PumpIOPost *>(variant)->to);
+            QCOMPARE(static_cast<const PumpIOPost *>(json)->cc, static_cast<const PumpIOPost *>(variant)->cc);
+            QCOMPARE(static_cast<const PumpIOPost *>(json)->shares, static_cast<const PumpIOPost *>(variant)->shares);
+            QCOMPARE(static_cast<const PumpIOPost *>(json)->replies, static_cast<const PumpIOPost *>(variant)->replies);
+        }
+    }
+    qDeleteAll(variantPosts);
+    qDeleteAll(jsonPosts);
+}
+
+void JsonDecodingTest::allocations_data()
+{
+    addRows();
+}
+
+void JsonDecodingTest::allocations()
+{
+    QFETCH(int, backend);
+    QFETCH(QByteArray, buffer);
+
+    qint64 perPost[2];
+    for (const bool json: {false, true}) {
+        const qint64 before = allocationCount;
+        const QList<Choqok::Post *> posts = readTimeline(Backend(backend), json, buffer);
+        perPost[json] = (allocationCount - before) / posts.count();
+        qDeleteAll(posts);
+    }
+    qDebug() << "Allocations per post, QVariantMap:" << perPost[false] << "QJsonObject:" << perPost[true];
+    QVERIFY(perPost[true] < perPost[false]);
+}
+
+void JsonDecodingTest::benchmark_data()
+{
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<bool>("json");
+    QTest::addColumn<QByteArray>("buffer");
+
+    QTest::newRow("mastodon, QVariantMap") << int(Mastodon) << false << mastodonTimeline(postCount);
+    QTest::newRow("mastodon, QJsonObject") << int(Mastodon) << true << mastodonTimeline(postCount);
+    QTest::newRow("pump.io, QVariantMap") << int(PumpIO) << false << pumpIOTimeline(postCount);
+    QTest::newRow("pump.io, QJsonObject") << int(PumpIO) << true << pumpIOTimeline(postCount);
+}
+
+void JsonDecodingTest::benchmark()
+{
+    QFETCH(int, backend);
+    QFETCH(bool, json);
+    QFETCH(QByteArray, buffer);
+
+    QBENCHMARK {
+        qDeleteAll(readTimeline(Backend(backend), json, buffer));
+    }
+}
+
+QTEST_GUILESS_MAIN(JsonDecodingTest)
+
+#include "jsondecodingtest.moc"
@@ -0,0 +1,193 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include <QHash>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+
+#include "mastodonstream.h"
+
+/**
+Accepts the connections of a stream and collects their request headers
+*/
+class EventServer : public QObject
+{
+    Q_OBJECT
+public:
+    EventServer()
+    {
+        connect(&server, SIGNAL(newConnection()), this, SLOT(slotNewConnection()));
+    }
+
+    bool listen()
+    {
+        return server.listen(QHostAddress::LocalHost);
+    }
+
+    QUrl url() const
+    {
+        return QUrl(QStringLiteral("http://127.0.0.1:%1/api/v1/streaming/user").arg(server.serverPort()));
+    }
+
+    QList<QTcpSocket *> connections;    // with a complete request
+    QList<QByteArray> requests;
+
+private Q_SLOTS:
+    void slotNewConnection()
+    {
+        while (QTcpSocket *socket = server.nextPendingConnection()) {
+            connect(socket, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+        }
+    }
+
+    void slotReadyRead()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+        QByteArray &buffer = buffers[socket];
+        buffer += socket->readAll();
+        if (!connections.contains(socket) && buffer.contains("\r\n\r\n")) {
+            connections << socket;
+            requests << buffer;
+        }
+    }
+
+private:
+    QTcpServer server;
+    QHash<QTcpSocket *, QByteArray> buffers;
+};
+
+static const QByteArray acceptedReply("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n\r\n");
+
+class MastodonStreamTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void events();
+    void reconnect();
+    void refused();
+};
+
+void MastodonStreamTest::events()
+{
+    EventServer server;
+    QVERIFY(server.listen());
+    MastodonStream stream;
+    stream.setUrl(server.url());
+    stream.setAccessToken(QStringLiteral("secret"));
+    QSignalSpy connectedSpy(&stream, SIGNAL(connected()));
+    QSignalSpy eventSpy(&stream, SIGNAL(eventReceived(QString,QByteArray)));
+
+    stream.start();
+    QTRY_COMPARE(server.requests.count(), 1);
+    QVERIFY(server.requests.at(0).startsWith("GET /api/v1/streaming/user HTTP/1.1\r\n"));
+    QVERIFY(server.requests.at(0).contains("Authorization: Bearer secret\r\n"));
+    QVERIFY(server.requests.at(0).contains("Accept: text/event-stream\r\n"));
+
+    QTcpSocket *socket = server.connections.at(0);
+    socket->write(acceptedReply);
+    QTRY_COMPARE(connectedSpy.count(), 1);
+    QVERIFY(stream.isConnected());
+
+    // The heartbeat is a comment, not an event
+    socket->write(":thump\n\n");
+    socket->write("event: update\ndata: {\"id\":\"1\",\n");
+    socket->write("data: \"content\":\"<p>Hello</p>\"}\n\n");
+    // Line ends of the server may be CRLF, and events are split across reads
+    socket->write("event: delete\r\ndata: 1\r\n\r");
+    socket->flush();
+    QTest::qWait(50);
+    socket->write("\nevent: notification\ndata: {}\n\n");
+    socket->write(":thump\n\n");
+
+    QTRY_COMPARE(eventSpy.count(), 3);
+    QCOMPARE(eventSpy.at(0).at(0).toString(), QStringLiteral("update"));
+    QCOMPARE(eventSpy.at(0).at(1).toByteArray(), QByteArray("{\"id\":\"1\",\n\"content\":\"<p>Hello</p>\"}"));
+    QCOMPARE(eventSpy.at(1).at(0).toString(), QStringLiteral("delete"));
+    QCOMPARE(eventSpy.at(1).at(1).toByteArray(), QByteArray("1"));
+    QCOMPARE(eventSpy.at(2).at(0).toString(), QStringLiteral("notification"));
+    QCOMPARE(eventSpy.at(2).at(1).toByteArray(), QByteArray("{}"));
+
+    stream.stop();
+    QVERIFY(!stream.isConnected());
+}
+
+void MastodonStreamTest::reconnect()
+{
+    EventServer server;
+    QVERIFY(server.listen());
+    MastodonStream stream;
+    stream.setUrl(server.url());
+    QSignalSpy connectedSpy(&stream, SIGNAL(connected()));
+    QSignalSpy disconnectedSpy(&stream, SIGNAL(disconnected()));
+    QSignalSpy eventSpy(&stream, SIGNAL(eventReceived(QString,QByteArray)));
+
+    stream.start();
+    QTRY_COMPARE(server.requests.count(), 1);
+    server.connections.at(0)->write(acceptedReply);
+    server.connections.at(0)->write("event: delete\ndata: 1\n\n");
+    QTRY_COMPARE(eventSpy.count(), 1);
+
+    // The server goes away, the stream comes back after a second
+    server.connections.at(0)->disconnectFromHost();
+    QTRY_COMPARE(disconnectedSpy.count(), 1);
+    QVERIFY(!stream.isConnected());
+
+    QTRY_COMPARE(server.requests.count(), 2);
+    server.connections.at(1)->write(acceptedReply);
+    QTRY_COMPARE(connectedSpy.count(), 2);
+    server.connections.at(1)->write("event: delete\ndata: 2\n\n");
+    QTRY_COMPARE(eventSpy.count(), 2);
+    QCOMPARE(eventSpy.at(1).at(1).toByteArray(), QByteArray("2"));
+
+    stream.stop();
+    QCOMPARE(disconnectedSpy.count(), 2);
+}
+
+void MastodonStreamTest::refused()
+{
+    EventServer server;
+    QVERIFY(server.listen());
+    MastodonStream stream;
+    stream.setUrl(server.url());
+    QSignalSpy connectedSpy(&stream, SIGNAL(connected()));
+    QSignalSpy eventSpy(&stream, SIGNAL(eventReceived(QString,QByteArray)));
+
+    stream.start();
+    QTRY_COMPARE(server.requests.count(), 1);
+    server.connections.at(0)->write("HTTP/1.1 401 Unauthorized\r\nContent-Type: text/event-stream\r\n"
+                                    "Content-Length: 23\r\n\r\nevent: delete\ndata: 1\n\n");
+
+    // The refused stream is retried, its body is not taken for events
+    QTRY_COMPARE(server.requests.count(), 2);
+    QCOMPARE(connectedSpy.count(), 0);
+    QCOMPARE(eventSpy.count(), 0);
+
+    stream.stop();
+}
+
+QTEST_GUILESS_MAIN(MastodonStreamTest)
+
+#include "mastodonstreamtest.moc"
@@ -0,0 +1,182 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTest>
+
+#include "accountmanager.h"
+#include "choqoktypes.h"
+#include "postbackupstore.h"
+
+using namespace Choqok;
+
+static const QString alias(QStringLiteral("test"));
+static const QString timeline(QStringLiteral("Home"));
+
+class PostBackupStoreTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void saveAndLoad();
+    void appendOnlyChanges();
+    void compaction();
+
+private:
+    static QString fileName();
+    static Post *createPost(int id, const QString &content);
+    static QList<Post *> reload();
+};
+
+void PostBackupStoreTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void PostBackupStoreTest::init()
+{
+    PostBackupStore::removeStore(alias, timeline);
+}
+
+void PostBackupStoreTest::cleanupTestCase()
+{
+    PostBackupStore::removeStore(alias, timeline);
+}
+
+QString PostBackupStoreTest::fileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation) + QLatin1Char('/') +
+           AccountManager::generatePostBackupFileName(alias, timeline) + QLatin1String(".bin");
+}
+
+Post *PostBackupStoreTest::createPost(int id, const QString &content)
+{
+    Post *post = new Post;
+    post->postId = QString::number(id);
+    post->content = content;
+    post->creationDateTime = QDateTime(QDate(2026, 10, 17), QTime(12, 0), Qt::UTC).addSecs(id);
+    post->author.userName = QStringLiteral("user%1").arg(id % 3);
+    return post;
+}
+
+/// Load the posts with a new store, which only knows what is in the file
+QList<Post *> PostBackupStoreTest::reload()
+{
+    delete PostBackupStore::store(alias, timeline);
+    return PostBackupStore::store(alias, timeline)->load();
+}
+
+void PostBackupStoreTest::saveAndLoad()
+{
+    QList<Post *> posts;
+    posts << createPost(3, QStringLiteral("third")) << createPost(1, QStringLiteral("first"))
+          << createPost(2, QStringLiteral("second"));
+    PostBackupStore::store(alias, timeline)->save(posts);
+    qDeleteAll(posts);
+
+    QList<Post *> loaded = reload();
+    QCOMPARE(loaded.count(), 3);
+    // Oldest first
+    QCOMPARE(loaded.at(0)->content, QStringLiteral("first"));
+    QCOMPARE(loaded.at(1)->content, QStringLiteral("second"));
+    QCOMPARE(loaded.at(2)->content, QStringLiteral("third"));
+    QCOMPARE(loaded.at(2)->postId, QStringLiteral("3"));
+    QCOMPARE(loaded.at(2)->author.userName, QStringLiteral("user0"));
+    qDeleteAll(loaded);
+}
+
+void PostBackupStoreTest::appendOnlyChanges()
+{
+    PostBackupStore *store = PostBackupStore::store(alias, timeline);
+    QList<Post *> posts;
+    posts << createPost(1, QStringLiteral("first")) << createPost(2, QStringLiteral("second"));
+    store->save(posts);
+    const qint64 size = QFileInfo(fileName()).size();
+
+    // Nothing changed, nothing is written
+    store->save(posts);
+    QCOMPARE(QFileInfo(fileName()).size(), size);
+    qDeleteAll(reload());
+    PostBackupStore::store(alias, timeline)->save(posts);
+    QCOMPARE(QFileInfo(fileName()).size(), size);
+
+    // One post changed, one left the timeline and one is new
+    posts.at(0)->content = QStringLiteral("edited");
+    delete posts.takeAt(1);
+    posts << createPost(4, QStringLiteral("fourth"));
+    PostBackupStore::store(alias, timeline)->save(posts);
+    qDeleteAll(posts);
+
+    QList<Post *> loaded = reload();
+    QCOMPARE(loaded.count(), 2);
+    QCOMPARE(loaded.at(0)->content, QStringLiteral("edited"));
+    QCOMPARE(loaded.at(1)->content, QStringLiteral("fourth"));
+    qDeleteAll(loaded);
+}
+
+void PostBackupStoreTest::compaction()
+{
+    PostBackupStore *store = PostBackupStore::store(alias, timeline);
+    QList<Post *> posts;
+    for (int i = 0; i < 10; ++i) {
+        posts << createPost(i, QStringLiteral("post %1").arg(i));
+    }
+    store->save(posts);
+
+    // Superseded records pile up until the log is compacted in the background,
+    // a compaction is dropped if posts were saved before it was done
+    bool compacted = false;
+    for (int i = 0; i < 1000 && !compacted; ++i) {
+        const qint64 size = QFileInfo(fileName()).size();
+        posts.at(i % 10)->content = QStringLiteral("edit %1").arg(i);
+        store->save(posts);
+        QTest::qWait(20);
+        compacted = QFileInfo(fileName()).size() < size;
+    }
+    QVERIFY(compacted);
+
+    // The store knows where the posts are in the compacted log
+    posts.at(0)->content = QStringLiteral("after compaction");
+    store->save(posts);
+    QStringList contents;
+    for (const Post *post: posts) {
+        contents << post->content;
+    }
+    qDeleteAll(posts);
+
+    QList<Post *> loaded = reload();
+    QCOMPARE(loaded.count(), 10);
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(loaded.at(i)->content, contents.at(i));
+    }
+    qDeleteAll(loaded);
+}
+
+QTEST_MAIN(PostBackupStoreTest)
+
+#include "postbackupstoretest.moc"
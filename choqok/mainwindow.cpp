@@ -56,6 +56,7 @@
 #include "postwidget.h"
 #include "quickpost.h"
 #include "systrayicon.h"
+#include "updatescheduler.h"
 #include "uploadmediadialog.h"
 
 const char *mainButtonStyleSheet = "QPushButton{\
@@ -81,7 +82,6 @@ MainWindow::MainWindow(ChoqokApplication *application)
     setAttribute(Qt::WA_DeleteOnClose, false);
     setAttribute(Qt::WA_QuitOnClose, false);
 
-    timelineTimer = new QTimer(this);
     setWindowTitle(i18n("Choqok"));
     connect(mainWidget, &QTabWidget::currentChanged, this, &MainWindow::slotCurrentBlogChanged);
     setCentralWidget(mainWidget);
@@ -97,7 +97,6 @@ MainWindow::MainWindow(ChoqokApplication *application)
         mPrevUpdateInterval = 10;
     }
 
-    connect(timelineTimer, &QTimer::timeout, this, &MainWindow::updateTimelines);
     connect(this, &MainWindow::markAllAsRead, this, &MainWindow::slotMarkAllAsRead);
     connect(Choqok::AccountManager::self(), SIGNAL(accountAdded(Choqok::Account*)),
             this, SLOT(addBlog(Choqok::Account*)));
@@ -150,9 +149,6 @@ void MainWindow::loadAllAccounts()
             addBlog(ac, true);
         }
         qCDebug(CHOQOK) << "All accounts loaded.";
-        if (Choqok::BehaviorSettings::updateInterval() > 0) {
-            QTimer::singleShot(500, this, &MainWindow::updateTimelines);
-        }
     } else {
         if (m_splash) {
             m_splash->finish(this);
@@ -399,12 +395,10 @@ void MainWindow::slotBehaviorConfigChanged()
     } else {
         actionCollection()->action(QLatin1String("choqok_enable_notify"))->setChecked(false);
     }
+    Choqok::UpdateScheduler::self()->setInterval(Choqok::BehaviorSettings::updateInterval());
     if (Choqok::BehaviorSettings::updateInterval() > 0) {
-        timelineTimer->setInterval(Choqok::BehaviorSettings::updateInterval() * 60000);
-        timelineTimer->start();
         actionCollection()->action(QLatin1String("choqok_enable_updates"))->setChecked(true);
     } else {
-        timelineTimer->stop();
         actionCollection()->action(QLatin1String("choqok_enable_updates"))->setChecked(false);
     }
 
@@ -415,7 +409,7 @@ void MainWindow::slotQuit()
 {
     qCDebug(CHOQOK);
     Choqok::BehaviorSettings::setPosition(pos());
-    timelineTimer->stop();
+    Choqok::UpdateScheduler::self()->setEnabled(false);
     Choqok::BehaviorSettings::self()->save();
     app->quitChoqok();
 }
@@ -423,8 +417,7 @@ void MainWindow::slotQuit()
 void MainWindow::disableApp()
 {
     qCDebug(CHOQOK);
-    timelineTimer->stop();
-//     qCDebug(CHOQOK)<<"timelineTimer stoped";
+    Choqok::UpdateScheduler::self()->setEnabled(false);
     actionCollection()->action(QLatin1String("update_timeline"))->setEnabled(false);
     actionCollection()->action(QLatin1String("choqok_new_post"))->setEnabled(false);
 //     actionCollection()->action( "choqok_search" )->setEnabled( false );
@@ -435,10 +428,7 @@ void MainWindow::disableApp()
 void MainWindow::enableApp()
 {
     qCDebug(CHOQOK);
-    if (Choqok::BehaviorSettings::updateInterval() > 0) {
-        timelineTimer->start();
-//         qCDebug(CHOQOK)<<"timelineTimer started";
-    }
+    Choqok::UpdateScheduler::self()->setEnabled(true);
     actionCollection()->action(QLatin1String("update_timeline"))->setEnabled(true);
     actionCollection()->action(QLatin1String("choqok_new_post"))->setEnabled(true);
 //     actionCollection()->action( "choqok_search" )->setEnabled( true );
@@ -468,7 +458,8 @@ void MainWindow::addBlog(Choqok::Account *account, bool isStartup)
 
     mainWidget->addTab(widget, QIcon::fromTheme(account->microblog()->pluginIcon()), account->alias());
 
-    if (!isStartup) {
+    Choqok::UpdateScheduler::self()->addAccount(account);
+    if (!isStartup && !Choqok::UpdateScheduler::self()->isEnabled()) {
         QTimer::singleShot(1500, widget, &Choqok::UI::MicroBlogWidget::updateTimelines);
     }
     enableApp();
@@ -487,6 +478,7 @@ void MainWindow::updateBlog(Choqok::Account *account, bool enabled)
 void MainWindow::removeBlog(const QString &alias)
 {
     qCDebug(CHOQOK);
+    Choqok::UpdateScheduler::self()->removeAccount(alias);
     for (int i = 0; i < mainWidget->count(); ++i) {
         Choqok::UI::MicroBlogWidget *tmp = qobject_cast<Choqok::UI::MicroBlogWidget *>(mainWidget->widget(i));
         if (tmp->currentAccount()->alias() == alias) {
@@ -555,13 +547,11 @@ void MainWindow::setTimeLineUpdatesEnabled(bool isEnabled)
             Choqok::BehaviorSettings::setUpdateInterval(mPrevUpdateInterval);
         }
         Q_EMIT updateTimelines();
-        timelineTimer->start(Choqok::BehaviorSettings::updateInterval() * 60000);
-//         qCDebug(CHOQOK)<<"timelineTimer started";
+        Choqok::UpdateScheduler::self()->setInterval(Choqok::BehaviorSettings::updateInterval());
     } else {
         mPrevUpdateInterval = Choqok::BehaviorSettings::updateInterval();
-        timelineTimer->stop();
-//         qCDebug(CHOQOK)<<"timelineTimer stoped";
         Choqok::BehaviorSettings::setUpdateInterval(0);
+        Choqok::UpdateScheduler::self()->setInterval(0);
     }
 }
 
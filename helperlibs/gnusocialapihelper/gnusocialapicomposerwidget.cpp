@@ -35,7 +35,6 @@
 #include "choqoktextedit.h"
 #include "microblog.h"
 #include "notifymanager.h"
-#include "shortenmanager.h"
 
 #include "twitterapitextedit.h"
 
@@ -77,18 +76,13 @@ GNUSocialApiComposerWidget::~GNUSocialApiComposerWidget()
     delete d;
 }
 
-void GNUSocialApiComposerWidget::submitPost(const QString &txt)
+void GNUSocialApiComposerWidget::sendPost(const QString &text)
 {
     if (d->mediumToAttach.isEmpty()) {
-        Choqok::UI::ComposerWidget::submitPost(txt);
+        Choqok::UI::ComposerWidget::sendPost(text);
     } else {
         qCDebug(CHOQOK);
         editorContainer()->setEnabled(false);
-        QString text = txt;
-        if (currentAccount()->postCharLimit() &&
-                text.size() > (int)currentAccount()->postCharLimit()) {
-            text = Choqok::ShortenManager::self()->parseText(text);
-        }
         setPostToSubmit(nullptr);
         setPostToSubmit(new Choqok::Post);
         postToSubmit()->content = text;
@@ -46,17 +46,6 @@
 
 const QRegExp GNUSocialApiPostWidget::mGroupRegExp(QLatin1String("([\\s]|^)!([a-z0-9]+){1,64}"),  Qt::CaseInsensitive);
 const QRegExp GNUSocialApiPostWidget::mGNUSocialApiUserRegExp(QLatin1String("([\\s\\W]|^)@([a-z0-9_]+){1,64}(?!(@))"), Qt::CaseInsensitive);
-const QRegExp GNUSocialApiPostWidget::mGNUSocialApiHashRegExp(QLatin1String("([\\s]|^)#([\\w_\\.\\-]+)"), Qt::CaseInsensitive);
-
-const QString subdomains = QLatin1String("(([a-z0-9-_]\\.)?)");
-const QString dname = QLatin1String("(([a-z0-9-\\x0080-\\xFFFF]){1,63}\\.)+");
-const QString zone = QLatin1String("((a[cdefgilmnoqrstuwxz])|(b[abdefghijlmnorstvwyz])|(c[acdfghiklmnoruvxyz])|(d[ejkmoz])|(e[ceghrstu])|\
-(f[ijkmor])|(g[abdefghilmnpqrstuwy])|(h[kmnrtu])|(i[delmnoqrst])|(j[emop])|(k[eghimnprwyz])|(l[abcikrstuvy])|\
-(m[acdefghklmnopqrstuvwxyz])|(n[acefgilopruz])|(om)|(p[aefghklnrstwy])|(qa)|(r[eosuw])|(s[abcdeghijklmnortuvyz])|\
-(t[cdfghjkmnoprtvwz])|(u[agksyz])|(v[aceginu])|(w[fs])|(ye)|(z[amrw])\
-|(asia|com|info|net|org|biz|name|pro|aero|cat|coop|edu|jobs|mobi|museum|tel|travel|gov|int|mil|local)|(中国)|(公司)|(网络)|(صر)|(امارات)|(рф))");
-const QString domain = QLatin1Char('(') + subdomains + dname + zone + QLatin1Char(')');
-const QRegExp GNUSocialApiPostWidget::mStatusNetUserRegExp(QLatin1String("([\\s\\W]|^)@(([a-z0-9]+){1,64}@") + domain + QLatin1Char(')'), Qt::CaseInsensitive);
 
 class GNUSocialApiPostWidget::Private
 {
@@ -124,15 +113,17 @@ void GNUSocialApiPostWidget::slotReplyToAll()
     Q_EMIT reply(txt, currentPost()->postId, currentPost()->author.userName);
 }
 
-QString GNUSocialApiPostWidget::prepareStatus(const QString &text)
+QString GNUSocialApiPostWidget::entityToHtml(const Choqok::Entity &entity, const QString &text)
 {
-    QString res = TwitterApiPostWidget::prepareStatus(text);
-    res.replace(mStatusNetUserRegExp, QLatin1String("\\1@<a href='user://\\2'>\\2</a>"));
-    res.replace(mGNUSocialApiUserRegExp, QLatin1String("\\1@<a href='user://\\2'>\\2</a>"));
-    res.replace(mGroupRegExp, QLatin1String("\\1!<a href='group://\\2'>\\2</a>"));
-    res.replace(mGNUSocialApiHashRegExp, QLatin1String("\\1#<a href='tag://\\2'>\\2</a>"));
-
-    return res;
+    // Users may be of other servers, like @someone@example.org
+    if (entity.type == Choqok::Entity::Mention) {
+        return QStringLiteral("@<a href='user://%1'>%1</a>").arg(text.mid(1));
+    } else if (entity.type == Choqok::Entity::Group) {
+        return QStringLiteral("!<a href='group://%1'>%1</a>").arg(text.mid(1));
+    } else if (entity.type == Choqok::Entity::Hashtag) {
+        return QStringLiteral("#<a href='tag://%1'>%1</a>").arg(text.mid(1));
+    }
+    return TwitterApiPostWidget::entityToHtml(entity, text);
 }
 
 QString GNUSocialApiPostWidget::generateSign()
@@ -36,9 +36,7 @@ public:
 protected:
     static const QRegExp mGroupRegExp;
     static const QRegExp mGNUSocialApiUserRegExp;
-    static const QRegExp mGNUSocialApiHashRegExp;
-    static const QRegExp mStatusNetUserRegExp;
-    virtual QString prepareStatus(const QString &text) override;
+    virtual QString entityToHtml(const Choqok::Entity &entity, const QString &text) override;
     virtual void checkAnchor(const QUrl &url) override;
     virtual QString generateSign() override;
     virtual void slotReplyToAll() override;
@@ -34,12 +34,14 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "account.h"
 #include "accountmanager.h"
 #include "application.h"
+#include "backgroundjob.h"
 #include "choqokappearancesettings.h"
 #include "choqokbehaviorsettings.h"
 #include "choqokuiglobal.h"
 #include "editaccountwidget.h"
 #include "microblogwidget.h"
 #include "notifymanager.h"
+#include "postbackupstore.h"
 #include "postwidget.h"
 #include "timelinewidget.h"
 
@@ -176,6 +178,25 @@ QList< Choqok::Post * > TwitterApiMicroBlog::loadTimeline(Choqok::Account *accou
         return list;    //NOTE Won't cache favorites, and this is for compatibility with older versions!
     }
     qCDebug(CHOQOK) << timelineName;
+    Choqok::PostBackupStore *store = Choqok::PostBackupStore::store(account->alias(), timelineName);
+    if (store->exists() || !store->hasLegacyBackup()) {
+        list = store->load();
+    } else {
+        // One time migration of the KConfig backup of older versions
+        list = loadLegacyTimeline(account, timelineName);
+        store->save(list);
+        store->removeLegacyBackup();
+    }
+    if (!list.isEmpty()) {
+        mTimelineLatestId[account][timelineName] = list.last()->postId;
+    }
+    return list;
+}
+
+QList< Choqok::Post * > TwitterApiMicroBlog::loadLegacyTimeline(Choqok::Account *account,
+        const QString &timelineName)
+{
+    QList< Choqok::Post * > list;
     QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(), timelineName);
     KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
     QStringList tmpList = postsBackup.groupList();
@@ -228,57 +249,17 @@ QList< Choqok::Post * > TwitterApiMicroBlog::loadTimeline(Choqok::Account *accou
 
             list.append(st);
         }
-        mTimelineLatestId[account][timelineName] = st->postId;
     }
     return list;
 }
 
-void TwitterApiMicroBlog::saveTimeline(Choqok::Account *account,
-                                       const QString &timelineName,
-                                       const QList< Choqok::UI::PostWidget * > &timeline)
+void TwitterApiMicroBlog::savePosts(Choqok::Account *account,
+                                    const QString &timelineName,
+                                    const QList< Choqok::Post * > &timeline)
 {
     if (timelineName.compare(QLatin1String("Favorite")) != 0) {
         qCDebug(CHOQOK);
-        QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(), timelineName);
-        KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
-
-        ///Clear previous data:
-        for (const QString &group: postsBackup.groupList()) {
-            postsBackup.deleteGroup(group);
-        }
-
-        for (Choqok::UI::PostWidget *wd: timeline) {
-            const Choqok::Post *post = (wd->currentPost());
-            KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
-            grp.writeEntry("creationDateTime", post->creationDateTime);
-            grp.writeEntry("postId", post->postId);
-            grp.writeEntry("text", post->content);
-            grp.writeEntry("source", post->source);
-            grp.writeEntry("inReplyToPostId", post->replyToPostId);
-            grp.writeEntry("inReplyToUserId", post->replyToUserId);
-            grp.writeEntry("favorited", post->isFavorited);
-            grp.writeEntry("inReplyToUserName", post->replyToUserName);
-            grp.writeEntry("authorId", post->author.userId);
-            grp.writeEntry("authorUserName", post->author.userName);
-            grp.writeEntry("authorRealName", post->author.realName);
-            grp.writeEntry("authorHomePageUrl", post->author.homePageUrl);
-            grp.writeEntry("authorProfileImageUrl", post->author.profileImageUrl);
-            grp.writeEntry("authorDescription" , post->author.description);
-            grp.writeEntry("isPrivate" , post->isPrivate);
-            grp.writeEntry("authorLocation" , post->author.location);
-            grp.writeEntry("isProtected" , post->author.isProtected);
-            grp.writeEntry("isRead" , post->isRead);
-            grp.writeEntry("repeatedFrom", post->repeatedFromUsername);
-            grp.writeEntry("repeatedPostId", post->repeatedPostId);
-            grp.writeEntry("repeatedDateTime", post->repeatedDateTime);
-            grp.writeEntry("conversationId", post->conversationId);
-            grp.writeEntry("mediaUrl", post->media);
-            grp.writeEntry("quotedPostId", post->quotedPost.postId);
-            grp.writeEntry("quotedProfileUrl", post->quotedPost.profileImageUrl);
-            grp.writeEntry("quotedContent", post->quotedPost.content);
-            grp.writeEntry("quotedUsername", post->quotedPost.username);
-        }
-        postsBackup.sync();
+        Choqok::PostBackupStore::store(account->alias(), timelineName)->save(timeline);
     }
     if (Choqok::Application::isShuttingDown()) {
         --d->countOfTimelinesToSave;
@@ -872,6 +853,13 @@ void TwitterApiMicroBlog::updateTimelines(Choqok::Account *theAccount)
     }
 }
 
+bool TwitterApiMicroBlog::updateTimeline(Choqok::Account *theAccount, const QString &timelineName)
+{
+    qCDebug(CHOQOK) << timelineName;
+    requestTimeLine(theAccount, timelineName, mTimelineLatestId[theAccount][timelineName]);
+    return true;
+}
+
 void TwitterApiMicroBlog::requestTimeLine(Choqok::Account *theAccount, QString type,
         QString latestStatusId, int page, QString maxId)
 {
@@ -954,20 +942,42 @@ void TwitterApiMicroBlog::slotRequestTimeline(KJob *job)
     QString type = mRequestTimelineMap.take(job);
     if (isValidTimeline(type)) {
         KIO::StoredTransferJob *j = qobject_cast<KIO::StoredTransferJob *>(job);
-        QList<Choqok::Post *> list;
         if (type == QLatin1String("Inbox") || type == QLatin1String("Outbox")) {
-            list = readDirectMessages(theAccount, j->data());
-        } else {
-            list = readTimeline(theAccount, j->data());
-
-        }
-        if (!list.isEmpty()) {
-            mTimelineLatestId[theAccount][type] = list.last()->postId;
+            const QList<Choqok::Post *> list = readDirectMessages(theAccount, j->data());
+            if (!list.isEmpty()) {
+                mTimelineLatestId[theAccount][type] = list.last()->postId;
+            }
+            // Also when empty, UpdateScheduler backs off from idle timelines
             Q_EMIT timelineDataReceived(theAccount, type, list);
+        } else {
+            // Decode the JSON in a worker, readPost() is virtual and may use the account, so it stays here
+            const QByteArray data = j->data();
+            Choqok::BackgroundJob *parser = new Choqok::BackgroundJob([data]() {
+                return QJsonDocument::fromJson(data).toVariant();
+            }, this);
+            mParseTimelineMap[parser] = type;
+            mParserAccount[parser] = theAccount;
+            mParserBuffer[parser] = data;
+            connect(parser, SIGNAL(finished(Choqok::BackgroundJob*)),
+                    this, SLOT(slotTimelineParsed(Choqok::BackgroundJob*)));
+            parser->start();
         }
     }
 }
 
+void TwitterApiMicroBlog::slotTimelineParsed(Choqok::BackgroundJob *job)
+{
+    const QString type = mParseTimelineMap.take(job);
+    Choqok::Account *theAccount = mParserAccount.take(job);
+    const QByteArray buffer = mParserBuffer.take(job);
+    const QList<Choqok::Post *> list = readTimeline(theAccount, buffer, job->result());
+    if (!list.isEmpty()) {
+        mTimelineLatestId[theAccount][type] = list.last()->postId;
+    }
+    // Also when empty, UpdateScheduler backs off from idle timelines
+    Q_EMIT timelineDataReceived(theAccount, type, list);
+}
+
 QByteArray TwitterApiMicroBlog::authorizationHeader(TwitterApiAccount *theAccount, const QUrl &requestUrl,
                                                     QNetworkAccessManager::Operation method, const QVariantMap &params)
 {
@@ -1345,11 +1355,16 @@ QString TwitterApiMicroBlog::checkForError(const QByteArray &buffer)
 
 QList< Choqok::Post * > TwitterApiMicroBlog::readTimeline(Choqok::Account *theAccount,
         const QByteArray &buffer)
+{
+    return readTimeline(theAccount, buffer, QJsonDocument::fromJson(buffer).toVariant());
+}
+
+QList< Choqok::Post * > TwitterApiMicroBlog::readTimeline(Choqok::Account *theAccount,
+        const QByteArray &buffer, const QVariant &json)
 {
     QList<Choqok::Post *> postList;
-    const QJsonDocument json = QJsonDocument::fromJson(buffer);
     if (!json.isNull()) {
-        for (const QVariant &list: json.toVariant().toList()) {
+        for (const QVariant &list: json.toList()) {
             postList.prepend(readPost(theAccount, list.toMap(), new Choqok::Post));
         }
     } else {
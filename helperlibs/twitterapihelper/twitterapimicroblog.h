@@ -33,6 +33,11 @@ class TwitterApiSearchTimelineWidget;
 class TwitterApiAccount;
 class KJob;
 
+namespace Choqok
+{
+class BackgroundJob;
+}
+
 /**
 @author Mehrdad Momeny \<mehrdad.momeny@gmail.com\>
 */
@@ -45,8 +50,8 @@ public:
     virtual QMenu *createActionsMenu(Choqok::Account *theAccount,
                                      QWidget *parent = Choqok::UI::Global::mainWindow()) override;
     virtual QList< Choqok::Post * > loadTimeline(Choqok::Account *accountAlias, const QString &timelineName) override;
-    virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
-                              const QList< Choqok::UI::PostWidget * > &timeline) override;
+    virtual void savePosts(Choqok::Account *account, const QString &timelineName,
+                           const QList< Choqok::Post * > &timeline) override;
 
     virtual Choqok::UI::ComposerWidget *createComposerWidget(Choqok::Account *account, QWidget *parent) override;
     /**
@@ -93,6 +98,7 @@ public:
     @see timelineDataReceived()
     */
     virtual void updateTimelines(Choqok::Account *theAccount) override;
+    virtual bool updateTimeline(Choqok::Account *theAccount, const QString &timelineName) override;
 
     /**
      add post with Id @p postId to @p theAccount favorite list
@@ -189,6 +195,7 @@ protected Q_SLOTS:
     virtual void slotCreateFavorite(KJob *job);
     virtual void slotRemoveFavorite(KJob *job);
     virtual void slotRequestTimeline(KJob *job);
+    void slotTimelineParsed(Choqok::BackgroundJob *job);
     virtual void requestFriendsScreenName(TwitterApiAccount *theAccount, bool active);
     void slotRequestFriendsScreenNameActive(KJob *job);
     void slotRequestFriendsScreenNamePassive(KJob *job);
@@ -219,6 +226,15 @@ protected:
     virtual Choqok::Post *readPost(Choqok::Account *theAccount,
                                    const QByteArray &buffer, Choqok::Post *post);
     virtual QList<Choqok::Post *> readTimeline(Choqok::Account *theAccount, const QByteArray &buffer);
+    /**
+    Read posts of @p json, the already decoded @p buffer
+    */
+    virtual QList<Choqok::Post *> readTimeline(Choqok::Account *theAccount, const QByteArray &buffer,
+                                               const QVariant &json);
+    /**
+    Read posts of the KConfig based timeline backup of older versions
+    */
+    QList<Choqok::Post *> loadLegacyTimeline(Choqok::Account *account, const QString &timelineName);
     virtual Choqok::Post *readDirectMessage(Choqok::Account *theAccount, const QByteArray &buffer);
     virtual Choqok::Post *readDirectMessage(Choqok::Account *theAccount, const QVariantMap &var);
     virtual QList<Choqok::Post *> readDirectMessages(Choqok::Account *theAccount, const QByteArray &buffer);
@@ -243,6 +259,9 @@ protected:
     QMap<KJob *, Choqok::Post *> mCreatePostMap; //Job, post
     QMap<KJob *, Choqok::Post *> mFetchPostMap;
     QMap<KJob *, QString> mRequestTimelineMap; //Job, TimelineType
+    QMap<Choqok::BackgroundJob *, QString> mParseTimelineMap; //Parser, TimelineType
+    QMap<Choqok::BackgroundJob *, Choqok::Account *> mParserAccount;
+    QMap<Choqok::BackgroundJob *, QByteArray> mParserBuffer;
     QHash< Choqok::Account *, QMap<QString, QString> > mTimelineLatestId; //TimelineType, LatestId
     QMap<KJob *, Choqok::Account *> mJobsAccount;
     QMap<KJob *, QString> mFriendshipMap;
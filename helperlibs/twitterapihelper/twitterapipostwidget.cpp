@@ -34,6 +34,7 @@
 #include "choqokappearancesettings.h"
 #include "mediamanager.h"
 #include "microblog.h"
+#include "poststore.h"
 #include "textbrowser.h"
 #include "twitterapiaccount.h"
 #include "twitterapidebug.h"
@@ -46,7 +47,7 @@ class TwitterApiPostWidget::Private
 {
 public:
     Private(Choqok::Account *account)
-        : isBasePostShowed(false)
+        : btnFav(0), isBasePostShowed(false)
     {
         mBlog = qobject_cast<TwitterApiMicroBlog *>(account->microblog());
     }
@@ -217,6 +218,7 @@ void TwitterApiPostWidget::slotSetFavorite(Choqok::Account *theAccount, const QS
         qCDebug(CHOQOK) << postId;
         currentPost()->isFavorited = !currentPost()->isFavorited;
         updateFavStat();
+        Choqok::PostStore::self()->notifyChanged(currentAccount(), currentPost());
         disconnect(d->mBlog, SIGNAL(favoriteRemoved(Choqok::Account*,QString)),
                    this, SLOT(slotSetFavorite(Choqok::Account*,QString)));
         disconnect(d->mBlog, SIGNAL(favoriteCreated(Choqok::Account*,QString)),
@@ -224,6 +226,14 @@ void TwitterApiPostWidget::slotSetFavorite(Choqok::Account *theAccount, const QS
     }
 }
 
+void TwitterApiPostWidget::slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes)
+{
+    Choqok::UI::PostWidget::slotPostChanged(theAccount, post, changes);
+    if (d->btnFav && theAccount == currentAccount() && post == currentPost()) {
+        updateFavStat();
+    }
+}
+
 void TwitterApiPostWidget::updateFavStat()
 {
     if (currentPost()->isFavorited) {
@@ -240,10 +250,12 @@ void TwitterApiPostWidget::checkAnchor(const QUrl &url)
     QString scheme = url.scheme();
     if (scheme == QLatin1String("replyto")) {
         if (d->isBasePostShowed) {
-            setContent(prepareStatus(currentPost()->content).replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive));
-            updateUi();
+            setContent(renderContent());
             d->isBasePostShowed = false;
             return;
+        } else if (Choqok::Post *known = Choqok::PostStore::self()->find(currentAccount(), url.host())) {
+            // On a timeline of the account already, no need to ask the server
+            slotBasePostFetched(currentAccount(), known);
         } else {
             connect(currentAccount()->microblog(), SIGNAL(postFetched(Choqok::Account*,Choqok::Post*)),
                     this, SLOT(slotBasePostFetched(Choqok::Account*,Choqok::Post*)));
@@ -288,7 +300,6 @@ void TwitterApiPostWidget::slotBasePostFetched(Choqok::Account *theAccount, Choq
 
         baseStatusText += prepareStatus(post->content) + QLatin1String("</p>");
         setContent(content().prepend(baseStatusText.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive)));
-        updateUi();
         if( post->owners < 1 )
             delete post;
     }
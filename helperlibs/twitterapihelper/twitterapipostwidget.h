@@ -49,6 +49,8 @@ protected Q_SLOTS:
 
     void slotBasePostFetched(Choqok::Account *theAccount, Choqok::Post *post);
 
+    virtual void slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes) override;
+
 protected:
     virtual QString generateSign() override;
 
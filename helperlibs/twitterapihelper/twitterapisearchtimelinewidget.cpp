@@ -38,6 +38,7 @@
 #include "choqokbehaviorsettings.h"
 #include "choqoktypes.h"
 #include "postwidget.h"
+#include "updatescheduler.h"
 
 #include "twitterapidebug.h"
 #include "twitterapimicroblog.h"
@@ -69,6 +70,8 @@ TwitterApiSearchTimelineWidget::TwitterApiSearchTimelineWidget(Choqok::Account *
     d->searchBackend = qobject_cast<TwitterApiMicroBlog *>(currentAccount()->microblog())->searchBackend();
     connect(Choqok::UI::Global::mainWindow(), SIGNAL(updateTimelines()),
             this, SLOT(slotUpdateSearchResults()));
+    connect(Choqok::UpdateScheduler::self(), SIGNAL(intervalElapsed()),
+            this, SLOT(slotUpdateSearchResults()));
     addFooter();
     timelineDescription()->setText(i18nc("%1 is the name of a timeline", "Search results for %1", timelineName));
     setClosable();
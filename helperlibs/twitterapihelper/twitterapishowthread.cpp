@@ -28,6 +28,7 @@
 
 #include <KLocalizedString>
 
+#include "poststore.h"
 #include "postwidget.h"
 #include "twitterapiaccount.h"
 #include "twitterapidebug.h"
@@ -55,10 +56,7 @@ TwitterApiShowThread::TwitterApiShowThread(Choqok::Account *account, Choqok::Pos
     Choqok::UI::PostWidget *widget = d->account->microblog()->createPostWidget(d->account, finalPost, this);
     if (widget) {
         addPostWidgetToUi(widget);
-        Choqok::Post *ps = new Choqok::Post;
-        ps->postId = finalPost->replyToPostId;
-        d->desiredPostId = finalPost->replyToPostId;
-        d->account->microblog()->fetchPost(d->account, ps);
+        fetchPost(finalPost->replyToPostId);
     }
 }
 
@@ -108,14 +106,24 @@ void TwitterApiShowThread::slotAddNewPost(Choqok::Account *theAccount, Choqok::P
         Choqok::UI::PostWidget *widget = d->account->microblog()->createPostWidget(d->account, post, this);
         if (widget) {
             addPostWidgetToUi(widget);
-            Choqok::Post *ps = new Choqok::Post;
-            ps->postId = post->replyToPostId;
-            d->desiredPostId = ps->postId;
-            d->account->microblog()->fetchPost(d->account, ps);
+            fetchPost(post->replyToPostId);
         }
     }
 }
 
+void TwitterApiShowThread::fetchPost(const QString &postId)
+{
+    d->desiredPostId = postId;
+    Choqok::Post *known = Choqok::PostStore::self()->find(d->account, postId);
+    if (known) {
+        slotAddNewPost(d->account, known);
+        return;
+    }
+    Choqok::Post *ps = new Choqok::Post;
+    ps->postId = postId;
+    d->account->microblog()->fetchPost(d->account, ps);
+}
+
 void TwitterApiShowThread::addPostWidgetToUi(Choqok::UI::PostWidget *widget)
 {
     qCDebug(CHOQOK);
@@ -56,6 +56,10 @@ protected:
     void addPostWidgetToUi(Choqok::UI::PostWidget *widget);
 private:
     void setupUi();
+    /**
+    Show the post with @p postId next, from a timeline if it's there or else from the server
+    */
+    void fetchPost(const QString &postId);
 
     class Private;
     Private *const d;
@@ -198,18 +198,10 @@ void TwitterApiWhoisWidget::userInfoReceived(KJob *job)
     updateHtml();
     showForm();
 
-    QPixmap userAvatar = Choqok::MediaManager::self()->fetchImage(post.author.profileImageUrl,
-                         Choqok::MediaManager::Async);
-
-    if (!userAvatar.isNull()) {
-        d->wid->document()->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("img://profileImage")),
-                                        userAvatar);
-    } else {
-        connect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                this, SLOT(avatarFetched(QString,QPixmap)));
-        connect(Choqok::MediaManager::self(), SIGNAL(fetchError(QString,QString)),
-                this, SLOT(avatarFetchError(QString,QString)));
-    }
+    Choqok::MediaManager::self()->request(post.author.profileImageUrl, this,
+                                          SLOT(avatarFetched(QString,QPixmap)),
+                                          SLOT(avatarFetchError(QString,QString)),
+                                          Choqok::MediaManager::AvatarImage);
 }
 
 void TwitterApiWhoisWidget::avatarFetched(const QString &remoteUrl, const QPixmap &pixmap)
@@ -219,10 +211,6 @@ void TwitterApiWhoisWidget::avatarFetched(const QString &remoteUrl, const QPixma
         const QUrl url(QLatin1String("img://profileImage"));
         d->wid->document()->addResource(QTextDocument::ImageResource, url, pixmap);
         updateHtml();
-        disconnect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                   this, SLOT(avatarFetched(QString,QPixmap)));
-        disconnect(Choqok::MediaManager::self(), SIGNAL(fetchError(QString,QString)),
-                   this, SLOT(avatarFetchError(QString,QString)));
     }
 }
 
@@ -231,7 +219,7 @@ void TwitterApiWhoisWidget::avatarFetchError(const QString &remoteUrl, const QSt
     qCDebug(CHOQOK);
     Q_UNUSED(errMsg);
     if (remoteUrl == d->currentPost.author.profileImageUrl) {
-        ///Avatar fetching is failed! but will not disconnect to get the img if it fetches later!
+        ///Avatar fetching is failed!
         const QUrl url(QLatin1String("img://profileImage"));
         d->wid->document()->addResource(QTextDocument::ImageResource, url, QIcon::fromTheme(QLatin1String("image-missing")).pixmap(48));
         updateHtml();
@@ -37,6 +37,7 @@
 #include "libchoqokdebug.h"
 #include "microblog.h"
 #include "passwordmanager.h"
+#include "postbackupstore.h"
 #include "pluginmanager.h"
 
 namespace Choqok
@@ -132,8 +133,10 @@ bool AccountManager::removeAccount(const QString &alias)
             }
             QStringList names = a->timelineNames();
             while (!names.isEmpty()) {
+                const QString name = names.takeFirst();
+                PostBackupStore::removeStore(a->alias(), name);
                 const QString tmpFile = QStandardPaths::locate(QStandardPaths::DataLocation,
-                                                               generatePostBackupFileName(a->alias(), names.takeFirst()));
+                                                               generatePostBackupFileName(a->alias(), name));
                 qCDebug(CHOQOK) << "Will remove" << tmpFile;
                 const QUrl path = QUrl::fromLocalFile(tmpFile);
 
@@ -0,0 +1,122 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "backgroundjob.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+namespace Choqok
+{
+
+/**
+Shared by a job and its task, so the job may go away while the task still runs.
+*/
+struct BackgroundJobState
+{
+    QMutex mutex;
+    BackgroundJob *job; // null once the job was destroyed
+    QVariant result;
+};
+
+class BackgroundJob::Private
+{
+public:
+    Private(const Function &function)
+        : function(function), running(false)
+    {}
+
+    Function function;
+    QSharedPointer<BackgroundJobState> state;
+    QVariant result;
+    bool running;
+};
+
+class BackgroundTask : public QRunnable
+{
+public:
+    BackgroundTask(const QSharedPointer<BackgroundJobState> &state, BackgroundJob::Function function)
+        : state(state), function(function)
+    {}
+
+    virtual void run() override
+    {
+        const QVariant result = function();
+        QMutexLocker locker(&state->mutex);
+        if (state->job) {
+            state->result = result;
+            QMetaObject::invokeMethod(state->job, "slotFinished", Qt::QueuedConnection);
+        }
+    }
+
+private:
+    QSharedPointer<BackgroundJobState> state;
+    BackgroundJob::Function function;
+};
+
+BackgroundJob::BackgroundJob(const Function &function, QObject *parent)
+    : QObject(parent), d(new Private(function))
+{
+}
+
+BackgroundJob::~BackgroundJob()
+{
+    if (d->state) {
+        // Don't let the task post to us anymore, it drops its result when done
+        QMutexLocker locker(&d->state->mutex);
+        d->state->job = nullptr;
+    }
+    delete d;
+}
+
+void BackgroundJob::start()
+{
+    if (d->running) {
+        return;
+    }
+    d->running = true;
+    d->state.reset(new BackgroundJobState);
+    d->state->job = this;
+    QThreadPool::globalInstance()->start(new BackgroundTask(d->state, d->function));
+}
+
+QVariant BackgroundJob::result() const
+{
+    return d->result;
+}
+
+void BackgroundJob::slotFinished()
+{
+    {
+        QMutexLocker locker(&d->state->mutex);
+        d->result = d->state->result;
+    }
+    d->running = false;
+    Q_EMIT finished(this);
+    deleteLater();
+}
+
+}
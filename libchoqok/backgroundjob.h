@@ -0,0 +1,91 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef BACKGROUNDJOB_H
+#define BACKGROUNDJOB_H
+
+#include <QObject>
+#include <QVariant>
+
+#include <functional>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+
+/**
+@brief Runs a function in the global QThreadPool and reports its result on the GUI thread
+
+Used for CPU heavy work like parsing server replies, which would freeze the UI otherwise.
+The function must not touch any QObject or GUI state, it only gets its captured data.
+
+Usage:
+@code
+Choqok::BackgroundJob *job = new Choqok::BackgroundJob([data]() {
+    return QVariant::fromValue(parse(data));
+}, this);
+connect(job, SIGNAL(finished(Choqok::BackgroundJob*)), SLOT(slotParsed(Choqok::BackgroundJob*)));
+job->start();
+@endcode
+
+The job deletes itself after @ref finished() was emitted.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT BackgroundJob : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<QVariant ()> Function;
+
+    explicit BackgroundJob(const Function &function, QObject *parent = nullptr);
+    ~BackgroundJob();
+
+    /**
+    Queue the function to the thread pool
+    */
+    void start();
+
+    /**
+    @return value returned by the function, valid once @ref finished() was emitted
+    */
+    QVariant result() const;
+
+Q_SIGNALS:
+    /**
+    Emitted on the thread this job lives in, when the function returned
+    */
+    void finished(Choqok::BackgroundJob *job);
+
+protected Q_SLOTS:
+    void slotFinished();
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // BACKGROUNDJOB_H
@@ -25,6 +25,8 @@
 #define CHOQOKTYPES_H
 
 #include <QDateTime>
+#include <QList>
+#include <QMetaType>
 
 #include "choqok_export.h"
 
@@ -68,6 +70,68 @@ public:
     QString content;    
 };
 
+/**
+A part of a post content with a special meaning, like a link, a mention or a hashtag
+*/
+class CHOQOK_EXPORT Entity
+{
+public:
+    enum Type {
+        Url,
+        Mention,
+        Hashtag,
+        Email,
+        Group
+    };
+
+    Entity()
+        : type(Url), start(0), length(0)
+    {}
+    Entity(Type type, int start, int length, const QString &target = QString())
+        : type(type), start(start), length(length), target(target)
+    {}
+
+    Type type;
+    int start;      // position in Post::content
+    int length;
+    QString target; // link target, if it differs from the text
+};
+
+/**
+Something a plugin found out about a post, like where a short link leads to.
+Annotations are kept with the post and applied whenever it is rendered, see @ref UI::PostWidget::addAnnotation()
+*/
+class CHOQOK_EXPORT Annotation
+{
+public:
+    enum Type {
+        ExpandedUrl,    // the link of the entity leads to url
+        Thumbnail,      // imageUrl is shown instead of the text of the entity
+        Preview,        // a box with imageUrl, title and description linking to url, after the content
+        Highlight       // the post is highlighted
+    };
+
+    Annotation()
+        : type(ExpandedUrl), entity(-1)
+    {}
+    Annotation(Type type, int entity, const QString &url = QString(), const QString &imageUrl = QString())
+        : type(type), entity(entity), url(url), imageUrl(imageUrl)
+    {}
+
+    bool operator==(const Annotation &other) const
+    {
+        return type == other.type && entity == other.entity && url == other.url &&
+               imageUrl == other.imageUrl && title == other.title && description == other.description;
+    }
+
+    Type type;
+    int entity;     // index in Post::entities, -1 for the whole post
+    QString url;
+    QString imageUrl;   // remote URL of an image, as requested from MediaManager
+    QString title;
+    QString description;
+};
+
 class CHOQOK_EXPORT Post
 {
 public:
@@ -76,7 +140,7 @@ public:
     {}
     Post(const Post& u) = default;
     Post(Post&& u) = default;
-    virtual ~Post() {}
+    virtual ~Post(); // removes the post from PostStore
     Post& operator=(const Post& u) = default;
     Post& operator=(Post&& u) = default;
     
@@ -100,7 +164,9 @@ public:
     QString conversationId;
     QString media;          // first Image of Post, if available
     QuotedPost quotedPost;
-    unsigned int owners; // number of associated PostWidgets
+    QList<Entity> entities; // links, mentions, etc. of content, if known
+    QList<Annotation> annotations; // added by plugins
+    unsigned int owners; // number of associated PostWidgets and PostModels
 };
 /**
 Describe an specific timeline, Should use by @ref MicroBlog
@@ -114,4 +180,7 @@ public:
 };
 
 }
+
+Q_DECLARE_METATYPE(Choqok::Post *)
+
 #endif
@@ -33,8 +33,12 @@
 #include "ChoqokAdaptor.h"
 #include "choqokbehaviorsettings.h"
 #include "libchoqokdebug.h"
+#include "mediamanager.h"
+#include "postpipeline.h"
+#include "poststore.h"
 #include "quickpost.h"
 #include "shortenmanager.h"
+#include "updatescheduler.h"
 #include "uploadmediadialog.h"
 
 namespace Choqok
@@ -147,6 +151,27 @@ bool DbusHandler::getShortening()
     return Choqok::BehaviorSettings::shortenOnPaste();
 }
 
+QString DbusHandler::updateSchedule()
+{
+    return Choqok::UpdateScheduler::self()->scheduleDescription();
+}
+
+QString DbusHandler::mediaCacheStatistics()
+{
+    return Choqok::MediaManager::self()->cacheStatistics() + QLatin1Char('\n') +
+           Choqok::MediaManager::self()->downloadStatistics();
+}
+
+QString DbusHandler::postPipelineStatistics()
+{
+    return Choqok::UI::PostPipeline::self()->statistics();
+}
+
+QString DbusHandler::postStoreStatistics()
+{
+    return Choqok::PostStore::self()->statistics();
+}
+
 DbusHandler *ChoqokDbus()
 {
     if (DbusHandler::m_self == 0) {
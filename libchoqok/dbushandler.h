@@ -57,6 +57,10 @@ public Q_SLOTS:
      *   shareUrl: if you want to share an url with the html page title set bool title true;
      *   getShortening: return a bool for the active configuration of ShortenOnPaste option;
      *   setShortening: Control ShortenOnPaste option;
+     *   updateSchedule: return when each timeline is updated next and why;
+     *   mediaCacheStatistics: return hits, misses and evictions of the image caches, and the download queue;
+     *   postPipelineStatistics: return how long new posts wait for and spend in each plugin stage;
+     *   postStoreStatistics: return how many posts and users are kept, and how many duplicates were avoided;
      */
 
     void shareUrl(const QString &url, bool title = false);
@@ -65,6 +69,10 @@ public Q_SLOTS:
     void updateTimelines();
     void setShortening(bool flag);
     bool getShortening();
+    QString updateSchedule();
+    QString mediaCacheStatistics();
+    QString postPipelineStatistics();
+    QString postStoreStatistics();
 
 private:
     static DbusHandler *m_self;
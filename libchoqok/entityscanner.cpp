@@ -0,0 +1,355 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "entityscanner.h"
+
+#include <QByteArray>
+#include <QSet>
+#include <QStringList>
+#include <QVarLengthArray>
+
+namespace Choqok
+{
+
+static const char *const countryDomains =
+    "ac ad ae af ag ai al am an ao aq ar as at au aw ax az ba bb bd be bf bg bh bi bj bl bm bn bo br bs bt bv "
+    "bw by bz ca cc cd cf cg ch ci ck cl cm cn co cr cu cv cx cy cz de dj dk dm do dz ec ee eg eh er es et eu "
+    "fi fj fk fm fo fr ga gb gd ge gf gg gh gi gl gm gn gp gq gr gs gt gu gw gy hk hm hn hr ht hu id ie il im "
+    "in io iq ir is it je jm jo jp ke kg kh ki km kn kp kr kw ky kz la lb lc li lk lr ls lt lu lv ly ma mc md "
+    "me mf mg mh mk ml mm mn mo mp mq mr ms mt mu mv mw mx my mz na nc ne nf ng ni nl no np nr nu nz om pa pe "
+    "pf pg ph pk pl pn pr ps pt pw py qa re ro rs ru rw sa sb sc sd se sg sh si sj sk sl sm sn so sr st su sv "
+    "sy sz tc td tf tg th tj tk tm tn to tp tr tt tv tw tz ua ug uk us uy uz va vc ve vg vi vn vu wf ws ye za "
+    "zm zr zw";
+static const char *const genericDomains =
+    "asia com info net org biz name pro aero cat coop edu jobs mobi museum tel travel gov int mil local xxx "
+    "app blog dev online site social xyz";
+static const char *const internationalDomains = "中国 公司 网络 صر امارات рф";
+
+static QSet<QString> topLevelDomains()
+{
+    QSet<QString> domains;
+    for (const char *list: {countryDomains, genericDomains, internationalDomains}) {
+        for (const QString &domain: QString::fromUtf8(list).split(QLatin1Char(' '))) {
+            domains.insert(domain);
+        }
+    }
+    return domains;
+}
+
+static inline bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_');
+}
+
+static inline bool isAsciiWordChar(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_';
+}
+
+static inline bool isLabelChar(QChar c)
+{
+    return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('-') || c == QLatin1Char('_');
+}
+
+static inline bool isLocalPartChar(QChar c)
+{
+    return isAsciiWordChar(c) || c == QLatin1Char('.') || c == QLatin1Char('-') || c == QLatin1Char('+');
+}
+
+static inline bool isPathChar(QChar c)
+{
+    if (c.unicode() >= 0x80) {
+        return !c.isSpace();
+    }
+    static const QByteArray punctuation(":/?#[]@!$&()*%+,;=.~-|");
+    return isAsciiWordChar(c) || punctuation.contains(char(c.unicode()));
+}
+
+/// Punctuation which ends a sentence rather than a URL
+static inline bool isTrailingPunctuation(QChar c)
+{
+    switch (c.unicode()) {
+    case '!': case '(': case ')': case '[': case ']': case '{': case '}': case ';': case ':':
+    case '\'': case '"': case '.': case ',': case '<': case '>': case '?': case '`':
+    case 0x00AB: case 0x00BB: case 0x201C: case 0x201D: case 0x2018: case 0x2019:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int schemeLength(const QString &text, int pos)
+{
+    static const char *const schemes[] = { "https://", "http://", "ftps://", "ftp://" };
+    for (const char *scheme: schemes) {
+        const QLatin1String prefix(scheme);
+        if (text.midRef(pos, prefix.size()).compare(prefix, Qt::CaseInsensitive) == 0) {
+            return prefix.size();
+        }
+    }
+    return 0;
+}
+
+/**
+End of the host name starting at @p from, or -1 if there is none.
+With @p knownDomain it needs two labels or more and ends at the last known top level domain,
+"kde.org.example" gives "kde.org".
+*/
+static int scanHost(const QString &text, int from, bool knownDomain)
+{
+    const int size = text.size();
+    QVarLengthArray<int, 8> labelStarts;
+    QVarLengthArray<int, 8> labelEnds;
+    int pos = from;
+    while (true) {
+        const int start = pos;
+        while (pos < size && isLabelChar(text.at(pos))) {
+            ++pos;
+        }
+        if (pos == start || pos - start > 63) {
+            break;
+        }
+        labelStarts.append(start);
+        labelEnds.append(pos);
+        if (pos + 1 < size && text.at(pos) == QLatin1Char('.') && isLabelChar(text.at(pos + 1))) {
+            ++pos;
+        } else {
+            break;
+        }
+    }
+    if (labelEnds.isEmpty()) {
+        return -1;
+    }
+    if (!knownDomain) {
+        return labelEnds.last();
+    }
+    for (int i = labelEnds.size() - 1; i > 0; --i) {
+        if (EntityScanner::isKnownTopLevelDomain(text.mid(labelStarts[i], labelEnds[i] - labelStarts[i]))) {
+            return labelEnds[i];
+        }
+    }
+    return -1;
+}
+
+static int scanPort(const QString &text, int pos)
+{
+    const int size = text.size();
+    if (pos + 1 < size && text.at(pos) == QLatin1Char(':') && text.at(pos + 1).isDigit()) {
+        int end = pos + 1;
+        while (end < size && end - pos <= 5 && text.at(end).isDigit()) {
+            ++end;
+        }
+        return end;
+    }
+    return pos;
+}
+
+/// End of the path, query and fragment starting at @p pos, which may be @p pos itself
+static int scanPath(const QString &text, int pos, bool hasScheme)
+{
+    const int size = text.size();
+    if (pos >= size) {
+        return pos;
+    }
+    const QChar first = text.at(pos);
+    if (first != QLatin1Char('/') &&
+            !(hasScheme && (first == QLatin1Char('?') || first == QLatin1Char('#')))) {
+        return pos;
+    }
+    const int start = pos;
+    int opened = 0;
+    int closed = 0;
+    while (pos < size && isPathChar(text.at(pos))) {
+        if (text.at(pos) == QLatin1Char('(')) {
+            ++opened;
+        } else if (text.at(pos) == QLatin1Char(')')) {
+            ++closed;
+        }
+        ++pos;
+    }
+    while (pos > start + 1) {
+        const QChar c = text.at(pos - 1);
+        if (c == QLatin1Char(')') && opened >= closed) {
+            // Balanced, like in wikipedia links
+            break;
+        }
+        if (!isTrailingPunctuation(c)) {
+            break;
+        }
+        if (c == QLatin1Char(')')) {
+            --closed;
+        } else if (c == QLatin1Char('(')) {
+            --opened;
+        }
+        --pos;
+    }
+    return pos;
+}
+
+/// Finds a URL or an e-mail address starting at @p pos
+static int scanLink(const QString &text, int pos, Entity::Type *type, QString *target)
+{
+    const int size = text.size();
+    const int scheme = schemeLength(text, pos);
+    if (scheme > 0) {
+        int hostStart = pos + scheme;
+        // Skip user and password
+        int authorityEnd = hostStart;
+        while (authorityEnd < size && !text.at(authorityEnd).isSpace() && text.at(authorityEnd) != QLatin1Char('/') &&
+                text.at(authorityEnd) != QLatin1Char('?') && text.at(authorityEnd) != QLatin1Char('#')) {
+            ++authorityEnd;
+        }
+        const int at = text.midRef(hostStart, authorityEnd - hostStart).lastIndexOf(QLatin1Char('@'));
+        if (at >= 0) {
+            hostStart += at + 1;
+        }
+        const int hostEnd = scanHost(text, hostStart, false);
+        if (hostEnd < 0) {
+            return -1;
+        }
+        const int end = scanPath(text, scanPort(text, hostEnd), true);
+        *type = Entity::Url;
+        *target = text.mid(pos, end - pos);
+        return end;
+    }
+
+    int localEnd = pos;
+    while (localEnd < size && isLocalPartChar(text.at(localEnd))) {
+        ++localEnd;
+    }
+    if (localEnd < size && text.at(localEnd) == QLatin1Char('@')) {
+        const int end = scanHost(text, localEnd + 1, true);
+        if (end < 0) {
+            return -1;
+        }
+        *type = Entity::Email;
+        *target = QLatin1String("mailto:") + text.mid(pos, end - pos);
+        return end;
+    }
+
+    const int hostEnd = scanHost(text, pos, true);
+    if (hostEnd < 0) {
+        return -1;
+    }
+    const int end = scanPath(text, scanPort(text, hostEnd), false);
+    *type = Entity::Url;
+    *target = QLatin1String("http://") + text.mid(pos, end - pos);
+    return end;
+}
+
+static int scanMention(const QString &text, int pos)
+{
+    const int size = text.size();
+    int end = pos + 1;
+    while (end < size && isAsciiWordChar(text.at(end))) {
+        ++end;
+    }
+    if (end == pos + 1) {
+        return -1;
+    }
+    // A user of another server, like @someone@example.org
+    if (end + 1 < size && text.at(end) == QLatin1Char('@')) {
+        const int hostEnd = scanHost(text, end + 1, true);
+        if (hostEnd > 0) {
+            return hostEnd;
+        }
+    }
+    return end;
+}
+
+static int scanHashtag(const QString &text, int pos)
+{
+    const int size = text.size();
+    int end = pos + 1;
+    while (end < size) {
+        const QChar c = text.at(end);
+        if (!isWordChar(c) && !c.isMark() && c != QLatin1Char('.') && c != QLatin1Char('-')) {
+            break;
+        }
+        ++end;
+    }
+    while (end > pos + 1 && (text.at(end - 1) == QLatin1Char('.') || text.at(end - 1) == QLatin1Char('-'))) {
+        --end;
+    }
+    return end > pos + 1 ? end : -1;
+}
+
+static int scanGroup(const QString &text, int pos)
+{
+    const int size = text.size();
+    int end = pos + 1;
+    while (end < size && isAsciiWordChar(text.at(end)) && text.at(end) != QLatin1Char('_')) {
+        ++end;
+    }
+    return end > pos + 1 ? end : -1;
+}
+
+QList<Entity> EntityScanner::scan(const QString &text)
+{
+    QList<Entity> entities;
+    const int size = text.size();
+    int pos = 0;
+    while (pos < size) {
+        const QChar c = text.at(pos);
+        const QChar previous = pos > 0 ? text.at(pos - 1) : QChar(QLatin1Char(' '));
+        Entity::Type type = Entity::Url;
+        QString target;
+        int end = -1;
+        if (c == QLatin1Char('@')) {
+            if (!isWordChar(previous)) {
+                type = Entity::Mention;
+                end = scanMention(text, pos);
+            }
+        } else if (c == QLatin1Char('#')) {
+            if (previous.isSpace()) {
+                type = Entity::Hashtag;
+                end = scanHashtag(text, pos);
+            }
+        } else if (c == QLatin1Char('!')) {
+            if (previous.isSpace()) {
+                type = Entity::Group;
+                end = scanGroup(text, pos);
+            }
+        } else if (isLabelChar(c) && !isLabelChar(previous) && previous != QLatin1Char('.') &&
+                   previous != QLatin1Char('@') && previous != QLatin1Char('#') && previous != QLatin1Char('!')) {
+            end = scanLink(text, pos, &type, &target);
+        }
+
+        if (end > pos) {
+            entities.append(Entity(type, pos, end - pos, target));
+            pos = end;
+        } else {
+            ++pos;
+        }
+    }
+    return entities;
+}
+
+bool EntityScanner::isKnownTopLevelDomain(const QString &label)
+{
+    static const QSet<QString> domains = topLevelDomains();
+    return domains.contains(label.toLower());
+}
+
+}
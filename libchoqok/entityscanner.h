@@ -0,0 +1,70 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef ENTITYSCANNER_H
+#define ENTITYSCANNER_H
+
+#include <QList>
+#include <QString>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+namespace Choqok
+{
+
+/**
+@brief Finds links, e-mail addresses, mentions, hashtags and groups in plain text
+
+The text is scanned once from start to end, without regular expressions:
+- URLs with a http, https, ftp or ftps scheme, and host names without scheme whose top level
+  domain is known, like "kde.org/applications". Trailing punctuation is not part of a URL.
+- E-mail addresses, like "someone@example.org".
+- Mentions, like "@someone" or "@someone@example.org", after a non word character.
+- Hashtags, like "#choqok", and groups, like "!kde", after a space.
+
+Entities never overlap. Mentions, hashtags and groups include their leading character.
+The target of an URL is the URL, with "http://" if it has no scheme, the target of an
+e-mail address is its "mailto:" URL.
+
+It only touches its arguments, so it can be used from any thread.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT EntityScanner
+{
+public:
+    /**
+    @return the entities of @p text, in the order they appear
+    */
+    static QList<Entity> scan(const QString &text);
+
+    /**
+    @return true if @p label is a top level domain links without scheme are detected for
+    */
+    static bool isKnownTopLevelDomain(const QString &label);
+};
+
+}
+
+#endif // ENTITYSCANNER_H
@@ -0,0 +1,324 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "htmltext.h"
+
+namespace Choqok
+{
+
+static bool isBlockTag(const QString &name)
+{
+    static const char *const blockTags[] = {
+        "p", "div", "li", "ul", "ol", "blockquote", "pre", "h1", "h2", "h3", "h4", "h5", "h6", "tr", "table"
+    };
+    for (const char *tag: blockTags) {
+        if (name == QLatin1String(tag)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Decodes the character reference at @p pos, which points to '&'. Returns the index after it
+static int decodeReference(const QString &html, int pos, QString *result)
+{
+    const int end = html.indexOf(QLatin1Char(';'), pos + 1);
+    if (end < 0 || end - pos > 10) {
+        *result = QLatin1String("&");
+        return pos + 1;
+    }
+
+    const QStringRef name = html.midRef(pos + 1, end - pos - 1);
+    if (name.startsWith(QLatin1Char('#'))) {
+        bool ok = false;
+        uint code;
+        if (name.startsWith(QLatin1String("#x")) || name.startsWith(QLatin1String("#X"))) {
+            code = name.mid(2).toUInt(&ok, 16);
+        } else {
+            code = name.mid(1).toUInt(&ok, 10);
+        }
+        if (ok && code > 0 && code <= 0x10FFFF) {
+            *result = QString::fromUcs4(&code, 1);
+            return end + 1;
+        }
+    } else if (name == QLatin1String("amp")) {
+        *result = QLatin1String("&");
+        return end + 1;
+    } else if (name == QLatin1String("lt")) {
+        *result = QLatin1String("<");
+        return end + 1;
+    } else if (name == QLatin1String("gt")) {
+        *result = QLatin1String(">");
+        return end + 1;
+    } else if (name == QLatin1String("quot")) {
+        *result = QLatin1String("\"");
+        return end + 1;
+    } else if (name == QLatin1String("apos")) {
+        *result = QLatin1String("'");
+        return end + 1;
+    } else if (name == QLatin1String("nbsp")) {
+        // QTextDocument::toPlainText() gives normal spaces for these too
+        *result = QLatin1String(" ");
+        return end + 1;
+    }
+
+    *result = QLatin1String("&");
+    return pos + 1;
+}
+
+/// Value of attribute @p name in the attribute part of a tag, or a null string
+static QString attribute(const QStringRef &attributes, const QLatin1String &name)
+{
+    int pos = 0;
+    const int size = attributes.size();
+    while (pos < size) {
+        while (pos < size && (attributes.at(pos).isSpace() || attributes.at(pos) == QLatin1Char('/'))) {
+            ++pos;
+        }
+        const int nameStart = pos;
+        while (pos < size && !attributes.at(pos).isSpace() && attributes.at(pos) != QLatin1Char('=')) {
+            ++pos;
+        }
+        const QStringRef attributeName = attributes.mid(nameStart, pos - nameStart);
+        while (pos < size && attributes.at(pos).isSpace()) {
+            ++pos;
+        }
+        if (pos >= size || attributes.at(pos) != QLatin1Char('=')) {
+            if (attributeName.compare(name, Qt::CaseInsensitive) == 0) {
+                return QLatin1String("");
+            }
+            continue;
+        }
+        ++pos;
+        while (pos < size && attributes.at(pos).isSpace()) {
+            ++pos;
+        }
+
+        QString value;
+        if (pos < size && (attributes.at(pos) == QLatin1Char('"') || attributes.at(pos) == QLatin1Char('\''))) {
+            const QChar quote = attributes.at(pos);
+            int end = attributes.indexOf(quote, pos + 1);
+            if (end < 0) {
+                end = size;
+            }
+            value = attributes.mid(pos + 1, end - pos - 1).toString();
+            pos = end + 1;
+        } else {
+            const int valueStart = pos;
+            while (pos < size && !attributes.at(pos).isSpace()) {
+                ++pos;
+            }
+            value = attributes.mid(valueStart, pos - valueStart).toString();
+        }
+
+        if (attributeName.compare(name, Qt::CaseInsensitive) == 0) {
+            if (value.contains(QLatin1Char('&'))) {
+                QString decoded;
+                QString reference;
+                for (int i = 0; i < value.size();) {
+                    if (value.at(i) == QLatin1Char('&')) {
+                        i = decodeReference(value, i, &reference);
+                        decoded += reference;
+                    } else {
+                        decoded += value.at(i++);
+                    }
+                }
+                return decoded;
+            }
+            return value;
+        }
+    }
+    return QString();
+}
+
+QString HtmlText::toPlainText(const QString &html, QList<Entity> *entities)
+{
+    QString out;
+    out.reserve(html.size());
+
+    bool blockStart = true;     // nothing written in the current block yet
+    bool pendingSpace = false;  // collapsed white space, written before the next visible character
+
+    bool inAnchor = false;
+    int anchorStart = -1;
+    QString anchorHref;
+    QString anchorClass;
+
+    QString reference;
+    const int size = html.size();
+    int pos = 0;
+
+    auto appendText = [&](const QString &text) {
+        if (pendingSpace) {
+            out += QLatin1Char(' ');
+            pendingSpace = false;
+        }
+        if (inAnchor && anchorStart < 0) {
+            anchorStart = out.size();
+        }
+        out += text;
+        blockStart = false;
+    };
+    auto endBlock = [&]() {
+        if (!blockStart) {
+            out += QLatin1Char('\n');
+            blockStart = true;
+        }
+        pendingSpace = false;
+    };
+
+    while (pos < size) {
+        const QChar c = html.at(pos);
+
+        if (c == QLatin1Char('<')) {
+            if (html.midRef(pos, 4) == QLatin1String("<!--")) {
+                const int end = html.indexOf(QLatin1String("-->"), pos + 4);
+                pos = end < 0 ? size : end + 3;
+                continue;
+            }
+
+            // Find the end of the tag, '>' may appear in quoted attribute values
+            int end = pos + 1;
+            QChar quote;
+            while (end < size) {
+                const QChar t = html.at(end);
+                if (!quote.isNull()) {
+                    if (t == quote) {
+                        quote = QChar();
+                    }
+                } else if (t == QLatin1Char('"') || t == QLatin1Char('\'')) {
+                    quote = t;
+                } else if (t == QLatin1Char('>')) {
+                    break;
+                }
+                ++end;
+            }
+            if (end >= size) {
+                // Not a tag, but a stray '<'
+                appendText(QStringLiteral("<"));
+                ++pos;
+                continue;
+            }
+
+            int nameStart = pos + 1;
+            const bool closing = nameStart < end && html.at(nameStart) == QLatin1Char('/');
+            if (closing) {
+                ++nameStart;
+            }
+            int nameEnd = nameStart;
+            while (nameEnd < end && (html.at(nameEnd).isLetterOrNumber())) {
+                ++nameEnd;
+            }
+            const QString name = html.mid(nameStart, nameEnd - nameStart).toLower();
+            const QStringRef attributes = html.midRef(nameEnd, end - nameEnd);
+            pos = end + 1;
+
+            if (name == QLatin1String("br")) {
+                if (pendingSpace) {
+                    pendingSpace = false;
+                }
+                out += QLatin1Char('\n');
+                blockStart = false;
+            } else if (isBlockTag(name)) {
+                endBlock();
+            } else if (name == QLatin1String("a")) {
+                if (closing) {
+                    if (inAnchor && anchorStart >= 0 && entities) {
+                        const QString text = out.mid(anchorStart);
+                        Entity::Type type = Entity::Url;
+                        if (anchorClass.contains(QLatin1String("hashtag")) || text.startsWith(QLatin1Char('#'))) {
+                            type = Entity::Hashtag;
+                        } else if (anchorClass.contains(QLatin1String("mention")) || text.startsWith(QLatin1Char('@'))) {
+                            type = Entity::Mention;
+                        }
+                        entities->append(Entity(type, anchorStart, out.size() - anchorStart, anchorHref));
+                    }
+                    inAnchor = false;
+                } else {
+                    inAnchor = true;
+                    anchorStart = -1;
+                    anchorHref = attribute(attributes, QLatin1String("href"));
+                    anchorClass = attribute(attributes, QLatin1String("class"));
+                }
+            } else if (!closing && (name == QLatin1String("script") || name == QLatin1String("style"))) {
+                const QString closeTag = QLatin1String("</") + name;
+                const int close = html.indexOf(closeTag, pos, Qt::CaseInsensitive);
+                if (close < 0) {
+                    pos = size;
+                } else {
+                    const int closeEnd = html.indexOf(QLatin1Char('>'), close);
+                    pos = closeEnd < 0 ? size : closeEnd + 1;
+                }
+            }
+            continue;
+        }
+
+        if (c.isSpace()) {
+            if (!blockStart && !out.endsWith(QLatin1Char('\n'))) {
+                pendingSpace = true;
+            }
+            ++pos;
+            continue;
+        }
+
+        if (c == QLatin1Char('&')) {
+            pos = decodeReference(html, pos, &reference);
+            appendText(reference);
+            continue;
+        }
+
+        // Copy the run of plain characters at once
+        int end = pos + 1;
+        while (end < size) {
+            const QChar t = html.at(end);
+            if (t == QLatin1Char('<') || t == QLatin1Char('&') || t.isSpace()) {
+                break;
+            }
+            ++end;
+        }
+        appendText(html.mid(pos, end - pos));
+        pos = end;
+    }
+
+    // Trim like QString::trimmed() does, keeping the entities in place
+    int trailing = out.size();
+    while (trailing > 0 && out.at(trailing - 1).isSpace()) {
+        --trailing;
+    }
+    out.truncate(trailing);
+    int leading = 0;
+    while (leading < out.size() && out.at(leading).isSpace()) {
+        ++leading;
+    }
+    out.remove(0, leading);
+
+    if (entities) {
+        for (Entity &entity: *entities) {
+            entity.start = qMax(0, entity.start - leading);
+            entity.length = qMax(0, qMin(entity.length, out.size() - entity.start));
+        }
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef HTMLTEXT_H
+#define HTMLTEXT_H
+
+#include <QString>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+namespace Choqok
+{
+
+/**
+@brief Converts the simple HTML of server side rendered posts to plain text
+
+A single pass over the markup, for the small tag set services like Mastodon use
+(p, br, a, span, ...). It gives the same text as QTextDocument::toPlainText() for those,
+without building a document, so it's cheap and safe to use in any thread.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT HtmlText
+{
+public:
+    /**
+    @return plain text of @p html, trimmed. Paragraphs and line breaks become new lines,
+    runs of white space are collapsed and character references are decoded.
+
+    @param entities if not null, gets an entry with the href for every link of @p html.
+    Links with a "mention" or "hashtag" class, or whose text starts with '@' or '#',
+    are reported as @ref Entity::Mention or @ref Entity::Hashtag.
+    */
+    static QString toPlainText(const QString &html, QList<Entity> *entities = nullptr);
+};
+
+}
+
+#endif // HTMLTEXT_H
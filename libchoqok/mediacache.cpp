@@ -0,0 +1,220 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "mediacache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+#include "choqokbehaviorsettings.h"
+#include "libchoqokdebug.h"
+
+namespace Choqok
+{
+
+static const quint32 ENTRY_MAGIC = 0x43484d43; // "CHMC"
+static const quint8 ENTRY_VERSION = 1;
+
+static const char *const kindNames[MediaCache::KindCount] = { "avatars", "previews", "images" };
+
+/// Cost of a pixmap in the memory tier, in KiB
+static int pixmapCost(const QPixmap &pixmap)
+{
+    return qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+}
+
+MediaCache::MediaCache()
+    : maxAge(0), memoryHits(0), diskHits(0), misses(0), notModified(0), memoryEvictions(0), diskEvictions(0)
+{
+    baseDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/media/");
+    readSettings();
+}
+
+MediaCache::~MediaCache()
+{
+}
+
+void MediaCache::readSettings()
+{
+    memory[Avatars].setMaxCost(BehaviorSettings::avatarMemoryCache() * 1024);
+    memory[Previews].setMaxCost(BehaviorSettings::previewMemoryCache() * 1024);
+    memory[Images].setMaxCost(BehaviorSettings::imageMemoryCache() * 1024);
+    maxAge = BehaviorSettings::mediaMaxAge() * 3600;
+}
+
+bool MediaCache::findPixmap(const QString &key, Kind kind, QPixmap *pixmap)
+{
+    const QPixmap *cached = memory[kind].object(key);
+    if (!cached) {
+        return false;
+    }
+    ++memoryHits;
+    *pixmap = *cached;
+    return true;
+}
+
+void MediaCache::insertPixmap(const QString &key, Kind kind, const QPixmap &pixmap)
+{
+    QCache<QString, QPixmap> &cache = memory[kind];
+    const int count = cache.count() + (cache.contains(key) ? 0 : 1);
+    cache.insert(key, new QPixmap(pixmap), pixmapCost(pixmap));
+    memoryEvictions += count - cache.count();
+}
+
+QString MediaCache::directory(Kind kind) const
+{
+    return baseDirectory + QLatin1String(kindNames[kind]);
+}
+
+QString MediaCache::entryPath(const QString &key, Kind kind) const
+{
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return directory(kind) + QLatin1Char('/') + QLatin1String(hash);
+}
+
+bool MediaCache::isFresh(const Entry &entry) const
+{
+    return entry.stored.secsTo(QDateTime::currentDateTimeUtc()) < maxAge;
+}
+
+MediaCache::Entry MediaCache::readEntry(const QString &path)
+{
+    Entry entry;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return entry;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic;
+    quint8 version;
+    stream >> magic >> version;
+    if (magic != ENTRY_MAGIC || version != ENTRY_VERSION) {
+        return entry;
+    }
+    stream >> entry.etag >> entry.lastModified >> entry.stored >> entry.data;
+    if (stream.status() != QDataStream::Ok) {
+        entry.data.clear();
+    }
+    return entry;
+}
+
+bool MediaCache::writeEntry(const QString &path, const Entry &entry)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(CHOQOK) << "Cannot write" << path << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << ENTRY_MAGIC << ENTRY_VERSION << entry.etag << entry.lastModified << entry.stored << entry.data;
+    return file.commit();
+}
+
+int MediaCache::trimDirectory(const QString &directory, qint64 budget)
+{
+    QFileInfoList files = QDir(directory).entryInfoList(QDir::Files);
+    qint64 size = 0;
+    for (const QFileInfo &info: files) {
+        size += info.size();
+    }
+    if (size <= budget) {
+        return 0;
+    }
+    std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.lastModified() < b.lastModified();
+    });
+    int removed = 0;
+    for (const QFileInfo &info: files) {
+        if (size <= budget) {
+            break;
+        }
+        if (QFile::remove(info.absoluteFilePath())) {
+            size -= info.size();
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+QList<QPair<QString, qint64> > MediaCache::diskBudgets() const
+{
+    const qint64 mib = 1024 * 1024;
+    QList<QPair<QString, qint64> > budgets;
+    budgets << qMakePair(directory(Avatars), BehaviorSettings::avatarDiskCache() * mib)
+            << qMakePair(directory(Previews), BehaviorSettings::previewDiskCache() * mib)
+            << qMakePair(directory(Images), BehaviorSettings::imageDiskCache() * mib);
+    return budgets;
+}
+
+void MediaCache::clear()
+{
+    for (int kind = 0; kind < KindCount; ++kind) {
+        memory[kind].clear();
+        QDir(directory(Kind(kind))).removeRecursively();
+    }
+}
+
+void MediaCache::countDiskHit()
+{
+    ++diskHits;
+}
+
+void MediaCache::countMiss()
+{
+    ++misses;
+}
+
+void MediaCache::countNotModified()
+{
+    ++notModified;
+}
+
+void MediaCache::countDiskEvictions(int count)
+{
+    diskEvictions += count;
+}
+
+QString MediaCache::statistics() const
+{
+    QString usage;
+    for (int kind = 0; kind < KindCount; ++kind) {
+        usage += QStringLiteral(", %1 %2 (%3 of %4 KiB)").arg(memory[kind].count()).arg(QLatin1String(kindNames[kind]))
+                 .arg(memory[kind].totalCost()).arg(memory[kind].maxCost());
+    }
+    return QStringLiteral("Image cache: %1 memory hits, %2 disk hits, %3 misses, %4 revalidated unchanged, "
+                          "%5 evicted from memory, %6 evicted from disk; in memory%7")
+           .arg(memoryHits).arg(diskHits).arg(misses).arg(notModified)
+           .arg(memoryEvictions).arg(diskEvictions).arg(usage);
+}
+
+}
@@ -0,0 +1,144 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QList>
+#include <QPair>
+#include <QPixmap>
+#include <QString>
+
+namespace Choqok
+{
+
+/**
+@brief Two tier image cache of @ref MediaManager
+
+Decoded pixmaps are kept in memory, the least recently used ones are dropped first.
+Below that, encoded images are stored on disk together with the ETag and Last-Modified
+headers of their download. Once older than @ref BehaviorSettings::mediaMaxAge() they are
+revalidated with a conditional request instead of being downloaded again.
+
+Avatars, preview thumbnails and post images have their own budget in both tiers,
+see the MediaCache group of @ref BehaviorSettings.
+
+Disk entries are read and written by background jobs, so the static functions don't touch
+any member.
+
+@author Choqok Developers
+*/
+class MediaCache
+{
+public:
+    enum Kind {
+        Avatars = 0,
+        Previews,
+        Images,
+        KindCount
+    };
+
+    /**
+    An image on disk
+    */
+    struct Entry {
+        QByteArray data;
+        QByteArray etag;
+        QByteArray lastModified;
+        QDateTime stored;
+    };
+
+    MediaCache();
+    ~MediaCache();
+
+    /**
+    Apply the budgets of @ref BehaviorSettings, dropping pixmaps over them
+    */
+    void readSettings();
+
+    bool findPixmap(const QString &key, Kind kind, QPixmap *pixmap);
+    void insertPixmap(const QString &key, Kind kind, const QPixmap &pixmap);
+
+    /**
+    @return the file the disk entry of @p key is stored in, it may not exist
+    */
+    QString entryPath(const QString &key, Kind kind) const;
+
+    /**
+    @return true if @p entry was stored recently enough to be used without asking the server
+    */
+    bool isFresh(const Entry &entry) const;
+
+    /**
+    @return the entry in @p path, with empty data if there is none or it's damaged
+    */
+    static Entry readEntry(const QString &path);
+    static bool writeEntry(const QString &path, const Entry &entry);
+
+    /**
+    Remove the least recently stored files of @p directory until they take at most @p budget bytes
+    @return count of removed files
+    */
+    static int trimDirectory(const QString &directory, qint64 budget);
+
+    /**
+    @return the disk directories of all kinds, with their budget in bytes
+    */
+    QList<QPair<QString, qint64> > diskBudgets() const;
+
+    /**
+    Drop all pixmaps and remove all files
+    */
+    void clear();
+
+    void countDiskHit();
+    void countMiss();
+    void countNotModified();
+    void countDiskEvictions(int count);
+
+    /**
+    @return a human readable summary of hits, misses and evictions in both tiers
+    */
+    QString statistics() const;
+
+private:
+    QString directory(Kind kind) const;
+
+    QCache<QString, QPixmap> memory[KindCount];
+    QString baseDirectory;
+    int maxAge;
+
+    int memoryHits;
+    int diskHits;
+    int misses;
+    int notModified;
+    int memoryEvictions;
+    int diskEvictions;
+};
+
+}
+
+#endif // MEDIACACHE_H
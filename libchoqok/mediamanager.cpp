@@ -23,43 +23,309 @@
 #include "mediamanager.h"
 
 #include <QApplication>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
 #include <QHash>
 #include <QIcon>
+#include <QImage>
+#include <QImageReader>
+#include <QMetaMethod>
 #include <QMimeDatabase>
+#include <QPair>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVariantMap>
 
 #include <KEmoticons>
 #include <KEmoticonsTheme>
-#include <KImageCache>
 #include <KIO/StoredTransferJob>
 #include <KLocalizedString>
 #include <KMessageBox>
 
+#include "backgroundjob.h"
 #include "choqokbehaviorsettings.h"
 #include "choqokuiglobal.h"
 #include "libchoqokdebug.h"
+#include "mediacache.h"
+#include "multipartbody.h"
 #include "pluginmanager.h"
 #include "uploader.h"
 
 namespace Choqok
 {
 
+// Limits of parallel downloads, all of them and those from the same host
+static const int MAX_DOWNLOADS = 8;
+static const int MAX_HOST_DOWNLOADS = 4;
+// Files are trimmed to the disk budgets once no image was stored for that long
+static const int TRIM_DELAY_MSECS = 10 * 1000;
+// Uploads bigger than this get a progress entry in the job tracker
+static const qint64 TRACKED_UPLOAD_SIZE = 1024 * 1024;
+
+/// Decodes @p data, scaled down while decoding to fit into @p bounds if they are valid
+static QImage decodeImage(const QByteArray &data, const QSize &bounds)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    reader.setAutoTransform(true);
+    QSize size = reader.size();
+    if (bounds.isValid() && size.isValid() &&
+        (size.width() > bounds.width() || size.height() > bounds.height())) {
+        size.scale(bounds, Qt::KeepAspectRatio);
+        reader.setScaledSize(size);
+    }
+    return reader.read();
+}
+
+/// Encodes a scaled down image for the disk cache, keeping transparency where there is some
+static QByteArray encodeImage(const QImage &image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (image.hasAlphaChannel()) {
+        image.save(&buffer, "PNG");
+    } else {
+        image.save(&buffer, "JPEG", 90);
+    }
+    return data;
+}
+
+/// Value of the header @p name in raw HTTP @p headers, as given by the HTTP-Headers meta data of KIO
+static QByteArray headerValue(const QString &headers, const QString &name)
+{
+    for (const QString &line: headers.split(QLatin1Char('\n'))) {
+        const int colon = line.indexOf(QLatin1Char(':'));
+        if (colon > 0 && line.leftRef(colon).trimmed().compare(name, Qt::CaseInsensitive) == 0) {
+            return line.mid(colon + 1).trimmed().toLatin1();
+        }
+    }
+    return QByteArray();
+}
+
 class MediaManager::Private
 {
 public:
     Private()
-        : emoticons(KEmoticons().theme()), cache(QLatin1String("choqok-userimages"), 30000000), uploader(0)
+        : emoticons(KEmoticons().theme()), uploader(0),
+          peakQueued(0), downloaded(0), failed(0), bytesFetched(0), totalWait(0), longestWait(0)
     {}
+
+    struct Subscriber {
+        QPointer<QObject> receiver;
+        QPointer<QObject> owner;    // what the image is shown in, for cancel() and prioritize()
+        QMetaMethod method;
+        QMetaMethod errorMethod;
+        ImagePurpose purpose;
+    };
+
+    static QMetaMethod findMethod(QObject *receiver, const char *member)
+    {
+        if (!member) {
+            return QMetaMethod();
+        }
+        // Skip the code SLOT() and SIGNAL() put in front of the signature
+        const QByteArray signature = QMetaObject::normalizedSignature(member + 1);
+        const int index = receiver->metaObject()->indexOfMethod(signature.constData());
+        if (index < 0) {
+            qCCritical(CHOQOK) << "No such method" << signature << "in" << receiver->metaObject()->className();
+            return QMetaMethod();
+        }
+        return receiver->metaObject()->method(index);
+    }
+
+    static QString cacheKey(const QString &remoteUrl, ImagePurpose purpose)
+    {
+        // The original keeps the plain URL, spaces can't be part of it
+        if (purpose == OriginalImage) {
+            return remoteUrl;
+        }
+        return remoteUrl + QLatin1Char(' ') + QString::number(purpose);
+    }
+
+    static MediaCache::Kind cacheKind(ImagePurpose purpose)
+    {
+        switch (purpose) {
+        case AvatarImage:
+            return MediaCache::Avatars;
+        case PreviewImage:
+            return MediaCache::Previews;
+        default:
+            return MediaCache::Images;
+        }
+    }
+
+    /// Size the image for @p purpose is scaled down to, invalid for the original size
+    static QSize bounds(ImagePurpose purpose)
+    {
+        switch (purpose) {
+        case AvatarImage:
+            return QSize(48, 48);
+        case PreviewImage:
+            return QSize(200, 200);
+        case PostImage:
+            // Only the width is limited, posts are scrolled
+            return QSize(1024, 16 * 1024);
+        default:
+            return QSize();
+        }
+    }
+
+    static void notify(const QList<Subscriber> &list, const QString &remoteUrl, const QPixmap &pixmap)
+    {
+        for (const Subscriber &subscriber: list) {
+            if (subscriber.receiver) {
+                subscriber.method.invoke(subscriber.receiver, Qt::DirectConnection,
+                                         Q_ARG(QString, remoteUrl), Q_ARG(QPixmap, pixmap));
+            }
+        }
+    }
+
+    static void notifyError(const QList<Subscriber> &list, const QString &remoteUrl, const QString &errMsg)
+    {
+        for (const Subscriber &subscriber: list) {
+            if (subscriber.receiver) {
+                subscriber.errorMethod.invoke(subscriber.receiver, Qt::DirectConnection,
+                                              Q_ARG(QString, remoteUrl), Q_ARG(QString, errMsg));
+            }
+        }
+    }
+
+    /**
+     * Ends the subscriptions for @p remoteUrl, for all purposes or for @p purpose only,
+     * and returns the subscribers to notify
+     */
+    QList<Subscriber> takeSubscribers(const QString &remoteUrl, int purpose = -1)
+    {
+        QList<Subscriber> taken;
+        QList<Subscriber> &list = subscribers[remoteUrl];
+        for (int i = list.count() - 1; i >= 0; --i) {
+            if (purpose < 0 || list.at(i).purpose == purpose) {
+                taken.prepend(list.takeAt(i));
+            }
+        }
+        for (const Subscriber &subscriber: taken) {
+            bool waiting = false;
+            for (const Subscriber &other: list) {
+                waiting = waiting || other.owner == subscriber.owner;
+            }
+            QHash<QObject *, QSet<QString> >::iterator it = subscriptions.find(subscriber.owner.data());
+            if (!waiting && it != subscriptions.end()) {
+                it->remove(remoteUrl);
+                if (it->isEmpty()) {
+                    subscriptions.erase(it);
+                }
+            }
+        }
+        if (list.isEmpty()) {
+            subscribers.remove(remoteUrl);
+        }
+        return taken;
+    }
+
+    /// Purposes @p remoteUrl is waited for in, by subscribers or by fetchImage()
+    QList<ImagePurpose> wantedPurposes(const QString &remoteUrl) const
+    {
+        QList<ImagePurpose> purposes;
+        if (broadcastRequests.contains(remoteUrl)) {
+            purposes.append(OriginalImage);
+        }
+        for (const Subscriber &subscriber: subscribers.value(remoteUrl)) {
+            if (!purposes.contains(subscriber.purpose)) {
+                purposes.append(subscriber.purpose);
+            }
+        }
+        return purposes;
+    }
+
+    /// Takes the first queued URL whose host has a free download slot, urgent ones first
+    QString takeNextDownload()
+    {
+        for (QStringList *list: {&urgentQueue, &normalQueue}) {
+            for (int i = 0; i < list->count(); ++i) {
+                const QString &host = pending.value(list->at(i)).host;
+                if (hostDownloads.value(host) < MAX_HOST_DOWNLOADS) {
+                    return list->takeAt(i);
+                }
+            }
+        }
+        return QString();
+    }
+
+    void removePending(const QString &remoteUrl)
+    {
+        if (pending.remove(remoteUrl)) {
+            if (!normalQueue.removeOne(remoteUrl)) {
+                urgentQueue.removeOne(remoteUrl);
+            }
+        }
+    }
+
+    void finishDownload(KJob *job, const QString &remoteUrl)
+    {
+        queue.remove(job);
+        jobs.remove(remoteUrl);
+        const QString host = QUrl(remoteUrl).host();
+        if (--hostDownloads[host] <= 0) {
+            hostDownloads.remove(host);
+        }
+    }
+
+    struct PendingDownload {
+        QString host;
+        QElapsedTimer waiting;
+    };
+
+    /// Validators of a stale disk entry, and the purposes to refresh once it was revalidated
+    struct Revalidation {
+        QByteArray etag;
+        QByteArray lastModified;
+        QList<ImagePurpose> purposes;
+    };
+
     KEmoticonsTheme emoticons;
-    KImageCache cache;
+    MediaCache cache;
     QHash<KJob *, QString> queue;
+    QHash<QString, KJob *> jobs;
+    QHash<QString, int> hostDownloads;
+    // Downloads waiting for a free slot, in the order they will be started
+    QHash<QString, PendingDownload> pending;
+    QStringList urgentQueue;
+    QStringList normalQueue;
+    QHash<QString, Revalidation> revalidations;
+    // Images being decoded or read from disk, and how many of these run for each URL
+    QHash<BackgroundJob *, QPair<QString, ImagePurpose> > decodings;
+    QHash<QString, int> decodingUrls;
+    QTimer trimTimer;
+    // Receivers waiting for each URL, and the URLs each receiver waits for
+    QHash<QString, QList<Subscriber> > subscribers;
+    QHash<QObject *, QSet<QString> > subscriptions;
+    // URLs requested with fetchImage(), whose downloads are never aborted
+    QSet<QString> broadcastRequests;
     QPixmap defaultImage;
     Uploader *uploader;
+
+    int peakQueued;
+    int downloaded;
+    int failed;
+    qint64 bytesFetched;
+    qint64 totalWait;
+    qint64 longestWait;
 };
 
 MediaManager::MediaManager()
     : QObject(qApp), d(new Private)
 {
     d->defaultImage = QIcon::fromTheme(QLatin1String("image-loading")).pixmap(48);
+    d->trimTimer.setSingleShot(true);
+    d->trimTimer.setInterval(TRIM_DELAY_MSECS);
+    connect(&d->trimTimer, SIGNAL(timeout()), this, SLOT(trimDiskCache()));
+    connect(BehaviorSettings::self(), SIGNAL(configChanged()), this, SLOT(slotSettingsChanged()));
 }
 
 MediaManager::~MediaManager()
@@ -88,57 +354,435 @@ QString MediaManager::parseEmoticons(const QString &text)
     return d->emoticons.parseEmoticons(text, KEmoticonsTheme::DefaultParse, QStringList() << QLatin1String("(e)"));
 }
 
-QPixmap MediaManager::fetchImage(const QString &remoteUrl, ReturnMode mode /*= Sync*/)
+QPixmap MediaManager::fetchImage(const QString &remoteUrl, ReturnMode mode /*= Sync*/,
+                                 ImagePurpose purpose /*= OriginalImage*/)
 {
     QPixmap p;
-    if (d->cache.findPixmap(remoteUrl, &p)) {
-        Q_EMIT imageFetched(remoteUrl, p);
+    const QString key = Private::cacheKey(remoteUrl, purpose);
+    const MediaCache::Kind kind = Private::cacheKind(purpose);
+    if (d->cache.findPixmap(key, kind, &p)) {
+        if (purpose == OriginalImage) {
+            Q_EMIT imageFetched(remoteUrl, p);
+        }
     } else if (mode == Async) {
-        if (d->queue.values().contains(remoteUrl)) {
-            ///The file is on the way, wait to download complete.
-            return p;
+        if (purpose == OriginalImage) {
+            d->broadcastRequests.insert(remoteUrl);
+        }
+        startLoading(remoteUrl, purpose);
+    }
+    return p;
+}
+
+bool MediaManager::request(const QString &remoteUrl, QObject *receiver, const char *member,
+                           const char *errorMember, ImagePurpose purpose, QObject *owner)
+{
+    if (!receiver) {
+        return false;
+    }
+    if (!owner) {
+        owner = receiver;
+    }
+    Private::Subscriber subscriber;
+    subscriber.receiver = receiver;
+    subscriber.owner = owner;
+    subscriber.method = Private::findMethod(receiver, member);
+    subscriber.errorMethod = Private::findMethod(receiver, errorMember);
+    subscriber.purpose = purpose;
+
+    QPixmap p;
+    if (d->cache.findPixmap(Private::cacheKey(remoteUrl, purpose), Private::cacheKind(purpose), &p)) {
+        subscriber.method.invoke(receiver, Qt::DirectConnection, Q_ARG(QString, remoteUrl), Q_ARG(QPixmap, p));
+        return true;
+    }
+
+    QSet<QString> &urls = d->subscriptions[owner];
+    if (urls.contains(remoteUrl)) {
+        for (const Private::Subscriber &other: d->subscribers.value(remoteUrl)) {
+            if (other.receiver == receiver && other.owner == owner && other.purpose == purpose) {
+                ///Already waiting for it
+                return false;
+            }
         }
-        QUrl srcUrl(remoteUrl);
-        KIO::StoredTransferJob *job = KIO::storedGet(srcUrl, KIO::NoReload, KIO::HideProgressInfo) ;
+    }
+    connect(owner, SIGNAL(destroyed(QObject*)), this, SLOT(slotOwnerDestroyed(QObject*)),
+            Qt::UniqueConnection);
+    urls.insert(remoteUrl);
+    d->subscribers[remoteUrl].append(subscriber);
+    startLoading(remoteUrl, purpose);
+    return false;
+}
+
+void MediaManager::cancel(const QString &remoteUrl, QObject *owner)
+{
+    if (!d->subscriptions.contains(owner)) {
+        return;
+    }
+    QSet<QString> urls;
+    if (remoteUrl.isEmpty()) {
+        urls = d->subscriptions.take(owner);
+    } else {
+        QSet<QString> &subscribed = d->subscriptions[owner];
+        if (!subscribed.remove(remoteUrl)) {
+            return;
+        }
+        urls.insert(remoteUrl);
+        if (subscribed.isEmpty()) {
+            d->subscriptions.remove(owner);
+        }
+    }
+
+    for (const QString &url: urls) {
+        QList<Private::Subscriber> &list = d->subscribers[url];
+        for (int i = list.count() - 1; i >= 0; --i) {
+            if (list.at(i).owner == owner || !list.at(i).owner) {
+                list.removeAt(i);
+            }
+        }
+        if (!list.isEmpty()) {
+            continue;
+        }
+        d->subscribers.remove(url);
+        // Revalidations are for the cache, and not aborted either
+        if (!d->broadcastRequests.contains(url) && !d->revalidations.contains(url)) {
+            d->removePending(url);
+            KJob *job = d->jobs.value(url);
+            if (job) {
+                qCDebug(CHOQOK) << "Nobody waits for" << url << "anymore";
+                d->finishDownload(job, url);
+                job->kill();
+            }
+        }
+    }
+    startDownloads();
+}
+
+void MediaManager::prioritize(QObject *owner)
+{
+    const QHash<QObject *, QSet<QString> >::const_iterator it = d->subscriptions.constFind(owner);
+    if (it == d->subscriptions.constEnd()) {
+        return;
+    }
+    for (const QString &url: it.value()) {
+        if (d->normalQueue.removeOne(url)) {
+            d->urgentQueue.append(url);
+        }
+    }
+}
+
+QString MediaManager::downloadStatistics() const
+{
+    const int finished = d->downloaded + d->failed;
+    return QStringLiteral("Downloads: %1 running, %2 queued (at most %3), %4 done, %5 failed, "
+                          "%6 KiB fetched, waited %7 ms on average and %8 ms at most")
+           .arg(d->jobs.count()).arg(d->pending.count()).arg(d->peakQueued)
+           .arg(d->downloaded).arg(d->failed).arg(d->bytesFetched / 1024)
+           .arg(finished > 0 ? d->totalWait / finished : 0).arg(d->longestWait);
+}
+
+QString MediaManager::cacheStatistics() const
+{
+    return d->cache.statistics();
+}
+
+void MediaManager::slotOwnerDestroyed(QObject *owner)
+{
+    cancel(QString(), owner);
+}
+
+void MediaManager::slotSettingsChanged()
+{
+    d->cache.readSettings();
+    d->trimTimer.start();
+}
+
+void MediaManager::startLoading(const QString &remoteUrl, ImagePurpose purpose)
+{
+    if (d->jobs.contains(remoteUrl) || d->pending.contains(remoteUrl) || d->decodingUrls.contains(remoteUrl)) {
+        // Whatever is waited for is served once these are done
+        return;
+    }
+    const QString path = d->cache.entryPath(Private::cacheKey(remoteUrl, purpose), Private::cacheKind(purpose));
+    if (!QFile::exists(path)) {
+        d->cache.countMiss();
+        startFetch(remoteUrl);
+        return;
+    }
+    startReading(remoteUrl, purpose, path, false);
+}
+
+void MediaManager::startReading(const QString &remoteUrl, ImagePurpose purpose, const QString &path,
+                                bool touch)
+{
+    BackgroundJob *reader = new BackgroundJob([path, touch]() {
+        MediaCache::Entry entry = MediaCache::readEntry(path);
+        QVariantMap result;
+        if (!entry.data.isEmpty()) {
+            if (touch) {
+                entry.stored = QDateTime::currentDateTimeUtc();
+                MediaCache::writeEntry(path, entry);
+            }
+            result[QLatin1String("image")] = decodeImage(entry.data, QSize());
+            result[QLatin1String("etag")] = entry.etag;
+            result[QLatin1String("lastModified")] = entry.lastModified;
+            result[QLatin1String("stored")] = entry.stored;
+        }
+        return QVariant(result);
+    }, this);
+    d->decodings.insert(reader, qMakePair(remoteUrl, purpose));
+    ++d->decodingUrls[remoteUrl];
+    connect(reader, SIGNAL(finished(Choqok::BackgroundJob*)), this, SLOT(slotImageRead(Choqok::BackgroundJob*)));
+    reader->start();
+}
+
+void MediaManager::continueLoading(const QString &remoteUrl)
+{
+    if (d->decodingUrls.contains(remoteUrl)) {
+        return;
+    }
+    // Asked for in another size meanwhile
+    for (ImagePurpose purpose: d->wantedPurposes(remoteUrl)) {
+        startLoading(remoteUrl, purpose);
+    }
+}
+
+bool MediaManager::startFetch(const QString &remoteUrl)
+{
+    if (d->jobs.contains(remoteUrl) || d->pending.contains(remoteUrl)) {
+        ///The file is on the way, wait to download complete.
+        return true;
+    }
+    const QUrl srcUrl(remoteUrl);
+    if (!srcUrl.isValid()) {
+        deliverError(remoteUrl, i18n("The request failed. Cannot get image file."));
+        return false;
+    }
+    Private::PendingDownload download;
+    download.host = srcUrl.host();
+    download.waiting.start();
+    d->pending.insert(remoteUrl, download);
+    d->normalQueue.append(remoteUrl);
+    d->peakQueued = qMax(d->peakQueued, d->pending.count());
+    // Let the caller subscribe or prioritize before the first download starts
+    QTimer::singleShot(0, this, SLOT(startDownloads()));
+    return true;
+}
+
+void MediaManager::startDownloads()
+{
+    while (d->jobs.count() < MAX_DOWNLOADS) {
+        const QString remoteUrl = d->takeNextDownload();
+        if (remoteUrl.isEmpty()) {
+            break;
+        }
+        const Private::PendingDownload download = d->pending.take(remoteUrl);
+        const qint64 waited = download.waiting.elapsed();
+        d->totalWait += waited;
+        d->longestWait = qMax(d->longestWait, waited);
+
+        const QHash<QString, Private::Revalidation>::const_iterator revalidation = d->revalidations.constFind(remoteUrl);
+        const bool conditional = revalidation != d->revalidations.constEnd();
+        KIO::StoredTransferJob *job = KIO::storedGet(QUrl(remoteUrl), conditional ? KIO::Reload : KIO::NoReload,
+                                                     KIO::HideProgressInfo) ;
         if (!job) {
             qCCritical(CHOQOK) << "Cannot create a FileCopyJob!";
-            QString errMsg = i18n("Cannot create a KDE Job. Please check your installation.");
-            Q_EMIT fetchError(remoteUrl, errMsg);
-            return p;
+            ++d->failed;
+            d->revalidations.remove(remoteUrl);
+            deliverError(remoteUrl, i18n("Cannot create a KDE Job. Please check your installation."));
+            continue;
+        }
+        job->addMetaData(QStringLiteral("PropagateHttpHeader"), QStringLiteral("true"));
+        if (conditional) {
+            QStringList headers;
+            if (!revalidation->etag.isEmpty()) {
+                headers << QLatin1String("If-None-Match: ") + QLatin1String(revalidation->etag);
+            }
+            if (!revalidation->lastModified.isEmpty()) {
+                headers << QLatin1String("If-Modified-Since: ") + QLatin1String(revalidation->lastModified);
+            }
+            job->addMetaData(QStringLiteral("customHTTPHeader"), headers.join(QLatin1String("\r\n")));
         }
         d->queue.insert(job, remoteUrl);
+        d->jobs.insert(remoteUrl, job);
+        ++d->hostDownloads[download.host];
         connect(job, SIGNAL(result(KJob*)), this, SLOT(slotImageFetched(KJob*)));
         job->start();
     }
-    return p;
+}
+
+void MediaManager::deliverError(const QString &remoteUrl, const QString &errMsg)
+{
+    d->broadcastRequests.remove(remoteUrl);
+    Q_EMIT fetchError(remoteUrl, errMsg);
+    Private::notifyError(d->takeSubscribers(remoteUrl), remoteUrl, errMsg);
+}
+
+void MediaManager::startDecoding(const QString &remoteUrl, const QByteArray &data, ImagePurpose purpose,
+                                 const QByteArray &etag, const QByteArray &lastModified)
+{
+    const QSize bounds = Private::bounds(purpose);
+    const QString path = d->cache.entryPath(Private::cacheKey(remoteUrl, purpose), Private::cacheKind(purpose));
+    BackgroundJob *decoder = new BackgroundJob([data, bounds, path, etag, lastModified]() {
+        const QImage image = decodeImage(data, bounds);
+        if (!image.isNull()) {
+            MediaCache::Entry entry;
+            // Originals are stored as they came, everything else as the scaled down image
+            entry.data = bounds.isValid() ? encodeImage(image) : data;
+            entry.etag = etag;
+            entry.lastModified = lastModified;
+            entry.stored = QDateTime::currentDateTimeUtc();
+            MediaCache::writeEntry(path, entry);
+        }
+        return QVariant::fromValue(image);
+    }, this);
+    d->decodings.insert(decoder, qMakePair(remoteUrl, purpose));
+    ++d->decodingUrls[remoteUrl];
+    connect(decoder, SIGNAL(finished(Choqok::BackgroundJob*)), this, SLOT(slotImageDecoded(Choqok::BackgroundJob*)));
+    decoder->start();
 }
 
 void MediaManager::slotImageFetched(KJob *job)
 {
     KIO::StoredTransferJob *baseJob = qobject_cast<KIO::StoredTransferJob *>(job);
+    if (!d->queue.contains(job)) {
+        return;
+    }
     QString remote = d->queue.value(job);
-    d->queue.remove(job);
+    d->finishDownload(job, remote);
+    d->bytesFetched += baseJob->data().size();
+    startDownloads();
+    const Private::Revalidation revalidation = d->revalidations.take(remote);
 
     int responseCode = 0;
     if (baseJob->metaData().contains(QStringLiteral("responsecode"))) {
         responseCode = baseJob->queryMetaData(QStringLiteral("responsecode")).toInt();
     }
 
-    if (job->error() || (responseCode > 399 && responseCode < 600)) {
+    QList<ImagePurpose> purposes = d->wantedPurposes(remote);
+    for (ImagePurpose purpose: revalidation.purposes) {
+        if (!purposes.contains(purpose)) {
+            purposes.append(purpose);
+        }
+    }
+
+    if (responseCode == 304 && !job->error()) {
+        // Not modified, what's on disk is good for another while
+        ++d->downloaded;
+        d->cache.countNotModified();
+        for (ImagePurpose purpose: purposes) {
+            const QString path = d->cache.entryPath(Private::cacheKey(remote, purpose), Private::cacheKind(purpose));
+            startReading(remote, purpose, path, true);
+        }
+    } else if (job->error() || (responseCode > 399 && responseCode < 600)) {
         qCCritical(CHOQOK) << "Job error:" << job->error() << "\t" << job->errorString();
         qCCritical(CHOQOK) << "HTTP response code" << responseCode;
-        QString errMsg = i18n("Cannot download image from %1.", job->errorString());
-        Q_EMIT fetchError(remote, errMsg);
+        ++d->failed;
+        deliverError(remote, i18n("Cannot download image from %1.", job->errorString()));
+    } else {
+        ++d->downloaded;
+        const QString headers = baseJob->queryMetaData(QStringLiteral("HTTP-Headers"));
+        const QByteArray etag = headerValue(headers, QLatin1String("ETag"));
+        const QByteArray lastModified = headerValue(headers, QLatin1String("Last-Modified"));
+        // Decode once for every size that is waited for
+        for (ImagePurpose purpose: purposes) {
+            startDecoding(remote, baseJob->data(), purpose, etag, lastModified);
+        }
+    }
+
+    if (d->jobs.isEmpty() && d->pending.isEmpty()) {
+        qCDebug(CHOQOK) << downloadStatistics();
+        qCDebug(CHOQOK) << cacheStatistics();
+    }
+}
+
+void MediaManager::slotImageDecoded(BackgroundJob *job)
+{
+    const QPair<QString, ImagePurpose> decoding = d->decodings.take(job);
+    const QString &remote = decoding.first;
+    const ImagePurpose purpose = decoding.second;
+    if (--d->decodingUrls[remote] <= 0) {
+        d->decodingUrls.remove(remote);
+    }
+
+    const QImage image = job->result().value<QImage>();
+    if (image.isNull()) {
+        qCCritical(CHOQOK) << "Cannot decode image from" << remote;
+        const QString errMsg = i18n("The request failed. Cannot get image file.");
+        if (purpose == OriginalImage && d->broadcastRequests.remove(remote)) {
+            Q_EMIT fetchError(remote, errMsg);
+        }
+        Private::notifyError(d->takeSubscribers(remote, purpose), remote, errMsg);
     } else {
-        QPixmap p;
-        if (p.loadFromData(baseJob->data())) {
-            d->cache.insertPixmap(remote, p);
-            Q_EMIT imageFetched(remote, p);
-        } else {
-            qCCritical(CHOQOK) << "Cannot parse reply from " << baseJob->url().toDisplayString();
-            Q_EMIT fetchError(remote, i18n("The request failed. Cannot get image file."));
+        imageReady(remote, purpose, image);
+        d->trimTimer.start();
+    }
+    continueLoading(remote);
+}
+
+void MediaManager::slotImageRead(BackgroundJob *job)
+{
+    const QPair<QString, ImagePurpose> decoding = d->decodings.take(job);
+    const QString &remote = decoding.first;
+    const ImagePurpose purpose = decoding.second;
+    if (--d->decodingUrls[remote] <= 0) {
+        d->decodingUrls.remove(remote);
+    }
+
+    const QVariantMap result = job->result().toMap();
+    const QImage image = result.value(QLatin1String("image")).value<QImage>();
+    if (image.isNull()) {
+        // Gone or damaged, download it again
+        QFile::remove(d->cache.entryPath(Private::cacheKey(remote, purpose), Private::cacheKind(purpose)));
+        continueLoading(remote);
+        return;
+    }
+
+    d->cache.countDiskHit();
+    imageReady(remote, purpose, image);
+
+    MediaCache::Entry entry;
+    entry.stored = result.value(QLatin1String("stored")).toDateTime();
+    if (!d->cache.isFresh(entry) && !d->jobs.contains(remote) && !d->pending.contains(remote)) {
+        // Shown as it is, but asked for again in case it changed
+        Private::Revalidation &revalidation = d->revalidations[remote];
+        revalidation.etag = result.value(QLatin1String("etag")).toByteArray();
+        revalidation.lastModified = result.value(QLatin1String("lastModified")).toByteArray();
+        if (!revalidation.purposes.contains(purpose)) {
+            revalidation.purposes.append(purpose);
         }
+        startFetch(remote);
+    }
+    continueLoading(remote);
+}
+
+void MediaManager::imageReady(const QString &remoteUrl, ImagePurpose purpose, const QImage &image)
+{
+    // Only the conversion to a pixmap has to happen on the GUI thread
+    const QPixmap p = QPixmap::fromImage(image);
+    d->cache.insertPixmap(Private::cacheKey(remoteUrl, purpose), Private::cacheKind(purpose), p);
+    if (purpose == OriginalImage && d->broadcastRequests.remove(remoteUrl)) {
+        Q_EMIT imageFetched(remoteUrl, p);
     }
+    // Take the subscribers first, their slots may request or cancel other images
+    Private::notify(d->takeSubscribers(remoteUrl, purpose), remoteUrl, p);
+}
+
+void MediaManager::trimDiskCache()
+{
+    const QList<QPair<QString, qint64> > budgets = d->cache.diskBudgets();
+    BackgroundJob *trimmer = new BackgroundJob([budgets]() {
+        int removed = 0;
+        for (const QPair<QString, qint64> &budget: budgets) {
+            removed += MediaCache::trimDirectory(budget.first, budget.second);
+        }
+        return QVariant(removed);
+    }, this);
+    connect(trimmer, SIGNAL(finished(Choqok::BackgroundJob*)), this, SLOT(slotDiskCacheTrimmed(Choqok::BackgroundJob*)));
+    trimmer->start();
+}
+
+void MediaManager::slotDiskCacheTrimmed(BackgroundJob *job)
+{
+    d->cache.countDiskEvictions(job->result().toInt());
 }
 
 void MediaManager::clearImageCache()
@@ -182,26 +826,50 @@ void MediaManager::uploadMedium(const QUrl &localUrl, const QString &pluginId)
     if (!d->uploader) {
         return;
     }
-    KIO::StoredTransferJob *picJob = KIO::storedGet(localUrl, KIO::Reload, KIO::HideProgressInfo);
-    picJob->exec();
-    if (picJob->error()) {
-        qCritical() << "Job error:" << picJob->errorString();
-        KMessageBox::detailedError(UI::Global::mainWindow(), i18n("Uploading medium failed: cannot read the medium file."),
-                                   picJob->errorString());
-        return;
-    }
-    const QByteArray picData = picJob->data();
-    if (picData.count() == 0) {
-        qCritical() << "Cannot read the media file, please check if it exists.";
+    const QString path = localUrl.toLocalFile();
+    QFileInfo info(path);
+    if (path.isEmpty() || !info.isReadable() || info.size() == 0) {
+        qCCritical(CHOQOK) << "Cannot read the media file, please check if it exists:" << localUrl;
         KMessageBox::error(UI::Global::mainWindow(), i18n("Uploading medium failed: cannot read the medium file."));
         return;
     }
     connect(d->uploader, SIGNAL(mediumUploaded(QUrl,QString)),
-            this, SIGNAL(mediumUploaded(QUrl,QString)));
+            this, SIGNAL(mediumUploaded(QUrl,QString)), Qt::UniqueConnection);
     connect(d->uploader, SIGNAL(uploadingFailed(QUrl,QString)),
-            this, SIGNAL(mediumUploadFailed(QUrl,QString)));
+            this, SIGNAL(mediumUploadFailed(QUrl,QString)), Qt::UniqueConnection);
+    connect(d->uploader, SIGNAL(uploadProgress(QUrl,qint64,qint64)),
+            this, SIGNAL(mediumUploadProgress(QUrl,qint64,qint64)), Qt::UniqueConnection);
+    // Only the start of the file is read to find its type, the file itself is read while it's sent
     const QMimeDatabase db;
-    d->uploader->upload(localUrl, picData, db.mimeTypeForUrl(localUrl).name().toLocal8Bit());
+    d->uploader->upload(localUrl, db.mimeTypeForFile(path).name().toLocal8Bit());
+}
+
+void MediaManager::cancelUpload(const QUrl &localUrl)
+{
+    if (d->uploader) {
+        d->uploader->cancel(localUrl);
+    }
+}
+
+KIO::StoredTransferJob *MediaManager::postMultipart(const QUrl &url, MultipartBody *body)
+{
+    if (!body->isOpen() && !body->open(QIODevice::ReadOnly)) {
+        qCCritical(CHOQOK) << "Cannot open the request body:" << body->errorString();
+        delete body;
+        return nullptr;
+    }
+    // Big uploads are shown in the job tracker of the desktop, and can be cancelled there
+    const KIO::JobFlags flags = body->size() > TRACKED_UPLOAD_SIZE ? KIO::DefaultFlags : KIO::HideProgressInfo;
+    KIO::StoredTransferJob *job = KIO::storedHttpPost(body, url, body->size(), flags);
+    if (!job) {
+        qCCritical(CHOQOK) << "Cannot create a http POST request!";
+        delete body;
+        return nullptr;
+    }
+    body->setParent(job);
+    job->addMetaData(QStringLiteral("content-type"),
+                     QStringLiteral("Content-Type: ") + QLatin1String(body->contentType()));
+    return job;
 }
 
 QByteArray MediaManager::createMultipartFormData(const QMap< QString, QByteArray > &formdata,
@@ -33,10 +33,15 @@
 namespace KIO
 {
 class Job;
+class StoredTransferJob;
 }
 class KJob;
+class QImage;
 namespace Choqok
 {
+class BackgroundJob;
+class MultipartBody;
+
 /**
     @brief Media files manager!
     A simple and global way to fetch and cache images
@@ -50,6 +55,17 @@ public:
     enum ReturnMode {
         Sync = 0, Async
     };
+
+    /**
+     * What an image is shown as. Images are decoded at the size needed for it,
+     * and cached separately for each purpose.
+     */
+    enum ImagePurpose {
+        OriginalImage = 0,  ///< Full size
+        AvatarImage,        ///< At most 48x48
+        PreviewImage,       ///< At most 200x200, for thumbnails in posts
+        PostImage           ///< At most 1024 wide, for images attached to posts
+    };
     ~MediaManager();
 
     static MediaManager *self();
@@ -58,15 +74,67 @@ public:
      * @brief Fetch an Image and cache it for later use.
      *
      * @param remoteUrl The URL of image to fetch
-     * @param mode Return mode, if set to Sync and the image is not available in the cache the null pixmap will be returned.
-     * if mode set to @ref Async and image is not available in the cache, the null pixmap will be returned
-     * and then @ref MediaManager will fetch the image and emit @ref imageFetched() on success or
-     * emit @ref fetchError() on error.
-     * And if mode set to @ref Sync and image is not in the cache @ref MediaManager will not fetch it.
+     * @param mode Return mode, if set to Sync and the image is not available in the memory cache the null pixmap will be returned.
+     * if mode set to @ref Async and image is not available in the memory cache, the null pixmap will be returned
+     * and then @ref MediaManager will read it from the disk cache or fetch the image and emit @ref imageFetched()
+     * on success or emit @ref fetchError() on error.
+     * And if mode set to @ref Sync and image is not in the memory cache @ref MediaManager will not load it,
+     * so it never blocks on disk access. Use @ref request() to get it anyway.
+     * @param purpose The cached size to look for, signals are emitted for @ref OriginalImage only
      *
      * @return return @ref QPixmap of requested image if exists in cache, otherwise null pixmap
      */
-    QPixmap fetchImage(const QString &remoteUrl, ReturnMode mode = Sync);
+    QPixmap fetchImage(const QString &remoteUrl, ReturnMode mode = Sync, ImagePurpose purpose = OriginalImage);
+
+    /**
+     * @brief Fetch an image for @p receiver only
+     *
+     * Unlike @ref fetchImage() with @ref Async mode, the result is not broadcast to everyone listening to
+     * @ref imageFetched(), but delivered to the subscribers of @p remoteUrl only.
+     * Several requests for the same URL share one download.
+     * Downloads are queued, and only a few of them run at the same time, see @ref prioritize().
+     *
+     * @param remoteUrl The URL of image to fetch
+     * @param receiver The object to deliver the image to
+     * @param member A slot of @p receiver, like SLOT(imageFetched(QString,QPixmap))
+     * @param errorMember An optional slot of @p receiver, like SLOT(fetchError(QString,QString)),
+     * called when the image could not be fetched
+     * @param purpose The size the image is wanted in, it's decoded at that size in a background thread
+     * @param owner The object the image is shown in, @p receiver if null. Subscriptions are cancelled and
+     * prioritized by owner, and end when it's destroyed. Plugins fetching images for a post pass its widget.
+     *
+     * @return true if the image was in the cache and @p member was called before returning
+     *
+     * @see cancel()
+     */
+    bool request(const QString &remoteUrl, QObject *receiver, const char *member,
+                 const char *errorMember = nullptr, ImagePurpose purpose = OriginalImage,
+                 QObject *owner = nullptr);
+
+    /**
+     * @brief End the subscriptions owned by @p owner for @p remoteUrl, or for all URLs if it's empty
+     *
+     * A download nobody waits for anymore is aborted.
+     */
+    void cancel(const QString &remoteUrl, QObject *owner);
+
+    /**
+     * @brief Download the queued images owned by @p owner before all others
+     *
+     * Meant for widgets which became visible, so that images on screen don't wait for those which aren't.
+     */
+    void prioritize(QObject *owner);
+
+    /**
+     * @return a human readable summary of the download queue: its depth, the time spent waiting
+     * in it and the amount of data fetched
+     */
+    QString downloadStatistics() const;
+
+    /**
+     * @return a human readable summary of the hits, misses and evictions of the memory and disk caches
+     */
+    QString cacheStatistics() const;
 
     /**
      * @return KDE Default image
@@ -82,15 +150,29 @@ public:
 
     /**
     Upload medium at @p localUrl to @p pluginId service or to last used service when @p pluginId is empty.
+    @p localUrl must be a local file, it's streamed to the service without being loaded into memory.
 
     @see mediumUploaded()
     @see mediumUploadFailed()
+    @see mediumUploadProgress()
+    @see cancelUpload()
     */
     void uploadMedium(const QUrl &localUrl, const QString &pluginId = QString());
 
+    /**
+    Create a job posting @p body to @p url. The body is read while it's sent, and deleted with the job.
+    Uploads of more than a megabyte are shown in the job tracker of the desktop, where they can be cancelled.
+
+    The job starts by itself, callers add their headers and connect to its result.
+    @return the job, or a null pointer if it couldn't be created (@p body is deleted then)
+    */
+    static KIO::StoredTransferJob *postMultipart(const QUrl &url, MultipartBody *body);
+
     /**
     Create and return a byte array containing a multipart/form-data to send with HTTP POST request
 
+    @deprecated It copies every medium into the returned array, use @ref MultipartBody instead
+
     Boundary is AaB03x
 
     @param formdata are the "form-data" parts of data.
@@ -112,20 +194,43 @@ public Q_SLOTS:
      */
     void clearImageCache();
 
+    /**
+     * @brief Abort the upload of @p localUrl started with @ref uploadMedium()
+     *
+     * @ref mediumUploadFailed() is emitted for it.
+     */
+    void cancelUpload(const QUrl &localUrl);
+
 Q_SIGNALS:
     void fetchError(const QString &remoteUrl, const QString &errMsg);
     void imageFetched(const QString &remoteUrl, const QPixmap &pixmap);
 
     void mediumUploaded(const QUrl &localUrl, const QString &remoteUrl);
     void mediumUploadFailed(const QUrl &localUrl, const QString &errorMessage);
+    void mediumUploadProgress(const QUrl &localUrl, qint64 sent, qint64 total);
 
 protected Q_SLOTS:
     void slotImageFetched(KJob *job);
+    void slotOwnerDestroyed(QObject *owner);
+    void startDownloads();
+    void slotImageDecoded(Choqok::BackgroundJob *job);
+    void slotImageRead(Choqok::BackgroundJob *job);
+    void slotSettingsChanged();
+    void trimDiskCache();
+    void slotDiskCacheTrimmed(Choqok::BackgroundJob *job);
 
 protected:
     MediaManager();
 
 private:
+    void startLoading(const QString &remoteUrl, ImagePurpose purpose);
+    void startReading(const QString &remoteUrl, ImagePurpose purpose, const QString &path, bool touch);
+    void continueLoading(const QString &remoteUrl);
+    bool startFetch(const QString &remoteUrl);
+    void startDecoding(const QString &remoteUrl, const QByteArray &data, ImagePurpose purpose,
+                       const QByteArray &etag, const QByteArray &lastModified);
+    void imageReady(const QString &remoteUrl, ImagePurpose purpose, const QImage &image);
+    void deliverError(const QString &remoteUrl, const QString &errMsg);
     class Private;
     Private *const d;
     static MediaManager *mSelf;
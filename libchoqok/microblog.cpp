@@ -45,11 +45,13 @@ public:
     QString homepage;
     QStringList timelineTypes;
     QTimer *saveTimelinesTimer;
+    bool streaming;
 };
 
 MicroBlog::MicroBlog(const QString &componentName, QObject *parent)
     : Plugin(componentName, parent), d(new Private)
 {
+    d->streaming = false;
     qCDebug(CHOQOK);
     d->saveTimelinesTimer = new QTimer(this);
     d->saveTimelinesTimer->setInterval(BehaviorSettings::notifyInterval() * 60000);
@@ -207,6 +209,11 @@ void MicroBlog::updateTimelines(Account *)
     qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
 }
 
+bool MicroBlog::updateTimeline(Account *, const QString &)
+{
+    return false;
+}
+
 QList< Post * > MicroBlog::loadTimeline(Account *, const QString &)
 {
     qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
@@ -218,6 +225,28 @@ void MicroBlog::saveTimeline(Account *, const QString &, const QList< UI::PostWi
     qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
 }
 
+void MicroBlog::savePosts(Account *account, const QString &timelineName, const QList< Post * > &posts)
+{
+    QList<UI::PostWidget *> timeline;
+    for (Post *post: posts) {
+        timeline.append(createPostWidget(account, post, nullptr));
+    }
+    saveTimeline(account, timelineName, timeline);
+    qDeleteAll(timeline);
+}
+
+bool MicroBlog::isStreamingPosts() const
+{
+    return d->streaming;
+}
+
+void MicroBlog::streamPosts(Account *theAccount, const QString &timelineName, const QList<Post *> &posts)
+{
+    d->streaming = true;
+    Q_EMIT timelineDataReceived(theAccount, timelineName, posts);
+    d->streaming = false;
+}
+
 QString MicroBlog::postUrl(Account *, const QString &, const QString &) const
 {
     qCWarning(CHOQOK) << "MicroBlog Plugin should implement this!";
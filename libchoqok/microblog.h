@@ -172,10 +172,24 @@ public:
     @brief Save a specific timeline!
     @Note Implementation of this is optional, i.e. One microblog may don't have timeline backup
 
+    @deprecated Reimplement savePosts(), TimelineWidget may not keep a widget for each post
     @see loadTimeline()
     */
     virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
                               const QList<UI::PostWidget *> &timeline);
+
+    /**
+    @brief Save the posts of a specific timeline!
+    This is what TimelineWidget calls to back up its posts.
+
+    Default implementation wraps @p posts in temporary widgets and calls saveTimeline(),
+    so microblogs which only reimplement that one keep working.
+
+    @see loadTimeline()
+    */
+    virtual void savePosts(Choqok::Account *account, const QString &timelineName,
+                           const QList<Choqok::Post *> &posts);
+
     /**
     @brief Load a specific timeline!
     @Note Implementation of this is optional, i.e. One microblog may don't have timeline backup
@@ -224,6 +238,17 @@ public:
     */
     virtual void updateTimelines(Choqok::Account *theAccount);
 
+    /**
+    Request to update only the timeline @p timelineName of account.
+    It will arrive with timelineDataReceived() signal!
+
+    @return false if this microblog can only update all timelines at once with updateTimelines(),
+    that is what the default implementation does.
+
+    @see UpdateScheduler
+    */
+    virtual bool updateTimeline(Choqok::Account *theAccount, const QString &timelineName);
+
     /**
     return Url to account page on service (Some kind of blog homepage)
     */
@@ -266,10 +291,17 @@ public:
 
     static QString errorString(ErrorType type);
 
+    /**
+    @return true while timelineDataReceived() delivers posts the server pushed, e.g. over a streaming API,
+    rather than the reply to updateTimeline() or updateTimelines()
+    */
+    bool isStreamingPosts() const;
+
 Q_SIGNALS:
 
     /**
     emit when data for a timeline received! @p type specifies the type of timeline as specifies in timelineTypes()
+    Replies to updateTimeline() and updateTimelines() are emitted even if they have no new posts.
     */
     void timelineDataReceived(Choqok::Account *theAccount, const QString &timelineName,
                               QList<Choqok::Post *> data);
@@ -316,6 +348,12 @@ protected:
     void setServiceName(const QString &);
     void setServiceHomepageUrl(const QString &);
 
+    /**
+    Emit timelineDataReceived() for @p posts the server pushed without being asked
+    @see isStreamingPosts()
+    */
+    void streamPosts(Choqok::Account *theAccount, const QString &timelineName, const QList<Choqok::Post *> &posts);
+
 protected Q_SLOTS:
     void slotConfigChanged();
 
@@ -0,0 +1,226 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "multipartbody.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QUuid>
+
+#include <cstring>
+
+#include <KLocalizedString>
+
+#include "libchoqokdebug.h"
+
+namespace Choqok
+{
+
+class MultipartBody::Private
+{
+public:
+    Private()
+        : size(0), finished(false)
+    {}
+
+    /// Either bytes in memory, or a file which is read when its part is sent
+    struct Part {
+        QByteArray data;
+        QFile *file;
+        qint64 offset;
+        qint64 size;
+    };
+
+    void append(const QByteArray &bytes)
+    {
+        if (!parts.isEmpty() && !parts.last().file) {
+            parts.last().data += bytes;
+            parts.last().size += bytes.size();
+        } else {
+            Part part;
+            part.data = bytes;
+            part.file = nullptr;
+            part.offset = 0;
+            part.size = bytes.size();
+            parts.append(part);
+        }
+        size += bytes.size();
+    }
+
+    void appendFile(QFile *file)
+    {
+        Part part;
+        part.file = file;
+        part.offset = 0;
+        part.size = file->size();
+        parts.append(part);
+        size += part.size;
+    }
+
+    /// Quotes and line breaks can't be part of a quoted header value
+    static QByteArray quoted(const QString &value)
+    {
+        QByteArray result = value.toUtf8();
+        result.replace('"', "%22").replace('\r', "%0D").replace('\n', "%0A");
+        return '"' + result + '"';
+    }
+
+    QByteArray header(const QString &name) const
+    {
+        return "--" + boundary + "\r\nContent-Disposition: form-data; name=" + quoted(name);
+    }
+
+    QByteArray boundary;
+    QList<Part> parts;
+    qint64 size;
+    bool finished;
+};
+
+MultipartBody::MultipartBody(QObject *parent)
+    : QIODevice(parent), d(new Private)
+{
+    d->boundary = "choqok" + QUuid::createUuid().toRfc4122().toHex();
+}
+
+MultipartBody::~MultipartBody()
+{
+    delete d;
+}
+
+void MultipartBody::addField(const QString &name, const QByteArray &value)
+{
+    if (d->finished) {
+        qCWarning(CHOQOK) << "Body was opened already, cannot add" << name;
+        return;
+    }
+    d->append(d->header(name) + "\r\n\r\n" + value + "\r\n");
+}
+
+void MultipartBody::addData(const QString &name, const QString &fileName, const QByteArray &mediumType,
+                            const QByteArray &data)
+{
+    if (d->finished) {
+        qCWarning(CHOQOK) << "Body was opened already, cannot add" << name;
+        return;
+    }
+    d->append(d->header(name) + "; filename=" + Private::quoted(fileName) +
+              "\r\nContent-Type: " + mediumType + "\r\n\r\n" + data + "\r\n");
+}
+
+bool MultipartBody::addFile(const QString &name, const QString &filePath, const QByteArray &mediumType,
+                            const QString &fileName)
+{
+    if (d->finished) {
+        qCWarning(CHOQOK) << "Body was opened already, cannot add" << name;
+        return false;
+    }
+    QFile *file = new QFile(filePath, this);
+    if (!file->open(QIODevice::ReadOnly)) {
+        setErrorString(i18n("Cannot read %1: %2", filePath, file->errorString()));
+        delete file;
+        return false;
+    }
+    const QString partFileName = fileName.isEmpty() ? QFileInfo(filePath).fileName() : fileName;
+    d->append(d->header(name) + "; filename=" + Private::quoted(partFileName) +
+              "\r\nContent-Type: " + mediumType + "\r\n\r\n");
+    d->appendFile(file);
+    d->append("\r\n");
+    return true;
+}
+
+QByteArray MultipartBody::contentType() const
+{
+    return "multipart/form-data; boundary=" + d->boundary;
+}
+
+bool MultipartBody::open(OpenMode mode)
+{
+    if (mode != QIODevice::ReadOnly) {
+        setErrorString(i18n("A request body can only be read."));
+        return false;
+    }
+    if (!d->finished) {
+        d->append("--" + d->boundary + "--\r\n");
+        d->finished = true;
+        qint64 offset = 0;
+        for (Private::Part &part: d->parts) {
+            part.offset = offset;
+            offset += part.size;
+        }
+    }
+    return QIODevice::open(mode);
+}
+
+bool MultipartBody::isSequential() const
+{
+    return false;
+}
+
+qint64 MultipartBody::size() const
+{
+    return d->size;
+}
+
+qint64 MultipartBody::readData(char *data, qint64 maxSize)
+{
+    qint64 position = pos();
+    qint64 read = 0;
+    for (const Private::Part &part: d->parts) {
+        if (read >= maxSize) {
+            break;
+        }
+        if (position >= part.offset + part.size) {
+            continue;
+        }
+        const qint64 inPart = position - part.offset;
+        const qint64 wanted = qMin(maxSize - read, part.size - inPart);
+        qint64 got = wanted;
+        if (part.file) {
+            if (part.file->pos() != inPart && !part.file->seek(inPart)) {
+                got = -1;
+            } else {
+                got = part.file->read(data + read, wanted);
+            }
+            if (got < wanted) {
+                // The file was changed or removed since it was added
+                setErrorString(i18n("Cannot read %1: %2", part.file->fileName(), part.file->errorString()));
+                return read > 0 ? read : -1;
+            }
+        } else {
+            memcpy(data + read, part.data.constData() + inPart, wanted);
+        }
+        read += got;
+        position += got;
+    }
+    return read;
+}
+
+qint64 MultipartBody::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef MULTIPARTBODY_H
+#define MULTIPARTBODY_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+
+/**
+@brief A multipart/form-data request body, read straight from the files it contains
+
+Fields are kept in memory, files are only opened and read piece by piece while the body
+is sent, so uploading a big medium doesn't copy it into memory.
+
+Usage:
+@code
+Choqok::MultipartBody *body = new Choqok::MultipartBody;
+body->addField(QLatin1String("status"), text.toUtf8());
+if (!body->addFile(QLatin1String("media"), localUrl.toLocalFile(), mediumType)) {
+    // report body->errorString()
+}
+KIO::StoredTransferJob *job = Choqok::MediaManager::postMultipart(url, body);
+@endcode
+
+The body can't be changed anymore once it was opened.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT MultipartBody : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit MultipartBody(QObject *parent = nullptr);
+    ~MultipartBody();
+
+    void addField(const QString &name, const QByteArray &value);
+
+    /**
+    Add a file part with @p data as its content, for media which are in memory anyway
+    */
+    void addData(const QString &name, const QString &fileName, const QByteArray &mediumType,
+                 const QByteArray &data);
+
+    /**
+    Add a file part read from @p filePath, named @p fileName or after the file if that's empty
+    @return false if the file can't be read, @ref errorString() tells why
+    */
+    bool addFile(const QString &name, const QString &filePath, const QByteArray &mediumType,
+                 const QString &fileName = QString());
+
+    /**
+    @return the value of the Content-Type header for this body, with its boundary
+    */
+    QByteArray contentType() const;
+
+    /**
+    Opening for reading only is supported
+    */
+    bool open(OpenMode mode) override;
+    bool isSequential() const override;
+    qint64 size() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // MULTIPARTBODY_H
@@ -0,0 +1,500 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "postbackupstore.h"
+
+#include <QApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include <algorithm>
+
+#include "accountmanager.h"
+#include "application.h"
+#include "libchoqokdebug.h"
+
+namespace Choqok
+{
+
+static const quint32 STORE_MAGIC = 0x43504253; // "CPBS"
+static const quint32 STORE_VERSION = 1;
+static const int STREAM_VERSION = QDataStream::Qt_5_6;
+
+/// Don't bother compacting logs with less superseded records than this
+static const int MIN_GARBAGE_RECORDS = 64;
+
+enum RecordType {
+    PutRecord = 1,
+    RemoveRecord = 2
+};
+
+static QByteArray serializePost(const Post *post)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    out << post->creationDateTime << post->postId << post->link << post->content << post->source
+        << post->replyToPostId << post->replyToUserId << post->isFavorited << post->replyToUserName
+        << post->author.userId << post->author.realName << post->author.userName
+        << post->author.location << post->author.description << post->author.profileImageUrl
+        << post->author.homePageUrl << post->author.isProtected
+        << post->type << post->isPrivate << post->isRead
+        << post->repeatedFromUsername << post->repeatedPostId << post->repeatedDateTime
+        << post->conversationId << post->media
+        << post->quotedPost.username << post->quotedPost.profileImageUrl
+        << post->quotedPost.postId << post->quotedPost.content;
+    return data;
+}
+
+static bool deserializePost(const QByteArray &data, Post *post)
+{
+    QDataStream in(data);
+    in.setVersion(STREAM_VERSION);
+    in >> post->creationDateTime >> post->postId >> post->link >> post->content >> post->source
+       >> post->replyToPostId >> post->replyToUserId >> post->isFavorited >> post->replyToUserName
+       >> post->author.userId >> post->author.realName >> post->author.userName
+       >> post->author.location >> post->author.description >> post->author.profileImageUrl
+       >> post->author.homePageUrl >> post->author.isProtected
+       >> post->type >> post->isPrivate >> post->isRead
+       >> post->repeatedFromUsername >> post->repeatedPostId >> post->repeatedDateTime
+       >> post->conversationId >> post->media
+       >> post->quotedPost.username >> post->quotedPost.profileImageUrl
+       >> post->quotedPost.postId >> post->quotedPost.content;
+    return in.status() == QDataStream::Ok;
+}
+
+static void writeHeader(QDataStream &out)
+{
+    out << STORE_MAGIC << STORE_VERSION;
+}
+
+/**
+Writes a compacted log to the temporary file of @p file, the store commits it on the main thread.
+*/
+class CompactionTask : public QRunnable
+{
+public:
+    CompactionTask(PostBackupStore *store, QSaveFile *file, const QByteArray &data, int generation,
+                   QSemaphore *finished)
+        : store(store), file(file), data(data), generation(generation), finished(finished)
+    {}
+
+    virtual void run() override
+    {
+        const bool success = file->write(data) == data.size() && file->flush();
+        QMetaObject::invokeMethod(store, "slotCompactionDone", Qt::QueuedConnection,
+                                  Q_ARG(int, generation), Q_ARG(bool, success));
+        // Store and file must outlive us until here
+        finished->release();
+    }
+
+private:
+    PostBackupStore *store;
+    QSaveFile *file;
+    QByteArray data;
+    int generation;
+    QSemaphore *finished;
+};
+
+/// Where the serialized post of a record is in the log
+struct Record {
+    qint64 offset;
+    int size;
+};
+
+class PostBackupStore::Private
+{
+public:
+    Private()
+        : records(0), loaded(false), generation(0), compaction(nullptr), mapped(nullptr)
+    {}
+
+    /**
+    Make the content of the log file available in log, memory mapped if possible
+    */
+    bool mapLog();
+    void unmapLog();
+
+    /// The serialized post of @p record, without copying it, or a null array if the log is shorter
+    QByteArray recordData(const Record &record) const;
+
+    QString alias;
+    QString timelineName;
+    QString fileName;
+    QHash<QString, Record> live;     // <postId, latest record>
+    int records;                     // records in the log, including superseded ones
+    bool loaded;
+    int generation;                  // bumped on every append, to detect outdated compactions
+    QSaveFile *compaction;           // compacted log being written, if any
+    QHash<QString, Record> compactedLive; // live, as it is in the compacted log
+    QSemaphore compactionFinished;   // released when the task writing compaction is done with us
+
+    QFile file;
+    uchar *mapped;
+    QByteArray log;                  // the mapped file, or its content if it could not be mapped
+};
+
+bool PostBackupStore::Private::mapLog()
+{
+    unmapLog();
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 size = file.size();
+    mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (mapped) {
+        log = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(size));
+    } else {
+        log = file.readAll();
+    }
+    return true;
+}
+
+void PostBackupStore::Private::unmapLog()
+{
+    log.clear();
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    file.close();
+}
+
+QByteArray PostBackupStore::Private::recordData(const Record &record) const
+{
+    if (record.offset < 0 || record.offset + record.size > log.size()) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(log.constData() + record.offset, record.size);
+}
+
+typedef QHash<QString, PostBackupStore *> StoreHash;
+Q_GLOBAL_STATIC(StoreHash, stores)
+
+static QString storeFileName(const QString &alias, const QString &timelineName)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation) + QLatin1Char('/') +
+           AccountManager::generatePostBackupFileName(alias, timelineName) + QLatin1String(".bin");
+}
+
+PostBackupStore::PostBackupStore(const QString &alias, const QString &timelineName)
+    : QObject(qApp), d(new Private)
+{
+    d->alias = alias;
+    d->timelineName = timelineName;
+    d->fileName = storeFileName(alias, timelineName);
+}
+
+PostBackupStore::~PostBackupStore()
+{
+    d->unmapLog();
+    if (d->compaction) {
+        // The task refers to us, make sure it's done before going away
+        d->compactionFinished.acquire();
+        delete d->compaction;
+    }
+    stores()->remove(d->fileName);
+    delete d;
+}
+
+PostBackupStore *PostBackupStore::store(const QString &alias, const QString &timelineName)
+{
+    const QString fileName = storeFileName(alias, timelineName);
+    PostBackupStore *store = stores()->value(fileName);
+    if (!store) {
+        store = new PostBackupStore(alias, timelineName);
+        stores()->insert(fileName, store);
+    }
+    return store;
+}
+
+void PostBackupStore::removeStore(const QString &alias, const QString &timelineName)
+{
+    const QString fileName = storeFileName(alias, timelineName);
+    delete stores()->take(fileName);
+    QFile::remove(fileName);
+}
+
+bool PostBackupStore::exists() const
+{
+    return QFile::exists(d->fileName);
+}
+
+void PostBackupStore::readLog()
+{
+    d->live.clear();
+    d->records = 0;
+    d->loaded = true;
+
+    if (!d->mapLog()) {
+        return;
+    }
+
+    const qint64 size = d->log.size();
+    QDataStream in(d->log);
+    in.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != STORE_MAGIC || version > STORE_VERSION) {
+        // Keep it aside instead of appending to something we can't read
+        qCWarning(CHOQOK) << "Unknown post backup format in" << d->fileName;
+        d->unmapLog();
+        const QString unknownFileName = d->fileName + QLatin1String(".unknown");
+        QFile::remove(unknownFileName);
+        QFile::rename(d->fileName, unknownFileName);
+        return;
+    }
+
+    // Only index the records, posts are decoded from the log when they are needed
+    qint64 validSize = in.device()->pos();
+    while (!in.atEnd()) {
+        quint8 type = 0;
+        QString postId;
+        Record record = { 0, 0 };
+        in >> type >> postId;
+        if (type == PutRecord) {
+            // The serialized post is a QByteArray, its size followed by the data
+            quint32 dataSize = 0;
+            in >> dataSize;
+            record.offset = in.device()->pos();
+            record.size = dataSize == 0xffffffff ? 0 : int(dataSize);
+            if (in.skipRawData(record.size) != record.size) {
+                in.setStatus(QDataStream::ReadPastEnd);
+            }
+        }
+        if (in.status() != QDataStream::Ok || (type != PutRecord && type != RemoveRecord)) {
+            break;
+        }
+        if (type == PutRecord) {
+            d->live.insert(postId, record);
+        } else {
+            d->live.remove(postId);
+        }
+        ++d->records;
+        validSize = in.device()->pos();
+    }
+
+    d->unmapLog();
+
+    if (validSize < size) {
+        // Interrupted write, drop the partial record so new ones are appended to a valid log
+        qCWarning(CHOQOK) << "Truncating damaged post backup" << d->fileName << "to" << validSize << "bytes";
+        QFile::resize(d->fileName, validSize);
+    }
+}
+
+QList<Post *> PostBackupStore::load(PostFactory createPost)
+{
+    readLog();
+
+    QList<Post *> list;
+    if (d->live.isEmpty() || !d->mapLog()) {
+        return list;
+    }
+    for (QHash<QString, Record>::const_iterator it = d->live.constBegin(); it != d->live.constEnd(); ++it) {
+        const QByteArray data = d->recordData(it.value());
+        Post *post = createPost ? createPost() : new Post;
+        if (!data.isNull() && deserializePost(data, post)) {
+            list.append(post);
+        } else {
+            delete post;
+        }
+    }
+    d->unmapLog();
+
+    std::stable_sort(list.begin(), list.end(), [](const Post *a, const Post *b) {
+        return a->creationDateTime < b->creationDateTime;
+    });
+    qCDebug(CHOQOK) << list.count() << "posts loaded from" << d->fileName;
+    return list;
+}
+
+void PostBackupStore::save(const QList<Post *> &posts)
+{
+    if (!d->loaded) {
+        readLog();
+    } else if (!exists()) {
+        // Removed behind our back, write all posts again
+        d->live.clear();
+        d->records = 0;
+    }
+
+    QByteArray records;
+    QDataStream out(&records, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    int count = 0;
+    QList<QPair<QString, Record> > appended; // offsets relative to the start of records
+
+    // Compare with the records in the log, posts which didn't change aren't written again
+    d->mapLog();
+    QSet<QString> current;
+    for (const Post *post: posts) {
+        const QByteArray data = serializePost(post);
+        current.insert(post->postId);
+        QHash<QString, Record>::const_iterator it = d->live.constFind(post->postId);
+        if (it == d->live.constEnd() || d->recordData(it.value()) != data) {
+            out << quint8(PutRecord) << post->postId;
+            const Record record = { out.device()->pos() + qint64(sizeof(quint32)), data.size() };
+            out << data;
+            appended.append(qMakePair(post->postId, record));
+            ++count;
+        }
+    }
+    d->unmapLog();
+    for (QHash<QString, Record>::iterator it = d->live.begin(); it != d->live.end();) {
+        if (current.contains(it.key())) {
+            ++it;
+        } else {
+            out << quint8(RemoveRecord) << it.key();
+            it = d->live.erase(it);
+            ++count;
+        }
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(d->fileName).absolutePath());
+    QFile file(d->fileName);
+    const bool isNew = !file.exists() || file.size() == 0;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(CHOQOK) << "Cannot open post backup" << d->fileName << file.errorString();
+        // Our idea of the log is wrong now, read it again next time
+        d->loaded = false;
+        return;
+    }
+    if (isNew) {
+        QDataStream header(&file);
+        header.setVersion(STREAM_VERSION);
+        writeHeader(header);
+        d->records = 0;
+    }
+    const qint64 base = file.size();
+    if (file.write(records) != records.size()) {
+        qCWarning(CHOQOK) << "Cannot write post backup" << d->fileName << file.errorString();
+        d->loaded = false;
+    }
+    file.close();
+
+    for (const QPair<QString, Record> &record: appended) {
+        const Record inLog = { base + record.second.offset, record.second.size };
+        d->live.insert(record.first, inLog);
+    }
+    d->records += count;
+    ++d->generation;
+    qCDebug(CHOQOK) << count << "records appended to" << d->fileName;
+
+    if (d->records - d->live.count() > qMax(d->live.count(), MIN_GARBAGE_RECORDS) &&
+        !Application::isShuttingDown()) {
+        compact();
+    }
+}
+
+void PostBackupStore::compact()
+{
+    if (d->compaction || !d->mapLog()) {
+        return;
+    }
+
+    QSaveFile *file = new QSaveFile(d->fileName);
+    if (!file->open(QIODevice::WriteOnly)) {
+        qCWarning(CHOQOK) << "Cannot compact post backup" << d->fileName << file->errorString();
+        delete file;
+        d->unmapLog();
+        return;
+    }
+    d->compaction = file;
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    writeHeader(out);
+    d->compactedLive.clear();
+    for (QHash<QString, Record>::const_iterator it = d->live.constBegin(); it != d->live.constEnd(); ++it) {
+        const QByteArray post = d->recordData(it.value());
+        if (post.isNull()) {
+            continue;
+        }
+        out << quint8(PutRecord) << it.key();
+        const Record record = { out.device()->pos() + qint64(sizeof(quint32)), post.size() };
+        out << post;
+        d->compactedLive.insert(it.key(), record);
+    }
+    d->unmapLog();
+
+    QThreadPool::globalInstance()->start(new CompactionTask(this, file, data, d->generation,
+                                                            &d->compactionFinished));
+}
+
+void PostBackupStore::slotCompactionDone(int generation, bool success)
+{
+    // The task may not have released it yet, it's about to
+    d->compactionFinished.acquire();
+    QSaveFile *file = d->compaction;
+    d->compaction = nullptr;
+
+    if (!success || generation != d->generation) {
+        // Failed, or posts were appended meanwhile, try again on a later save
+        file->cancelWriting();
+    } else if (file->commit()) {
+        // Atomically replaced the log, the old one stays in place if anything went wrong
+        d->live = d->compactedLive;
+        d->records = d->live.count();
+        qCDebug(CHOQOK) << "Compacted" << d->fileName;
+    } else {
+        qCWarning(CHOQOK) << "Cannot replace post backup" << d->fileName << file->errorString();
+    }
+    delete file;
+    d->compactedLive.clear();
+}
+
+bool PostBackupStore::hasLegacyBackup() const
+{
+    return !QStandardPaths::locate(QStandardPaths::DataLocation,
+                                   AccountManager::generatePostBackupFileName(d->alias, d->timelineName)).isEmpty();
+}
+
+void PostBackupStore::removeLegacyBackup()
+{
+    const QString fileName = QStandardPaths::locate(QStandardPaths::DataLocation,
+                             AccountManager::generatePostBackupFileName(d->alias, d->timelineName));
+    if (!fileName.isEmpty()) {
+        qCDebug(CHOQOK) << "Removing migrated backup" << fileName;
+        QFile::remove(fileName);
+    }
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef POSTBACKUPSTORE_H
+#define POSTBACKUPSTORE_H
+
+#include <QList>
+#include <QObject>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+namespace Choqok
+{
+
+/**
+@brief Binary backup of the posts of a timeline
+
+Posts are kept in an append-only log: saving a timeline only appends records for posts
+which are new or changed since the last save, and removal records for posts which left
+the timeline. When most of the log is superseded records, it's compacted in a worker thread.
+
+The store only keeps an index of where the latest record of each post is in the log, no
+post data. Loading decodes those records straight from the memory mapped file, superseded
+ones are skipped without being read, and saving compares posts with them in place.
+
+The file lives next to the KConfig backup of older versions, named after
+@ref AccountManager::generatePostBackupFileName(). Use @ref hasLegacyBackup() and
+@ref removeLegacyBackup() to migrate those once.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT PostBackupStore : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+    Creates an empty post of the microblog specific type, to be filled by @ref load()
+    */
+    typedef Post *(*PostFactory)();
+
+    ~PostBackupStore();
+
+    /**
+    @return the store of timeline @p timelineName of account @p alias
+    */
+    static PostBackupStore *store(const QString &alias, const QString &timelineName);
+
+    /**
+    Delete the store of timeline @p timelineName of account @p alias, e.g. on account removal
+    */
+    static void removeStore(const QString &alias, const QString &timelineName);
+
+    /**
+    @return true if there is a backup file for this timeline
+    */
+    bool exists() const;
+
+    /**
+    @brief Read all posts of this timeline, sorted by creation time, oldest first
+
+    @param createPost used to create the posts, plain @ref Post objects if it's null
+    */
+    QList<Post *> load(PostFactory createPost = nullptr);
+
+    /**
+    @brief Make @p posts the content of this timeline backup
+
+    Only differences to the last saved state are written.
+    */
+    void save(const QList<Post *> &posts);
+
+    /**
+    @return true if there is a KConfig based backup of an older Choqok version
+    */
+    bool hasLegacyBackup() const;
+
+    /**
+    Delete the KConfig based backup after its posts were migrated to this store
+    */
+    void removeLegacyBackup();
+
+protected Q_SLOTS:
+    void slotCompactionDone(int generation, bool success);
+
+protected:
+    PostBackupStore(const QString &alias, const QString &timelineName);
+
+private:
+    void readLog();
+    void compact();
+
+    class Private;
+    Private *const d;
+};
+
+}
+
+#endif // POSTBACKUPSTORE_H
@@ -0,0 +1,297 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+#include "poststore.h"
+
+#include <QApplication>
+#include <QHash>
+#include <QMetaMethod>
+#include <QPointer>
+#include <QThread>
+#include <QUrl>
+
+#include "account.h"
+#include "choqoktypes.h"
+#include "libchoqokdebug.h"
+#include "microblog.h"
+
+namespace Choqok
+{
+
+class PostStore::Private
+{
+public:
+    Private()
+        : duplicatePosts(0), sharedUsers(0)
+    {}
+
+    struct UserEntry {
+        User user;
+        int posts;      // count of kept posts by this user
+    };
+
+    struct PostEntry {
+        Account *account;
+        QString postId;
+        QString userKey;
+    };
+
+    struct Subscriber {
+        QPointer<QObject> receiver;
+        QMetaMethod method;
+    };
+
+    static QMetaMethod findMethod(QObject *receiver, const char *member)
+    {
+        // Skip the code SLOT() puts in front of the signature
+        const QByteArray signature = QMetaObject::normalizedSignature(member + 1);
+        const int index = receiver->metaObject()->indexOfMethod(signature.constData());
+        if (index < 0) {
+            qCCritical(CHOQOK) << "No such method" << signature << "in" << receiver->metaObject()->className();
+            return QMetaMethod();
+        }
+        return receiver->metaObject()->method(index);
+    }
+
+    /// Copies what the server knows better from @p fresh to @p known, keeping local state like isRead
+    static int merge(Post *known, const Post *fresh)
+    {
+        int changes = NoChange;
+        if (known->isFavorited != fresh->isFavorited || known->isPrivate != fresh->isPrivate) {
+            known->isFavorited = fresh->isFavorited;
+            known->isPrivate = fresh->isPrivate;
+            changes |= StateChanged;
+        }
+        if (known->content != fresh->content) {
+            known->content = fresh->content;
+            // Entities and annotations point into the old content
+            known->entities = fresh->entities;
+            known->annotations.clear();
+            changes |= ContentChanged;
+        }
+        if (known->media != fresh->media || known->quotedPost.postId != fresh->quotedPost.postId ||
+                known->quotedPost.content != fresh->quotedPost.content ||
+                known->repeatedPostId != fresh->repeatedPostId) {
+            known->media = fresh->media;
+            known->quotedPost = fresh->quotedPost;
+            known->repeatedFromUsername = fresh->repeatedFromUsername;
+            known->repeatedPostId = fresh->repeatedPostId;
+            known->repeatedDateTime = fresh->repeatedDateTime;
+            changes |= ContentChanged;
+        }
+        if (!sameUser(known->author, fresh->author)) {
+            known->author = fresh->author;
+            changes |= ContentChanged;
+        }
+        return changes;
+    }
+
+    /// Users are the same on all accounts of one server, their profile URL tells it apart
+    static QString userKey(Account *account, const User &user)
+    {
+        if (user.userName.isEmpty() && user.userId.isEmpty()) {
+            return QString();
+        }
+        const QUrl url = account->microblog()->profileUrl(account, user);
+        if (url.isEmpty()) {
+            return QString();
+        }
+        return account->microblog()->pluginId() + QLatin1Char(' ') + url.toString();
+    }
+
+    static bool sameUser(const User &a, const User &b)
+    {
+        return a.userId == b.userId && a.userName == b.userName && a.realName == b.realName &&
+               a.location == b.location && a.description == b.description &&
+               a.profileImageUrl == b.profileImageUrl && a.homePageUrl == b.homePageUrl &&
+               a.isProtected == b.isProtected && a.followersCount == b.followersCount;
+    }
+
+    QHash<Account *, QHash<QString, Post *> > posts;
+    QHash<Post *, PostEntry> entries;
+    QHash<QString, UserEntry> users;
+    QHash<Post *, QList<Subscriber> > subscribers;
+    int duplicatePosts;
+    int sharedUsers;
+};
+
+PostStore *PostStore::mSelf = nullptr;
+
+PostStore::PostStore()
+    : QObject(qApp), d(new Private)
+{
+}
+
+PostStore::~PostStore()
+{
+    delete d;
+    mSelf = nullptr;
+}
+
+PostStore *PostStore::self()
+{
+    if (!mSelf) {
+        mSelf = new PostStore;
+    }
+    return mSelf;
+}
+
+Post *PostStore::intern(Account *account, Post *post)
+{
+    if (!account || !post || post->postId.isEmpty() || d->entries.contains(post)) {
+        return post;
+    }
+
+    QHash<QString, Post *> &accountPosts = d->posts[account];
+    Post *known = accountPosts.value(post->postId);
+    if (known) {
+        ++d->duplicatePosts;
+        const int changes = Private::merge(known, post);
+        if (post->owners == 0) {
+            delete post;
+        }
+        if (changes != NoChange) {
+            const QString userKey = d->entries.value(known).userKey;
+            QHash<QString, Private::UserEntry>::iterator user = d->users.find(userKey);
+            if (user != d->users.end()) {
+                // A newer profile, later posts share this one
+                user->user = known->author;
+            }
+            notifyChanged(account, known, changes);
+        }
+        return known;
+    }
+
+    Private::PostEntry entry;
+    entry.account = account;
+    entry.postId = post->postId;
+    entry.userKey = Private::userKey(account, post->author);
+    if (!entry.userKey.isEmpty()) {
+        QHash<QString, Private::UserEntry>::iterator user = d->users.find(entry.userKey);
+        if (user == d->users.end()) {
+            Private::UserEntry userEntry;
+            userEntry.user = post->author;
+            userEntry.posts = 1;
+            d->users.insert(entry.userKey, userEntry);
+        } else {
+            if (Private::sameUser(user->user, post->author)) {
+                post->author = user->user;
+                ++d->sharedUsers;
+            } else {
+                // A newer profile, later posts share this one
+                user->user = post->author;
+            }
+            ++user->posts;
+        }
+    }
+    accountPosts.insert(post->postId, post);
+    d->entries.insert(post, entry);
+    return post;
+}
+
+Post *PostStore::find(Account *account, const QString &postId) const
+{
+    return d->posts.value(account).value(postId);
+}
+
+void PostStore::subscribe(Post *post, QObject *receiver, const char *member)
+{
+    if (!post || !receiver) {
+        return;
+    }
+    QList<Private::Subscriber> &list = d->subscribers[post];
+    for (int i = list.count() - 1; i >= 0; --i) {
+        if (list.at(i).receiver == receiver) {
+            return;
+        }
+        // Widgets of virtual timelines come and go, drop the ones which are gone
+        if (!list.at(i).receiver) {
+            list.removeAt(i);
+        }
+    }
+    Private::Subscriber subscriber;
+    subscriber.receiver = receiver;
+    subscriber.method = Private::findMethod(receiver, member);
+    list.append(subscriber);
+}
+
+void PostStore::notifyChanged(Account *account, Post *post, int changes)
+{
+    // Copy, the receivers may subscribe while being notified
+    const QList<Private::Subscriber> list = d->subscribers.value(post);
+    for (const Private::Subscriber &subscriber: list) {
+        if (subscriber.receiver) {
+            subscriber.method.invoke(subscriber.receiver, Qt::DirectConnection,
+                                     Q_ARG(Choqok::Account *, account), Q_ARG(Choqok::Post *, post),
+                                     Q_ARG(int, changes));
+        }
+    }
+}
+
+void PostStore::forget(Post *post)
+{
+    // Parsers create and delete posts in worker threads too, those were never kept
+    if (!mSelf || QThread::currentThread() != mSelf->thread()) {
+        return;
+    }
+    Private *d = mSelf->d;
+    d->subscribers.remove(post);
+    QHash<Post *, Private::PostEntry>::iterator it = d->entries.find(post);
+    if (it == d->entries.end()) {
+        return;
+    }
+
+    QHash<Account *, QHash<QString, Post *> >::iterator accountPosts = d->posts.find(it->account);
+    if (accountPosts != d->posts.end()) {
+        if (accountPosts->value(it->postId) == post) {
+            accountPosts->remove(it->postId);
+        }
+        if (accountPosts->isEmpty()) {
+            d->posts.erase(accountPosts);
+        }
+    }
+    if (!it->userKey.isEmpty()) {
+        QHash<QString, Private::UserEntry>::iterator user = d->users.find(it->userKey);
+        if (user != d->users.end() && --user->posts <= 0) {
+            d->users.erase(user);
+        }
+    }
+    d->entries.erase(it);
+}
+
+QString PostStore::statistics() const
+{
+    return QStringLiteral("%1 posts of %2 accounts, %3 users\n"
+                          "%4 duplicate posts dropped, %5 posts share the data of their author")
+           .arg(d->entries.count())
+           .arg(d->posts.count())
+           .arg(d->users.count())
+           .arg(d->duplicatePosts)
+           .arg(d->sharedUsers);
+}
+
+Post::~Post()
+{
+    PostStore::forget(this);
+}
+
+}
@@ -0,0 +1,114 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+#ifndef POSTSTORE_H
+#define POSTSTORE_H
+
+#include <QObject>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+
+class Account;
+class Post;
+
+/**
+@brief Keeps a single instance of each post of an account, and of the data of each user
+
+The same status often arrives in several timelines, e.g. Home, Favorites and search results.
+@ref TimelineWidget interns every new post here, so all its views share one @ref Post and
+count it in @ref Post::owners, instead of each keeping a copy.
+
+Posts are kept per account, as their state (favorited, read) depends on it.
+Authors are kept per service, so accounts on the same server share the data of a user,
+the strings of equal users are shared instead of copied.
+
+Views @ref subscribe() to the posts they show. Changes to a shared post, like its favorite or
+read state or a newer copy from the server, are delivered to the subscribers of that post only.
+Deleted posts are forgotten automatically.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT PostStore : public QObject
+{
+    Q_OBJECT
+public:
+    enum Change {
+        NoChange = 0,
+        StateChanged = 0x01,    ///< favorited, read or private
+        ContentChanged = 0x02   ///< content, author, media, quoted or repeated post, to be rendered again
+    };
+
+    ~PostStore();
+
+    static PostStore *self();
+
+    /**
+    @return the post of @p account with the id of @p post.
+    If the store has one already, that gets the server side data of @p post (keeping e.g. its read state),
+    its subscribers are notified if that changed anything, and @p post is deleted unless it has owners.
+    Otherwise @p post is kept and returned, its author shares the data of a known equal user.
+    Posts without an id are returned as they are.
+    */
+    Choqok::Post *intern(Choqok::Account *account, Choqok::Post *post);
+
+    /**
+    @return the post of @p account with @p postId, or 0 if no view holds it
+    */
+    Choqok::Post *find(Choqok::Account *account, const QString &postId) const;
+
+    /**
+    Call @p member of @p receiver whenever @p post is changed, until either is destroyed.
+    @p member is a slot like SLOT(slotPostChanged(Choqok::Account*,Choqok::Post*,int)), the int tells
+    the @ref Change "changes"
+    */
+    void subscribe(Choqok::Post *post, QObject *receiver, const char *member);
+
+    /**
+    Tell the subscribers of @p post of @p account that it was changed
+    */
+    void notifyChanged(Choqok::Account *account, Choqok::Post *post, int changes = StateChanged);
+
+    /**
+    Called by the destructor of @ref Post, removes @p post from the store
+    */
+    static void forget(Choqok::Post *post);
+
+    /**
+    @return a human readable summary of the posts and users kept, and of duplicates avoided
+    */
+    QString statistics() const;
+
+protected:
+    PostStore();
+
+private:
+    class Private;
+    Private *const d;
+    static PostStore *mSelf;
+};
+
+}
+
+#endif // POSTSTORE_H
@@ -22,19 +22,70 @@
 
 #include "shortener.h"
 
+#include <QHash>
+
+#include <KJob>
+
 namespace Choqok
 {
 
+class Shortener::Private
+{
+public:
+    QHash<KJob *, QString> jobs;
+};
+
 Shortener::Shortener(const QString &componentName, QObject *parent)
-    : Plugin(componentName, parent)
+    : Plugin(componentName, parent), d(new Private)
 {
 }
 
 Shortener::~Shortener()
-{}
+{
+    delete d;
+}
 
 QString Shortener::shorten(const QString &url)
 {
+    KJob *job = createShortenJob(url);
+    if (!job) {
+        return url;
+    }
+    job->exec();
+    const QString shortUrl = shortUrlFromJob(job, url);
+    return shortUrl.isEmpty() ? url : shortUrl;
+}
+
+void Shortener::shortenAsync(const QString &url)
+{
+    KJob *job = createShortenJob(url);
+    if (!job) {
+        // Only the blocking interface is implemented
+        Q_EMIT shortened(url, shorten(url));
+        return;
+    }
+    d->jobs.insert(job, url);
+    connect(job, SIGNAL(result(KJob*)), this, SLOT(slotShortenJobResult(KJob*)));
+    job->start();
+}
+
+KJob *Shortener::createShortenJob(const QString &url)
+{
+    Q_UNUSED(url);
+    return 0;
+}
+
+QString Shortener::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(job);
     return url;
 }
+
+void Shortener::slotShortenJobResult(KJob *job)
+{
+    const QString url = d->jobs.take(job);
+    const QString shortUrl = shortUrlFromJob(job, url);
+    Q_EMIT shortened(url, shortUrl.isEmpty() ? url : shortUrl);
+}
+
 }
@@ -27,11 +27,17 @@
 
 #include "plugin.h"
 
+class KJob;
+
 namespace Choqok
 {
 /**
 @brief The base class for a Shortener plugin main class.
 
+Plugins implement @ref createShortenJob() and @ref shortUrlFromJob(), so many URLs can be
+shortened at once with @ref shortenAsync(). Plugins which only reimplement @ref shorten()
+still work, but block while shortening.
+
 @author Mehrdad Momeny \<mehrdad.momeny@gmail.com\>
 */
 class CHOQOK_EXPORT Shortener : public Plugin
@@ -40,12 +46,43 @@ class CHOQOK_EXPORT Shortener : public Plugin
 public:
     virtual ~Shortener();
     /**
-        Shorten the @p url and return the shortened URL
+        Shorten the @p url and return the shortened URL, waiting for the service.
+        Kept for compatibility, use @ref shortenAsync() instead.
     */
     virtual QString shorten(const QString &url);
 
+    /**
+        Start shortening @p url, @ref shortened() is emitted once done
+    */
+    void shortenAsync(const QString &url);
+
+Q_SIGNALS:
+    /**
+        @p shortUrl is @p url if it could not be shortened
+    */
+    void shortened(const QString &url, const QString &shortUrl);
+
 protected:
     Shortener(const QString &componentName, QObject *parent);
+
+    /**
+        Create the job that asks the service to shorten @p url, it is started by the caller.
+        The default returns 0, for plugins which only reimplement @ref shorten().
+    */
+    virtual KJob *createShortenJob(const QString &url);
+
+    /**
+        Read the short URL for @p url from the reply of the finished @p job.
+        Return an empty string, after notifying the user, if it failed.
+    */
+    virtual QString shortUrlFromJob(KJob *job, const QString &url);
+
+private Q_SLOTS:
+    void slotShortenJobResult(KJob *job);
+
+private:
+    class Private;
+    Private *const d;
 };
 }//End Namespace Choqok
 #endif
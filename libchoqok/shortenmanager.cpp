@@ -23,9 +23,25 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "shortenmanager.h"
 
 #include <QApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMetaMethod>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimer>
 
+#include <KIO/MimetypeJob>
 #include <KSharedConfig>
 
+#include <algorithm>
+
 #include "choqokbehaviorsettings.h"
 #include "libchoqokdebug.h"
 #include "pluginmanager.h"
@@ -34,6 +50,19 @@ along with this program; if not, see http://www.gnu.org/licenses/
 namespace Choqok
 {
 
+static const quint32 EXPANSIONS_MAGIC = 0x43485558; // "CHUX"
+static const quint8 EXPANSIONS_VERSION = 1;
+/// Redirections followed for one short URL, e.g. t.co pointing to bit.ly pointing to the page
+static const int MAX_HOPS = 5;
+/// Targets up to this length are taken for short URLs again, like the plugins do
+static const int SHORT_URL_LENGTH = 30;
+/// URLs without a redirection are probed again after a day
+static const int NO_EXPANSION_SECS = 24 * 3600;
+static const int MAX_EXPANSIONS = 20000;
+static const int SAVE_DELAY_MSECS = 30 * 1000;
+/// Time the shortening service gets for all URLs of a text
+static const int SHORTEN_DEADLINE_MSECS = 10 * 1000;
+
 class ShortenManagerPrivate
 {
 public:
@@ -42,13 +71,288 @@ public:
     QRegExp findUrlRegExp;
     QRegExp removeUrlRegExp;
 
+    /// A known expansion, an empty url means there is no redirection
+    struct Expansion {
+        QString url;
+        QDateTime expires;
+    };
+
+    struct Subscriber {
+        QPointer<QObject> receiver;
+        QMetaMethod method;
+    };
+
+    /// A redirection probe running for a short URL
+    struct Lookup {
+        QString url;
+        QUrl target;
+        int hops;
+    };
+
+    QHash<QString, Expansion> expansions;
+    bool expansionsLoaded;
+    QTimer saveTimer;
+    QHash<QString, QList<Subscriber> > subscribers;
+    QHash<KJob *, Lookup> lookups;
+
+    /// A text waiting for its URLs to be shortened
+    struct ParseRequest {
+        QString text;
+        QSet<QString> pending;
+        Subscriber subscriber;
+        qint64 deadline;
+    };
+
+    // Short URLs of this session by long URL, and the ones being shortened
+    QHash<QString, QString> shortUrls;
+    QSet<QString> shortening;
+    QHash<QString, QList<Subscriber> > shortenSubscribers;
+    QList<ParseRequest> parseRequests;
+    QTimer deadlineTimer;
+
     ShortenManagerPrivate()
-        : backend(0)
+        : backend(0), expansionsLoaded(false)
     {
+        deadlineTimer.setSingleShot(true);
+        QObject::connect(&deadlineTimer, SIGNAL(timeout()), &instance, SLOT(slotParseDeadline()));
         findUrlRegExp.setPattern(QLatin1String("(ftps?|https?)://"));
         removeUrlRegExp.setPattern(QLatin1String("^(https?)://"));
+        saveTimer.setSingleShot(true);
+        saveTimer.setInterval(SAVE_DELAY_MSECS);
+        QObject::connect(&saveTimer, SIGNAL(timeout()), &instance, SLOT(saveExpansions()));
+        QObject::connect(qApp, SIGNAL(aboutToQuit()), &instance, SLOT(saveExpansions()));
         reloadConfig();
     }
+
+    static QMetaMethod findMethod(QObject *receiver, const char *member)
+    {
+        // Skip the code SLOT() puts in front of the signature
+        const QByteArray signature = QMetaObject::normalizedSignature(member + 1);
+        const int index = receiver->metaObject()->indexOfMethod(signature.constData());
+        if (index < 0) {
+            qCCritical(CHOQOK) << "No such method" << signature << "in" << receiver->metaObject()->className();
+            return QMetaMethod();
+        }
+        return receiver->metaObject()->method(index);
+    }
+
+    /// @p shortUrl as it is put into texts
+    QString displayUrl(const QString &url, const QString &shortUrl) const
+    {
+        QString result = shortUrl;
+        if (BehaviorSettings::removeHttp() && url != shortUrl) {
+            result.remove(removeUrlRegExp);
+        }
+        return result;
+    }
+
+    /// Replace the long URLs of @p text by their known short URLs, collecting all in @p urls
+    QString replaceUrls(const QString &text, QStringList *urls = 0) const
+    {
+        QString t;
+        int i = 0, j = 0;
+        while ((j = text.indexOf(findUrlRegExp, i)) != -1) {
+            t += text.midRef(i, j - i);
+            int k = text.indexOf(QLatin1Char(' '), j);
+            if (k == -1) {
+                k = text.length();
+            }
+            const QString baseUrl = text.mid(j, k - j);
+            if (baseUrl.count() > 30) {
+                if (urls) {
+                    urls->append(baseUrl);
+                }
+                t += displayUrl(baseUrl, shortUrls.value(baseUrl, baseUrl));
+            } else {
+                t += baseUrl;
+            }
+            i = k;
+        }
+        t += text.midRef(i);
+        return t;
+    }
+
+    void startShortening(const QString &url)
+    {
+        if (shortening.contains(url)) {
+            return;
+        }
+        qCDebug(CHOQOK) << "Shortening:" << url;
+        shortening.insert(url);
+        NotifyManager::shortening(url);
+        // Plugins with the blocking interface only answer right away
+        backend->shortenAsync(url);
+    }
+
+    /// Process events until none of @p urls is being shortened, or the deadline passed
+    void waitFor(const QStringList &urls)
+    {
+        QEventLoop loop;
+        QTimer timer;
+        timer.setSingleShot(true);
+        QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+        QObject::connect(&instance, SIGNAL(urlShortened(QString,QString)), &loop, SLOT(quit()));
+        timer.start(SHORTEN_DEADLINE_MSECS);
+        while (timer.isActive()) {
+            bool busy = false;
+            for (const QString &url: urls) {
+                if (shortening.contains(url)) {
+                    busy = true;
+                    break;
+                }
+            }
+            if (!busy) {
+                break;
+            }
+            loop.exec();
+        }
+    }
+
+    void scheduleDeadline()
+    {
+        if (parseRequests.isEmpty()) {
+            deadlineTimer.stop();
+            return;
+        }
+        qint64 next = parseRequests.first().deadline;
+        for (const ParseRequest &request: parseRequests) {
+            next = qMin(next, request.deadline);
+        }
+        deadlineTimer.start(qMax<qint64>(0, next - QDateTime::currentMSecsSinceEpoch()));
+    }
+
+    /// Answer @p requests with the URLs shortened so far
+    void finishParseRequests(const QList<ParseRequest> &requests)
+    {
+        for (const ParseRequest &request: requests) {
+            if (request.subscriber.receiver) {
+                request.subscriber.method.invoke(request.subscriber.receiver, Qt::DirectConnection,
+                                                 Q_ARG(QString, request.text),
+                                                 Q_ARG(QString, replaceUrls(request.text)));
+            }
+        }
+    }
+
+    static QString expansionsFile()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/urlexpansions");
+    }
+
+    void loadExpansions()
+    {
+        if (expansionsLoaded) {
+            return;
+        }
+        expansionsLoaded = true;
+        QFile file(expansionsFile());
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_6);
+        quint32 magic;
+        quint8 version;
+        stream >> magic >> version;
+        if (magic != EXPANSIONS_MAGIC || version != EXPANSIONS_VERSION) {
+            return;
+        }
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        QString url;
+        Expansion expansion;
+        while (!stream.atEnd()) {
+            stream >> url >> expansion.url >> expansion.expires;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            if (expansion.expires > now) {
+                expansions.insert(url, expansion);
+            }
+        }
+        qCDebug(CHOQOK) << expansions.count() << "URL expansions loaded";
+    }
+
+    bool findExpansion(const QString &url, QString *expanded)
+    {
+        loadExpansions();
+        QHash<QString, Expansion>::iterator it = expansions.find(url);
+        if (it == expansions.end()) {
+            return false;
+        }
+        if (it->expires <= QDateTime::currentDateTimeUtc()) {
+            expansions.erase(it);
+            return false;
+        }
+        *expanded = it->url;
+        return true;
+    }
+
+    void insertExpansion(const QString &url, const QString &expanded)
+    {
+        loadExpansions();
+        Expansion expansion;
+        expansion.url = expanded;
+        expansion.expires = QDateTime::currentDateTimeUtc().addSecs(expanded.isEmpty() ? NO_EXPANSION_SECS
+                            : BehaviorSettings::urlExpansionMaxAge() * 24 * 3600);
+        expansions.insert(url, expansion);
+        if (expansions.count() > MAX_EXPANSIONS) {
+            pruneExpansions();
+        }
+        if (!saveTimer.isActive()) {
+            saveTimer.start();
+        }
+    }
+
+    /// Drop expired expansions, and the ones expiring first if still too many
+    void pruneExpansions()
+    {
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        QList<QDateTime> expiries;
+        for (QHash<QString, Expansion>::iterator it = expansions.begin(); it != expansions.end();) {
+            if (it->expires <= now) {
+                it = expansions.erase(it);
+            } else {
+                expiries.append(it->expires);
+                ++it;
+            }
+        }
+        if (expansions.count() <= MAX_EXPANSIONS * 3 / 4) {
+            return;
+        }
+        std::sort(expiries.begin(), expiries.end());
+        const QDateTime limit = expiries.at(expiries.count() - MAX_EXPANSIONS * 3 / 4);
+        for (QHash<QString, Expansion>::iterator it = expansions.begin(); it != expansions.end();) {
+            if (it->expires < limit) {
+                it = expansions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /// Answer all requests for @p url, @p expanded is empty if there is no redirection
+    void notify(const QString &url, const QString &expanded)
+    {
+        const QList<Subscriber> list = subscribers.take(url);
+        const QUrl fromUrl(url);
+        const QUrl toUrl(expanded);
+        for (const Subscriber &subscriber: list) {
+            if (subscriber.receiver) {
+                subscriber.method.invoke(subscriber.receiver, Qt::DirectConnection,
+                                         Q_ARG(QUrl, fromUrl), Q_ARG(QUrl, toUrl));
+            }
+        }
+    }
+
+    /// Stop the probe of @p job, caching and announcing what it found so far
+    void finishLookup(KJob *job, bool cache)
+    {
+        const Lookup lookup = lookups.take(job);
+        const QString expanded = lookup.target.isValid() ? lookup.target.toString() : QString();
+        if (cache) {
+            insertExpansion(lookup.url, expanded);
+        }
+        notify(lookup.url, expanded);
+    }
     void reloadConfig()
     {
         const QString pluginId = Choqok::BehaviorSettings::shortenerPlugin();
@@ -68,17 +372,15 @@ public:
         backend = qobject_cast<Shortener *>(plugin);
         if (!backend) {
             qCDebug(CHOQOK) << "Could not load a Shortener plugin. Shortening Disabled";
+            return;
         }
+        QObject::connect(backend, SIGNAL(shortened(QString,QString)),
+                         &instance, SLOT(slotShortened(QString,QString)));
     }
 };
 
 Q_GLOBAL_STATIC(ShortenManagerPrivate, _smp)
 
-QString shorten(const QString &url)
-{
-    return _smp->backend->shorten(url);
-}
-
 ShortenManager::ShortenManager(QObject *parent)
     : QObject(parent)
 {
@@ -94,50 +396,145 @@ ShortenManager *ShortenManager::self()
 
 QString ShortenManager::shortenUrl(const QString &url)
 {
-    if (_smp->backend) {
-        qCDebug(CHOQOK) << "Shortening:" << url;
-        NotifyManager::shortening(url);
-        QString shortUrl = shorten(url);
-        if (BehaviorSettings::removeHttp() && url != shortUrl) {
-            shortUrl.remove(_smp->removeUrlRegExp);
-        }
-        return shortUrl;
-    } else {
+    if (!_smp->backend) {
         qCDebug(CHOQOK) << "There isn't any Shortener plugin.";
         return url;
     }
+    if (!_smp->shortUrls.contains(url)) {
+        _smp->startShortening(url);
+        _smp->waitFor(QStringList(url));
+    }
+    return _smp->displayUrl(url, _smp->shortUrls.value(url, url));
 }
 
 void ShortenManager::reloadConfig()
 {
+    const Shortener *oldBackend = _smp->backend;
     _smp->reloadConfig();
+    if (_smp->backend == oldBackend) {
+        return;
+    }
+    // Short URLs of the old service are not needed, and its answers won't come anymore
+    _smp->shortUrls.clear();
+    const QSet<QString> shortening = _smp->shortening;
+    for (const QString &url: shortening) {
+        slotShortened(url, url);
+    }
 }
 
 QString ShortenManager::parseText(const QString &text)
 {
     qCDebug(CHOQOK);
-    QString t;
-    int i = 0, j = 0;
-    while ((j = text.indexOf(_smp->findUrlRegExp, i)) != -1) {
-        t += text.mid(i, j - i);
-        int k = text.indexOf(QLatin1Char(' '), j);
-        if (k == -1) {
-            k = text.length();
-        }
-        QString baseUrl = text.mid(j, k - j);
-        if (baseUrl.count() > 30) {
-            QString tmp = Choqok::ShortenManager::self()->shortenUrl(baseUrl);
-            if (BehaviorSettings::removeHttp() && tmp != baseUrl) {
-                tmp.remove(_smp->removeUrlRegExp);
+    if (_smp->backend) {
+        const QStringList urls = urlsToShorten(text);
+        for (const QString &url: urls) {
+            if (!_smp->shortUrls.contains(url)) {
+                _smp->startShortening(url);
             }
-            t += tmp;
+        }
+        _smp->waitFor(urls);
+    }
+    return _smp->replaceUrls(text);
+}
+
+void ShortenManager::shortenUrl(const QString &url, QObject *receiver, const char *member)
+{
+    ShortenManagerPrivate::Subscriber subscriber;
+    subscriber.receiver = receiver;
+    subscriber.method = ShortenManagerPrivate::findMethod(receiver, member);
+    if (!subscriber.method.isValid()) {
+        return;
+    }
+    if (!_smp->backend || _smp->shortUrls.contains(url)) {
+        subscriber.method.invoke(receiver, Qt::DirectConnection, Q_ARG(QString, url),
+                                 Q_ARG(QString, _smp->displayUrl(url, _smp->shortUrls.value(url, url))));
+        return;
+    }
+    _smp->shortenSubscribers[url].append(subscriber);
+    _smp->startShortening(url);
+}
+
+void ShortenManager::parseText(const QString &text, QObject *receiver, const char *member)
+{
+    ShortenManagerPrivate::ParseRequest request;
+    request.text = text;
+    request.subscriber.receiver = receiver;
+    request.subscriber.method = ShortenManagerPrivate::findMethod(receiver, member);
+    if (!request.subscriber.method.isValid()) {
+        return;
+    }
+    if (_smp->backend) {
+        for (const QString &url: urlsToShorten(text)) {
+            if (!_smp->shortUrls.contains(url)) {
+                request.pending.insert(url);
+            }
+        }
+    }
+    if (request.pending.isEmpty()) {
+        _smp->finishParseRequests(QList<ShortenManagerPrivate::ParseRequest>() << request);
+        return;
+    }
+    request.deadline = QDateTime::currentMSecsSinceEpoch() + SHORTEN_DEADLINE_MSECS;
+    _smp->parseRequests.append(request);
+    _smp->scheduleDeadline();
+    for (const QString &url: request.pending) {
+        _smp->startShortening(url);
+    }
+}
+
+QStringList ShortenManager::urlsToShorten(const QString &text)
+{
+    QStringList urls;
+    _smp->replaceUrls(text, &urls);
+    return urls;
+}
+
+void ShortenManager::slotShortened(const QString &url, const QString &shortUrl)
+{
+    if (!_smp->shortening.remove(url)) {
+        return;
+    }
+    if (!shortUrl.isEmpty() && shortUrl != url) {
+        _smp->shortUrls.insert(url, shortUrl);
+    }
+    const QString display = _smp->displayUrl(url, _smp->shortUrls.value(url, url));
+    for (const ShortenManagerPrivate::Subscriber &subscriber: _smp->shortenSubscribers.take(url)) {
+        if (subscriber.receiver) {
+            subscriber.method.invoke(subscriber.receiver, Qt::DirectConnection,
+                                     Q_ARG(QString, url), Q_ARG(QString, display));
+        }
+    }
+    Q_EMIT urlShortened(url, display);
+
+    QList<ShortenManagerPrivate::ParseRequest> done;
+    for (int i = 0; i < _smp->parseRequests.count();) {
+        ShortenManagerPrivate::ParseRequest &request = _smp->parseRequests[i];
+        if (request.pending.remove(url) && request.pending.isEmpty()) {
+            done.append(_smp->parseRequests.takeAt(i));
+        } else {
+            ++i;
+        }
+    }
+    if (!done.isEmpty()) {
+        _smp->scheduleDeadline();
+        _smp->finishParseRequests(done);
+    }
+}
+
+void ShortenManager::slotParseDeadline()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<ShortenManagerPrivate::ParseRequest> done;
+    for (int i = 0; i < _smp->parseRequests.count();) {
+        if (_smp->parseRequests.at(i).deadline <= now) {
+            qCDebug(CHOQOK) << "Shortening took too long, leaving" << _smp->parseRequests.at(i).pending.count() << "URLs";
+            done.append(_smp->parseRequests.takeAt(i));
         } else {
-            t += baseUrl;
+            ++i;
         }
-        i = k;
     }
-    t += text.mid(i);
-    return t;
+    _smp->scheduleDeadline();
+    _smp->finishParseRequests(done);
 }
 
 void ShortenManager::emitNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const QUrl &fromUrl, const QUrl &toUrl)
@@ -145,5 +542,137 @@ void ShortenManager::emitNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const
     Q_EMIT newUnshortenedUrl(widget, fromUrl, toUrl);
 }
 
+bool ShortenManager::findExpansion(const QUrl &url, QUrl *expanded)
+{
+    QString target;
+    if (!_smp->findExpansion(url.toString(), &target)) {
+        return false;
+    }
+    *expanded = QUrl(target);
+    return true;
+}
+
+void ShortenManager::addExpansion(const QUrl &url, const QUrl &expanded)
+{
+    const QString key = url.toString();
+    const QString target = expanded == url ? QString() : expanded.toString();
+    _smp->insertExpansion(key, target);
+    // A running probe isn't needed anymore
+    for (QHash<KJob *, ShortenManagerPrivate::Lookup>::iterator it = _smp->lookups.begin();
+         it != _smp->lookups.end(); ++it) {
+        if (it->url == key) {
+            KJob *job = it.key();
+            _smp->lookups.erase(it);
+            job->kill();
+            break;
+        }
+    }
+    _smp->notify(key, target);
+}
+
+void ShortenManager::expandUrl(const QUrl &url, QObject *receiver, const char *member)
+{
+    ShortenManagerPrivate::Subscriber subscriber;
+    subscriber.receiver = receiver;
+    subscriber.method = ShortenManagerPrivate::findMethod(receiver, member);
+    if (!subscriber.method.isValid()) {
+        return;
+    }
+
+    const QString key = url.toString();
+    QString expanded;
+    if (_smp->findExpansion(key, &expanded)) {
+        subscriber.method.invoke(receiver, Qt::DirectConnection,
+                                 Q_ARG(QUrl, url), Q_ARG(QUrl, QUrl(expanded)));
+        return;
+    }
+
+    QList<ShortenManagerPrivate::Subscriber> &list = _smp->subscribers[key];
+    list.append(subscriber);
+    if (list.count() > 1) {
+        // Already being expanded
+        return;
+    }
+
+    KIO::MimetypeJob *job = KIO::mimetype(url, KIO::HideProgressInfo);
+    if (!job) {
+        qCCritical(CHOQOK) << "Cannot create a http header request!";
+        _smp->subscribers.remove(key);
+        return;
+    }
+    ShortenManagerPrivate::Lookup lookup;
+    lookup.url = key;
+    lookup.hops = 0;
+    _smp->lookups.insert(job, lookup);
+    connect(job, SIGNAL(permanentRedirection(KIO::Job*,QUrl,QUrl)),
+            this, SLOT(slotRedirected(KIO::Job*,QUrl,QUrl)));
+    connect(job, SIGNAL(result(KJob*)), this, SLOT(slotExpansionResult(KJob*)));
+    job->start();
+}
+
+void ShortenManager::slotRedirected(KIO::Job *job, const QUrl &fromUrl, const QUrl &toUrl)
+{
+    Q_UNUSED(fromUrl);
+    QHash<KJob *, ShortenManagerPrivate::Lookup>::iterator it = _smp->lookups.find(job);
+    if (it == _smp->lookups.end()) {
+        return;
+    }
+    it->target = toUrl;
+    ++it->hops;
+
+    // KIO keeps following the redirections, stop it once the target isn't a short URL anymore
+    QString known;
+    if (_smp->findExpansion(toUrl.toString(), &known)) {
+        if (!known.isEmpty()) {
+            it->target = QUrl(known);
+        }
+    } else if (toUrl.toString().length() <= SHORT_URL_LENGTH && it->hops < MAX_HOPS) {
+        return;
+    }
+    _smp->finishLookup(job, true);
+    job->kill();
+}
+
+void ShortenManager::slotExpansionResult(KJob *job)
+{
+    if (!_smp->lookups.contains(job)) {
+        return;
+    }
+    // Failed requests are tried again next time, unless a redirection was seen before
+    const bool cache = !job->error() || _smp->lookups.value(job).target.isValid();
+    if (job->error()) {
+        qCDebug(CHOQOK) << "Cannot expand" << _smp->lookups.value(job).url << job->errorString();
+    }
+    _smp->finishLookup(job, cache);
+}
+
+void ShortenManager::saveExpansions()
+{
+    _smp->saveTimer.stop();
+    if (!_smp->expansionsLoaded) {
+        return;
+    }
+    const QString path = ShortenManagerPrivate::expansionsFile();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(CHOQOK) << "Cannot write" << path << file.errorString();
+        return;
+    }
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << EXPANSIONS_MAGIC << EXPANSIONS_VERSION;
+    for (QHash<QString, ShortenManagerPrivate::Expansion>::const_iterator it = _smp->expansions.constBegin();
+         it != _smp->expansions.constEnd(); ++it) {
+        if (it->expires > now) {
+            stream << it.key() << it->url << it->expires;
+        }
+    }
+    if (!file.commit()) {
+        qCWarning(CHOQOK) << "Cannot write" << path << file.errorString();
+    }
+}
+
 }
 
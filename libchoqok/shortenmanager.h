@@ -24,10 +24,18 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #define CHOQOKSHORTENMANAGER_H
 
 #include <QObject>
+#include <QStringList>
 #include <QUrl>
 
 #include "shortener.h"
 
+class KJob;
+
+namespace KIO
+{
+class Job;
+}
+
 namespace Choqok
 {
 namespace UI
@@ -48,15 +56,38 @@ public:
     static ShortenManager *self();
     /**
         If there is any shorten plugin loaded/enabled return Shortened URL
-        else return @p url
+        else return @p url.
+        Waits for the service, up to a deadline. Kept for callers which need the result right
+        away, like the D-Bus interface, use the asynchronous overload where possible.
     */
     QString shortenUrl(const QString &url);
 
     /**
-        Parse and find Urls and then shorten them. and return result text
+        Parse and find Urls and then shorten them. and return result text.
+        The URLs are shortened in parallel, the ones that took longer than the deadline are
+        left as they are. Kept for compatibility, Choqok itself uses the asynchronous overload.
     */
     QString parseText(const QString &text);
 
+    /**
+        Shorten @p url in the background. @p member of @p receiver is called as
+        member(QString url, QString shortUrl) once done, right away if it was shortened before.
+        @p shortUrl is @p url if there is no shortener or the service failed.
+    */
+    void shortenUrl(const QString &url, QObject *receiver, const char *member);
+
+    /**
+        Shorten all long URLs of @p text in parallel. @p member of @p receiver is called as
+        member(QString text, QString result) once all are done, or after the deadline with
+        the URLs that weren't shortened in time left as they are.
+    */
+    void parseText(const QString &text, QObject *receiver, const char *member);
+
+    /**
+        @return the URLs of @p text which @ref parseText() shortens
+    */
+    QStringList urlsToShorten(const QString &text);
+
     /**
         Reload configurations.
         Should call after change on shortening plugin!
@@ -65,9 +96,44 @@ public:
 
     void emitNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const QUrl &fromUrl, const QUrl &toUrl);
 
+    /**
+        Look up the expansion of short @p url in the cache shared by all unshortening plugins.
+        Returns true if it is known, @p expanded is then set to the target, or to an empty
+        URL if @p url doesn't redirect anywhere.
+    */
+    bool findExpansion(const QUrl &url, QUrl *expanded);
+
+    /**
+        Remember that @p url expands to @p expanded, e.g. as told by a web service.
+        Pending @ref expandUrl() requests for @p url are answered with it.
+    */
+    void addExpansion(const QUrl &url, const QUrl &expanded);
+
+    /**
+        Expand short @p url by following its permanent redirections, up to a few hops while
+        the target is a short URL again.
+        @p member of @p receiver is called as member(QUrl fromUrl, QUrl toUrl) once done, right
+        away if the expansion is cached. @p toUrl is empty if @p url doesn't redirect.
+        Concurrent requests for the same URL share one lookup, and results are kept on disk
+        for @ref BehaviorSettings::urlExpansionMaxAge() days.
+    */
+    void expandUrl(const QUrl &url, QObject *receiver, const char *member);
+
 Q_SIGNALS:
     void newUnshortenedUrl(Choqok::UI::PostWidget *widget, const QUrl &fromUrl, const QUrl &toUrl);
 
+    /**
+        Emitted whenever shortening @p url finished, @p shortUrl is @p url if it failed
+    */
+    void urlShortened(const QString &url, const QString &shortUrl);
+
+private Q_SLOTS:
+    void slotShortened(const QString &url, const QString &shortUrl);
+    void slotParseDeadline();
+    void slotRedirected(KIO::Job *job, const QUrl &fromUrl, const QUrl &toUrl);
+    void slotExpansionResult(KJob *job);
+    void saveExpansions();
+
 private:
     ShortenManager(QObject *parent = 0);
     ~ShortenManager();
@@ -30,7 +30,6 @@
 
 #include "choqok_export.h"
 
-class QTimer;
 class QTabWidget;
 
 namespace Choqok
@@ -69,7 +68,6 @@ protected:
     virtual QSize sizeHint() const override;
 
     QTabWidget *mainWidget;
-    QTimer *timelineTimer;
 };
 
 }
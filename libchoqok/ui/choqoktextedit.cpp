@@ -27,6 +27,7 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include <QLabel>
 #include <QMenu>
 #include <QMimeData>
+#include <QTextDocument>
 #include <QTimer>
 
 #include <KLocalizedString>
@@ -141,10 +142,9 @@ void TextEdit::undoableClear()
 
 void TextEdit::insertFromMimeData(const QMimeData *source)
 {
+    KTextEdit::insertPlainText(source->text());
     if (Choqok::BehaviorSettings::shortenOnPaste()) {
-        KTextEdit::insertPlainText(ShortenManager::self()->parseText(source->text()));
-    } else {
-        KTextEdit::insertPlainText(source->text());
+        shortenUrlsOf(source->text());
     }
 }
 
@@ -203,10 +203,30 @@ void TextEdit::shortenUrls()
     if (!cur.hasSelection()) {
         cur.select(QTextCursor::BlockUnderCursor);
     }
-    QString shortened = ShortenManager::self()->parseText(cur.selectedText());
-    cur.removeSelectedText();
-    cur.insertText(shortened);
-    setTextCursor(cur);
+    shortenUrlsOf(cur.selectedText());
+}
+
+void TextEdit::shortenUrlsOf(const QString &text)
+{
+    for (const QString &url: ShortenManager::self()->urlsToShorten(text)) {
+        ShortenManager::self()->shortenUrl(url, this, SLOT(slotUrlShortened(QString,QString)));
+    }
+}
+
+void TextEdit::slotUrlShortened(const QString &url, const QString &shortUrl)
+{
+    if (url == shortUrl) {
+        return;
+    }
+    // The text may have been edited meanwhile, replace wherever the URL still is
+    QTextCursor cursor = document()->find(url, 0, QTextDocument::FindCaseSensitively);
+    while (!cursor.isNull()) {
+        // Not when it's only the start of a longer URL
+        if (document()->characterAt(cursor.selectionEnd()).isSpace()) {
+            cursor.insertText(shortUrl);
+        }
+        cursor = document()->find(url, cursor, QTextDocument::FindCaseSensitively);
+    }
 }
 
 void TextEdit::slotChangeSpellerLanguage()
@@ -243,13 +263,12 @@ void TextEdit::setCharLimit(uint charLimit /*= 0*/)
 
 void TextEdit::setPlainText(const QString &text)
 {
-    if (Choqok::BehaviorSettings::shortenOnPaste()) {
-        KTextEdit::setPlainText(ShortenManager::self()->parseText(text));
-    } else {
-        KTextEdit::setPlainText(text);
-    }
+    KTextEdit::setPlainText(text);
     moveCursor(QTextCursor::End);
     setEnabled(true);
+    if (Choqok::BehaviorSettings::shortenOnPaste()) {
+        shortenUrlsOf(text);
+    }
 }
 
 void TextEdit::setText(const QString &text)
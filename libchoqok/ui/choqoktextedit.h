@@ -70,6 +70,7 @@ protected Q_SLOTS:
     void setupSpeller();
     void slotAboutToShowContextMenu(QMenu *menu);
     void shortenUrls();
+    void slotUrlShortened(const QString &url, const QString &shortUrl);
 
 protected:
     uint charLimit();
@@ -79,6 +80,11 @@ protected:
     QLabel *lblRemainChar;
 
 private:
+    /**
+    Shorten the long URLs of @p text in the background, they are replaced in the editor once done
+    */
+    void shortenUrlsOf(const QString &text);
+
     class Private;
     Private *const d;
 };
@@ -50,6 +50,8 @@ public:
     QWidget *editorContainer;
     QPointer<QLabel> replyToUsernameLabel;
     QPointer<QPushButton> btnCancelReply;
+    /// Submitted text waiting for its URLs to be shortened
+    QString textToShorten;
 };
 
 ComposerWidget::ComposerWidget(Choqok::Account *account, QWidget *parent /*= 0*/)
@@ -119,11 +121,29 @@ void ComposerWidget::submitPost(const QString &txt)
 {
     qCDebug(CHOQOK);
     editorContainer()->setEnabled(false);
-    QString text = txt;
     if (currentAccount()->postCharLimit() &&
-            text.size() > (int)currentAccount()->postCharLimit()) {
-        text = Choqok::ShortenManager::self()->parseText(text);
+            txt.size() > (int)currentAccount()->postCharLimit()) {
+        // The editor stays disabled until it's sent, the result may be delivered right away
+        d->textToShorten = txt;
+        Choqok::ShortenManager::self()->parseText(txt, this, SLOT(slotTextShortened(QString,QString)));
+    } else {
+        sendPost(txt);
+    }
+}
+
+void ComposerWidget::slotTextShortened(const QString &text, const QString &result)
+{
+    if (text != d->textToShorten) {
+        return;
     }
+    d->textToShorten.clear();
+    sendPost(result);
+}
+
+void ComposerWidget::sendPost(const QString &text)
+{
+    qCDebug(CHOQOK);
+    editorContainer()->setEnabled(false);
     delete d->postToSubmit;
     d->postToSubmit = new Choqok::Post;
     d->postToSubmit->content = text;
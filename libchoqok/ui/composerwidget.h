@@ -55,13 +55,24 @@ public Q_SLOTS:
     virtual void abort();
 
 protected Q_SLOTS:
+    /**
+    Shorten the URLs of @p text in the background if it's too long, then send it with @ref sendPost()
+    */
     virtual void submitPost(const QString &text);
     virtual void slotPostSubmited(Choqok::Account *theAccount, Choqok::Post *post);
     virtual void slotErrorPost(Choqok::Account *theAccount, Choqok::Post *post);
     virtual void editorTextChanged();
     virtual void editorCleared();
 
+private Q_SLOTS:
+    void slotTextShortened(const QString &text, const QString &result);
+
 protected:
+    /**
+    Send @p text, its URLs are shortened already if it was too long.
+    Sub classes reimplement this to send attachments or replies their own way.
+    */
+    virtual void sendPost(const QString &text);
     /**
     Sub classes can use another editor! (Should be a subclass of Choqok::Editor)
     */
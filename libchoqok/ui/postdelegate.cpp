@@ -0,0 +1,261 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "postdelegate.h"
+
+#include <QAbstractItemView>
+#include <QCache>
+#include <QFontMetrics>
+#include <QHash>
+#include <QMultiHash>
+#include <QPainter>
+#include <QPair>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QTextDocument>
+
+#include <climits>
+
+#include "choqokappearancesettings.h"
+#include "mediamanager.h"
+#include "postmodel.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+/// Only rows painted without a widget need a document, i.e. those scrolled by quickly
+static const int MAX_CACHED_DOCUMENTS = 100;
+static const int AVATAR_COLUMN_WIDTH = 48 + 5 + 3; // avatar, its padding and the one of the text
+static const int ROW_MARGINS = 16;                 // document margins, cell spacing and the frame
+
+const QString rowTemplate(QLatin1String("<table width=\"100%\"><tr><td width=\"48\" style=\"padding-right: 5px;\"><img src=\"img://profileImage\" width=\"48\" height=\"48\" /></td><td dir=\"%3\" style=\"padding-right:3px;\"><p>%1</p></td></tr><tr><td></td><td style=\"font-size:small;\" dir=\"ltr\" align=\"right\" valign=\"bottom\">%2</td></tr></table>"));
+
+class PostDelegate::Private
+{
+public:
+    Private(PostDelegate *parent)
+        : q(parent), documents(MAX_CACHED_DOCUMENTS)
+    {}
+
+    QPixmap avatar(const QModelIndex &index, const QString &url)
+    {
+        if (url.isEmpty()) {
+            return MediaManager::self()->defaultImage();
+        }
+        ///A cached avatar is delivered to slotAvatarFetched() before request() returns
+        requestedUrl = url;
+        requestedAvatar = QPixmap();
+        if (!MediaManager::self()->request(url, q, SLOT(slotAvatarFetched(QString,QPixmap)),
+                                           SLOT(slotAvatarFailed(QString,QString)), MediaManager::AvatarImage)) {
+            const QPersistentModelIndex row(index);
+            if (!waitingAvatars.contains(url, row)) {
+                waitingAvatars.insert(url, row);
+            }
+        }
+        requestedUrl.clear();
+        return requestedAvatar.isNull() ? MediaManager::self()->defaultImage() : requestedAvatar;
+    }
+
+    QTextDocument *document(const QModelIndex &index, const Post *post, const QFont &font, int width)
+    {
+        QTextDocument *doc = documents.object(post->postId);
+        if (!doc) {
+            doc = new QTextDocument;
+            doc->setDefaultFont(font);
+            doc->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("img://profileImage")),
+                             avatar(index, post->author.profileImageUrl));
+
+            QString content = post->content.toHtmlEscaped();
+            content.replace(QLatin1Char('\n'), QLatin1String("<br/>"));
+            const QString sign = QLatin1String("<b>") + post->author.userName.toHtmlEscaped() + QLatin1String("</b>");
+            const QLatin1String dir(post->content.isRightToLeft() ? "rtl" : "ltr");
+            doc->setHtml(rowTemplate.arg(content, sign, dir));
+            documents.insert(post->postId, doc);
+        }
+        if (!qFuzzyCompare(doc->textWidth(), qreal(width))) {
+            doc->setTextWidth(width);
+        }
+        return doc;
+    }
+
+    PostDelegate *q;
+    QCache<QString, QTextDocument> documents;
+    QHash<QString, QPair<int, int> > widgetHeights; // <postId, <width, height> >, measured by PostWidget
+    QHash<QString, QPair<int, int> > estimatedHeights; // <postId, <width, height> >
+    QMultiHash<QString, QPersistentModelIndex> waitingAvatars; // <avatar url, rows painted without it>
+    QPointer<QAbstractItemView> view;
+    QString requestedUrl;
+    QPixmap requestedAvatar;
+};
+
+PostDelegate::PostDelegate(QObject *parent)
+    : QStyledItemDelegate(parent), d(new Private(this))
+{
+}
+
+PostDelegate::~PostDelegate()
+{
+    delete d;
+}
+
+static int viewWidth(const QStyleOptionViewItem &option)
+{
+    const QAbstractItemView *view = qobject_cast<const QAbstractItemView *>(option.widget);
+    return view ? view->viewport()->width() : option.rect.width();
+}
+
+/// Font PostWidget shows posts in
+static QFont rowFont(const QStyleOptionViewItem &option)
+{
+    return AppearanceSettings::isCustomUi() ? AppearanceSettings::font() : option.font;
+}
+
+/// Height of the row of @p post at @p width from font metrics, without parsing any HTML
+static int estimateHeight(const Post *post, const QFont &font, int width)
+{
+    QFont small(font);
+    if (font.pointSizeF() > 0) {
+        small.setPointSizeF(font.pointSizeF() * 0.8);
+    }
+    const int textWidth = qMax(1, width - 2 - AVATAR_COLUMN_WIDTH - ROW_MARGINS);
+    const QRect text = QFontMetrics(font).boundingRect(0, 0, textWidth, INT_MAX, Qt::TextWordWrap,
+                                                       post->content);
+    return qMax(48, text.height()) + QFontMetrics(small).lineSpacing() + ROW_MARGINS;
+}
+
+void PostDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                         const QModelIndex &index) const
+{
+    const Post *post = index.data(PostModel::PostRole).value<Post *>();
+    if (!post) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    QColor back;
+    if (AppearanceSettings::isCustomUi()) {
+        back = post->isRead ? AppearanceSettings::readBackColor() : AppearanceSettings::unreadBackColor();
+    } else {
+        back = post->isRead ? option.palette.base().color() : option.palette.alternateBase().color();
+    }
+
+    d->view = qobject_cast<QAbstractItemView *>(const_cast<QWidget *>(option.widget));
+    if (d->view && d->view->indexWidget(index)) {
+        // Covered by its PostWidget
+        return;
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(QColor(150, 150, 150));
+    painter->setBrush(back);
+    painter->drawRoundedRect(option.rect.adjusted(0, 0, -1, -1), 5, 5);
+
+    QTextDocument *doc = d->document(index, post, rowFont(option), option.rect.width() - 2);
+    painter->translate(option.rect.topLeft() + QPoint(1, 1));
+    doc->drawContents(painter, QRectF(0, 0, option.rect.width() - 2, option.rect.height() - 2));
+    painter->restore();
+}
+
+QSize PostDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const Post *post = index.data(PostModel::PostRole).value<Post *>();
+    if (!post) {
+        return QStyledItemDelegate::sizeHint(option, index);
+    }
+
+    // Called for every row on each relayout of the view, so it must not lay out documents
+    const int width = viewWidth(option);
+    const QPair<int, int> measured = d->widgetHeights.value(post->postId, qMakePair(-1, -1));
+    if (measured.first == width) {
+        return QSize(width, measured.second);
+    }
+    QPair<int, int> estimated = d->estimatedHeights.value(post->postId, qMakePair(-1, -1));
+    if (estimated.first != width) {
+        const QFont font = rowFont(option);
+        int height = estimateHeight(post, font, width);
+        if (measured.first > 0) {
+            // Carry over what the estimate missed at the width the widget was shown at,
+            // e.g. previews or images, so rows don't jump once widgets attach again
+            height += measured.second - estimateHeight(post, font, measured.first);
+        }
+        estimated = qMakePair(width, height);
+        d->estimatedHeights.insert(post->postId, estimated);
+    }
+    return QSize(width, estimated.second);
+}
+
+void PostDelegate::setWidgetHeight(const QModelIndex &index, int width, int height)
+{
+    const QString postId = index.data(PostModel::PostIdRole).toString();
+    const QPair<int, int> measured(width, height);
+    if (d->widgetHeights.value(postId) != measured) {
+        d->widgetHeights.insert(postId, measured);
+        d->estimatedHeights.remove(postId);
+        Q_EMIT sizeHintChanged(index);
+    }
+}
+
+void PostDelegate::invalidate(const QString &postId)
+{
+    d->documents.remove(postId);
+    d->widgetHeights.remove(postId);
+    d->estimatedHeights.remove(postId);
+}
+
+void PostDelegate::clearCache()
+{
+    d->documents.clear();
+    d->widgetHeights.clear();
+    d->estimatedHeights.clear();
+}
+
+void PostDelegate::slotAvatarFetched(const QString &remoteUrl, const QPixmap &pixmap)
+{
+    if (remoteUrl == d->requestedUrl) {
+        d->requestedAvatar = pixmap;
+        return;
+    }
+    const QList<QPersistentModelIndex> rows = d->waitingAvatars.values(remoteUrl);
+    d->waitingAvatars.remove(remoteUrl);
+    for (const QPersistentModelIndex &row: rows) {
+        if (!row.isValid()) {
+            continue;
+        }
+        d->documents.remove(row.data(PostModel::PostIdRole).toString());
+        if (d->view) {
+            d->view->update(row);
+        }
+    }
+}
+
+void PostDelegate::slotAvatarFailed(const QString &remoteUrl, const QString &errMsg)
+{
+    Q_UNUSED(errMsg);
+    d->waitingAvatars.remove(remoteUrl);
+}
+
+}
+}
@@ -0,0 +1,92 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef POSTDELEGATE_H
+#define POSTDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+class QTextDocument;
+
+namespace Choqok
+{
+namespace UI
+{
+
+/**
+@brief Paints rows of a @ref PostModel without creating a widget for them
+
+Size hints come from font metrics and are cached per post, the view asks for them
+on every relayout, so no HTML is parsed there. Laid out documents are only built to
+paint rows which don't have a widget yet, and cached per post.
+Avatars are requested from @ref MediaManager without blocking, rows painted
+before theirs arrived are laid out again once it's there.
+Once a @ref PostWidget is shown for a row, its real height is reported with
+@ref setWidgetHeight() and used as size hint for that row.
+
+@see PostModel
+*/
+class CHOQOK_EXPORT PostDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit PostDelegate(QObject *parent = 0);
+    virtual ~PostDelegate();
+
+    virtual void paint(QPainter *painter, const QStyleOptionViewItem &option,
+                       const QModelIndex &index) const override;
+    virtual QSize sizeHint(const QStyleOptionViewItem &option,
+                           const QModelIndex &index) const override;
+
+    /**
+    @brief Use @p height as size hint of the row at @p index while the view is @p width wide
+    */
+    void setWidgetHeight(const QModelIndex &index, int width, int height);
+
+    /**
+    @brief Drop cached layout of the post with id @p postId
+    */
+    void invalidate(const QString &postId);
+
+public Q_SLOTS:
+    /**
+    @brief Drop all cached layouts, e.g. after style changes
+    */
+    void clearCache();
+
+private Q_SLOTS:
+    void slotAvatarFetched(const QString &remoteUrl, const QPixmap &pixmap);
+    void slotAvatarFailed(const QString &remoteUrl, const QString &errMsg);
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+}
+
+#endif // POSTDELEGATE_H
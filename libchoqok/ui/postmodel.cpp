@@ -0,0 +1,196 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "postmodel.h"
+
+#include <QHash>
+
+namespace Choqok
+{
+namespace UI
+{
+
+class PostModel::Private
+{
+public:
+    Private(bool reverse)
+        : reverseOrder(reverse)
+    {}
+
+    /**
+    @return true if @p a should be shown above @p b
+    */
+    bool isBefore(const Post *a, const Post *b) const
+    {
+        if (reverseOrder) {
+            return a->creationDateTime < b->creationDateTime;
+        } else {
+            return a->creationDateTime > b->creationDateTime;
+        }
+    }
+
+    /**
+    Binary search for the first row that isn't shown above @p post
+    */
+    int lowerBound(const Post *post) const
+    {
+        int low = 0;
+        int high = list.count();
+        while (low < high) {
+            const int mid = (low + high) / 2;
+            if (isBefore(list.at(mid), post)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    static void release(Post *post)
+    {
+        if (post->owners < 2) {
+            delete post;
+        } else {
+            post->owners--;
+        }
+    }
+
+    bool reverseOrder;
+    QList<Post *> list;
+    QHash<QString, Post *> ids;
+};
+
+PostModel::PostModel(bool reverseOrder, QObject *parent)
+    : QAbstractListModel(parent), d(new Private(reverseOrder))
+{
+}
+
+PostModel::~PostModel()
+{
+    for (Post *post: d->list) {
+        Private::release(post);
+    }
+    delete d;
+}
+
+int PostModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return d->list.count();
+}
+
+QVariant PostModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= d->list.count()) {
+        return QVariant();
+    }
+    Post *post = d->list.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return post->content;
+    case PostRole:
+        return QVariant::fromValue(post);
+    case PostIdRole:
+        return post->postId;
+    case CreationDateTimeRole:
+        return post->creationDateTime;
+    case IsReadRole:
+        return post->isRead;
+    default:
+        return QVariant();
+    }
+}
+
+int PostModel::addPost(Post *post)
+{
+    if (!post || d->ids.contains(post->postId)) {
+        return -1;
+    }
+
+    const int low = d->lowerBound(post);
+    beginInsertRows(QModelIndex(), low, low);
+    post->owners++;
+    d->list.insert(low, post);
+    d->ids.insert(post->postId, post);
+    endInsertRows();
+    return low;
+}
+
+void PostModel::removePost(const QString &postId)
+{
+    const int row = rowOf(postId);
+    if (row < 0) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    Post *post = d->list.takeAt(row);
+    d->ids.remove(postId);
+    endRemoveRows();
+    Private::release(post);
+}
+
+void PostModel::postChanged(const QString &postId)
+{
+    const int row = rowOf(postId);
+    if (row >= 0) {
+        const QModelIndex idx = index(row);
+        Q_EMIT dataChanged(idx, idx);
+    }
+}
+
+bool PostModel::contains(const QString &postId) const
+{
+    return d->ids.contains(postId);
+}
+
+int PostModel::rowOf(const QString &postId) const
+{
+    Post *post = d->ids.value(postId);
+    if (!post) {
+        return -1;
+    }
+    // Called for each live widget while scrolling, so don't scan the whole timeline:
+    // only posts created at the same time are looked through
+    for (int row = d->lowerBound(post); row < d->list.count() && !d->isBefore(post, d->list.at(row)); ++row) {
+        if (d->list.at(row) == post) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+Post *PostModel::post(int row) const
+{
+    return d->list.value(row);
+}
+
+QList<Post *> PostModel::posts() const
+{
+    return d->list;
+}
+
+}
+}
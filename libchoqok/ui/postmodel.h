@@ -0,0 +1,97 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef POSTMODEL_H
+#define POSTMODEL_H
+
+#include <QAbstractListModel>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+/**
+@brief List model of the posts shown on a timeline
+
+Rows are kept sorted by creation time, newest first unless the model is
+created in reverse order. The model holds a reference on each post through
+@ref Choqok::Post::owners, the same way @ref PostWidget does, so a post stays
+alive as long as either the model or a widget uses it.
+
+@see PostDelegate
+*/
+class CHOQOK_EXPORT PostModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        PostRole = Qt::UserRole + 1,
+        PostIdRole,
+        CreationDateTimeRole,
+        IsReadRole
+    };
+
+    explicit PostModel(bool reverseOrder = false, QObject *parent = 0);
+    virtual ~PostModel();
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /**
+    @brief Insert @p post at its place in the timeline
+    @return the row of the post, or -1 if a post with the same id already exists
+    */
+    int addPost(Choqok::Post *post);
+
+    /**
+    @brief Remove the post with id @p postId and release the model reference on it
+    */
+    void removePost(const QString &postId);
+
+    /**
+    @brief Notify views that the post with id @p postId has changed
+    */
+    void postChanged(const QString &postId);
+
+    bool contains(const QString &postId) const;
+    int rowOf(const QString &postId) const;
+    Choqok::Post *post(int row) const;
+
+    /**
+    @return all posts of the model, in display order
+    */
+    QList<Choqok::Post *> posts() const;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
+}
+
+#endif // POSTMODEL_H
@@ -0,0 +1,338 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "postpipeline.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+
+#include "choqokuiglobal.h"
+#include "libchoqokdebug.h"
+#include "postwidget.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+/// Time one slice may take, so the event loop keeps up with painting and input
+static const qint64 SLICE_BUDGET_MSECS = 8;
+
+static const char *const stageNames[PostPipeline::StageCount] = { "filter", "expand", "preview" };
+
+class PostPipeline::Private
+{
+public:
+    Private()
+        : sliceQueued(false), filteredPosts(0), droppedPosts(0), filterNsecs(0)
+    {}
+
+    struct Item {
+        QPointer<PostWidget> widget;
+        PostWidget *key;    // the widget, even after it was deleted
+        int stage;
+        bool urgent;
+        QElapsedTimer queued;
+    };
+
+    struct Statistics {
+        Statistics()
+            : posts(0), waitMsecs(0), maxWaitMsecs(0), busyNsecs(0), maxBusyNsecs(0)
+        {}
+        int posts;
+        qint64 waitMsecs;
+        qint64 maxWaitMsecs;
+        qint64 busyNsecs;
+        qint64 maxBusyNsecs;
+    };
+
+    /// First stage from @p stage on which has processors, or StageCount
+    int nextStage(int stage) const
+    {
+        while (stage < StageCount && processors[stage].isEmpty()) {
+            ++stage;
+        }
+        return stage;
+    }
+
+    void enqueue(PostWidget *widget, int stage, bool urgent)
+    {
+        Item item;
+        item.widget = widget;
+        item.key = widget;
+        item.stage = stage;
+        item.urgent = urgent;
+        item.queued.start();
+        if (urgent) {
+            urgentQueues[stage].append(item);
+        } else {
+            queues[stage].append(item);
+            waiting.insert(widget);
+        }
+    }
+
+    /// Moves the item of @p widget to the urgent queue of its stage, keeping the order otherwise
+    void prioritize(PostWidget *widget)
+    {
+        if (!waiting.remove(widget)) {
+            return;
+        }
+        for (int stage = 0; stage < StageCount; ++stage) {
+            QList<Item> &queue = queues[stage];
+            for (int i = 0; i < queue.size(); ++i) {
+                if (queue.at(i).key == widget && queue.at(i).widget) {
+                    Item item = queue.takeAt(i);
+                    item.urgent = true;
+                    urgentQueues[stage].append(item);
+                    return;
+                }
+            }
+        }
+    }
+
+    /// Takes the next item of the lowest stage with work, urgent ones first
+    bool takeNext(Item *item)
+    {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            if (!urgentQueues[stage].isEmpty()) {
+                *item = urgentQueues[stage].takeFirst();
+                return true;
+            }
+            if (!queues[stage].isEmpty()) {
+                *item = queues[stage].takeFirst();
+                waiting.remove(item->key);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool hasWork() const
+    {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            if (!urgentQueues[stage].isEmpty() || !queues[stage].isEmpty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QList<PostProcessor *> processors[StageCount];
+    /// Posts which were painted, see PostPipeline::prioritize()
+    QList<Item> urgentQueues[StageCount];
+    QList<Item> queues[StageCount];
+    /// Widgets with an item in queues, so painting a post that isn't waiting costs a lookup only
+    QSet<PostWidget *> waiting;
+    Statistics statistics[StageCount];
+    bool sliceQueued;
+
+    QList<PostFilter *> filters;
+    int filteredPosts;
+    int droppedPosts;
+    qint64 filterNsecs;
+};
+
+PostProcessor::~PostProcessor()
+{
+}
+
+PostFilter::~PostFilter()
+{
+}
+
+PostPipeline *PostPipeline::mSelf = nullptr;
+
+PostPipeline::PostPipeline()
+    : QObject(qApp), d(new Private)
+{
+    connect(Global::SessionManager::self(),
+            SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
+            this, SLOT(slotNewPostWidget(Choqok::UI::PostWidget*)));
+}
+
+PostPipeline::~PostPipeline()
+{
+    delete d;
+    mSelf = nullptr;
+}
+
+PostPipeline *PostPipeline::self()
+{
+    if (!mSelf) {
+        mSelf = new PostPipeline;
+    }
+    return mSelf;
+}
+
+void PostPipeline::addProcessor(Stage stage, PostProcessor *processor)
+{
+    if (stage < FilterStage || stage >= StageCount || d->processors[stage].contains(processor)) {
+        return;
+    }
+    d->processors[stage].append(processor);
+}
+
+void PostPipeline::removeProcessor(PostProcessor *processor)
+{
+    for (QList<PostProcessor *> &processors: d->processors) {
+        processors.removeAll(processor);
+    }
+}
+
+void PostPipeline::addFilter(PostFilter *filter)
+{
+    if (!d->filters.contains(filter)) {
+        d->filters.append(filter);
+    }
+}
+
+void PostPipeline::removeFilter(PostFilter *filter)
+{
+    d->filters.removeAll(filter);
+}
+
+bool PostPipeline::acceptPost(Choqok::Account *account, Choqok::Post *post)
+{
+    if (d->filters.isEmpty()) {
+        return true;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    bool accepted = true;
+    for (PostFilter *filter: d->filters) {
+        if (!filter->acceptPost(account, post)) {
+            accepted = false;
+            break;
+        }
+    }
+    ++d->filteredPosts;
+    d->filterNsecs += timer.nsecsElapsed();
+    if (!accepted) {
+        ++d->droppedPosts;
+    }
+    return accepted;
+}
+
+void PostPipeline::slotNewPostWidget(PostWidget *widget)
+{
+    if (!widget) {
+        return;
+    }
+    const int stage = d->nextStage(FilterStage);
+    if (stage == FilterStage) {
+        // Right away, the widget is not painted yet
+        runStage(widget, stage, 0, false);
+    } else if (stage < StageCount) {
+        d->enqueue(widget, stage, false);
+        scheduleSlice();
+    }
+}
+
+void PostPipeline::prioritize(PostWidget *widget)
+{
+    d->prioritize(widget);
+}
+
+void PostPipeline::processSlice()
+{
+    d->sliceQueued = false;
+    QElapsedTimer slice;
+    slice.start();
+    Private::Item item;
+    while (slice.elapsed() < SLICE_BUDGET_MSECS && d->takeNext(&item)) {
+        runStage(item.widget, item.stage, item.queued.elapsed(), item.urgent);
+    }
+    scheduleSlice();
+}
+
+void PostPipeline::runStage(PostWidget *widget, int stage, qint64 waitMsecs, bool urgent)
+{
+    // Deleted, or closed by a filter. A new widget is hidden until its layout shows it, that's fine
+    if (!widget || widget->isClosed()) {
+        return;
+    }
+
+    QPointer<PostWidget> guard(widget);
+    Private::Statistics &statistics = d->statistics[stage];
+    QElapsedTimer busy;
+    busy.start();
+    // A processor may remove itself while running
+    const QList<PostProcessor *> processors = d->processors[stage];
+    for (PostProcessor *processor: processors) {
+        if (guard && !widget->isClosed() && d->processors[stage].contains(processor)) {
+            processor->processPost(widget);
+        }
+    }
+    const qint64 busyNsecs = busy.nsecsElapsed();
+
+    ++statistics.posts;
+    statistics.waitMsecs += waitMsecs;
+    statistics.maxWaitMsecs = qMax(statistics.maxWaitMsecs, waitMsecs);
+    statistics.busyNsecs += busyNsecs;
+    statistics.maxBusyNsecs = qMax(statistics.maxBusyNsecs, busyNsecs);
+
+    const int next = d->nextStage(stage + 1);
+    if (next < StageCount && guard && !widget->isClosed()) {
+        d->enqueue(widget, next, urgent);
+        scheduleSlice();
+    }
+}
+
+void PostPipeline::scheduleSlice()
+{
+    if (!d->sliceQueued && d->hasWork()) {
+        d->sliceQueued = true;
+        QTimer::singleShot(0, this, SLOT(processSlice()));
+    }
+}
+
+QString PostPipeline::statistics() const
+{
+    QString result = QStringLiteral("before rendering: %1 posts, %2 dropped, %3 filters, avg %4 ms\n")
+                     .arg(d->filteredPosts)
+                     .arg(d->droppedPosts)
+                     .arg(d->filters.size())
+                     .arg(d->filterNsecs / qMax(d->filteredPosts, 1) / 1000000.0, 0, 'f', 3);
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const Private::Statistics &statistics = d->statistics[stage];
+        const int posts = qMax(statistics.posts, 1);
+        result += QStringLiteral("%1: %2 posts, %3 waiting, %4 processors, wait avg %5 ms max %6 ms, "
+                                 "processing avg %7 ms max %8 ms\n")
+                  .arg(QLatin1String(stageNames[stage]))
+                  .arg(statistics.posts)
+                  .arg(d->urgentQueues[stage].size() + d->queues[stage].size())
+                  .arg(d->processors[stage].size())
+                  .arg(statistics.waitMsecs / posts)
+                  .arg(statistics.maxWaitMsecs)
+                  .arg(statistics.busyNsecs / posts / 1000000.0, 0, 'f', 2)
+                  .arg(statistics.maxBusyNsecs / 1000000.0, 0, 'f', 2);
+    }
+    return result;
+}
+
+}
+}
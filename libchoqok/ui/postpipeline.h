@@ -0,0 +1,159 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef POSTPIPELINE_H
+#define POSTPIPELINE_H
+
+#include <QObject>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+
+class Account;
+class Post;
+
+namespace UI
+{
+
+class PostWidget;
+
+/**
+@brief Interface of plugins which process new posts, see @ref PostPipeline
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT PostProcessor
+{
+public:
+    virtual ~PostProcessor();
+
+    /**
+    Process @p widget, which is shown and has its entities available.
+    Should return quickly, and start anything slow (like network requests) asynchronously.
+    */
+    virtual void processPost(PostWidget *widget) = 0;
+};
+
+/**
+@brief Interface of plugins which drop new posts before they are shown, see @ref PostPipeline::acceptPost()
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT PostFilter
+{
+public:
+    virtual ~PostFilter();
+
+    /**
+    @return false to drop @p post, a new post of a timeline of @p account.
+    No widget exists for it yet, so this should only look at the post.
+    */
+    virtual bool acceptPost(Choqok::Account *account, Choqok::Post *post) = 0;
+};
+
+/**
+@brief Runs the post processing plugins on new posts
+
+Every new post widget passes the stages in order: filters, then expanding of links, then previews.
+Filters run as soon as the widget is added, so removed posts are never painted.
+The other stages run in slices of a few milliseconds between events, posts which were painted
+(see @ref prioritize()) first.
+Posts closed by a filter skip the later stages.
+
+Before that, @ref TimelineWidget asks the @ref PostFilter "post filters" about each new post,
+and doesn't create a widget at all for the ones they drop.
+
+@ref statistics() tells how long posts waited for each stage and how long the stage took.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT PostPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    enum Stage {
+        FilterStage = 0,
+        ExpandStage,
+        PreviewStage,
+        StageCount
+    };
+
+    ~PostPipeline();
+
+    static PostPipeline *self();
+
+    /**
+    Run @p processor for every new post in @p stage, processors of a stage run in the order they were added
+    */
+    void addProcessor(Stage stage, PostProcessor *processor);
+
+    /**
+    Stop running @p processor, e.g. because it is going to be destroyed
+    */
+    void removeProcessor(PostProcessor *processor);
+
+    /**
+    Ask @p filter about every new post of the timelines
+    */
+    void addFilter(PostFilter *filter);
+    void removeFilter(PostFilter *filter);
+
+    /**
+    @return true unless one of the filters drops @p post of @p account
+    */
+    bool acceptPost(Choqok::Account *account, Choqok::Post *post);
+
+    /**
+    Run the remaining stages of @p widget before those of posts which weren't painted yet.
+    Called by @ref PostWidget when it is painted, costs a lookup if it's not waiting.
+    */
+    void prioritize(PostWidget *widget);
+
+    /**
+    @return a human readable summary of posts dropped, and of posts processed, waiting times and
+    processing times per stage
+    */
+    QString statistics() const;
+
+protected Q_SLOTS:
+    void slotNewPostWidget(Choqok::UI::PostWidget *widget);
+    void processSlice();
+
+protected:
+    PostPipeline();
+
+private:
+    void runStage(PostWidget *widget, int stage, qint64 waitMsecs, bool urgent);
+    void scheduleSlice();
+
+    class Private;
+    Private *const d;
+    static PostPipeline *mSelf;
+};
+
+}
+}
+
+#endif // POSTPIPELINE_H
@@ -23,8 +23,12 @@ along with this program; if not, see http://www.gnu.org/licenses/
 
 #include <QCloseEvent>
 #include <QGridLayout>
+#include <QHash>
 #include <QTimer>
 #include <QPushButton>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextTable>
 
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -33,16 +37,16 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "choqokbehaviorsettings.h"
 #include "choqoktools.h"
 #include "choqokuiglobal.h"
+#include "entityscanner.h"
 #include "libchoqokdebug.h"
 #include "mediamanager.h"
+#include "postpipeline.h"
+#include "poststore.h"
 #include "quickpost.h"
+#include "relativetimeticker.h"
 #include "timelinewidget.h"
 #include "textbrowser.h"
-#include "urlutils.h"
 
-static const int _15SECS = 15000;
-static const int _MINUTE = 60000;
-static const int _HOUR = 60 * _MINUTE;
 
 using namespace Choqok;
 using namespace Choqok::UI;
@@ -52,6 +56,8 @@ class PostWidget::Private
 public:
     Private(Account *account, Choqok::Post *post)
         : mCurrentPost(post), mCurrentAccount(account), dir(QLatin1String("ltr")), timeline(0)
+        , dirtyParts(NoPart), updateQueued(false), relayoutCount(0), layoutStale(false), imageWidth(0)
+        , annotationsChanged(false), closed(false), removing(false), requestedPreview(nullptr)
     {
         mCurrentPost->owners++;
 
@@ -64,7 +70,6 @@ public:
     Post *mCurrentPost;
     Account *mCurrentAccount;
 //         bool mRead;
-    QTimer mTimer;
 
     //BEGIN UI contents:
     QString mSign;
@@ -74,16 +79,41 @@ public:
     QString imageUrl;
     QString dir;
     QPixmap originalImage;
+    // Post image scaled to the widths it was shown at, see PostWidget::updatePostImage()
+    QHash<int, QPixmap> scaledImages;
     QString extraContents;
+    QString timestampText;
+    /// The post text as last rendered into mContent, see PostWidget::renderContent()
+    QString renderedContent;
     //END UI contents;
 
     QStringList detectedUrls;
 
     TimelineWidget *timeline;
-    
+
+    /// Parts of the document changed since the last render, see PostWidget::scheduleUpdate()
+    int dirtyParts;
+    bool updateQueued;
+    int relayoutCount;
+    /// Resized while hidden, text and image are laid out for the old width
+    bool layoutStale;
+    int imageWidth;
+    /// Annotations were added since the content was rendered
+    bool annotationsChanged;
+    bool closed;
+    bool removing;
+    /// Receives a preview delivered from the memory cache while previewResource() requests it
+    QPixmap *requestedPreview;
+
     static const QLatin1String resourceImageUrl;
 };
 
+// Post images are scaled in steps of this many pixels, and that many sizes are kept
+static const int IMAGE_WIDTH_STEP = 32;
+static const int MAX_SCALED_IMAGES = 4;
+
+const QString mPreviewTemplate(QLatin1String("<br/><table><tr><td rowspan=2>%1</td><td><a href='%2' title='%2'><b>%3</b></a></td></tr><tr><font size=\"-1\">%4</font></tr></table>"));
+
 const QString mImageTemplate(QLatin1String("<div style=\"padding-top:5px;padding-bottom:3px;\"><img width=\"%1\" height=\"%2\" src=\"%3\"/></div>"));
 
 const QLatin1String PostWidget::Private::resourceImageUrl("img://postImage");
@@ -96,8 +126,6 @@ QPushButton{border:0px} QPushButton::menu-indicator{image:none;}"));
 
 const QString PostWidget::hrefTemplate(QLatin1String("<a href='%1' title='%1' target='_blank'>%2</a>"));
 
-const QRegExp PostWidget::dirRegExp(QLatin1String("(RT|RD)|(@([^\\s\\W]+))|(#([^\\s\\W]+))|(!([^\\s\\W]+))"));
-
 QString PostWidget::readStyle;
 QString PostWidget::unreadStyle;
 QString PostWidget::ownStyle;
@@ -111,10 +139,9 @@ PostWidget::PostWidget(Account *account, Choqok::Post *post, QWidget *parent/* =
     if (isOwnPost()) {
         d->mCurrentPost->isRead = true;
     }
-    d->mTimer.start(_MINUTE);
-    connect(&d->mTimer, SIGNAL(timeout()), this, SLOT(updateUi()));
     connect(_mainWidget, SIGNAL(clicked(QMouseEvent*)), SLOT(mousePressEvent(QMouseEvent*)));
     connect(_mainWidget, SIGNAL(anchorClicked(QUrl)), this, SLOT(checkAnchor(QUrl)));
+    PostStore::self()->subscribe(d->mCurrentPost, this, SLOT(slotPostChanged(Choqok::Account*,Choqok::Post*,int)));
 
     d->timeline = qobject_cast<TimelineWidget *>(parent);
 
@@ -125,8 +152,7 @@ void PostWidget::checkAnchor(const QUrl &url)
 {
     if (url.scheme() == QLatin1String("choqok")) {
         if (url.host() == QLatin1String("showoriginalpost")) {
-            setContent(prepareStatus(currentPost()->content).replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive));
-            updateUi();
+            setContent(renderContent());
         }
     } else {
         Choqok::openUrl(url);
@@ -135,6 +161,7 @@ void PostWidget::checkAnchor(const QUrl &url)
 
 PostWidget::~PostWidget()
 {
+    RelativeTimeTicker::self()->unschedule(this);
     if (d->mCurrentPost->owners < 2) {
         delete d->mCurrentPost;
     } else {
@@ -191,7 +218,7 @@ void PostWidget::setupUi()
 
     _mainWidget->setLayout(d->buttonsLayout);
     connect(_mainWidget, SIGNAL(textChanged()), this, SLOT(setHeight()));
-
+    _mainWidget->viewport()->installEventFilter(this);
 }
 
 void PostWidget::initUi()
@@ -211,37 +238,174 @@ void PostWidget::initUi()
     }
 
     d->mProfileImage = QLatin1String("<img src=\"img://profileImage\" title=\"") + d->mCurrentPost->author.realName + QLatin1String("\" width=\"48\" height=\"48\" />");
-    d->mContent = prepareStatus(d->mCurrentPost->content);
+    d->mContent = renderContent();
     d->mSign = generateSign();
     setupAvatar();
     fetchImage();
     d->dir = getDirection(d->mCurrentPost->content);
     setUiStyle();
 
-    d->mContent.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
-    d->mContent.replace(QLatin1String("\n"), QLatin1String("<br/>"));
     d->extraContents.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
     d->mSign.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
 
-    updateUi();
+    // Render right away, the timeline needs the real height to lay out the new post
+    d->dirtyParts = AllParts;
+    flushUpdates();
 }
 
-void PostWidget::updateUi()
+QDateTime PostWidget::displayedDateTime() const
 {
-    QDateTime time;
     if (d->mCurrentPost->repeatedDateTime.isNull()) {
-        time = d->mCurrentPost->creationDateTime;
+        return d->mCurrentPost->creationDateTime;
     } else {
-        time = d->mCurrentPost->repeatedDateTime;
+        return d->mCurrentPost->repeatedDateTime;
+    }
+}
+
+void PostWidget::updateUi()
+{
+    scheduleUpdate(AllParts);
+}
+
+void PostWidget::scheduleUpdate(int parts)
+{
+    d->dirtyParts |= parts;
+    if (!d->updateQueued) {
+        d->updateQueued = true;
+        QMetaObject::invokeMethod(this, "flushUpdates", Qt::QueuedConnection);
     }
+}
 
-    _mainWidget->setHtml(baseTextTemplate.arg( d->mProfileImage,                     /*1*/
-                                               d->mContent,                          /*2*/
-                                               d->mSign.arg(formatDateTime(time)),   /*3*/
-                                               d->dir,                               /*4*/
-                                               d->mImage,                            /*5*/
-                                               d->extraContents                      /*6*/
-                                               ));
+int PostWidget::relayoutCount() const
+{
+    return d->relayoutCount;
+}
+
+void PostWidget::flushUpdates()
+{
+    const int parts = d->dirtyParts;
+    d->dirtyParts = NoPart;
+    d->updateQueued = false;
+    if (parts == NoPart) {
+        return;
+    }
+
+    if (d->annotationsChanged) {
+        d->annotationsChanged = false;
+        // Plugins may have put more around the post text, only the text itself is replaced
+        const QString old = d->renderedContent;
+        const QString rendered = renderContent();
+        const int pos = old.isEmpty() ? -1 : d->mContent.indexOf(old);
+        if (pos >= 0) {
+            d->mContent.replace(pos, old.size(), rendered);
+        }
+    }
+
+    if (parts == AvatarPart) {
+        // Only an image resource changed, it has a fixed size so a repaint is enough
+        _mainWidget->viewport()->update();
+        return;
+    }
+
+    const QDateTime time = displayedDateTime();
+    const QString timestamp = formatDateTime(time);
+    bool patched = false;
+    if ((parts & ~(AvatarPart | ContentPart | SignPart)) == 0) {
+        patched = true;
+        if (parts & ContentPart) {
+            patched = replaceCellContents(0, QLatin1String("<p>") + d->mContent + QLatin1String("</p>"));
+        }
+        if (patched && (parts & SignPart)) {
+            patched = replaceCellContents(-1, QLatin1String("<span style=\"font-size:small;\">") +
+                                          d->mSign.arg(timestamp) + QLatin1String("</span>"));
+        }
+    }
+
+    if (!patched) {
+        _mainWidget->setHtml(baseTextTemplate.arg( d->mProfileImage,                     /*1*/
+                                                   d->mContent,                          /*2*/
+                                                   d->mSign.arg(timestamp),              /*3*/
+                                                   d->dir,                               /*4*/
+                                                   d->mImage,                            /*5*/
+                                                   d->extraContents                      /*6*/
+                                                   ));
+    }
+
+    ++d->relayoutCount;
+    qCDebug(CHOQOK) << "Post" << d->mCurrentPost->postId << (patched ? "patched" : "rebuilt")
+                    << "re-layouts:" << d->relayoutCount;
+
+    if (!patched || (parts & SignPart)) {
+        d->timestampText = timestamp;
+        RelativeTimeTicker::self()->schedule(this, time);
+    }
+}
+
+bool PostWidget::replaceCellContents(int row, const QString &html)
+{
+    QTextTable *table = nullptr;
+    for (QTextFrame *frame: _mainWidget->document()->rootFrame()->childFrames()) {
+        table = qobject_cast<QTextTable *>(frame);
+        if (table) {
+            break;
+        }
+    }
+    if (!table || table->columns() < 2) {
+        return false;
+    }
+    if (row < 0) {
+        row = table->rows() - 1;
+    }
+    const QTextTableCell cell = table->cellAt(row, 1);
+    if (!cell.isValid()) {
+        return false;
+    }
+
+    QTextCursor cursor = cell.firstCursorPosition();
+    cursor.setPosition(cell.lastCursorPosition().position(), QTextCursor::KeepAnchor);
+    cursor.insertHtml(html);
+    return true;
+}
+
+void PostWidget::updateTimestamp()
+{
+    const QDateTime time = displayedDateTime();
+    const QString text = formatDateTime(time);
+    if (text != d->timestampText && !(d->dirtyParts & SignPart)) {
+        // The timestamp is the last text of the sign, so search backwards for it
+        // and patch it in place instead of re-laying out the whole document.
+        QTextDocument *doc = _mainWidget->document();
+        QTextCursor cursor(doc);
+        cursor.movePosition(QTextCursor::End);
+        if (!d->timestampText.isEmpty()) {
+            cursor = doc->find(d->timestampText, cursor, QTextDocument::FindBackward | QTextDocument::FindCaseSensitively);
+        }
+        if (d->timestampText.isEmpty() || cursor.isNull()) {
+            updateUi();
+            return;
+        }
+        cursor.insertText(text, cursor.charFormat());
+        d->timestampText = text;
+    }
+    RelativeTimeTicker::self()->schedule(this, time);
+}
+
+bool PostWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && watched == _mainWidget->viewport()) {
+        // On screen now, so its images are wanted before those of hidden posts
+        MediaManager::self()->prioritize(this);
+        PostPipeline::self()->prioritize(this);
+        if (d->layoutStale) {
+            QTimer::singleShot(0, this, SLOT(updateLayout()));
+        }
+        if (RelativeTimeTicker::self()->isStale(this)) {
+            // Label got outdated while hidden, refresh it once painting is done
+            RelativeTimeTicker::self()->unschedule(this);
+            QTimer::singleShot(0, this, SLOT(updateTimestamp()));
+        }
+    }
+    return QWidget::eventFilter(watched, event);
 }
 
 void PostWidget::setStyle(const QColor &color, const QColor &back, const QColor &read, const QColor &readBack, const QColor &own, const QColor &ownBack, const QFont &font)
@@ -284,6 +448,7 @@ Post *PostWidget::currentPost() const
 void PostWidget::setCurrentPost(Post *post)
 {
     d->mCurrentPost = post;
+    PostStore::self()->subscribe(post, this, SLOT(slotPostChanged(Choqok::Account*,Choqok::Post*,int)));
 }
 
 void PostWidget::setRead(bool read/* = true*/)
@@ -295,6 +460,22 @@ void PostWidget::setRead(bool read/* = true*/)
     } else if (currentPost()->isRead != read) {
         d->mCurrentPost->isRead = read;
         setUiStyle();
+        if (d->mCurrentPost->owners > 1) {
+            PostStore::self()->notifyChanged(d->mCurrentAccount, d->mCurrentPost);
+        }
+    }
+}
+
+void PostWidget::slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes)
+{
+    if (theAccount != d->mCurrentAccount || post != d->mCurrentPost) {
+        return;
+    }
+    if (changes & PostStore::StateChanged) {
+        setUiStyle();
+    }
+    if (changes & PostStore::ContentChanged) {
+        updateUi();
     }
 }
 
@@ -313,15 +494,23 @@ bool PostWidget::isRead() const
 
 void PostWidget::setUiStyle()
 {
+    QString style;
     if (isOwnPost()) {
-        setStyleSheet(ownStyle);
+        style = ownStyle;
     } else {
         if (currentPost()->isRead) {
-            setStyleSheet(readStyle);
+            style = readStyle;
         } else {
-            setStyleSheet(unreadStyle);
+            style = unreadStyle;
         }
     }
+    for (const Choqok::Annotation &annotation: currentPost()->annotations) {
+        if (annotation.type == Choqok::Annotation::Highlight) {
+            style.replace(QLatin1String("border: 1px solid rgb(150,150,150)"), QLatin1String("border: 2px solid rgb(255,0,0)"));
+            break;
+        }
+    }
+    setStyleSheet(style);
     setHeight();
 }
 
@@ -343,10 +532,22 @@ void PostWidget::closeEvent(QCloseEvent *event)
     if (!isRead()) {
         setReadWithSignal();
     }
+    d->closed = true;
     Q_EMIT aboutClosing(currentPost()->postId, this);
+    MediaManager::self()->cancel(QString(), this);
     event->accept();
 }
 
+bool PostWidget::isClosed() const
+{
+    return d->closed;
+}
+
+bool PostWidget::isRemoving() const
+{
+    return d->removing;
+}
+
 void PostWidget::mousePressEvent(QMouseEvent *ev)
 {
     if (!isRead()) {
@@ -357,12 +558,32 @@ void PostWidget::mousePressEvent(QMouseEvent *ev)
 
 void PostWidget::resizeEvent(QResizeEvent *event)
 {
-    updatePostImage( event->size().width() );
-    setHeight();
-    updateUi();
+    const bool wasStale = d->layoutStale;
+    d->layoutStale = true;
+    if (!d->timeline || !visibleRegion().isEmpty()) {
+        updateLayout();
+    } else if (!wasStale) {
+        // Hidden posts follow once resizing is over, or when they are shown
+        d->timeline->scheduleLayoutUpdate(this);
+    }
     QWidget::resizeEvent(event);
 }
 
+void PostWidget::updateLayout()
+{
+    if (!d->layoutStale) {
+        return;
+    }
+    d->layoutStale = false;
+    // Text is re-wrapped by the document itself, only a rescaled post image needs a new render
+    const QString image = d->mImage;
+    updatePostImage( width() );
+    setHeight();
+    if (image != d->mImage) {
+        updateUi();
+    }
+}
+
 void PostWidget::enterEvent(QEvent *event)
 {
     for (QPushButton *btn: buttons()) {
@@ -388,50 +609,120 @@ void PostWidget::updatePostImage(int width)
     if ( !d->originalImage.isNull() ) {
         // TODO: Find a way to calculate the difference we need to subtract.
         width -= 76;
-        
-        QPixmap newPixmap = d->originalImage.scaledToWidth(width, Qt::SmoothTransformation);
-        auto newW = newPixmap.width();
-        auto newH = newPixmap.height();
-        auto origW = d->originalImage.width();
-        auto origH = d->originalImage.height();
-        
-        const QUrl url(d->resourceImageUrl);
-        // only use scaled image if it's smaller than the original one
-        if (newW <= origW && newH <= origH) { // never scale up
-            d->mImage = mImageTemplate.arg(QString::number(newW), QString::number(newH), d->resourceImageUrl);
-            _mainWidget->document()->addResource(QTextDocument::ImageResource, url, newPixmap);
+        // Scale to steps of IMAGE_WIDTH_STEP pixels only, so that resizing a bit reuses the last image
+        width = qMax(IMAGE_WIDTH_STEP, width - width % IMAGE_WIDTH_STEP);
+        // never scale up
+        width = qMin(width, d->originalImage.width());
+        if (width == d->imageWidth) {
+            return;
+        }
+        d->imageWidth = width;
+
+        QPixmap newPixmap;
+        if (width == d->originalImage.width()) {
+            newPixmap = d->originalImage;
         } else {
-            d->mImage = mImageTemplate.arg(QString::number(origW), QString::number(origH), d->resourceImageUrl);
-            _mainWidget->document()->addResource(QTextDocument::ImageResource, url, d->originalImage);
+            newPixmap = d->scaledImages.value(width);
+            if (newPixmap.isNull()) {
+                if (d->scaledImages.count() >= MAX_SCALED_IMAGES) {
+                    d->scaledImages.clear();
+                }
+                newPixmap = d->originalImage.scaledToWidth(width, Qt::SmoothTransformation);
+                d->scaledImages.insert(width, newPixmap);
+            }
         }
+
+        const QUrl url(d->resourceImageUrl);
+        d->mImage = mImageTemplate.arg(QString::number(newPixmap.width()), QString::number(newPixmap.height()),
+                                       d->resourceImageUrl);
+        _mainWidget->document()->addResource(QTextDocument::ImageResource, url, newPixmap);
+    }
+}
+
+/// The href of a link for @p entity, whose text is @p text
+static QString linkTarget(const Choqok::Entity &entity, const QString &text)
+{
+    if (entity.type == Choqok::Entity::Email) {
+        return entity.target.isEmpty() ? QLatin1String("mailto:") + text : entity.target;
+    }
+    QString url = entity.target.isEmpty() ? text : entity.target;
+    if (entity.type == Choqok::Entity::Url && !url.startsWith(QLatin1String("http"), Qt::CaseInsensitive) &&
+            !url.startsWith(QLatin1String("ftp"), Qt::CaseInsensitive)) {
+        url.prepend(QLatin1String("http://"));
     }
+    return url;
 }
 
 QString PostWidget::prepareStatus(const QString &txt)
 {
-    QString text = removeTags(txt);
+    // The entities of the post are found once and kept, other texts (e.g. quotes) are scanned every time
+    const bool isContent = txt == d->mCurrentPost->content;
+    const QList<Choqok::Entity> entities = isContent ? this->entities() : Choqok::EntityScanner::scan(txt);
+    const QList<Choqok::Annotation> annotations = isContent ? d->mCurrentPost->annotations : QList<Choqok::Annotation>();
 
-    d->detectedUrls = UrlUtils::detectUrls(text);
-    for (const QString &url: d->detectedUrls) {
-        QString httpUrl(url);
-        if (!httpUrl.startsWith(QLatin1String("http"), Qt::CaseInsensitive) &&
-                !httpUrl.startsWith(QLatin1String("ftp"), Qt::CaseInsensitive)) {
-            httpUrl.prepend(QLatin1String("http://"));
-            text.replace(url, httpUrl);
+    QString text;
+    text.reserve(txt.size() * 2);
+    if (isContent) {
+        d->detectedUrls.clear();
+    }
+    int pos = 0;
+    for (int i = 0; i < entities.size(); ++i) {
+        const Choqok::Entity &entity = entities.at(i);
+        if (entity.start < pos || entity.length <= 0 || entity.start + entity.length > txt.size()) {
+            continue;
         }
-
-        text.replace(url, hrefTemplate.arg(httpUrl, url));
+        const QString entityText = txt.mid(entity.start, entity.length);
+        if (isContent && entity.type == Choqok::Entity::Url) {
+            d->detectedUrls << linkTarget(entity, entityText);
+        }
+        text += removeTags(txt.mid(pos, entity.start - pos));
+
+        Choqok::Entity shown(entity);
+        QString thumbnail;
+        for (const Choqok::Annotation &annotation: annotations) {
+            if (annotation.entity != i) {
+                continue;
+            }
+            if (annotation.type == Choqok::Annotation::ExpandedUrl && !annotation.url.isEmpty()) {
+                shown.target = annotation.url;
+            } else if (annotation.type == Choqok::Annotation::Thumbnail) {
+                thumbnail = previewResource(annotation.imageUrl);
+            }
+        }
+        if (thumbnail.isEmpty()) {
+            text += entityToHtml(shown, entityText);
+        } else {
+            text += hrefTemplate.arg(linkTarget(shown, entityText),
+                                     QLatin1String("<img align='left' src='") + thumbnail + QLatin1String("' />"));
+        }
+        pos = entity.start + entity.length;
     }
-
-    text = UrlUtils::detectEmails(text);
+    text += removeTags(txt.mid(pos));
 
     if (AppearanceSettings::isEmoticonsEnabled()) {
         text = MediaManager::self()->parseEmoticons(text);
     }
 
+    for (const Choqok::Annotation &annotation: annotations) {
+        if (annotation.type == Choqok::Annotation::Preview) {
+            const QString image = previewResource(annotation.imageUrl);
+            text += mPreviewTemplate.arg(image.isEmpty() ? QString() : QLatin1String("<img align='left' height=64 src='") + image + QLatin1String("' />"),
+                                         annotation.url, annotation.title.toHtmlEscaped(),
+                                         annotation.description.toHtmlEscaped());
+        }
+    }
+
     return text;
 }
 
+QString PostWidget::entityToHtml(const Choqok::Entity &entity, const QString &text)
+{
+    if (entity.type == Choqok::Entity::Url || entity.type == Choqok::Entity::Email || !entity.target.isEmpty()) {
+        return hrefTemplate.arg(linkTarget(entity, text), removeTags(text));
+    }
+    return removeTags(text);
+}
+
 QString PostWidget::removeTags(const QString &text) const
 {
     QString txt(text);
@@ -443,7 +734,17 @@ QString PostWidget::removeTags(const QString &text) const
 }
 QLatin1String PostWidget::getDirection(QString txt)
 {
-    txt.remove(dirRegExp);
+    // Mentions, tags, groups and retweet marks don't tell the direction of the text
+    const QList<Choqok::Entity> entities = Choqok::EntityScanner::scan(txt);
+    for (int i = entities.size() - 1; i >= 0; --i) {
+        const Choqok::Entity &entity = entities.at(i);
+        if (entity.type == Choqok::Entity::Mention || entity.type == Choqok::Entity::Hashtag ||
+                entity.type == Choqok::Entity::Group) {
+            txt.remove(entity.start, entity.length);
+        }
+    }
+    txt.remove(QLatin1String("RT"));
+    txt.remove(QLatin1String("RD"));
     txt = txt.trimmed();
     if (txt.isRightToLeft()) {
         return QLatin1String("rtl");
@@ -460,28 +761,23 @@ QString PostWidget::formatDateTime(const QDateTime &time)
     }
     auto seconds = time.secsTo(QDateTime::currentDateTime());
     if (seconds <= 15) {
-        d->mTimer.setInterval(_15SECS);
         return i18n("Just now");
     }
 
     if (seconds <= 45) {
-        d->mTimer.setInterval(_15SECS);
         return i18np("1 sec ago", "%1 secs ago", seconds);
     }
 
     auto minutes = (seconds - 45 + 59) / 60;
     if (minutes <= 45) {
-        d->mTimer.setInterval(_MINUTE);
         return i18np("1 min ago", "%1 mins ago", minutes);
     }
 
     auto hours = (seconds - 45 * 60 + 3599) / 3600;
     if (hours <= 18) {
-        d->mTimer.setInterval(_MINUTE * 15);
         return i18np("1 hour ago", "%1 hours ago", hours);
     }
 
-    d->mTimer.setInterval(_HOUR);
     auto days = (seconds - 18 * 3600 + 24 * 3600 - 1) / (24 * 3600);
     return i18np("1 day ago", "%1 days ago", days);
 }
@@ -495,6 +791,7 @@ void PostWidget::removeCurrentPost()
                 SIGNAL(errorPost(Choqok::Account*,Choqok::Post*,Choqok::MicroBlog::ErrorType,QString)),
                 this, SLOT(slotPostError(Choqok::Account*,Choqok::Post*,Choqok::MicroBlog::ErrorType,QString)));
         setReadWithSignal();
+        d->removing = true;
         d->mCurrentAccount->microblog()->removePost(d->mCurrentAccount, d->mCurrentPost);
     }
 }
@@ -533,38 +830,40 @@ void PostWidget::fetchImage()
         return;
     }
 
-    QPixmap pix = MediaManager::self()->fetchImage(d->imageUrl, MediaManager::Async);
-
-    if (!pix.isNull()) {
-        slotImageFetched(d->imageUrl, pix);
-    } else {
-        connect(MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                this, SLOT(slotImageFetched(QString,QPixmap)));
-    }
+    MediaManager::self()->request(d->imageUrl, this, SLOT(slotImageFetched(QString,QPixmap)), nullptr,
+                                  MediaManager::PostImage);
 }
 
 void PostWidget::slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap)
 {
     if (remoteUrl == d->imageUrl) {
-        disconnect(MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)), this, SLOT(slotImageFetched(QString,QPixmap)));
         d->originalImage = pixmap;
+        d->scaledImages.clear();
+        d->imageWidth = 0;
         updatePostImage( width() );
         updateUi();
     }
 }
 
-void PostWidget::setupAvatar()
+void PostWidget::slotPreviewFetched(const QString &remoteUrl, const QPixmap &pixmap)
 {
-    QPixmap pix = MediaManager::self()->fetchImage(d->mCurrentPost->author.profileImageUrl,
-                  MediaManager::Async);
-    if (!pix.isNull()) {
-        avatarFetched(d->mCurrentPost->author.profileImageUrl, pix);
-    } else {
-        connect(MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                this, SLOT(avatarFetched(QString,QPixmap)));
-        connect(MediaManager::self(), SIGNAL(fetchError(QString,QString)),
-                this, SLOT(avatarFetchError(QString,QString)));
+    if (d->requestedPreview) {
+        // Was in the memory cache, previewResource() adds it
+        *d->requestedPreview = pixmap;
+        return;
     }
+    QUrl url(remoteUrl);
+    url.setScheme(QLatin1String("img"));
+    _mainWidget->document()->addResource(QTextDocument::ImageResource, url, pixmap);
+    d->annotationsChanged = true;
+    scheduleUpdate(ContentPart);
+}
+
+void PostWidget::setupAvatar()
+{
+    MediaManager::self()->request(d->mCurrentPost->author.profileImageUrl, this,
+                                  SLOT(avatarFetched(QString,QPixmap)),
+                                  SLOT(avatarFetchError(QString,QString)), MediaManager::AvatarImage);
 }
 
 void PostWidget::avatarFetched(const QString &remoteUrl, const QPixmap &pixmap)
@@ -572,11 +871,7 @@ void PostWidget::avatarFetched(const QString &remoteUrl, const QPixmap &pixmap)
     if (remoteUrl == d->mCurrentPost->author.profileImageUrl) {
         const QUrl url(QLatin1String("img://profileImage"));
         _mainWidget->document()->addResource(QTextDocument::ImageResource, url, pixmap);
-        updateUi();
-        disconnect(MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                   this, SLOT(avatarFetched(QString,QPixmap)));
-        disconnect(MediaManager::self(), SIGNAL(fetchError(QString,QString)),
-                   this, SLOT(avatarFetchError(QString,QString)));
+        scheduleUpdate(AvatarPart);
     }
 }
 
@@ -584,11 +879,11 @@ void PostWidget::avatarFetchError(const QString &remoteUrl, const QString &errMs
 {
     Q_UNUSED(errMsg);
     if (remoteUrl == d->mCurrentPost->author.profileImageUrl) {
-        ///Avatar fetching is failed! but will not disconnect to get the img if it fetches later!
+        ///Avatar fetching is failed!
         const QUrl url(QLatin1String("img://profileImage"));
         _mainWidget->document()->addResource(QTextDocument::ImageResource,
                                              url, QIcon::fromTheme(QLatin1String("image-missing")).pixmap(48));
-        updateUi();
+        scheduleUpdate(AvatarPart);
     }
 }
 
@@ -602,6 +897,7 @@ void PostWidget::slotPostError(Account *theAccount, Choqok::Post *post,
 {
     if (theAccount == currentAccount() && post == d->mCurrentPost) {
         qCDebug(CHOQOK) << errorMessage;
+        d->removing = false;
         disconnect(d->mCurrentAccount->microblog(), SIGNAL(postRemoved(Choqok::Account*,Choqok::Post*)),
                    this, SLOT(slotCurrentPostRemoved(Choqok::Account*,Choqok::Post*)));
         disconnect(d->mCurrentAccount->microblog(),
@@ -629,7 +925,7 @@ QString PostWidget::content() const
 void PostWidget::setContent(const QString &content)
 {
     d->mContent = content;
-    updateUi();
+    scheduleUpdate(ContentPart);
 }
 
 QStringList PostWidget::urls()
@@ -637,6 +933,70 @@ QStringList PostWidget::urls()
     return d->detectedUrls;
 }
 
+QList<Choqok::Entity> PostWidget::entities()
+{
+    if (d->mCurrentPost->entities.isEmpty()) {
+        d->mCurrentPost->entities = Choqok::EntityScanner::scan(d->mCurrentPost->content);
+    }
+    return d->mCurrentPost->entities;
+}
+
+void PostWidget::addAnnotation(const Choqok::Annotation &annotation)
+{
+    QList<Choqok::Annotation> &annotations = d->mCurrentPost->annotations;
+    if (annotations.contains(annotation)) {
+        return;
+    }
+    if (annotation.type == Choqok::Annotation::ExpandedUrl) {
+        for (int i = annotations.size() - 1; i >= 0; --i) {
+            if (annotations.at(i).type == Choqok::Annotation::ExpandedUrl && annotations.at(i).entity == annotation.entity) {
+                annotations.removeAt(i);
+            }
+        }
+    }
+    annotations.append(annotation);
+
+    if (annotation.type == Choqok::Annotation::Highlight) {
+        setUiStyle();
+    } else {
+        // Several plugins annotating the same post cause one render
+        d->annotationsChanged = true;
+        scheduleUpdate(ContentPart);
+    }
+}
+
+QString PostWidget::renderContent()
+{
+    QString content = prepareStatus(d->mCurrentPost->content);
+    content.replace(QLatin1String("<a href"), QLatin1String("<a style=\"text-decoration:none\" href"), Qt::CaseInsensitive);
+    content.replace(QLatin1String("\n"), QLatin1String("<br/>"));
+    d->renderedContent = content;
+    return content;
+}
+
+QString PostWidget::previewResource(const QString &remoteUrl)
+{
+    if (remoteUrl.isEmpty()) {
+        return QString();
+    }
+    QUrl url(remoteUrl);
+    url.setScheme(QLatin1String("img"));
+    QTextDocument *document = _mainWidget->document();
+    if (document->resource(QTextDocument::ImageResource, url).isNull()) {
+        // Added by the plugin to another widget of the same post, rendered again once it's here
+        QPixmap pixmap;
+        d->requestedPreview = &pixmap;
+        MediaManager::self()->request(remoteUrl, this, SLOT(slotPreviewFetched(QString,QPixmap)), nullptr,
+                                      MediaManager::PreviewImage);
+        d->requestedPreview = nullptr;
+        if (pixmap.isNull()) {
+            return QString();
+        }
+        document->addResource(QTextDocument::ImageResource, url, pixmap);
+    }
+    return url.toDisplayString();
+}
+
 QString PostWidget::sign() const
 {
     return d->mSign;
@@ -645,7 +1005,7 @@ QString PostWidget::sign() const
 void PostWidget::setSign(const QString &sign)
 {
     d->mSign = sign;
-    updateUi();
+    scheduleUpdate(SignPart);
 }
 
 void PostWidget::deleteLater()
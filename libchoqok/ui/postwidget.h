@@ -117,8 +117,37 @@ public:
 
     QStringList urls();
 
+    /**
+    @return the entities of the post content, found the first time they are needed.
+    Plugins should use these instead of searching the content again.
+    */
+    QList<Choqok::Entity> entities();
+
+    /**
+    Add @p annotation to the post, the content is rendered again with all annotations before the next paint.
+    An @ref Choqok::Annotation::ExpandedUrl replaces an earlier one of the same entity.
+    */
+    void addAnnotation(const Choqok::Annotation &annotation);
+
     TimelineWidget *timelineWidget() const;
 
+    /**
+    @return number of times the document of this post was laid out again, for debugging
+    */
+    int relayoutCount() const;
+
+    /**
+    @return true once the widget was closed, e.g. by a filter, it is deleted soon.
+    Unlike isHidden() this is false for a widget which its layout didn't show yet.
+    */
+    bool isClosed() const;
+
+    /**
+    @return true while the user's request to remove the post from the server is running,
+    the widget closes itself once it's removed.
+    */
+    bool isRemoving() const;
+
     /**
      * Plugins can add status specific actions and process them internally
      *
@@ -128,12 +157,23 @@ public:
     static QString getBaseStyle();
 
 public Q_SLOTS:
+    /**
+    Lay out text and post image for the current width, if that was put off while the widget was hidden
+    */
+    void updateLayout();
+
     /**
     Set Style sheet of widget to corresponding data->
     @see setStyle()
     */
     void setUiStyle();
 
+    /**
+    Update the relative time label, e.g. "5 mins ago", without rebuilding the whole content
+    @see RelativeTimeTicker
+    */
+    void updateTimestamp();
+
 Q_SIGNALS:
     /**
     Emit and contain text to resend.
@@ -167,6 +207,11 @@ protected Q_SLOTS:
     */
     virtual void updateUi();
 
+    /**
+    Render all changes scheduled with @ref scheduleUpdate() now
+    */
+    void flushUpdates();
+
     /**
     Call microblog() to remove this post!
     */
@@ -180,6 +225,13 @@ protected Q_SLOTS:
     */
     void slotCurrentPostRemoved(Choqok::Account *theAccount, Choqok::Post *post);
 
+    /**
+    Show the new state or content of the post, if @p post is the current one and was changed elsewhere.
+    Subclasses update their own parts, e.g. the favorite button.
+    @see PostStore::subscribe()
+    */
+    virtual void slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes);
+
     virtual void slotPostError(Choqok::Account *theAccount, Choqok::Post *post,
                                Choqok::MicroBlog::ErrorType error, const QString &errorMessage);
 
@@ -187,9 +239,29 @@ protected Q_SLOTS:
     void avatarFetched(const QString &remoteUrl, const QPixmap &pixmap);
 
     void slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap);
+    void slotPreviewFetched(const QString &remoteUrl, const QPixmap &pixmap);
     virtual void mousePressEvent(QMouseEvent *ev) override;
 
 protected:
+    /**
+    Parts of the post document, to tell @ref scheduleUpdate() what has changed
+    */
+    enum UiPart {
+        NoPart = 0,
+        AvatarPart = 0x01,  ///< Avatar image resource only
+        ContentPart = 0x02, ///< @ref content()
+        SignPart = 0x04,    ///< @ref sign() and timestamp
+        AllParts = 0xFF
+    };
+
+    /**
+    @brief Render changed @p parts on the next event loop iteration
+
+    Changes scheduled before that are merged into a single render, and content and
+    sign changes are patched into the existing document instead of rebuilding it.
+    */
+    void scheduleUpdate(int parts);
+
     virtual void setupUi();
     virtual void closeEvent(QCloseEvent *event) override;
     virtual void setupAvatar();
@@ -198,10 +270,24 @@ protected:
     virtual void resizeEvent(QResizeEvent *event) override;
     virtual void enterEvent(QEvent *event) override;
     virtual void leaveEvent(QEvent *event) override;
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
     virtual QString prepareStatus(const QString &text);
+    /**
+    @return the content of the post, as HTML for @ref setContent(), with the annotations applied
+    */
+    QString renderContent();
+    /**
+    @return the HTML for @p entity of the post text, @p text is the part of the text it covers.
+    The default links URLs, e-mail addresses and every entity with a target, and escapes the rest.
+    */
+    virtual QString entityToHtml(const Choqok::Entity &entity, const QString &text);
     QLatin1String getDirection(QString text);
     virtual QString generateSign();
     virtual QString formatDateTime(const QDateTime &time);
+    /**
+    @return repeat time of the post if it's a repeat, its creation time otherwise
+    */
+    QDateTime displayedDateTime() const;
     virtual bool isResendAvailable() ;
     virtual bool isRemoveAvailable() ;
     virtual bool isOwnPost();
@@ -226,7 +312,6 @@ protected:
     static const QString webIconText;
     static const QString hrefTemplate;
     static const QString baseTextTemplate;
-    static const QRegExp dirRegExp;
 
     void setAvatarText(const QString &text);
     QString avatarText() const;
@@ -236,6 +321,9 @@ protected:
     void updatePostImage(int width);
 
 private:
+    bool replaceCellContents(int row, const QString &html);
+    QString previewResource(const QString &remoteUrl);
+
     class Private;
     Private *const d;
 };
@@ -59,6 +59,8 @@ public:
     QList<Account *> submittedAccounts;
     bool isPostSubmitted;
     QPushButton *attach;
+    /// Submitted text waiting for its URLs to be shortened
+    QString textToShorten;
 //     QString replyToId;
 };
 
@@ -175,12 +177,32 @@ void QuickPost::submitPost(const QString &txt)
         return;
     }
     this->hide();
-    d->submittedAccounts.clear();
-    QString newPost = txt;
     if (currentAccount->postCharLimit() &&
             txt.size() > (int)currentAccount->postCharLimit()) {
-        newPost = Choqok::ShortenManager::self()->parseText(txt);
+        // Sent once shortened, the result may be delivered right away
+        d->textToShorten = txt;
+        Choqok::ShortenManager::self()->parseText(txt, this, SLOT(slotTextShortened(QString,QString)));
+    } else {
+        sendPost(txt);
+    }
+}
+
+void QuickPost::slotTextShortened(const QString &text, const QString &result)
+{
+    if (text != d->textToShorten) {
+        return;
     }
+    d->textToShorten.clear();
+    sendPost(result);
+}
+
+void QuickPost::sendPost(const QString &newPost)
+{
+    Choqok::Account *currentAccount = d->accountsList.value(d->comboAccounts->currentText());
+    if (!currentAccount) {
+        return;
+    }
+    d->submittedAccounts.clear();
     delete d->submittedPost;
     if (d->all->isChecked()) {
         d->submittedPost = new Post;
@@ -76,8 +76,12 @@ protected Q_SLOTS:
     void postError(Choqok::Account *theAccount, Choqok::Post *post,
                    Choqok::MicroBlog::ErrorType error, const QString &errorMessage);
 
+private Q_SLOTS:
+    void slotTextShortened(const QString &text, const QString &result);
+
 private:
     void setupUi();
+    void sendPost(const QString &text);
     class Private;
     Private *const d;
 };
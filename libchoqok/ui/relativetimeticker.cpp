@@ -0,0 +1,170 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "relativetimeticker.h"
+
+#include <QApplication>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QTimer>
+
+#include "postwidget.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+static const qint64 _15SECS = 15;
+static const qint64 _MINUTE = 60;
+static const qint64 _HOUR = 60 * _MINUTE;
+static const qint64 _DAY = 24 * _HOUR;
+
+/// Buckets due within this many msecs are handled by the same wake up
+static const qint64 SLACK_MSECS = 500;
+
+class RelativeTimeTicker::Private
+{
+public:
+    QMap<qint64, QSet<PostWidget *> > buckets; // <due time in msecs since epoch, widgets>
+    QHash<PostWidget *, qint64> dueTimes;
+    QSet<PostWidget *> stale;
+    QTimer timer;
+};
+
+RelativeTimeTicker *RelativeTimeTicker::mSelf = nullptr;
+
+RelativeTimeTicker::RelativeTimeTicker()
+    : QObject(qApp), d(new Private)
+{
+    d->timer.setSingleShot(true);
+    connect(&d->timer, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+}
+
+RelativeTimeTicker::~RelativeTimeTicker()
+{
+    delete d;
+    mSelf = nullptr;
+}
+
+RelativeTimeTicker *RelativeTimeTicker::self()
+{
+    if (!mSelf) {
+        mSelf = new RelativeTimeTicker;
+    }
+    return mSelf;
+}
+
+qint64 RelativeTimeTicker::secsToNextChange(qint64 age)
+{
+    if (age <= 15) {
+        // "Just now"
+        return 16 - age;
+    }
+    if (age <= 45) {
+        // "x secs ago", no need to be exact here
+        return qMin(_15SECS, 46 - age);
+    }
+    const qint64 minutes = (age - 45 + 59) / _MINUTE;
+    if (minutes <= 45) {
+        return (minutes + 1) * _MINUTE - 14 - age;
+    }
+    const qint64 hours = (age - 45 * _MINUTE + 3599) / _HOUR;
+    if (hours <= 18) {
+        return (hours + 1) * _HOUR - 899 - age;
+    }
+    const qint64 days = (age - 18 * _HOUR + _DAY - 1) / _DAY;
+    return (days + 1) * _DAY - 21599 - age;
+}
+
+void RelativeTimeTicker::schedule(PostWidget *widget, const QDateTime &time)
+{
+    unschedule(widget);
+    if (!time.isValid()) {
+        return;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    qint64 due = now.toMSecsSinceEpoch() + secsToNextChange(time.secsTo(now)) * 1000;
+    // Round up to whole seconds, so posts created in the same second share a bucket
+    due = ((due + 999) / 1000) * 1000;
+
+    d->buckets[due].insert(widget);
+    d->dueTimes.insert(widget, due);
+
+    const qint64 wait = qMax<qint64>(0, d->buckets.firstKey() - QDateTime::currentMSecsSinceEpoch());
+    if (!d->timer.isActive() || d->timer.remainingTime() > wait) {
+        d->timer.start(int(wait));
+    }
+}
+
+void RelativeTimeTicker::unschedule(PostWidget *widget)
+{
+    d->stale.remove(widget);
+    if (!d->dueTimes.contains(widget)) {
+        return;
+    }
+    const qint64 due = d->dueTimes.take(widget);
+    QMap<qint64, QSet<PostWidget *> >::iterator it = d->buckets.find(due);
+    if (it != d->buckets.end()) {
+        it->remove(widget);
+        if (it->isEmpty()) {
+            d->buckets.erase(it);
+        }
+    }
+}
+
+bool RelativeTimeTicker::isStale(PostWidget *widget) const
+{
+    return d->stale.contains(widget);
+}
+
+void RelativeTimeTicker::slotTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<PostWidget *> due;
+    while (!d->buckets.isEmpty() && d->buckets.firstKey() <= now + SLACK_MSECS) {
+        for (PostWidget *widget: d->buckets.first()) {
+            d->dueTimes.remove(widget);
+            due.append(widget);
+        }
+        d->buckets.erase(d->buckets.begin());
+    }
+
+    for (PostWidget *widget: due) {
+        if (widget->visibleRegion().isEmpty()) {
+            d->stale.insert(widget);
+        } else {
+            // Reschedules the widget
+            widget->updateTimestamp();
+        }
+    }
+
+    if (!d->buckets.isEmpty() && !d->timer.isActive()) {
+        d->timer.start(int(qMax<qint64>(0, d->buckets.firstKey() - QDateTime::currentMSecsSinceEpoch())));
+    }
+}
+
+}
+}
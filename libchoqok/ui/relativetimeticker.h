@@ -0,0 +1,94 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef RELATIVETIMETICKER_H
+#define RELATIVETIMETICKER_H
+
+#include <QDateTime>
+#include <QObject>
+
+#include "choqok_export.h"
+
+namespace Choqok
+{
+namespace UI
+{
+
+class PostWidget;
+
+/**
+@brief One timer for the "x mins ago" labels of all posts
+
+Posts are grouped in buckets by the time their relative time label changes next,
+and the ticker only wakes up when the earliest bucket is due.
+Due posts which are not visible are marked as stale instead of being updated,
+@ref PostWidget refreshes them as soon as they get painted again.
+
+@see PostWidget::updateTimestamp()
+*/
+class CHOQOK_EXPORT RelativeTimeTicker : public QObject
+{
+    Q_OBJECT
+public:
+    ~RelativeTimeTicker();
+
+    static RelativeTimeTicker *self();
+
+    /**
+    @brief Schedule an update of @p widget for the next label change of @p time
+    Replaces any previous schedule of @p widget.
+    */
+    void schedule(PostWidget *widget, const QDateTime &time);
+
+    /**
+    @brief Forget about @p widget, e.g. because it is going to be destroyed
+    */
+    void unschedule(PostWidget *widget);
+
+    /**
+    @return true if the label of @p widget changed while it was not visible
+    */
+    bool isStale(PostWidget *widget) const;
+
+    /**
+    @return seconds until the relative time label of a post which is @p age seconds old changes,
+    matching PostWidget::formatDateTime()
+    */
+    static qint64 secsToNextChange(qint64 age);
+
+protected Q_SLOTS:
+    void slotTimeout();
+
+protected:
+    RelativeTimeTicker();
+
+private:
+    class Private;
+    Private *const d;
+    static RelativeTimeTicker *mSelf;
+};
+
+}
+}
+
+#endif // RELATIVETIMETICKER_H
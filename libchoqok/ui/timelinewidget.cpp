@@ -21,7 +21,11 @@ along with this program; if not, see http://www.gnu.org/licenses/
 */
 #include "timelinewidget.h"
 
+#include <algorithm>
+
+#include <QEvent>
 #include <QLabel>
+#include <QListView>
 #include <QPointer>
 #include <QPushButton>
 #include <QScrollArea>
@@ -35,20 +39,29 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "choqokbehaviorsettings.h"
 #include "libchoqokdebug.h"
 #include "microblog.h"
-#include "postwidget.h"
 #include "notifymanager.h"
+#include "postdelegate.h"
+#include "postmodel.h"
+#include "poststore.h"
+#include "postwidget.h"
 
 namespace Choqok
 {
 namespace UI
 {
 
+/// Count of rows above and below the viewport which keep their PostWidget in virtual mode
+static const int VIRTUAL_ROWS_MARGIN = 3;
+/// Posts resized while hidden are laid out once the timeline kept its size for that long
+static const int LAYOUT_DELAY_MSECS = 200;
+
 class TimelineWidget::Private
 {
 public:
     Private(Account *account, const QString &timelineName)
         : currentAccount(account), timelineName(timelineName),
-          btnMarkAllAsRead(0), unreadCount(0), placeholderLabel(0), info(0), isClosable(false)
+          btnMarkAllAsRead(0), unreadCount(0), placeholderLabel(0), scrollArea(0), info(0), isClosable(false),
+          model(0), delegate(0), listView(0), recountQueued(false)
     {
         if (account->microblog()->isValidTimeline(timelineName)) {
             info = account->microblog()->timelineInfo(timelineName);
@@ -74,28 +87,57 @@ public:
     Choqok::TimelineInfo *info;
     bool isClosable;
     QIcon timelineIcon;
+
+    // Virtual mode only, see AppearanceSettings::useVirtualTimeline()
+    PostModel *model;
+    PostDelegate *delegate;
+    QListView *listView;
+    QTimer updateVisibleTimer;
+
+    // Posts resized while hidden, laid out together when resizing is over
+    QList<QPointer<PostWidget> > staleLayouts;
+    QTimer layoutTimer;
+
+    // Posts shared with other timelines were marked as read there
+    bool recountQueued;
 };
 
 TimelineWidget::TimelineWidget(Choqok::Account *account, const QString &timelineName, QWidget *parent /*= 0*/)
     : QWidget(parent), d(new Private(account, timelineName))
 {
     setAttribute(Qt::WA_DeleteOnClose);
+    d->layoutTimer.setSingleShot(true);
+    d->layoutTimer.setInterval(LAYOUT_DELAY_MSECS);
+    connect(&d->layoutTimer, SIGNAL(timeout()), this, SLOT(updateStaleLayouts()));
     setupUi();
     loadTimeline();
 }
 
 TimelineWidget::~TimelineWidget()
 {
+    // Shown PostWidgets have this as event filter, get rid of them while d is still valid
+    delete d->listView;
     delete d;
 }
 
 void TimelineWidget::loadTimeline()
 {
     QList<Choqok::Post *> list = currentAccount()->microblog()->loadTimeline(currentAccount(), timelineName());
+    for (Choqok::Post *&p: list) {
+        p = PostStore::self()->intern(d->currentAccount, p);
+        PostStore::self()->subscribe(p, this, SLOT(slotPostChanged(Choqok::Account*,Choqok::Post*,int)));
+    }
     connect(currentAccount()->microblog(), SIGNAL(saveTimelines()), SLOT(saveTimeline()));
+    connect(currentAccount()->microblog(), SIGNAL(postRemoved(Choqok::Account*,Choqok::Post*)),
+            SLOT(slotPostRemoved(Choqok::Account*,Choqok::Post*)));
 
     if (!BehaviorSettings::markAllAsReadOnExit()) {
         addNewPosts(list);
+    } else if (d->model) {
+        for (Choqok::Post *p: list) {
+            p->isRead = true;
+            d->model->addPost(p);
+        }
     } else {
         for (Choqok::Post *p: list) {
             PostWidget *pw = d->currentAccount->microblog()->createPostWidget(d->currentAccount, p, this);
@@ -152,36 +194,42 @@ void TimelineWidget::setupUi()
     d->lblDesc->setFont(fnt);
 
     QVBoxLayout *gridLayout;
-    QWidget *scrollAreaWidgetContents;
-    QVBoxLayout *verticalLayout_2;
-    QSpacerItem *verticalSpacer;
     gridLayout = new QVBoxLayout(this);
     gridLayout->setMargin(0);
     gridLayout->setObjectName(QLatin1String("gridLayout"));
-    d->scrollArea = new QScrollArea(this);
-    d->scrollArea->setObjectName(QLatin1String("scrollArea"));
-    d->scrollArea->setFrameShape(QFrame::NoFrame);
-    d->scrollArea->setWidgetResizable(true);
-    scrollAreaWidgetContents = new QWidget();
-    scrollAreaWidgetContents->setObjectName(QLatin1String("scrollAreaWidgetContents"));
-    scrollAreaWidgetContents->setGeometry(QRect(0, 0, 254, 300));
-    verticalLayout_2 = new QVBoxLayout(scrollAreaWidgetContents);
-    verticalLayout_2->setMargin(1);
-    d->mainLayout = new QVBoxLayout();
-    verticalSpacer = new QSpacerItem(20, 40, QSizePolicy::Minimum, QSizePolicy::Expanding);
-
-    d->mainLayout->addItem(verticalSpacer);
-    d->mainLayout->setSpacing(5);
-    d->mainLayout->setMargin(1);
 
     d->titleBarLayout = new QHBoxLayout;
     d->titleBarLayout->addWidget(d->lblDesc);
-    verticalLayout_2->addLayout(d->mainLayout);
-
-    d->scrollArea->setWidget(scrollAreaWidgetContents);
-
     gridLayout->addLayout(d->titleBarLayout);
-    gridLayout->addWidget(d->scrollArea);
+
+    if (AppearanceSettings::useVirtualTimeline()) {
+        setupVirtualUi(gridLayout);
+    } else {
+        QWidget *scrollAreaWidgetContents;
+        QVBoxLayout *verticalLayout_2;
+        QSpacerItem *verticalSpacer;
+        d->scrollArea = new QScrollArea(this);
+        d->scrollArea->setObjectName(QLatin1String("scrollArea"));
+        d->scrollArea->setFrameShape(QFrame::NoFrame);
+        d->scrollArea->setWidgetResizable(true);
+        scrollAreaWidgetContents = new QWidget();
+        scrollAreaWidgetContents->setObjectName(QLatin1String("scrollAreaWidgetContents"));
+        scrollAreaWidgetContents->setGeometry(QRect(0, 0, 254, 300));
+        verticalLayout_2 = new QVBoxLayout(scrollAreaWidgetContents);
+        verticalLayout_2->setMargin(1);
+        d->mainLayout = new QVBoxLayout();
+        verticalSpacer = new QSpacerItem(20, 40, QSizePolicy::Minimum, QSizePolicy::Expanding);
+
+        d->mainLayout->addItem(verticalSpacer);
+        d->mainLayout->setSpacing(5);
+        d->mainLayout->setMargin(1);
+
+        verticalLayout_2->addLayout(d->mainLayout);
+
+        d->scrollArea->setWidget(scrollAreaWidgetContents);
+
+        gridLayout->addWidget(d->scrollArea);
+    }
     if (AppearanceSettings::useReverseOrder()) {
         d->order = -1;
         QTimer::singleShot(0, this, SLOT(scrollToBottom()));
@@ -190,8 +238,168 @@ void TimelineWidget::setupUi()
     }
 }
 
+void TimelineWidget::setupVirtualUi(QVBoxLayout *gridLayout)
+{
+    d->model = new PostModel(AppearanceSettings::useReverseOrder(), this);
+    d->delegate = new PostDelegate(this);
+
+    d->listView = new QListView(this);
+    d->listView->setObjectName(QLatin1String("listView"));
+    d->listView->setFrameShape(QFrame::NoFrame);
+    d->listView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    d->listView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    d->listView->setSelectionMode(QAbstractItemView::NoSelection);
+    d->listView->setResizeMode(QListView::Adjust);
+    d->listView->setSpacing(2);
+    d->listView->setModel(d->model);
+    d->listView->setItemDelegate(d->delegate);
+    d->listView->viewport()->installEventFilter(this);
+
+    d->mainLayout = new QVBoxLayout();
+    d->mainLayout->setSpacing(5);
+    d->mainLayout->setMargin(1);
+    d->mainLayout->addWidget(d->listView);
+    gridLayout->addLayout(d->mainLayout);
+
+    d->updateVisibleTimer.setSingleShot(true);
+    d->updateVisibleTimer.setInterval(0);
+    connect(&d->updateVisibleTimer, SIGNAL(timeout()), this, SLOT(updateVisiblePostWidgets()));
+    connect(d->listView->verticalScrollBar(), SIGNAL(valueChanged(int)), &d->updateVisibleTimer, SLOT(start()));
+    connect(d->model, SIGNAL(rowsInserted(QModelIndex,int,int)), &d->updateVisibleTimer, SLOT(start()));
+    connect(d->model, SIGNAL(rowsRemoved(QModelIndex,int,int)), &d->updateVisibleTimer, SLOT(start()));
+}
+
+void TimelineWidget::updateVisiblePostWidgets()
+{
+    if (!d->listView) {
+        return;
+    }
+    const int rowCount = d->model->rowCount();
+    if (rowCount == 0) {
+        return;
+    }
+
+    // Probe a few pixels around the edges, indexAt() is invalid on the spacing between rows
+    const QRect rect = d->listView->viewport()->rect();
+    QModelIndex first;
+    for (int y = rect.top(); y <= rect.bottom() && !first.isValid(); y += 2) {
+        first = d->listView->indexAt(QPoint(rect.center().x(), y));
+    }
+    QModelIndex last;
+    for (int y = rect.bottom(); y >= rect.top() && !last.isValid(); y -= 2) {
+        last = d->listView->indexAt(QPoint(rect.center().x(), y));
+    }
+    const int firstRow = qMax(0, (first.isValid() ? first.row() : 0) - VIRTUAL_ROWS_MARGIN);
+    const int lastRow = qMin(rowCount - 1, (last.isValid() ? last.row() : 0) + VIRTUAL_ROWS_MARGIN);
+
+    for (PostWidget *pw: d->posts.values()) {
+        const int row = d->model->rowOf(pw->currentPost()->postId);
+        if (row < firstRow || row > lastRow) {
+            releasePostWidget(pw);
+        }
+    }
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        Choqok::Post *post = d->model->post(row);
+        if (post && !d->posts.contains(post->postId)) {
+            PostWidget *pw = d->currentAccount->microblog()->createPostWidget(d->currentAccount, post, this);
+            if (pw) {
+                addPostWidgetToUi(pw);
+            }
+        }
+    }
+}
+
+void TimelineWidget::scheduleLayoutUpdate(PostWidget *widget)
+{
+    d->staleLayouts.append(widget);
+    d->layoutTimer.start();
+}
+
+void TimelineWidget::updateStaleLayouts()
+{
+    const QList<QPointer<PostWidget> > widgets = d->staleLayouts;
+    d->staleLayouts.clear();
+    for (const QPointer<PostWidget> &widget: widgets) {
+        if (widget) {
+            widget->updateLayout();
+        }
+    }
+}
+
+void TimelineWidget::resizeEvent(QResizeEvent *event)
+{
+    // Stale posts wait until resizing is over, not just until the first of them turned stale
+    if (!d->staleLayouts.isEmpty()) {
+        d->layoutTimer.start();
+    }
+    QWidget::resizeEvent(event);
+}
+
+void TimelineWidget::releasePostWidget(PostWidget *widget)
+{
+    const QString postId = widget->currentPost()->postId;
+    widget->removeEventFilter(this);
+    disconnect(widget, SIGNAL(aboutClosing(QString,PostWidget*)),
+               this, SLOT(postWidgetClosed(QString,PostWidget*)));
+    d->posts.remove(postId);
+    d->sortedPostsList.remove(widget->currentPost()->creationDateTime, widget);
+
+    const int row = d->model->rowOf(postId);
+    if (row >= 0) {
+        d->listView->setIndexWidget(d->model->index(row), 0);
+    }
+    // Don't use PostWidget::deleteLater(), it closes the widget and marks the post as read
+    widget->QObject::deleteLater();
+}
+
+void TimelineWidget::removePostFromModel(const QString &postId)
+{
+    PostWidget *widget = d->posts.value(postId);
+    if (widget) {
+        releasePostWidget(widget);
+    }
+    d->delegate->invalidate(postId);
+    d->model->removePost(postId);
+}
+
+bool TimelineWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    if (d->listView && event->type() == QEvent::Resize) {
+        if (watched == d->listView->viewport()) {
+            d->updateVisibleTimer.start();
+        } else {
+            PostWidget *pw = qobject_cast<PostWidget *>(watched);
+            if (pw) {
+                const int row = d->model->rowOf(pw->currentPost()->postId);
+                if (row >= 0) {
+                    d->delegate->setWidgetHeight(d->model->index(row), d->listView->viewport()->width(),
+                                                 pw->height());
+                }
+            }
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
 void TimelineWidget::removeOldPosts()
 {
+    if (d->model) {
+        int count = d->model->rowCount() - BehaviorSettings::countOfPosts();
+        // Oldest posts are at the bottom, or at the top in reverse order
+        QList<Choqok::Post *> list = d->model->posts();
+        if (d->order == 0) {
+            std::reverse(list.begin(), list.end());
+        }
+        for (int i = 0; count > 0 && i < list.count(); ++i) {
+            if (list.at(i)->isRead) {
+                removePostFromModel(list.at(i)->postId);
+                --count;
+            }
+        }
+        return;
+    }
+
     int count = d->sortedPostsList.count() - BehaviorSettings::countOfPosts();
 //     qCDebug(CHOQOK)<<count;
     while (count > 0 && !d->sortedPostsList.isEmpty()) {
@@ -205,7 +413,7 @@ void TimelineWidget::removeOldPosts()
 
 void TimelineWidget::addPlaceholderMessage(const QString &msg)
 {
-    if ( d->posts.isEmpty() ) {
+    if (d->posts.isEmpty() && (!d->model || d->model->rowCount() == 0)) {
         if (!d->placeholderLabel) {
             d->placeholderLabel = new QLabel(this);
             d->mainLayout->insertWidget(d->order, d->placeholderLabel);
@@ -217,11 +425,38 @@ void TimelineWidget::addPlaceholderMessage(const QString &msg)
 void TimelineWidget::addNewPosts(QList< Choqok::Post * > &postList)
 {
     qCDebug(CHOQOK) << d->currentAccount->alias() << d->timelineName << postList.count();
+    // Posts other timelines show already are shared, not added as another copy
+    for (Choqok::Post *&p: postList) {
+        p = PostStore::self()->intern(d->currentAccount, p);
+        PostStore::self()->subscribe(p, this, SLOT(slotPostChanged(Choqok::Account*,Choqok::Post*,int)));
+    }
     int unread = 0;
+    QList<Choqok::Post *> dropped;
     for (Choqok::Post *p: postList) {
+        if (d->model) {
+            if (d->model->contains(p->postId)) {
+                continue;
+            }
+            if (d->currentAccount->username().compare(p->author.userName, Qt::CaseInsensitive) == 0) {
+                p->isRead = true;
+            }
+            if (!PostPipeline::self()->acceptPost(d->currentAccount, p)) {
+                dropped.append(p);
+                continue;
+            }
+            d->model->addPost(p);
+            if (!p->isRead) {
+                ++unread;
+            }
+            continue;
+        }
         if (d->posts.keys().contains(p->postId)) {
             continue;
         }
+        if (!PostPipeline::self()->acceptPost(d->currentAccount, p)) {
+            dropped.append(p);
+            continue;
+        }
         PostWidget *pw = d->currentAccount->microblog()->createPostWidget(d->currentAccount, p, this);
         if (pw) {
             addPostWidgetToUi(pw);
@@ -230,6 +465,18 @@ void TimelineWidget::addNewPosts(QList< Choqok::Post * > &postList)
             }
         }
     }
+    // Nothing else took them
+    for (Choqok::Post *p: dropped) {
+        postList.removeOne(p);
+        if (p->owners == 0) {
+            delete p;
+        }
+    }
+    if (d->model && d->placeholderLabel && d->model->rowCount() > 0) {
+        d->mainLayout->removeWidget(d->placeholderLabel);
+        delete d->placeholderLabel;
+        d->placeholderLabel = 0;
+    }
     removeOldPosts();
     if (unread) {
         d->unreadCount += unread;
@@ -270,7 +517,16 @@ void TimelineWidget::addPostWidgetToUi(PostWidget *widget)
             this, SLOT(slotOnePostReaded()));
     connect(widget, SIGNAL(aboutClosing(QString,PostWidget*)),
             SLOT(postWidgetClosed(QString,PostWidget*)));
-    d->mainLayout->insertWidget(d->order, widget);
+    if (d->model) {
+        int row = d->model->rowOf(widget->currentPost()->postId);
+        if (row < 0) {
+            row = d->model->addPost(widget->currentPost());
+        }
+        d->listView->setIndexWidget(d->model->index(row), widget);
+        widget->installEventFilter(this);
+    } else {
+        d->mainLayout->insertWidget(d->order, widget);
+    }
     d->posts.insert(widget->currentPost()->postId, widget);
     d->sortedPostsList.insert(widget->currentPost()->creationDateTime, widget);
     Global::SessionManager::self()->emitNewPostWidgetAdded(widget, currentAccount(), timelineName());
@@ -297,6 +553,17 @@ void TimelineWidget::markAllAsRead()
         for (PostWidget *pw: d->sortedPostsList) {
             pw->setRead();
         }
+        if (d->model) {
+            for (Choqok::Post *p: d->model->posts()) {
+                if (!p->isRead) {
+                    p->isRead = true;
+                    if (p->owners > 1) {
+                        PostStore::self()->notifyChanged(d->currentAccount, p);
+                    }
+                }
+            }
+            d->listView->viewport()->update();
+        }
         int unread = -d->unreadCount;
         d->unreadCount = 0;
         Q_EMIT updateUnreadCount(unread);
@@ -306,8 +573,12 @@ void TimelineWidget::markAllAsRead()
 
 void TimelineWidget::scrollToBottom()
 {
-    d->scrollArea->verticalScrollBar()->
-    triggerAction(QAbstractSlider::SliderToMaximum);
+    if (d->listView) {
+        d->listView->scrollToBottom();
+    } else {
+        d->scrollArea->verticalScrollBar()->
+        triggerAction(QAbstractSlider::SliderToMaximum);
+    }
 }
 
 Account *TimelineWidget::currentAccount()
@@ -320,6 +591,10 @@ void TimelineWidget::settingsChanged()
     for (PostWidget *pw: d->sortedPostsList) {
         pw->setUiStyle();
     }
+    if (d->delegate) {
+        d->delegate->clearCache();
+        d->listView->doItemsLayout();
+    }
 }
 
 void TimelineWidget::slotOnePostReaded()
@@ -334,7 +609,15 @@ void TimelineWidget::slotOnePostReaded()
 void TimelineWidget::saveTimeline()
 {
     if (currentAccount()->microblog()) {
-        currentAccount()->microblog()->saveTimeline(currentAccount(), timelineName(), posts().values());
+        QList<Choqok::Post *> list;
+        if (d->model) {
+            list = d->model->posts();
+        } else {
+            for (PostWidget *pw: posts()) {
+                list.append(pw->currentPost());
+            }
+        }
+        currentAccount()->microblog()->savePosts(currentAccount(), timelineName(), list);
     }
 }
 
@@ -347,6 +630,89 @@ void TimelineWidget::postWidgetClosed(const QString &postId, PostWidget *post)
 {
     d->posts.remove(postId);
     d->sortedPostsList.remove(post->currentPost()->creationDateTime, post);
+    if (d->model) {
+        // The widget is closed for good (e.g. removed or filtered), drop its row too
+        post->removeEventFilter(this);
+        d->delegate->invalidate(postId);
+        d->model->removePost(postId);
+    }
+}
+
+void TimelineWidget::slotPostRemoved(Account *theAccount, Post *post)
+{
+    if (theAccount != currentAccount()) {
+        return;
+    }
+    PostWidget *widget = d->posts.value(post->postId);
+    if (widget && widget->isRemoving()) {
+        // The widget whose Remove button was clicked closes itself, see PostWidget::slotCurrentPostRemoved()
+        return;
+    }
+    if (d->model) {
+        removePostFromModel(post->postId);
+    } else if (widget) {
+        widget->close();
+    }
+}
+
+void TimelineWidget::slotPostChanged(Account *theAccount, Post *post, int changes)
+{
+    if (theAccount != currentAccount()) {
+        return;
+    }
+    // Still subscribed to posts which were dropped or removed since
+    if (d->model) {
+        if (!d->model->contains(post->postId)) {
+            return;
+        }
+        if (changes & PostStore::ContentChanged) {
+            d->delegate->invalidate(post->postId);
+        }
+        d->model->postChanged(post->postId);
+    } else {
+        PostWidget *widget = d->posts.value(post->postId);
+        if (!widget || widget->currentPost() != post) {
+            return;
+        }
+    }
+    if (!(changes & PostStore::StateChanged) || d->recountQueued) {
+        return;
+    }
+    // Marking a timeline as read changes many posts at once, count them once afterwards
+    d->recountQueued = true;
+    QMetaObject::invokeMethod(this, "recountUnread", Qt::QueuedConnection);
+}
+
+void TimelineWidget::recountUnread()
+{
+    d->recountQueued = false;
+    int unread = 0;
+    if (d->model) {
+        for (Choqok::Post *p: d->model->posts()) {
+            if (!p->isRead) {
+                ++unread;
+            }
+        }
+    } else {
+        for (PostWidget *pw: d->posts) {
+            if (!pw->isRead()) {
+                ++unread;
+            }
+        }
+    }
+    const int change = unread - d->unreadCount;
+    if (change) {
+        d->unreadCount = unread;
+        Q_EMIT updateUnreadCount(change);
+        if (d->unreadCount == 0 && d->btnMarkAllAsRead) {
+            d->btnMarkAllAsRead->deleteLater();
+        }
+    }
+}
+
+PostModel *TimelineWidget::postModel() const
+{
+    return d->model;
 }
 
 QMap< QString, PostWidget * > &TimelineWidget::posts() const
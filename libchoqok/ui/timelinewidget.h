@@ -40,6 +40,7 @@ class Account;
 namespace UI
 {
 
+class PostModel;
 class PostWidget;
 /**
 @brief Choqok base Timeline Widget
@@ -99,9 +100,17 @@ public:
 
     /**
     @return list of all widgets available on this timeline
+    @note On a virtual timeline only posts near the visible area have a widget
+    @see postModel()
     */
     QList<PostWidget *> postWidgets();
 
+    /**
+    @return model of all posts on a virtual timeline, or null when posts are laid out as widgets
+    @see AppearanceSettings::useVirtualTimeline()
+    */
+    PostModel *postModel() const;
+
     /**
      * @return true if this timeline is closable!
      */
@@ -109,6 +118,12 @@ public:
 
     void setClosable(bool isClosable = true);
 
+    /**
+    Have @p widget lay out its contents for its new width once the timeline wasn't resized for a moment
+    @see PostWidget::updateLayout()
+    */
+    void scheduleLayoutUpdate(PostWidget *widget);
+
 public Q_SLOTS:
     /**
     @brief Mark all posts as read
@@ -140,6 +155,17 @@ protected Q_SLOTS:
     virtual void loadTimeline();
     void postWidgetClosed(const QString &postId, PostWidget *widget);
 
+    /**
+    Drop the post with the id of @p post, e.g. when the server reports it as deleted
+    */
+    void slotPostRemoved(Choqok::Account *theAccount, Choqok::Post *post);
+
+    /**
+    Update the unread count and the row if @p post of this timeline was changed elsewhere
+    @see PostStore::subscribe()
+    */
+    void slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes);
+
 protected:
     /**
     Add a PostWidget to UI
@@ -155,9 +181,22 @@ protected:
     QLabel *timelineDescription();
     virtual void setUnreadCount(int unread);
     virtual void showMarkAllAsReadButton();
+    virtual bool eventFilter(QObject *watched, QEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
+
+private Q_SLOTS:
+    /**
+    Create PostWidgets for rows around the visible area of a virtual timeline and release the others
+    */
+    void updateVisiblePostWidgets();
+    void updateStaleLayouts();
+    void recountUnread();
 
 private:
     void setupUi();
+    void setupVirtualUi(QVBoxLayout *gridLayout);
+    void releasePostWidget(PostWidget *widget);
+    void removePostFromModel(const QString &postId);
     class Private;
     Private *const d;
 };
@@ -92,6 +92,8 @@ UploadMediaDialog::UploadMediaDialog(QWidget *parent, const QString &url)
             SLOT(slotMediumUploaded(QUrl,QString)));
     connect(Choqok::MediaManager::self(), SIGNAL(mediumUploadFailed(QUrl,QString)),
             SLOT(slotMediumUploadFailed(QUrl,QString)));
+    connect(Choqok::MediaManager::self(), SIGNAL(mediumUploadProgress(QUrl,qint64,qint64)),
+            SLOT(slotMediumUploadProgress(QUrl,qint64,qint64)));
 }
 
 UploadMediaDialog::~UploadMediaDialog()
@@ -136,6 +138,16 @@ void UploadMediaDialog::accept()
     Choqok::MediaManager::self()->uploadMedium(d->localUrl, plugin);
 }
 
+void UploadMediaDialog::reject()
+{
+    if (d->progress && showed) {
+        // Closing the dialog aborts its upload, without reporting it as failed
+        showed = false;
+        Choqok::MediaManager::self()->cancelUpload(d->localUrl);
+    }
+    QDialog::reject();
+}
+
 void Choqok::UI::UploadMediaDialog::currentPluginChanged(int index)
 {
     QString key = d->ui.uploaderPlugin->itemData(index).toString();
@@ -270,6 +282,16 @@ void Choqok::UI::UploadMediaDialog::slotMediumUploadFailed(const QUrl &localUrl,
     resize(winSize);
 }
 
+void Choqok::UI::UploadMediaDialog::slotMediumUploadProgress(const QUrl &localUrl, qint64 sent, qint64 total)
+{
+    if (d->localUrl == localUrl && showed && d->progress && total > 0) {
+        // Percents, as sizes of big files don't fit into the int range of QProgressBar
+        d->progress->setRange(0, 100);
+        d->progress->setValue(int(sent * 100 / total));
+        d->progress->setFormat(i18n("Uploading... %p%"));
+    }
+}
+
 void Choqok::UI::UploadMediaDialog::slotMediumChanged(const QString &url)
 {
     d->ui.previewer->showPreview(QUrl::fromLocalFile(url));
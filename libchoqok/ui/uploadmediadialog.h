@@ -48,11 +48,13 @@ protected:
 
 protected Q_SLOTS:
     virtual void accept() override;
+    virtual void reject() override;
     void currentPluginChanged(int index);
     void slotAboutClicked();
     void slotConfigureClicked();
     void slotMediumUploadFailed(const QUrl &localUrl, const QString &errorMessage);
     void slotMediumUploaded(const QUrl &localUrl, const QString &remoteUrl);
+    void slotMediumUploadProgress(const QUrl &localUrl, qint64 sent, qint64 total);
     void slotMediumChanged(const QString &url);
 
 private:
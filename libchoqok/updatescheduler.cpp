@@ -0,0 +1,426 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "updatescheduler.h"
+
+#include <QApplication>
+#include <QHash>
+#include <QTimer>
+
+#include "account.h"
+#include "libchoqokdebug.h"
+
+namespace Choqok
+{
+
+/// Least time between two requests sent by the scheduler
+static const qint64 REQUEST_GAP_MSECS = 2000;
+/// Timelines are never updated more often than this, however busy they are
+static const int MIN_INTERVAL_SECS = 60;
+/// Average count of new posts per update, from which a timeline counts as busy
+static const double BUSY_POSTS = 10;
+/// QTimer takes an int, wake up at least once a day
+static const qint64 MAX_WAIT_MSECS = 24 * 3600 * 1000;
+
+class ScheduleEntry
+{
+public:
+    ScheduleEntry(Account *account, const QString &timeline)
+        : account(account), alias(account->alias()), timeline(timeline), due(0), interval(0),
+          jitter(0), idleUpdates(0), failures(0), postsPerUpdate(0), pending(false)
+    {
+        // Up to 10% longer or shorter intervals, so timelines don't keep hitting the same moment
+        jitter = int(qHash(alias + QLatin1Char('/') + timeline) % 21) - 10;
+    }
+
+    Account *account;
+    QString alias;
+    QString timeline;
+    qint64 due;             // msecs since epoch
+    int interval;           // secs
+    int jitter;             // percent
+    int idleUpdates;
+    int failures;
+    double postsPerUpdate;
+    bool pending;
+    QString reason;
+};
+
+class UpdateScheduler::Private
+{
+public:
+    Private()
+        : interval(0), enabled(true), lastRequest(0)
+    {}
+
+    ScheduleEntry *find(Account *account, const QString &timeline) const
+    {
+        for (ScheduleEntry *entry: entries) {
+            if (entry->account == account && entry->timeline == timeline) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool isScheduled(Account *account) const
+    {
+        for (ScheduleEntry *entry: entries) {
+            if (entry->account == account) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Wake up when the next entry is due, but not sooner than REQUEST_GAP_MSECS after the last request
+    void restartTimer()
+    {
+        timer.stop();
+        if (!enabled || interval <= 0 || entries.isEmpty()) {
+            return;
+        }
+        qint64 next = entries.first()->due;
+        for (ScheduleEntry *entry: entries) {
+            next = qMin(next, entry->due);
+        }
+        next = qMax(next, lastRequest + REQUEST_GAP_MSECS);
+        timer.start(int(qBound(qint64(0), next - QDateTime::currentMSecsSinceEpoch(), MAX_WAIT_MSECS)));
+    }
+
+    QList<ScheduleEntry *> entries;
+    QHash<QString, qint64> rateLimitedUntil;   // <alias, msecs since epoch>
+    QTimer timer;
+    QTimer intervalTimer;
+    int interval;           // secs
+    bool enabled;
+    qint64 lastRequest;
+};
+
+UpdateScheduler *UpdateScheduler::mSelf = nullptr;
+
+UpdateScheduler::UpdateScheduler()
+    : QObject(qApp), d(new Private)
+{
+    d->timer.setSingleShot(true);
+    connect(&d->timer, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+    connect(&d->intervalTimer, SIGNAL(timeout()), this, SIGNAL(intervalElapsed()));
+}
+
+UpdateScheduler::~UpdateScheduler()
+{
+    qDeleteAll(d->entries);
+    delete d;
+    mSelf = nullptr;
+}
+
+UpdateScheduler *UpdateScheduler::self()
+{
+    if (!mSelf) {
+        mSelf = new UpdateScheduler;
+    }
+    return mSelf;
+}
+
+static qint64 jittered(const ScheduleEntry *entry, qint64 now)
+{
+    return now + qint64(entry->interval) * (100 + entry->jitter) * 10;
+}
+
+void UpdateScheduler::addAccount(Account *account)
+{
+    connect(account->microblog(), SIGNAL(timelineDataReceived(Choqok::Account*,QString,QList<Choqok::Post*>)),
+            this, SLOT(slotTimelineDataReceived(Choqok::Account*,QString,QList<Choqok::Post*>)),
+            Qt::UniqueConnection);
+    connect(account->microblog(), SIGNAL(error(Choqok::Account*,Choqok::MicroBlog::ErrorType,QString,Choqok::MicroBlog::ErrorLevel)),
+            this, SLOT(slotError(Choqok::Account*,Choqok::MicroBlog::ErrorType,QString,Choqok::MicroBlog::ErrorLevel)),
+            Qt::UniqueConnection);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const QString &timeline: account->timelineNames()) {
+        if (d->find(account, timeline)) {
+            continue;
+        }
+        ScheduleEntry *entry = new ScheduleEntry(account, timeline);
+        entry->interval = d->interval;
+        // Due right away, restartTimer() keeps the requests apart
+        entry->due = now;
+        entry->reason = QLatin1String("first update");
+        d->entries.append(entry);
+    }
+    d->restartTimer();
+}
+
+void UpdateScheduler::removeAccount(const QString &alias)
+{
+    for (int i = d->entries.count() - 1; i >= 0; --i) {
+        if (d->entries[i]->alias == alias) {
+            delete d->entries.takeAt(i);
+        }
+    }
+    d->rateLimitedUntil.remove(alias);
+    d->restartTimer();
+}
+
+void UpdateScheduler::setInterval(int minutes)
+{
+    const int interval = minutes * 60;
+    if (interval == d->interval) {
+        return;
+    }
+    d->interval = interval;
+
+    // Start over with the new interval, without waiting for the old one
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (ScheduleEntry *entry: d->entries) {
+        entry->interval = interval;
+        entry->idleUpdates = 0;
+        entry->failures = 0;
+        entry->due = qMin(entry->due, jittered(entry, now));
+        entry->reason = QLatin1String("interval changed");
+    }
+
+    if (d->enabled && interval > 0) {
+        d->intervalTimer.start(interval * 1000);
+    } else {
+        d->intervalTimer.stop();
+    }
+    d->restartTimer();
+}
+
+void UpdateScheduler::setEnabled(bool enabled)
+{
+    d->enabled = enabled;
+    if (enabled && d->interval > 0) {
+        d->intervalTimer.start(d->interval * 1000);
+    } else {
+        d->intervalTimer.stop();
+    }
+    d->restartTimer();
+}
+
+bool UpdateScheduler::isEnabled() const
+{
+    return d->enabled && d->interval > 0;
+}
+
+void UpdateScheduler::reportRateLimit(Account *account, int remaining, const QDateTime &reset)
+{
+    int timelines = 0;
+    for (ScheduleEntry *entry: d->entries) {
+        timelines += entry->account == account ? 1 : 0;
+    }
+    // Leave the remaining requests for what the user does
+    if (remaining > timelines || !reset.isValid()) {
+        d->rateLimitedUntil.remove(account->alias());
+        return;
+    }
+
+    const qint64 until = reset.toMSecsSinceEpoch();
+    qCDebug(CHOQOK) << account->alias() << "has" << remaining << "requests left until" << reset;
+    d->rateLimitedUntil[account->alias()] = until;
+    for (ScheduleEntry *entry: d->entries) {
+        if (entry->account == account && entry->due < until) {
+            entry->due = until;
+            entry->reason = QStringLiteral("rate limited, %1 requests left").arg(remaining);
+            Q_EMIT scheduled(account, entry->timeline, QDateTime::fromMSecsSinceEpoch(until), entry->reason);
+        }
+    }
+    d->restartTimer();
+}
+
+void UpdateScheduler::reportHttpHeaders(Account *account, const QString &headers)
+{
+    int remaining = -1;
+    QDateTime reset;
+    for (const QString &line: headers.split(QLatin1Char('\n'))) {
+        const int colon = line.indexOf(QLatin1Char(':'));
+        if (colon < 0) {
+            continue;
+        }
+        // Matches both X-RateLimit-* and the X-Rate-Limit-* of Twitter
+        const QString name = line.left(colon).toLower().remove(QLatin1Char('-'));
+        const QString value = line.mid(colon + 1).trimmed();
+        if (name == QLatin1String("xratelimitremaining")) {
+            bool ok;
+            remaining = value.toInt(&ok);
+            if (!ok) {
+                remaining = -1;
+            }
+        } else if (name == QLatin1String("xratelimitreset")) {
+            bool ok;
+            const qint64 secs = value.toLongLong(&ok);
+            reset = ok ? QDateTime::fromMSecsSinceEpoch(secs * 1000) : QDateTime::fromString(value, Qt::ISODate);
+        }
+    }
+    if (remaining >= 0) {
+        reportRateLimit(account, remaining, reset);
+    }
+}
+
+QString UpdateScheduler::scheduleDescription() const
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList lines;
+    if (!isEnabled()) {
+        lines << QLatin1String("Updates are disabled");
+    }
+    for (ScheduleEntry *entry: d->entries) {
+        lines << QStringLiteral("%1/%2: next in %3 s, every %4 s%5 (%6)")
+              .arg(entry->alias).arg(entry->timeline)
+              .arg(qMax(qint64(0), (entry->due - now) / 1000))
+              .arg(entry->interval)
+              .arg(entry->pending ? QLatin1String(", waiting for reply") : QLatin1String(""))
+              .arg(entry->reason);
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+void UpdateScheduler::slotTimeout()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    ScheduleEntry *next = nullptr;
+    for (ScheduleEntry *entry: d->entries) {
+        if (entry->due <= now && (!next || entry->due < next->due)) {
+            next = entry;
+        }
+    }
+    if (!next || !d->enabled) {
+        d->restartTimer();
+        return;
+    }
+
+    const qint64 limitedUntil = d->rateLimitedUntil.value(next->alias);
+    if (limitedUntil > now) {
+        next->due = limitedUntil;
+        d->restartTimer();
+        return;
+    }
+    d->rateLimitedUntil.remove(next->alias);
+
+    Account *account = next->account;
+    qCDebug(CHOQOK) << "Updating" << next->alias << next->timeline << "(" << next->reason << ")";
+    QList<ScheduleEntry *> requested;
+    if (account->microblog()->updateTimeline(account, next->timeline)) {
+        requested << next;
+    } else {
+        account->microblog()->updateTimelines(account);
+        for (ScheduleEntry *entry: d->entries) {
+            if (entry->account == account) {
+                requested << entry;
+            }
+        }
+    }
+
+    for (ScheduleEntry *entry: requested) {
+        // Until the reply arrives, in case it never does
+        entry->pending = true;
+        entry->due = jittered(entry, now);
+    }
+    d->lastRequest = now;
+    d->restartTimer();
+}
+
+void UpdateScheduler::slotTimelineDataReceived(Account *account, const QString &timelineName,
+                                               QList<Post *> data)
+{
+    if (account->microblog()->isStreamingPosts()) {
+        // Not a reply to our polls, single pushed posts would skew the statistics
+        return;
+    }
+    ScheduleEntry *entry = d->find(account, timelineName);
+    if (!entry) {
+        if (!d->isScheduled(account) || !account->timelineNames().contains(timelineName)) {
+            return;
+        }
+        // A timeline added to the account after it was scheduled
+        entry = new ScheduleEntry(account, timelineName);
+        entry->interval = d->interval;
+        entry->due = jittered(entry, QDateTime::currentMSecsSinceEpoch());
+        entry->reason = QLatin1String("regular");
+        d->entries.append(entry);
+        d->restartTimer();
+        return;
+    }
+    if (!entry->pending) {
+        // Updates the user asked for, or replies which arrived after their poll timed out
+        return;
+    }
+
+    const int count = data.count();
+    entry->pending = false;
+    entry->failures = 0;
+    entry->postsPerUpdate = (entry->postsPerUpdate + count) / 2;
+    entry->idleUpdates = count > 0 ? 0 : entry->idleUpdates + 1;
+
+    if (entry->idleUpdates >= 2) {
+        // 2x the interval after 2 empty updates, 4x after 4
+        entry->interval = d->interval << qMin(entry->idleUpdates / 2, 2);
+        entry->reason = QStringLiteral("no new posts in %1 updates").arg(entry->idleUpdates);
+    } else if (entry->postsPerUpdate >= 2 * BUSY_POSTS) {
+        entry->interval = d->interval / 4;
+        entry->reason = QStringLiteral("busy, %1 new posts per update").arg(int(entry->postsPerUpdate));
+    } else if (entry->postsPerUpdate >= BUSY_POSTS) {
+        entry->interval = d->interval / 2;
+        entry->reason = QStringLiteral("busy, %1 new posts per update").arg(int(entry->postsPerUpdate));
+    } else {
+        entry->interval = d->interval;
+        entry->reason = QLatin1String("regular");
+    }
+    entry->interval = qMax(entry->interval, qMin(d->interval, MIN_INTERVAL_SECS));
+
+    entry->due = jittered(entry, QDateTime::currentMSecsSinceEpoch());
+    qCDebug(CHOQOK) << entry->alias << entry->timeline << "got" << count << "posts, next update in"
+                    << entry->interval << "s:" << entry->reason;
+    Q_EMIT scheduled(account, timelineName, QDateTime::fromMSecsSinceEpoch(entry->due), entry->reason);
+    d->restartTimer();
+}
+
+void UpdateScheduler::slotError(Account *account, MicroBlog::ErrorType error,
+                                const QString &errorMessage, MicroBlog::ErrorLevel level)
+{
+    Q_UNUSED(errorMessage)
+    Q_UNUSED(level)
+    if (error != MicroBlog::ServerError && error != MicroBlog::CommunicationError) {
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (ScheduleEntry *entry: d->entries) {
+        if (entry->account != account || !entry->pending) {
+            continue;
+        }
+        entry->pending = false;
+        ++entry->failures;
+        // Double the interval on each failure, up to 16x
+        entry->interval = d->interval << qMin(entry->failures, 4);
+        entry->reason = QStringLiteral("%1 failed updates").arg(entry->failures);
+        entry->due = jittered(entry, now);
+        qCDebug(CHOQOK) << entry->alias << entry->timeline << "failed, next update in"
+                        << entry->interval << "s";
+        Q_EMIT scheduled(account, entry->timeline, QDateTime::fromMSecsSinceEpoch(entry->due), entry->reason);
+    }
+    d->restartTimer();
+}
+
+}
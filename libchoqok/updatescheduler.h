@@ -0,0 +1,133 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef UPDATESCHEDULER_H
+#define UPDATESCHEDULER_H
+
+#include <QDateTime>
+#include <QObject>
+
+#include "choqok_export.h"
+#include "choqoktypes.h"
+#include "microblog.h"
+
+namespace Choqok
+{
+
+class Account;
+
+/**
+@brief Decides when each timeline of each account is updated
+
+Every timeline gets its own schedule, based on the update interval of @ref BehaviorSettings:
+- Requests are sent one by one with a small gap, instead of all accounts at the same moment.
+- Timelines which had no new posts for a while, or whose updates failed, are updated less often.
+- Timelines with many new posts per update are updated more often.
+- Rate limits reported by the server are respected, see @ref reportRateLimit().
+
+Microblogs which can't update a single timeline (see @ref MicroBlog::updateTimeline())
+get all their timelines updated together.
+
+Every decision is logged and announced with @ref scheduled(), @ref scheduleDescription()
+shows the current state.
+
+@author Choqok Developers
+*/
+class CHOQOK_EXPORT UpdateScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    ~UpdateScheduler();
+
+    static UpdateScheduler *self();
+
+    /**
+    Start scheduling the timelines of @p account, the first updates are sent shortly after
+    */
+    void addAccount(Choqok::Account *account);
+
+    /**
+    Stop scheduling the timelines of account with @p alias
+    */
+    void removeAccount(const QString &alias);
+
+    /**
+    Set the nominal update interval in minutes, 0 disables updates
+    */
+    void setInterval(int minutes);
+
+    /**
+    Pause or resume all updates, without forgetting the accounts
+    */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+    Tell the scheduler that only @p remaining requests are allowed for @p account until @p reset
+    */
+    void reportRateLimit(Choqok::Account *account, int remaining, const QDateTime &reset);
+
+    /**
+    Look for X-RateLimit-Remaining and X-RateLimit-Reset in raw HTTP @p headers of a reply
+    for @p account and call @ref reportRateLimit() if found.
+    Reset may be given as seconds since epoch or as an ISO date.
+    */
+    void reportHttpHeaders(Choqok::Account *account, const QString &headers);
+
+    /**
+    @return a human readable list of all timelines, with their next update and the reason for it
+    */
+    QString scheduleDescription() const;
+
+Q_SIGNALS:
+    /**
+    Emitted whenever the next update of @p timelineName of @p account was decided
+    */
+    void scheduled(Choqok::Account *account, const QString &timelineName,
+                   const QDateTime &due, const QString &reason);
+
+    /**
+    Emitted once per update interval, for timelines that are not part of an account
+    (e.g. search results)
+    */
+    void intervalElapsed();
+
+protected Q_SLOTS:
+    void slotTimeout();
+    void slotTimelineDataReceived(Choqok::Account *account, const QString &timelineName,
+                                  QList<Choqok::Post *> data);
+    void slotError(Choqok::Account *account, Choqok::MicroBlog::ErrorType error,
+                   const QString &errorMessage, Choqok::MicroBlog::ErrorLevel level);
+
+protected:
+    UpdateScheduler();
+
+private:
+    class Private;
+    Private *const d;
+    static UpdateScheduler *mSelf;
+};
+
+}
+
+#endif // UPDATESCHEDULER_H
@@ -23,17 +23,80 @@
 
 #include "uploader.h"
 
+#include <QHash>
+
+#include <KIO/StoredTransferJob>
+
+#include "libchoqokdebug.h"
+#include "mediamanager.h"
+#include "multipartbody.h"
+
 namespace Choqok
 {
 
+class Uploader::Private
+{
+public:
+    struct Upload {
+        QUrl localUrl;
+        qint64 size;
+    };
+    QHash<KJob *, Upload> jobs;
+};
+
 Choqok::Uploader::Uploader(const QString &componentName, QObject *parent)
-    : Plugin(componentName, parent)
+    : Plugin(componentName, parent), d(new Private)
 {
 
 }
 
 Choqok::Uploader::~Uploader()
-{}
+{
+    delete d;
+}
+
+KIO::StoredTransferJob *Uploader::post(const QUrl &localUrl, const QUrl &url, MultipartBody *body)
+{
+    const qint64 size = body->size();
+    KIO::StoredTransferJob *job = MediaManager::postMultipart(url, body);
+    if (!job) {
+        return nullptr;
+    }
+    Private::Upload upload;
+    upload.localUrl = localUrl;
+    upload.size = size;
+    d->jobs.insert(job, upload);
+    connect(job, SIGNAL(processedAmount(KJob*,KJob::Unit,qulonglong)),
+            this, SLOT(slotProcessedAmount(KJob*,KJob::Unit,qulonglong)));
+    connect(job, SIGNAL(finished(KJob*)), this, SLOT(slotJobFinished(KJob*)));
+    return job;
+}
+
+void Uploader::cancel(const QUrl &localUrl)
+{
+    for (QHash<KJob *, Private::Upload>::const_iterator it = d->jobs.constBegin(); it != d->jobs.constEnd(); ++it) {
+        if (it->localUrl == localUrl) {
+            qCDebug(CHOQOK) << "Aborting upload of" << localUrl;
+            KJob *job = it.key();
+            // The result is still emitted, for the plugin to report the upload as failed
+            job->kill(KJob::EmitResult);
+            return;
+        }
+    }
+}
+
+void Uploader::slotProcessedAmount(KJob *job, KJob::Unit unit, qulonglong amount)
+{
+    const QHash<KJob *, Private::Upload>::const_iterator it = d->jobs.constFind(job);
+    if (unit == KJob::Bytes && it != d->jobs.constEnd()) {
+        Q_EMIT uploadProgress(it->localUrl, qMin(qint64(amount), it->size), it->size);
+    }
+}
+
+void Uploader::slotJobFinished(KJob *job)
+{
+    d->jobs.remove(job);
+}
 
 }
 
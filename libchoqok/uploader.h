@@ -26,11 +26,20 @@
 
 #include <QUrl>
 
+#include <KJob>
+
 #include "plugin.h"
 
+namespace KIO
+{
+class StoredTransferJob;
+}
+
 namespace Choqok
 {
 
+class MultipartBody;
+
 /**
 @brief The base class for Medium uploader plugins.
 
@@ -42,16 +51,43 @@ class CHOQOK_EXPORT Uploader : public Plugin
 public:
     virtual ~Uploader();
 
-    /*virtual void upload( const QString &localUrl, const QByteArray &mediumType,
-                            const QString &optionalMessage = QString() );*/
-    virtual void upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType) = 0;
+    /**
+    Upload the local file @p localUrl, and emit @ref mediumUploaded() or @ref uploadingFailed() when done.
+    The file should be sent with @ref post(), which reads it while sending instead of loading it into memory.
+    */
+    virtual void upload(const QUrl &localUrl, const QByteArray &mediumType) = 0;
+
+    /**
+    Abort the upload of @p localUrl, if it was started with @ref post()
+    */
+    void cancel(const QUrl &localUrl);
 
 Q_SIGNALS:
     void mediumUploaded(const QUrl &localUrl, const QString &remoteUrl);
     void uploadingFailed(const QUrl &localUrl, const QString &errorMessage);
 
+    /**
+    Emitted while the upload of @p localUrl is sent, @p sent of @p total bytes are sent
+    */
+    void uploadProgress(const QUrl &localUrl, qint64 sent, qint64 total);
+
 protected:
     Uploader(const QString &componentName, QObject *parent);
+
+    /**
+    Create a job posting @p body to @p url for the upload of @p localUrl, see @ref MediaManager::postMultipart().
+    Its progress is reported with @ref uploadProgress(), and it can be aborted with @ref cancel().
+    @return the job, or a null pointer if it couldn't be created
+    */
+    KIO::StoredTransferJob *post(const QUrl &localUrl, const QUrl &url, MultipartBody *body);
+
+private Q_SLOTS:
+    void slotProcessedAmount(KJob *job, KJob::Unit unit, qulonglong amount);
+    void slotJobFinished(KJob *job);
+
+private:
+    class Private;
+    Private *const d;
 };
 
 }
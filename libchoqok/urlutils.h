@@ -38,10 +38,6 @@ public:
 
     static QStringList detectUrls(const QString &text);
     static QString detectEmails(const QString &text);
-
-private:
-    static const QRegExp mUrlRegExp;
-    static const QRegExp mEmailRegExp;
 };
 
 #endif // URLUTILS_H
@@ -36,6 +36,8 @@ public:
     QString host;
     QString acct;
     QString tokenSecret;
+    QString streamingUrl;
+    bool useStreaming;
     QStringList following;
     QVariantList lists;
     MastodonOAuth *oAuth;
@@ -49,11 +51,17 @@ MastodonAccount::MastodonAccount(MastodonMicroBlog *parent, const QString &alias
     d->acct = configGroup()->readEntry("Acct", QString());
     d->tokenSecret = Choqok::PasswordManager::self()->readPassword(QStringLiteral("%1_tokenSecret").arg(alias));
     d->consumerKey = configGroup()->readEntry("ConsumerKey", QString());
+    d->useStreaming = configGroup()->readEntry("UseStreaming", false);
+    d->streamingUrl = configGroup()->readEntry("StreamingUrl", QString());
     d->consumerSecret = Choqok::PasswordManager::self()->readPassword(QStringLiteral("%1_consumerSecret").arg(alias));
     d->oAuth = new MastodonOAuth(this);
     d->oAuth->setToken(d->tokenSecret);
 
     setPostCharLimit(500);
+
+    // Start or stop streaming when the settings change
+    connect(this, SIGNAL(modified(Choqok::Account*)), parent, SLOT(slotAccountChanged(Choqok::Account*)));
+    connect(this, SIGNAL(status(Choqok::Account*,bool)), parent, SLOT(slotAccountChanged(Choqok::Account*)));
 }
 
 MastodonAccount::~MastodonAccount()
@@ -67,6 +75,7 @@ void MastodonAccount::writeConfig()
     configGroup()->writeEntry("Host", d->host);
     configGroup()->writeEntry("Acct", d->acct);
     configGroup()->writeEntry("ConsumerKey", d->consumerKey);
+    configGroup()->writeEntry("UseStreaming", d->useStreaming);
     Choqok::PasswordManager::self()->writePassword(QStringLiteral("%1_consumerSecret").arg(alias()),
             d->consumerSecret);
     Choqok::PasswordManager::self()->writePassword(QStringLiteral("%1_tokenSecret").arg(alias()),
@@ -128,3 +137,28 @@ MastodonOAuth *MastodonAccount::oAuth()
 {
     return d->oAuth;
 }
+
+bool MastodonAccount::useStreaming()
+{
+    return d->useStreaming;
+}
+
+void MastodonAccount::setUseStreaming(bool useStreaming)
+{
+    d->useStreaming = useStreaming;
+}
+
+QString MastodonAccount::streamingUrl()
+{
+    return d->streamingUrl.isEmpty() ? d->host : d->streamingUrl;
+}
+
+QString MastodonAccount::timelineCursor(const QString &timeline)
+{
+    return configGroup()->readEntry(QStringLiteral("LastId_%1").arg(timeline), QString());
+}
+
+void MastodonAccount::setTimelineCursor(const QString &timeline, const QString &id)
+{
+    configGroup()->writeEntry(QStringLiteral("LastId_%1").arg(timeline), id);
+}
@@ -56,6 +56,24 @@ public:
 
     MastodonOAuth *oAuth();
 
+    /**
+    Receive new posts over the streaming API instead of waiting for the next poll
+    */
+    bool useStreaming();
+    void setUseStreaming(bool useStreaming);
+
+    /**
+    @return base url of the streaming API, the host unless the "StreamingUrl" config entry is set
+    */
+    QString streamingUrl();
+
+    /**
+    @return id of the newest post received for @p timeline, it's kept in the account config
+    so the next session only asks the server for newer posts
+    */
+    QString timelineCursor(const QString &timeline);
+    void setTimelineCursor(const QString &timeline, const QString &id);
+
 private:
     class Private;
     Private *d;
@@ -54,6 +54,7 @@ MastodonEditAccountWidget::MastodonEditAccountWidget(MastodonMicroBlog *microblo
     if (m_account) {
         kcfg_alias->setText(m_account->alias());
         kcfg_acct->setText(m_account->acct());
+        kcfg_streaming->setChecked(m_account->useStreaming());
         setAuthenticated(!m_account->tokenSecret().isEmpty());
     } else {
         setAuthenticated(false);
@@ -81,6 +82,7 @@ Choqok::Account *MastodonEditAccountWidget::apply()
     m_account->setAlias(kcfg_alias->text());
     m_account->setAcct(kcfg_acct->text());
     m_account->setTokenSecret(m_account->oAuth()->token());
+    m_account->setUseStreaming(kcfg_streaming->isChecked());
     m_account->writeConfig();
     saveTimelinesTable();
     return m_account;
@@ -26,36 +26,91 @@
 #include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QMenu>
 #include <QMimeDatabase>
-#include <QTextDocument>
+#include <QPointer>
+#include <QUrlQuery>
 
 #include <KIO/StoredTransferJob>
 #include <KPluginFactory>
 
 #include "accountmanager.h"
 #include "application.h"
+#include "backgroundjob.h"
 #include "choqokbehaviorsettings.h"
+#include "htmltext.h"
 #include "notifymanager.h"
+#include "postbackupstore.h"
+#include "poststore.h"
 #include "postwidget.h"
+#include "updatescheduler.h"
 
 #include "mastodonaccount.h"
 #include "mastodondebug.h"
 #include "mastodoneditaccountwidget.h"
 #include "mastodonpost.h"
 #include "mastodonpostwidget.h"
+#include "mastodonstream.h"
 
 class MastodonMicroBlog::Private
 {
 public:
+    /**
+    State of an update of one timeline, which spans several pages when more posts
+    arrived since the last update than fit in one
+    */
+    class TimelineUpdate
+    {
+    public:
+        TimelineUpdate(): pages(0)
+        {}
+        QString sinceId;
+        QString newestId;
+        QUrl nextPage;
+        QList<Choqok::Post *> posts;
+        int pages;
+    };
+
     Private(): countOfTimelinesToSave(0)
     {}
     int countOfTimelinesToSave;
+    QHash<Choqok::Account *, QHash<QString, TimelineUpdate> > timelineUpdates;
+    QHash<Choqok::Account *, QPointer<MastodonStream> > streams;
 };
 
+// Largest page the API serves, and how many pages an update may fetch to fill a gap
+static const int timelinePageSize = 40;
+static const int maxTimelinePages = 5;
+
 K_PLUGIN_FACTORY_WITH_JSON(MastodonMicroBlogFactory, "choqok_mastodon.json",
                            registerPlugin < MastodonMicroBlog > ();)
 
+// JSON keys of the API entities, QJsonObject looks these up without allocating
+static const QLatin1String accountKey("account");
+static const QLatin1String acctKey("acct");
+static const QLatin1String applicationKey("application");
+static const QLatin1String avatarKey("avatar");
+static const QLatin1String contentKey("content");
+static const QLatin1String createdAtKey("created_at");
+static const QLatin1String displayNameKey("display_name");
+static const QLatin1String favouritedKey("favourited");
+static const QLatin1String followersCountKey("followers_count");
+static const QLatin1String idKey("id");
+static const QLatin1String inReplyToAccountIdKey("in_reply_to_account_id");
+static const QLatin1String inReplyToIdKey("in_reply_to_id");
+static const QLatin1String nameKey("name");
+static const QLatin1String noteKey("note");
+static const QLatin1String reblogKey("reblog");
+static const QLatin1String spoilerTextKey("spoiler_text");
+static const QLatin1String urlKey("url");
+static const QLatin1String usernameKey("username");
+static const QLatin1String visibilityKey("visibility");
+
+static const QLatin1String streamUpdateEvent("update");
+static const QLatin1String streamNotificationEvent("notification");
+static const QLatin1String streamDeleteEvent("delete");
+
 const QString MastodonMicroBlog::homeTimeline(QLatin1String("/api/v1/timelines/home"));
 const QString MastodonMicroBlog::notificationsTimeline(QLatin1String("/api/v1/notifications"));
 //const QString MastodonMicroBlog::publicTimeline(QLatin1String("/api/v1/timelines/public"));
@@ -150,8 +205,37 @@ Choqok::Account *MastodonMicroBlog::createNewAccount(const QString &alias)
 QString MastodonMicroBlog::lastTimelineId(Choqok::Account *theAccount,
                                           const QString &timeline) const
 {
-    qCDebug(CHOQOK) << "Latest ID for timeline " << timeline << m_timelinesLatestIds[theAccount][timeline];
-    return m_timelinesLatestIds[theAccount][timeline];
+    QString id = m_timelinesLatestIds.value(theAccount).value(timeline);
+    if (id.isEmpty()) {
+        MastodonAccount *acc = qobject_cast<MastodonAccount *>(theAccount);
+        if (acc) {
+            id = acc->timelineCursor(timeline);
+        }
+    }
+    qCDebug(CHOQOK) << "Latest ID for timeline " << timeline << id;
+    return id;
+}
+
+QUrl MastodonMicroBlog::nextPageUrl(const QString &headers)
+{
+    // Link: <https://host/api/v1/timelines/home?max_id=42>; rel="next", <...>; rel="prev"
+    for (const QString &header: headers.split(QLatin1Char('\n'))) {
+        if (!header.startsWith(QLatin1String("link:"), Qt::CaseInsensitive)) {
+            continue;
+        }
+        for (const QString &link: header.mid(5).split(QLatin1Char(','))) {
+            const int start = link.indexOf(QLatin1Char('<'));
+            const int end = link.indexOf(QLatin1Char('>'), start + 1);
+            if (start < 0 || end < 0) {
+                continue;
+            }
+            const QString params = link.mid(end + 1);
+            if (params.contains(QLatin1String("rel=\"next\"")) || params.contains(QLatin1String("rel=next"))) {
+                return QUrl(link.mid(start + 1, end - start - 1));
+            }
+        }
+    }
+    return QUrl();
 }
 
 QList< Choqok::Post * > MastodonMicroBlog::readTimeline(const QByteArray &buffer)
@@ -159,9 +243,9 @@ QList< Choqok::Post * > MastodonMicroBlog::readTimeline(const QByteArray &buffer
     QList<Choqok::Post * > posts;
     const QJsonDocument json = QJsonDocument::fromJson(buffer);
     if (!json.isNull()) {
-        const QVariantList list = json.array().toVariantList();
-        for (const QVariant &element: list) {
-            posts.prepend(readPost(element.toMap(), new MastodonPost));
+        const QJsonArray list = json.array();
+        for (const QJsonValue &element: list) {
+            posts.prepend(readPost(element.toObject(), new MastodonPost));
         }
     } else {
         qCDebug(CHOQOK) << "Cannot parse JSON reply";
@@ -170,68 +254,65 @@ QList< Choqok::Post * > MastodonMicroBlog::readTimeline(const QByteArray &buffer
     return posts;
 }
 
-Choqok::Post *MastodonMicroBlog::readPost(const QVariantMap &var, Choqok::Post *post)
+void MastodonMicroBlog::readUser(const QJsonObject &account, Choqok::User *user)
+{
+    user->userId = account.value(acctKey).toString();
+    user->userName = account.value(usernameKey).toString();
+    user->realName = account.value(displayNameKey).toString();
+    user->homePageUrl = account.value(urlKey).toString();
+    user->followersCount = uint(account.value(followersCountKey).toDouble());
+
+    user->description = Choqok::HtmlText::toPlainText(account.value(noteKey).toString());
+
+    user->profileImageUrl = account.value(avatarKey).toString();
+}
+
+Choqok::Post *MastodonMicroBlog::readPost(const QJsonObject &var, Choqok::Post *post)
 {
     MastodonPost *p = dynamic_cast< MastodonPost * >(post);
     if (p) {
-        QVariantMap reblog = var[QLatin1String("reblog")].toMap();
-        QVariantMap status;
-        if (reblog.isEmpty()) {
-            status = var;
-        } else {
-            status = reblog;
+        const QJsonObject reblog = var.value(reblogKey).toObject();
+        const QJsonObject status = reblog.isEmpty() ? var : reblog;
+
+        QList<Choqok::Entity> entities;
+        const QString content = Choqok::HtmlText::toPlainText(status.value(spoilerTextKey).toString() +
+                                QLatin1String("<br />") + status.value(contentKey).toString(), &entities);
+        for (Choqok::Entity &entity: entities) {
+            entity.start += p->content.size();
         }
+        p->entities += entities;
+        p->content += content;
 
-        QTextDocument content;
-        content.setHtml(status[QLatin1String("spoiler_text")].toString() + QLatin1String("<br />") + status[QLatin1String("content")].toString());
-        p->content += content.toPlainText().trimmed();
-
-        p->creationDateTime = QDateTime::fromString(var[QLatin1String("created_at")].toString(),
-                              Qt::ISODate);
+        p->creationDateTime = QDateTime::fromString(var.value(createdAtKey).toString(), Qt::ISODate);
         p->creationDateTime.setTimeSpec(Qt::UTC);
 
-        p->link = var[QLatin1String("url")].toString();
-        p->isFavorited = var[QLatin1String("favourited")].toBool();
+        p->link = var.value(urlKey).toString();
+        p->isFavorited = var.value(favouritedKey).toBool();
         if (p->isFavorited) {
             p->isRead = true;
         }
-        p->postId = var[QLatin1String("id")].toString();
+        p->postId = var.value(idKey).toString();
 
-        p->conversationId = var[QLatin1String("id")].toString();
+        p->conversationId = p->postId;
 
-        QVariantMap application = var[QLatin1String("application")].toMap();
+        const QJsonObject application = var.value(applicationKey).toObject();
         if (!application.isEmpty()) {
-            p->source = application[QLatin1String("name")].toString();
+            p->source = application.value(nameKey).toString();
         }
 
-        if (var[QLatin1String("visibility")].toString().compare(QLatin1String("direct")) == 0) {
+        if (var.value(visibilityKey).toString() == QLatin1String("direct")) {
             p->isPrivate = true;
         }
 
-        QVariantMap account = status[QLatin1Literal("account")].toMap();
-
-        p->author.userId = account[QLatin1String("acct")].toString();
-        p->author.userName = account[QLatin1String("username")].toString();
-        p->author.realName = account[QLatin1String("display_name")].toString();
-        p->author.homePageUrl = account[QLatin1String("url")].toString();
-        p->author.followersCount = account[QLatin1String("followers_count")].toUInt();
-
-        QTextDocument description;
-        description.setHtml(account[QLatin1String("note")].toString());
-        p->author.description = description.toPlainText().trimmed();
+        readUser(status.value(accountKey).toObject(), &p->author);
 
-        p->author.profileImageUrl = account[QLatin1String("avatar")].toString();
-
-        p->replyToPostId = var[QLatin1String("in_reply_to_id")].toString();
-        p->replyToUserId = var[QLatin1String("in_reply_to_account_id")].toString();
+        p->replyToPostId = var.value(inReplyToIdKey).toString();
+        p->replyToUserId = var.value(inReplyToAccountIdKey).toString();
 
         if (!reblog.isEmpty()) {
-            p->repeatedDateTime = QDateTime::fromString(var[QLatin1String("created_at")].toString(),
-                              Qt::ISODate);
-            p->repeatedDateTime.setTimeSpec(Qt::UTC);
-
-            p->repeatedPostId = var[QLatin1String("id")].toString();
-            p->repeatedFromUsername = var[QLatin1Literal("account")].toMap()[QLatin1String("acct")].toString();
+            p->repeatedDateTime = p->creationDateTime;
+            p->repeatedPostId = p->postId;
+            p->repeatedFromUsername = var.value(accountKey).toObject().value(acctKey).toString();
         }
 
         return p;
@@ -352,6 +433,7 @@ void MastodonMicroBlog::slotFavorite(KJob *job)
     } else {
         post->isFavorited = !post->isFavorited;
         Q_EMIT favorite(theAccount, post);
+        Choqok::PostStore::self()->notifyChanged(theAccount, post);
     }
 }
 
@@ -360,6 +442,10 @@ void MastodonMicroBlog::setLastTimelineId(Choqok::Account *theAccount,
                                           const QString &id)
 {
     m_timelinesLatestIds[theAccount][timeline] = id;
+    MastodonAccount *acc = qobject_cast<MastodonAccount *>(theAccount);
+    if (acc) {
+        acc->setTimelineCursor(timeline, id);
+    }
 }
 
 void MastodonMicroBlog::setTimelinesInfo()
@@ -416,8 +502,34 @@ void MastodonMicroBlog::removePost(Choqok::Account *theAccount, Choqok::Post *po
     }
 }
 
+static Choqok::Post *createMastodonPost()
+{
+    return new MastodonPost;
+}
+
 QList<Choqok::Post * > MastodonMicroBlog::loadTimeline(Choqok::Account *account,
                                                 const QString &timelineName)
+{
+    Choqok::PostBackupStore *store = Choqok::PostBackupStore::store(account->alias(), timelineName);
+    QList< Choqok::Post * > list;
+    if (store->exists() || !store->hasLegacyBackup()) {
+        list = store->load(createMastodonPost);
+    } else {
+        // One time migration of the KConfig backup of older versions
+        list = loadLegacyTimeline(account, timelineName);
+        store->save(list);
+        store->removeLegacyBackup();
+    }
+
+    if (!list.isEmpty() && lastTimelineId(account, timelineName).isEmpty()) {
+        setLastTimelineId(account, timelineName, list.last()->conversationId);
+    }
+
+    return list;
+}
+
+QList<Choqok::Post * > MastodonMicroBlog::loadLegacyTimeline(Choqok::Account *account,
+                                                      const QString &timelineName)
 {
     QList< Choqok::Post * > list;
     const QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(),
@@ -462,10 +574,6 @@ QList<Choqok::Post * > MastodonMicroBlog::loadTimeline(Choqok::Account *account,
         list.append(st);
     }
 
-    if (!list.isEmpty()) {
-        setLastTimelineId(account, timelineName, list.last()->conversationId);
-    }
-
     return list;
 }
 
@@ -493,42 +601,10 @@ QString MastodonMicroBlog::userNameFromAcct(const QString &acct)
     }
 }
 
-void MastodonMicroBlog::saveTimeline(Choqok::Account *account, const QString &timelineName,
-                                     const QList< Choqok::UI::PostWidget * > &timeline)
+void MastodonMicroBlog::savePosts(Choqok::Account *account, const QString &timelineName,
+                                  const QList< Choqok::Post * > &timeline)
 {
-    const QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(),
-                             timelineName);
-    KConfig postsBackup(fileName, KConfig::NoGlobals, QStandardPaths::DataLocation);
-
-    ///Clear previous data:
-    for (const QString &group: postsBackup.groupList()) {
-        postsBackup.deleteGroup(group);
-    }
-
-    for (Choqok::UI::PostWidget *wd: timeline) {
-        MastodonPost *post = dynamic_cast<MastodonPost * >(wd->currentPost());
-        KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
-        grp.writeEntry("creationDateTime", post->creationDateTime);
-        grp.writeEntry("postId", post->postId);
-        grp.writeEntry("link", post->link);
-        grp.writeEntry("content", post->content);
-        grp.writeEntry("source", post->source);
-        grp.writeEntry("favorited", post->isFavorited);
-        grp.writeEntry("authorId", post->author.userId);
-        grp.writeEntry("authorRealName", post->author.realName);
-        grp.writeEntry("authorUserName", post->author.userName);
-        grp.writeEntry("authorDescription", post->author.description);
-        grp.writeEntry("authorProfileImageUrl", post->author.profileImageUrl);
-        grp.writeEntry("authorHomePageUrl", post->author.homePageUrl);
-        grp.writeEntry("isRead", post->isRead);
-        grp.writeEntry("conversationId", post->conversationId);
-        grp.writeEntry("replyToPostId", post->replyToPostId);
-        grp.writeEntry("replyToUserId", post->replyToUserId);
-        grp.writeEntry("repeatedFrom", post->repeatedFromUsername);
-        grp.writeEntry("repeatedPostId", post->repeatedPostId);
-        grp.writeEntry("repeatedDateTime", post->repeatedDateTime);
-    }
-    postsBackup.sync();
+    Choqok::PostBackupStore::store(account->alias(), timelineName)->save(timeline);
 
     if (Choqok::Application::isShuttingDown()) {
         --d->countOfTimelinesToSave;
@@ -547,39 +623,123 @@ void MastodonMicroBlog::updateTimelines(Choqok::Account *theAccount)
 {
     MastodonAccount *acc = qobject_cast<MastodonAccount *>(theAccount);
     if (acc) {
+        updateStream(acc);
         for (const QString &timeline: acc->timelineNames()) {
-            QUrl url(acc->host());
-            url = url.adjusted(QUrl::StripTrailingSlash);
-            url.setPath(url.path() + QLatin1Char('/') + m_timelinesPaths[timeline]);
-
-            QUrlQuery query;
-            if (timeline.compare(QLatin1String("Notifications")) == 0) {
-                const QString lastActivityId(lastTimelineId(theAccount, timeline));
-                if (!lastActivityId.isEmpty()) {
-                    query.addQueryItem(QLatin1String("since_id"), lastActivityId);
-                }
-            }
-//            else if (timeline.compare(QLatin1String("Local")) == 0) {
-//                query.addQueryItem(QLatin1String("local"), QLatin1String("true"));
-//            }
-            url.setQuery(query);
-
-            KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::Reload, KIO::HideProgressInfo);
-            if (!job) {
-                qCDebug(CHOQOK) << "Cannot create an http GET request!";
-                continue;
-            }
-            job->addMetaData(QLatin1String("customHTTPHeader"), authorizationMetaData(acc));
-            m_timelinesRequests[job] = timeline;
-            m_accountJobs[job] = acc;
-            connect(job, SIGNAL(result(KJob*)), this, SLOT(slotUpdateTimeline(KJob*)));
-            job->start();
+            fetchTimeline(acc, timeline);
         }
     } else {
         qCDebug(CHOQOK) << "theAccount is not a MastodonAccount!";
     }
 }
 
+bool MastodonMicroBlog::updateTimeline(Choqok::Account *theAccount, const QString &timelineName)
+{
+    MastodonAccount *acc = qobject_cast<MastodonAccount *>(theAccount);
+    if (!acc) {
+        qCDebug(CHOQOK) << "theAccount is not a MastodonAccount!";
+        return true;
+    }
+    MastodonStream *stream = updateStream(acc);
+    // The user stream carries both of these
+    if (stream && stream->isConnected() && (m_timelinesPaths[timelineName] == homeTimeline ||
+                                            m_timelinesPaths[timelineName] == notificationsTimeline)) {
+        qCDebug(CHOQOK) << timelineName << "is streamed, not polling it";
+        return true;
+    }
+    fetchTimeline(acc, timelineName);
+    return true;
+}
+
+void MastodonMicroBlog::fetchTimeline(MastodonAccount *acc, const QString &timelineName)
+{
+    if (d->timelineUpdates.value(acc).contains(timelineName)) {
+        qCDebug(CHOQOK) << "Update of" << timelineName << "is still running";
+        return;
+    }
+
+    QUrl url(acc->host());
+    url = url.adjusted(QUrl::StripTrailingSlash);
+    url.setPath(url.path() + QLatin1Char('/') + m_timelinesPaths[timelineName]);
+
+    Private::TimelineUpdate update;
+    update.sinceId = lastTimelineId(acc, timelineName);
+
+    QUrlQuery query;
+    if (!update.sinceId.isEmpty()) {
+        query.addQueryItem(QLatin1String("since_id"), update.sinceId);
+    }
+    query.addQueryItem(QLatin1String("limit"), QString::number(timelinePageSize));
+//    if (timelineName.compare(QLatin1String("Local")) == 0) {
+//        query.addQueryItem(QLatin1String("local"), QLatin1String("true"));
+//    }
+    url.setQuery(query);
+
+    d->timelineUpdates[acc][timelineName] = update;
+    fetchTimelinePage(acc, timelineName, url);
+}
+
+void MastodonMicroBlog::fetchTimelinePage(MastodonAccount *account, const QString &timeline,
+                                          const QUrl &url)
+{
+    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::Reload, KIO::HideProgressInfo);
+    if (!job) {
+        qCDebug(CHOQOK) << "Cannot create an http GET request!";
+        finishTimelineUpdate(account, timeline, false);
+        return;
+    }
+    job->addMetaData(QLatin1String("customHTTPHeader"), authorizationMetaData(account));
+    job->addMetaData(QLatin1String("PropagateHttpHeader"), QLatin1String("true"));
+    m_timelinesRequests[job] = timeline;
+    m_accountJobs[job] = account;
+    connect(job, SIGNAL(result(KJob*)), this, SLOT(slotUpdateTimeline(KJob*)));
+    job->start();
+}
+
+void MastodonMicroBlog::finishTimelineUpdate(Choqok::Account *account, const QString &timeline,
+                                             bool complete)
+{
+    const Private::TimelineUpdate update = d->timelineUpdates[account].take(timeline);
+    if (d->timelineUpdates[account].isEmpty()) {
+        d->timelineUpdates.remove(account);
+    }
+
+    if (complete && !update.newestId.isEmpty()) {
+        setLastTimelineId(account, timeline, update.newestId);
+    }
+    if (complete || !update.posts.isEmpty()) {
+        Q_EMIT timelineDataReceived(account, timeline, update.posts);
+    }
+}
+
+MastodonStream *MastodonMicroBlog::updateStream(MastodonAccount *account)
+{
+    MastodonStream *stream = d->streams.value(account);
+    if (!account->useStreaming() || !account->isEnabled()) {
+        if (stream) {
+            stream->stop();
+            stream->deleteLater();
+        }
+        d->streams.remove(account);
+        return nullptr;
+    }
+
+    QUrl url(account->streamingUrl());
+    url = url.adjusted(QUrl::StripTrailingSlash);
+    url.setPath(url.path() + QLatin1String("/api/v1/streaming/user"));
+
+    if (!stream) {
+        stream = new MastodonStream(account);
+        connect(stream, SIGNAL(connected()), this, SLOT(slotStreamConnected()));
+        connect(stream, SIGNAL(eventReceived(QString,QByteArray)),
+                this, SLOT(slotStreamEvent(QString,QByteArray)));
+        d->streams[account] = stream;
+    }
+    stream->setUrl(url);
+    stream->setAccessToken(account->oAuth()->token());
+    stream->start();
+    return stream;
+}
+
 QString MastodonMicroBlog::authorizationMetaData(MastodonAccount *account) const
 {
     return QStringLiteral("Authorization: Bearer ") + account->oAuth()->token();
@@ -637,8 +797,8 @@ void MastodonMicroBlog::slotCreatePost(KJob *job)
 
         const QJsonDocument json = QJsonDocument::fromJson(j->data());
         if (!json.isNull()) {
-            const QVariantMap reply = json.toVariant().toMap();
-            if (!reply[QLatin1String("id")].toString().isEmpty()) {
+            const QJsonObject reply = json.object();
+            if (!reply.value(idKey).toString().isEmpty()) {
                 Choqok::NotifyManager::success(i18n("New post submitted successfully"));
                 ret = 0;
                 Q_EMIT postCreated(theAccount, post);
@@ -675,9 +835,8 @@ void MastodonMicroBlog::slotFetchPost(KJob *job)
 
         const QJsonDocument json = QJsonDocument::fromJson(j->data());
         if (!json.isNull()) {
-            const QVariantMap reply = json.toVariant().toMap();
             MastodonPost *post = new MastodonPost;
-            readPost(reply, post);
+            readPost(json.object(), post);
             ret = 0;
             Q_EMIT postFetched(theAccount, post);
         } else {
@@ -736,6 +895,7 @@ void MastodonMicroBlog::slotUpdateTimeline(KJob *job)
         return;
     }
     Choqok::Account *account = m_accountJobs.take(job);
+    const QString timeline(m_timelinesRequests.take(job));
     if (!account) {
         qCDebug(CHOQOK) << "Account or Post is NULL pointer";
         return;
@@ -744,15 +904,107 @@ void MastodonMicroBlog::slotUpdateTimeline(KJob *job)
         qCDebug(CHOQOK) << "Job Error:" << job->errorString();
         Q_EMIT error(account, Choqok::MicroBlog::CommunicationError,
                      i18n("An error occurred when fetching the timeline"));
+        finishTimelineUpdate(account, timeline, false);
     } else {
         KIO::StoredTransferJob *j = qobject_cast<KIO::StoredTransferJob * >(job);
-        const QList<Choqok::Post * > list = readTimeline(j->data());
-        const QString timeline(m_timelinesRequests.take(job));
-        if (!list.isEmpty()) {
-            setLastTimelineId(account, timeline, list.last()->conversationId);
+        const QString headers(j->queryMetaData(QLatin1String("HTTP-Headers")));
+        Choqok::UpdateScheduler::self()->reportHttpHeaders(account, headers);
+        d->timelineUpdates[account][timeline].nextPage = nextPageUrl(headers);
+
+        const QByteArray data = j->data();
+        Choqok::BackgroundJob *parser = new Choqok::BackgroundJob([data]() {
+            return QVariant::fromValue(readTimeline(data));
+        }, this);
+        m_parserAccounts[parser] = account;
+        m_parserTimelines[parser] = timeline;
+        connect(parser, SIGNAL(finished(Choqok::BackgroundJob*)),
+                this, SLOT(slotTimelineParsed(Choqok::BackgroundJob*)));
+        parser->start();
+    }
+}
+
+void MastodonMicroBlog::slotTimelineParsed(Choqok::BackgroundJob *job)
+{
+    Choqok::Account *account = m_parserAccounts.take(job);
+    const QString timeline(m_parserTimelines.take(job));
+    const QList<Choqok::Post * > list = job->result().value<QList<Choqok::Post * > >();
+
+    Private::TimelineUpdate &update = d->timelineUpdates[account][timeline];
+    ++update.pages;
+    if (update.pages == 1 && !list.isEmpty()) {
+        update.newestId = list.last()->conversationId;
+    }
+    // Every page is older than the ones before, keep the list sorted oldest first
+    update.posts = list + update.posts;
+
+    // A full page means there may be more posts between it and the last update
+    MastodonAccount *acc = qobject_cast<MastodonAccount *>(account);
+    if (acc && !update.sinceId.isEmpty() && list.count() >= timelinePageSize && update.nextPage.isValid()) {
+        if (update.pages < maxTimelinePages) {
+            QUrl url(update.nextPage);
+            QUrlQuery query(url);
+            if (!query.hasQueryItem(QLatin1String("since_id"))) {
+                query.addQueryItem(QLatin1String("since_id"), update.sinceId);
+                url.setQuery(query);
+            }
+            qCDebug(CHOQOK) << "Filling gap of" << timeline << "with" << url;
+            fetchTimelinePage(acc, timeline, url);
+            return;
         }
+        qCDebug(CHOQOK) << "Gap of" << timeline << "is larger than" << maxTimelinePages << "pages, older posts are skipped";
+    }
 
-        Q_EMIT timelineDataReceived(account, timeline, list);
+    finishTimelineUpdate(account, timeline, true);
+}
+
+void MastodonMicroBlog::slotAccountChanged(Choqok::Account *account)
+{
+    MastodonAccount *acc = qobject_cast<MastodonAccount *>(account);
+    if (acc && (d->streams.contains(acc) || acc->useStreaming())) {
+        updateStream(acc);
+    }
+}
+
+void MastodonMicroBlog::slotStreamConnected()
+{
+    MastodonStream *stream = qobject_cast<MastodonStream *>(sender());
+    MastodonAccount *account = stream ? qobject_cast<MastodonAccount *>(stream->parent()) : nullptr;
+    if (account) {
+        // Catch up with what was posted while the stream was down
+        updateTimelines(account);
+    }
+}
+
+void MastodonMicroBlog::slotStreamEvent(const QString &event, const QByteArray &data)
+{
+    MastodonStream *stream = qobject_cast<MastodonStream *>(sender());
+    MastodonAccount *account = stream ? qobject_cast<MastodonAccount *>(stream->parent()) : nullptr;
+    if (!account) {
+        return;
+    }
+
+    if (event == streamUpdateEvent || event == streamNotificationEvent) {
+        const QString timeline(event == streamUpdateEvent ? QLatin1String("Home") : QLatin1String("Notifications"));
+        if (!account->timelineNames().contains(timeline)) {
+            return;
+        }
+        const QJsonObject object = QJsonDocument::fromJson(data).object();
+        if (object.isEmpty()) {
+            qCDebug(CHOQOK) << "Cannot parse streamed" << event;
+            return;
+        }
+
+        Choqok::Post *post = readPost(object, new MastodonPost);
+        if (!d->timelineUpdates.value(account).contains(timeline)) {
+            setLastTimelineId(account, timeline, post->conversationId);
+        }
+        QList<Choqok::Post *> list;
+        list.append(post);
+        streamPosts(account, timeline, list);
+    } else if (event == streamDeleteEvent) {
+        MastodonPost post;
+        post.postId = QString::fromUtf8(data).trimmed();
+        Q_EMIT postRemoved(account, &post);
     }
 }
 
@@ -27,10 +27,17 @@
 
 #include "microblog.h"
 
+class QJsonObject;
 class QUrl;
 class KJob;
+
+namespace Choqok
+{
+class BackgroundJob;
+}
 class MastodonAccount;
 class MastodonPost;
+class MastodonStream;
 
 class MastodonMicroBlog : public Choqok::MicroBlog
 {
@@ -60,13 +67,15 @@ public:
 
     virtual QUrl profileUrl(Choqok::Account *account, const Choqok::User &user) const override;
 
-    virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
-                              const QList< Choqok::UI::PostWidget * > &timeline) override;
+    virtual void savePosts(Choqok::Account *account, const QString &timelineName,
+                           const QList< Choqok::Post * > &timeline) override;
 
     virtual Choqok::TimelineInfo *timelineInfo(const QString &timelineName) override;
 
     virtual void updateTimelines(Choqok::Account *theAccount) override;
 
+    virtual bool updateTimeline(Choqok::Account *theAccount, const QString &timelineName) override;
+
     void toggleReblog(Choqok::Account *theAccount, Choqok::Post *post);
 
     void toggleFavorite(Choqok::Account *theAccount, Choqok::Post *post);
@@ -84,6 +93,10 @@ protected Q_SLOTS:
     void slotReblog(KJob *job);
     void slotRemovePost(KJob *job);
     void slotUpdateTimeline(KJob *job);
+    void slotTimelineParsed(Choqok::BackgroundJob *job);
+    void slotAccountChanged(Choqok::Account *account);
+    void slotStreamConnected();
+    void slotStreamEvent(const QString &event, const QByteArray &data);
 
 protected:
     static const QString homeTimeline;
@@ -94,9 +107,52 @@ protected:
 
     QString lastTimelineId(Choqok::Account *theAccount, const QString &timeline) const;
 
-    Choqok::Post *readPost(const QVariantMap &var, Choqok::Post *post);
-
-    QList<Choqok::Post * > readTimeline(const QByteArray &buffer);
+    /**
+    Start or stop the stream of @p account, following its settings
+    @return the running stream, or null if streaming is off
+    */
+    MastodonStream *updateStream(MastodonAccount *account);
+
+    /**
+    Request the posts of @p timeline which are newer than the last update
+    */
+    void fetchTimeline(MastodonAccount *account, const QString &timelineName);
+
+    /**
+    Request one page of @p timeline, the reply goes to slotUpdateTimeline()
+    */
+    void fetchTimelinePage(MastodonAccount *account, const QString &timeline, const QUrl &url);
+
+    /**
+    Deliver the posts collected by the update of @p timeline. The timeline cursor moves to the
+    newest of them only when @p complete, so a failed update is retried by the next one.
+    */
+    void finishTimelineUpdate(Choqok::Account *account, const QString &timeline, bool complete);
+
+    /**
+    @return the rel="next" target of a Link header in raw HTTP @p headers, used for pagination
+    */
+    static QUrl nextPageUrl(const QString &headers);
+
+    /**
+    Doesn't touch any member, so it's safe to call from a Choqok::BackgroundJob
+    */
+    static Choqok::Post *readPost(const QJsonObject &var, Choqok::Post *post);
+
+    /**
+    Read a Mastodon account entity into @p user
+    */
+    static void readUser(const QJsonObject &account, Choqok::User *user);
+
+    /**
+    Doesn't touch any member, so it's safe to call from a Choqok::BackgroundJob
+    */
+    static QList<Choqok::Post * > readTimeline(const QByteArray &buffer);
+
+    /**
+    Read posts of the KConfig based timeline backup of older versions
+    */
+    QList<Choqok::Post * > loadLegacyTimeline(Choqok::Account *account, const QString &timelineName);
 
     void setLastTimelineId(Choqok::Account *theAccount, const QString &timeline,
                            const QString &id);
@@ -111,6 +167,8 @@ protected:
     QHash<Choqok::Account *, QMap<QString, QString> > m_timelinesLatestIds;
     QHash<QString, QString> m_timelinesPaths;
     QMap<KJob *, QString> m_timelinesRequests;
+    QMap<Choqok::BackgroundJob *, Choqok::Account *> m_parserAccounts;
+    QMap<Choqok::BackgroundJob *, QString> m_parserTimelines;
 
 private:
     class Private;
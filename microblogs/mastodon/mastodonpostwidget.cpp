@@ -41,6 +41,10 @@ const QIcon MastodonPostWidget::unFavIcon(Choqok::MediaManager::convertToGraySca
 class MastodonPostWidget::Private
 {
 public:
+    Private()
+        : btnFavorite(0)
+    {}
+
     QPushButton *btnFavorite;
 };
 
@@ -127,6 +131,14 @@ void MastodonPostWidget::slotToggleFavorite(Choqok::Account *, Choqok::Post *)
     updateFavStat();
 }
 
+void MastodonPostWidget::slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes)
+{
+    Choqok::UI::PostWidget::slotPostChanged(theAccount, post, changes);
+    if (d->btnFavorite && theAccount == currentAccount() && post == currentPost()) {
+        updateFavStat();
+    }
+}
+
 void MastodonPostWidget::updateFavStat()
 {
     d->btnFavorite->setChecked(currentPost()->isFavorited);
@@ -0,0 +1,222 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "mastodonstream.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include "mastodondebug.h"
+
+static const int MIN_RETRY_MSECS = 1000;
+static const int MAX_RETRY_MSECS = 5 * 60 * 1000;
+// Mastodon sends a heartbeat comment every 15 seconds
+static const int WATCHDOG_MSECS = 60 * 1000;
+
+MastodonStream::MastodonStream(QObject *parent)
+    : QObject(parent), m_manager(new QNetworkAccessManager(this)),
+      m_reply(0), m_retryDelay(MIN_RETRY_MSECS), m_connected(false), m_running(false)
+{
+    m_reconnectTimer.setSingleShot(true);
+    connect(&m_reconnectTimer, SIGNAL(timeout()), this, SLOT(connectToServer()));
+    m_watchdog.setSingleShot(true);
+    m_watchdog.setInterval(WATCHDOG_MSECS);
+    connect(&m_watchdog, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+}
+
+MastodonStream::~MastodonStream()
+{
+    stop();
+}
+
+QUrl MastodonStream::url() const
+{
+    return m_url;
+}
+
+void MastodonStream::setUrl(const QUrl &url)
+{
+    m_url = url;
+}
+
+QString MastodonStream::accessToken() const
+{
+    return m_accessToken;
+}
+
+void MastodonStream::setAccessToken(const QString &token)
+{
+    m_accessToken = token;
+}
+
+void MastodonStream::start()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_retryDelay = MIN_RETRY_MSECS;
+    connectToServer();
+}
+
+void MastodonStream::stop()
+{
+    m_running = false;
+    m_reconnectTimer.stop();
+    m_watchdog.stop();
+    if (m_reply) {
+        QNetworkReply *reply = m_reply;
+        m_reply = 0;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    m_buffer.clear();
+    if (m_connected) {
+        m_connected = false;
+        Q_EMIT disconnected();
+    }
+}
+
+bool MastodonStream::isConnected() const
+{
+    return m_connected;
+}
+
+void MastodonStream::connectToServer()
+{
+    if (!m_running || m_reply) {
+        return;
+    }
+
+    qCDebug(CHOQOK) << "Connecting to" << m_url;
+
+    QNetworkRequest request(m_url);
+    request.setRawHeader("Authorization", "Bearer " + m_accessToken.toUtf8());
+    request.setRawHeader("Accept", "text/event-stream");
+    request.setRawHeader("Cache-Control", "no-cache");
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+
+    m_buffer.clear();
+    m_reply = m_manager->get(request);
+    connect(m_reply, SIGNAL(metaDataChanged()), this, SLOT(slotMetaDataChanged()));
+    connect(m_reply, SIGNAL(readyRead()), this, SLOT(slotReadyRead()));
+    connect(m_reply, SIGNAL(finished()), this, SLOT(slotFinished()));
+    m_watchdog.start();
+}
+
+void MastodonStream::slotMetaDataChanged()
+{
+    const int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 200 && !m_connected) {
+        qCDebug(CHOQOK) << "Streaming" << m_url;
+        m_connected = true;
+        Q_EMIT connected();
+    } else if (status >= 400) {
+        qCDebug(CHOQOK) << "Streaming refused with HTTP status" << status;
+        m_reply->abort();
+    }
+}
+
+void MastodonStream::slotReadyRead()
+{
+    if (!m_connected) {
+        // Body of an error reply
+        m_reply->readAll();
+        return;
+    }
+    // Only a stream that delivers counts as working, not one that is accepted and closed again
+    m_retryDelay = MIN_RETRY_MSECS;
+    m_watchdog.start();
+    m_buffer += m_reply->readAll();
+    parseEvents();
+}
+
+void MastodonStream::parseEvents()
+{
+    // Events are separated by an empty line, lines may end with CRLF
+    m_buffer.replace("\r\n", "\n");
+    int end;
+    while ((end = m_buffer.indexOf("\n\n")) >= 0) {
+        const QByteArray block = m_buffer.left(end);
+        m_buffer.remove(0, end + 2);
+
+        QString event;
+        QByteArray data;
+        for (const QByteArray &line: block.split('\n')) {
+            if (line.isEmpty() || line.startsWith(':')) {
+                // A comment, used as heartbeat
+                continue;
+            }
+            const int colon = line.indexOf(':');
+            const QByteArray field = colon < 0 ? line : line.left(colon);
+            QByteArray value = colon < 0 ? QByteArray() : line.mid(colon + 1);
+            if (value.startsWith(' ')) {
+                value.remove(0, 1);
+            }
+            if (field == "event") {
+                event = QString::fromUtf8(value);
+            } else if (field == "data") {
+                if (!data.isEmpty()) {
+                    data += '\n';
+                }
+                data += value;
+            }
+        }
+        if (!event.isEmpty()) {
+            Q_EMIT eventReceived(event, data);
+        }
+    }
+}
+
+void MastodonStream::slotFinished()
+{
+    QNetworkReply *reply = m_reply;
+    m_reply = 0;
+    m_watchdog.stop();
+    if (reply) {
+        if (reply->error() != QNetworkReply::NoError) {
+            qCDebug(CHOQOK) << "Stream closed:" << reply->errorString();
+        }
+        reply->deleteLater();
+    }
+    if (m_connected) {
+        m_connected = false;
+        Q_EMIT disconnected();
+    }
+    if (m_running) {
+        qCDebug(CHOQOK) << "Reconnecting in" << m_retryDelay << "ms";
+        m_reconnectTimer.start(m_retryDelay);
+        m_retryDelay = qMin(m_retryDelay * 2, MAX_RETRY_MSECS);
+    }
+}
+
+void MastodonStream::slotTimeout()
+{
+    qCDebug(CHOQOK) << "Stream" << m_url << "went silent";
+    if (m_reply) {
+        m_reply->abort();
+    }
+}
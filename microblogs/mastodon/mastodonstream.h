@@ -0,0 +1,107 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef MASTODONSTREAM_H
+#define MASTODONSTREAM_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/**
+@brief Server-sent events of a Mastodon stream
+
+Connects to @ref url(), like /api/v1/streaming/user of @ref MastodonAccount::streamingUrl(),
+and emits every event (update, notification, delete, ...) as it arrives.
+Lost connections are retried after 1 second, doubling up to 5 minutes, and a connection
+that sent nothing, not even the server's heartbeat, for a minute counts as lost.
+*/
+class MastodonStream : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MastodonStream(QObject *parent = nullptr);
+    ~MastodonStream();
+
+    QUrl url() const;
+    /**
+    Set the URL of the stream, used from the next connection on
+    */
+    void setUrl(const QUrl &url);
+
+    QString accessToken() const;
+    /**
+    Set the OAuth token sent as bearer, used from the next connection on
+    */
+    void setAccessToken(const QString &token);
+
+    /**
+    Connect, and keep reconnecting until @ref stop()
+    */
+    void start();
+    void stop();
+
+    /**
+    @return true while the server accepted the stream
+    */
+    bool isConnected() const;
+
+Q_SIGNALS:
+    /**
+    Emitted when the stream was (re)established, events missed while it was down are lost
+    */
+    void connected();
+    void disconnected();
+
+    /**
+    @p data is the payload of the event, e.g. a status entity as JSON for "update"
+    */
+    void eventReceived(const QString &event, const QByteArray &data);
+
+protected Q_SLOTS:
+    void connectToServer();
+    void slotMetaDataChanged();
+    void slotReadyRead();
+    void slotFinished();
+    void slotTimeout();
+
+private:
+    void parseEvents();
+
+    QUrl m_url;
+    QString m_accessToken;
+    QNetworkAccessManager *m_manager;
+    QNetworkReply *m_reply;
+    QByteArray m_buffer;
+    QTimer m_reconnectTimer;
+    QTimer m_watchdog;
+    int m_retryDelay;
+    bool m_connected;
+    bool m_running;
+};
+
+#endif // MASTODONSTREAM_H
@@ -57,8 +57,8 @@ OCSMicroblog::~OCSMicroblog()
     delete mProviderManager;
 }
 
-void OCSMicroblog::saveTimeline(Choqok::Account *account, const QString &timelineName,
-                                const QList< Choqok::UI::PostWidget * > &timeline)
+void OCSMicroblog::savePosts(Choqok::Account *account, const QString &timelineName,
+                             const QList< Choqok::Post * > &timeline)
 {
     qCDebug(CHOQOK);
     QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(), timelineName);
@@ -69,8 +69,7 @@ void OCSMicroblog::saveTimeline(Choqok::Account *account, const QString &timelin
         postsBackup.deleteGroup(group);
     }
 
-    for (Choqok::UI::PostWidget *wd: timeline) {
-        const Choqok::Post *post = wd->currentPost();
+    for (const Choqok::Post *post: timeline) {
         KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
         grp.writeEntry("creationDateTime", post->creationDateTime);
         grp.writeEntry("postId", post->postId);
@@ -45,8 +45,8 @@ public:
     virtual void abortCreatePost(Choqok::Account *theAccount, Choqok::Post *post = 0) override;
     virtual void fetchPost(Choqok::Account *theAccount, Choqok::Post *post) override;
     virtual void removePost(Choqok::Account *theAccount, Choqok::Post *post) override;
-    virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
-                              const QList< Choqok::UI::PostWidget * > &timeline) override;
+    virtual void savePosts(Choqok::Account *account, const QString &timelineName,
+                           const QList< Choqok::Post * > &timeline) override;
     virtual QList< Choqok::Post * > loadTimeline(Choqok::Account *account, const QString &timelineName) override;
     virtual Choqok::Account *createNewAccount(const QString &alias) override;
     virtual void updateTimelines(Choqok::Account *theAccount) override;
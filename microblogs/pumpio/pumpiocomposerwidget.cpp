@@ -34,7 +34,6 @@
 
 #include "account.h"
 #include "choqoktextedit.h"
-#include "shortenmanager.h"
 
 #include "pumpiodebug.h"
 #include "pumpiomicroblog.h"
@@ -72,18 +71,13 @@ PumpIOComposerWidget::~PumpIOComposerWidget()
     delete d;
 }
 
-void PumpIOComposerWidget::submitPost(const QString &text)
+void PumpIOComposerWidget::sendPost(const QString &text)
 {
     qCDebug(CHOQOK);
     editorContainer()->setEnabled(false);
-    QString txt = text;
-    if (currentAccount()->postCharLimit() &&
-            txt.size() > (int) currentAccount()->postCharLimit()) {
-        txt = Choqok::ShortenManager::self()->parseText(txt);
-    }
     setPostToSubmit(nullptr);
     setPostToSubmit(new Choqok::Post);
-    postToSubmit()->content = txt;
+    postToSubmit()->content = text;
     if (!replyToId.isEmpty()) {
         postToSubmit()->replyToPostId = replyToId;
     }
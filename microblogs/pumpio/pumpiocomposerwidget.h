@@ -33,7 +33,7 @@ public:
     ~PumpIOComposerWidget();
 
 protected Q_SLOTS:
-    virtual void submitPost(const QString &text) override;
+    virtual void sendPost(const QString &text) override;
     virtual void slotPostSubmited(Choqok::Account *theAccount, Choqok::Post *post) override;
     void slotSetReply(const QString replyToId, const QString replyToUsername, const QString replyToObjectType);
 
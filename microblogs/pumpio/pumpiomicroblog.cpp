@@ -25,7 +25,9 @@
 
 #include <QAction>
 #include <QFile>
+#include <QJsonArray>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QMenu>
 #include <QMimeDatabase>
 #include <QTextDocument>
@@ -35,8 +37,10 @@
 
 #include "accountmanager.h"
 #include "application.h"
+#include "backgroundjob.h"
 #include "choqokbehaviorsettings.h"
 #include "notifymanager.h"
+#include "poststore.h"
 
 #include "pumpioaccount.h"
 #include "pumpiocomposerwidget.h"
@@ -272,34 +276,36 @@ void PumpIOMicroBlog::createPostWithMedia(Choqok::Account *theAccount, Choqok::P
 {
     PumpIOAccount *acc = qobject_cast<PumpIOAccount *>(theAccount);
     if (acc) {
-        QFile media(filePath);
-        QByteArray data;
-        if (media.open(QIODevice::ReadOnly)) {
-            data = media.readAll();
-            media.close();
-        } else {
+        // The file is read while it's sent, and deleted with the job
+        QFile *media = new QFile(filePath);
+        if (!media->open(QIODevice::ReadOnly)) {
             qCDebug(CHOQOK) << "Cannot read the file";
+            delete media;
             return;
         }
 
         const QMimeDatabase db;
-        const QMimeType mimetype = db.mimeTypeForFileNameAndData(filePath, data);
+        const QMimeType mimetype = db.mimeTypeForFileNameAndData(filePath, media);
         const QString mime = mimetype.name();
         if (mime == QLatin1String("application/octet-stream")) {
             qCDebug(CHOQOK) << "Cannot retrieve file mimetype";
+            delete media;
             return;
         }
+        media->seek(0);
 
         QUrl url(acc->host());
         url = url.adjusted(QUrl::StripTrailingSlash);
         url.setPath(url.path() + QStringLiteral("/api/user/%1/uploads").arg(acc->username()));
-        KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
-        job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: ") + mime);
-        job->addMetaData(QLatin1String("customHTTPHeader"), authorizationMetaData(acc, url, QNetworkAccessManager::PostOperation));
+        KIO::StoredTransferJob *job = KIO::storedHttpPost(media, url, media->size(), KIO::HideProgressInfo);
         if (!job) {
             qCDebug(CHOQOK) << "Cannot create an http POST request!";
+            delete media;
             return;
         }
+        media->setParent(job);
+        job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: ") + mime);
+        job->addMetaData(QLatin1String("customHTTPHeader"), authorizationMetaData(acc, url, QNetworkAccessManager::PostOperation));
         m_accountJobs[job] = acc;
         m_uploadJobs[job] = post;
         connect(job, SIGNAL(result(KJob*)), this, SLOT(slotUpload(KJob*)));
@@ -443,8 +449,8 @@ QUrl PumpIOMicroBlog::profileUrl(Choqok::Account *account, const Choqok::User &u
     return QUrl(user.homePageUrl);
 }
 
-void PumpIOMicroBlog::saveTimeline(Choqok::Account *account, const QString &timelineName,
-                                   const QList< Choqok::UI::PostWidget * > &timeline)
+void PumpIOMicroBlog::savePosts(Choqok::Account *account, const QString &timelineName,
+                                const QList< Choqok::Post * > &timeline)
 {
     const QString fileName = Choqok::AccountManager::generatePostBackupFileName(account->alias(),
                              timelineName);
@@ -455,8 +461,8 @@ void PumpIOMicroBlog::saveTimeline(Choqok::Account *account, const QString &time
         postsBackup.deleteGroup(group);
     }
 
-    for (Choqok::UI::PostWidget *wd: timeline) {
-        PumpIOPost *post = dynamic_cast<PumpIOPost * >(wd->currentPost());
+    for (Choqok::Post *p: timeline) {
+        PumpIOPost *post = dynamic_cast<PumpIOPost * >(p);
         KConfigGroup grp(&postsBackup, post->creationDateTime.toString());
         grp.writeEntry("creationDateTime", post->creationDateTime);
         grp.writeEntry("postId", post->postId);
@@ -503,41 +509,52 @@ void PumpIOMicroBlog::updateTimelines(Choqok::Account *theAccount)
     PumpIOAccount *acc = qobject_cast<PumpIOAccount *>(theAccount);
     if (acc) {
         for (const QString &timeline: acc->timelineNames()) {
-            QUrl url(acc->host());
-            url = url.adjusted(QUrl::StripTrailingSlash);
-            url.setPath(url.path() + QLatin1Char('/') + (m_timelinesPaths[timeline].arg(acc->username())));
-            QUrlQuery query;
-
-            QVariantMap oAuthParams;
-            const QString lastActivityId(lastTimelineId(theAccount, timeline));
-            if (!lastActivityId.isEmpty()) {
-                oAuthParams.insert(QLatin1String("count"), QByteArray::number(200));
-                query.addQueryItem(QLatin1String("count"), QString::number(200));
-                oAuthParams.insert(QLatin1String("since"), QUrl::toPercentEncoding(lastActivityId));
-                query.addQueryItem(QLatin1String("since"), lastActivityId);
-            } else {
-                oAuthParams.insert(QLatin1String("count"), QByteArray::number(Choqok::BehaviorSettings::countOfPosts()));
-                query.addQueryItem(QLatin1String("count"), QString::number(Choqok::BehaviorSettings::countOfPosts()));
-            }
-            url.setQuery(query);
-
-            KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::Reload, KIO::HideProgressInfo);
-            if (!job) {
-                qCDebug(CHOQOK) << "Cannot create an http GET request!";
-                continue;
-            }
-            job->addMetaData(QLatin1String("customHTTPHeader"), authorizationMetaData(acc, url, QNetworkAccessManager::GetOperation,
-                             oAuthParams));
-            m_timelinesRequests[job] = timeline;
-            m_accountJobs[job] = acc;
-            connect(job, SIGNAL(result(KJob*)), this, SLOT(slotUpdateTimeline(KJob*)));
-            job->start();
+            updateTimeline(acc, timeline);
         }
     } else {
         qCDebug(CHOQOK) << "theAccount is not a PumpIOAccount!";
     }
 }
 
+bool PumpIOMicroBlog::updateTimeline(Choqok::Account *theAccount, const QString &timelineName)
+{
+    PumpIOAccount *acc = qobject_cast<PumpIOAccount *>(theAccount);
+    if (!acc) {
+        qCDebug(CHOQOK) << "theAccount is not a PumpIOAccount!";
+        return true;
+    }
+    QUrl url(acc->host());
+    url = url.adjusted(QUrl::StripTrailingSlash);
+    url.setPath(url.path() + QLatin1Char('/') + (m_timelinesPaths[timelineName].arg(acc->username())));
+    QUrlQuery query;
+
+    QVariantMap oAuthParams;
+    const QString lastActivityId(lastTimelineId(theAccount, timelineName));
+    if (!lastActivityId.isEmpty()) {
+        oAuthParams.insert(QLatin1String("count"), QByteArray::number(200));
+        query.addQueryItem(QLatin1String("count"), QString::number(200));
+        oAuthParams.insert(QLatin1String("since"), QUrl::toPercentEncoding(lastActivityId));
+        query.addQueryItem(QLatin1String("since"), lastActivityId);
+    } else {
+        oAuthParams.insert(QLatin1String("count"), QByteArray::number(Choqok::BehaviorSettings::countOfPosts()));
+        query.addQueryItem(QLatin1String("count"), QString::number(Choqok::BehaviorSettings::countOfPosts()));
+    }
+    url.setQuery(query);
+
+    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::Reload, KIO::HideProgressInfo);
+    if (!job) {
+        qCDebug(CHOQOK) << "Cannot create an http GET request!";
+        return true;
+    }
+    job->addMetaData(QLatin1String("customHTTPHeader"), authorizationMetaData(acc, url, QNetworkAccessManager::GetOperation,
+                     oAuthParams));
+    m_timelinesRequests[job] = timelineName;
+    m_accountJobs[job] = acc;
+    connect(job, SIGNAL(result(KJob*)), this, SLOT(slotUpdateTimeline(KJob*)));
+    job->start();
+    return true;
+}
+
 void PumpIOMicroBlog::fetchFollowing(Choqok::Account *theAccount)
 {
     PumpIOAccount *acc = qobject_cast<PumpIOAccount *>(theAccount);
@@ -735,6 +752,7 @@ void PumpIOMicroBlog::slotFavorite(KJob *job)
     } else {
         post->isFavorited = !post->isFavorited;
         Q_EMIT favorite(theAccount, post);
+        Choqok::PostStore::self()->notifyChanged(theAccount, post);
     }
 }
 
@@ -758,9 +776,8 @@ void PumpIOMicroBlog::slotFetchPost(KJob *job)
 
         const QJsonDocument json = QJsonDocument::fromJson(j->data());
         if (!json.isNull()) {
-            const QVariantMap reply = json.toVariant().toMap();
             PumpIOPost *post = new PumpIOPost;
-            readPost(reply, post);
+            readPost(json.object(), post);
             ret = 0;
             Q_EMIT postFetched(theAccount, post);
         } else {
@@ -795,13 +812,12 @@ void PumpIOMicroBlog::slotFetchReplies(KJob *job)
 
         const QJsonDocument json = QJsonDocument::fromJson(j->data());
         if (!json.isNull()) {
-            const QVariantMap reply = json.toVariant().toMap();
-            const QVariantList items = reply[QLatin1String("items")].toList();
+            const QJsonObject reply = json.object();
+            const QJsonArray items = reply.value(QLatin1String("items")).toArray();
             for (int i = items.size() - 1; i >= 0; i--) {
-                QVariantMap item = items.at(i).toMap();
                 PumpIOPost *r = new PumpIOPost;
-                readPost(item, r);
-                r->replyToPostId = reply[QLatin1String("url")].toString().remove(QLatin1String("/replies"));
+                readPost(items.at(i).toObject(), r);
+                r->replyToPostId = reply.value(QLatin1String("url")).toString().remove(QLatin1String("/replies"));
                 Q_EMIT postFetched(theAccount, r);
             }
             ret = 0;
@@ -1040,14 +1056,28 @@ void PumpIOMicroBlog::slotUpdateTimeline(KJob *job)
                      i18n("An error occurred when fetching the timeline"));
     } else {
         KIO::StoredTransferJob *j = qobject_cast<KIO::StoredTransferJob * >(job);
-        const QList<Choqok::Post * > list = readTimeline(j->data());
-        const QString timeline(m_timelinesRequests.take(job));
-        if (!list.isEmpty()) {
-            setLastTimelineId(account, timeline, list.last()->conversationId);
-        }
+        const QByteArray data = j->data();
+        Choqok::BackgroundJob *parser = new Choqok::BackgroundJob([data]() {
+            return QVariant::fromValue(readTimeline(data));
+        }, this);
+        m_parserAccounts[parser] = account;
+        m_parserTimelines[parser] = m_timelinesRequests.take(job);
+        connect(parser, SIGNAL(finished(Choqok::BackgroundJob*)),
+                this, SLOT(slotTimelineParsed(Choqok::BackgroundJob*)));
+        parser->start();
+    }
+}
 
-        Q_EMIT timelineDataReceived(account, timeline, list);
+void PumpIOMicroBlog::slotTimelineParsed(Choqok::BackgroundJob *job)
+{
+    Choqok::Account *account = m_parserAccounts.take(job);
+    const QString timeline(m_parserTimelines.take(job));
+    const QList<Choqok::Post * > list = job->result().value<QList<Choqok::Post * > >();
+    if (!list.isEmpty()) {
+        setLastTimelineId(account, timeline, list.last()->conversationId);
     }
+
+    Q_EMIT timelineDataReceived(account, timeline, list);
 }
 
 void PumpIOMicroBlog::slotUpload(KJob *job)
@@ -1130,115 +1160,114 @@ QString PumpIOMicroBlog::lastTimelineId(Choqok::Account *theAccount,
     return m_timelinesLatestIds[theAccount][timeline];
 }
 
-Choqok::Post *PumpIOMicroBlog::readPost(const QVariantMap &var, Choqok::Post *post)
+/// Missing keys and explicit nulls are the same for the pump.io API
+static bool isMissing(const QJsonValue &value)
+{
+    return value.isUndefined() || value.isNull();
+}
+
+static void readRecipients(const QJsonArray &recipients, QStringList *ids)
+{
+    for (const QJsonValue &element: recipients) {
+        const QJsonObject recipient = element.toObject();
+        const QString type = recipient.value(QLatin1String("objectType")).toString();
+        if (type == QLatin1String("person") || type == QLatin1String("collection")) {
+            const QString id = recipient.value(QLatin1String("id")).toString();
+
+            if (id.compare(QLatin1String("acct:")) != 0) {
+                ids->append(id);
+            }
+        }
+    }
+}
+
+Choqok::Post *PumpIOMicroBlog::readPost(const QJsonObject &var, Choqok::Post *post)
 {
     PumpIOPost *p = dynamic_cast< PumpIOPost * >(post);
     if (p) {
-        QVariantMap object;
-        if (var.value(QLatin1String("verb")).toString() == QLatin1String("post") ||
-                var.value(QLatin1String("verb")).toString() == QLatin1String("share")) {
-            object = var[QLatin1String("object")].toMap();
+        const QString verb = var.value(QLatin1String("verb")).toString();
+        QJsonObject object;
+        if (verb == QLatin1String("post") || verb == QLatin1String("share")) {
+            object = var.value(QLatin1String("object")).toObject();
         } else {
             object = var;
         }
 
         QTextDocument content;
-        if (!object[QLatin1String("displayName")].isNull()) {
-            content.setHtml(object[QLatin1String("displayName")].toString());
+        const QJsonValue displayName = object.value(QLatin1String("displayName"));
+        if (!isMissing(displayName)) {
+            content.setHtml(displayName.toString());
             p->content = content.toPlainText().trimmed();
             p->content += QLatin1Char('\n');
         }
 
-        content.setHtml(object[QLatin1String("content")].toString());
+        content.setHtml(object.value(QLatin1String("content")).toString());
         p->content += content.toPlainText().trimmed();
 
-        if (!object[QLatin1String("fullImage")].isNull()) {
-            const QVariantMap fullImage = object[QLatin1String("fullImage")].toMap();
-            if (!fullImage.isEmpty()) {
-                p->media = fullImage[QLatin1String("url")].toString();
-            }
+        const QJsonObject fullImage = object.value(QLatin1String("fullImage")).toObject();
+        if (!fullImage.isEmpty()) {
+            p->media = fullImage.value(QLatin1String("url")).toString();
         }
-        p->creationDateTime = QDateTime::fromString(var[QLatin1String("published")].toString(),
+        p->creationDateTime = QDateTime::fromString(var.value(QLatin1String("published")).toString(),
                               Qt::ISODate);
         p->creationDateTime.setTimeSpec(Qt::UTC);
-        if (object[QLatin1String("pump_io")].isNull()) {
-            p->link = object[QLatin1String("id")].toString();
+        const QJsonValue pumpIo = object.value(QLatin1String("pump_io"));
+        if (isMissing(pumpIo)) {
+            p->link = object.value(QLatin1String("id")).toString();
         } else {
-            p->link = object[QLatin1String("pump_io")].toMap().value(QLatin1String("proxyURL")).toString();
+            p->link = pumpIo.toObject().value(QLatin1String("proxyURL")).toString();
         }
-        p->type = object[QLatin1String("objectType")].toString();
-        p->isFavorited = object[QLatin1String("liked")].toBool();
+        p->type = object.value(QLatin1String("objectType")).toString();
+        p->isFavorited = object.value(QLatin1String("liked")).toBool();
         if (p->isFavorited) {
             p->isRead = true;
         }
-        p->postId = object[QLatin1String("id")].toString();
-        p->conversationId = var[QLatin1String("id")].toString();
-
-        QString author;
-        var[QLatin1String("author")].isNull() ? author = QLatin1String("actor") : author = QLatin1String("author");
-        QVariantMap actor;
-        if (var.value(QLatin1String("verb")).toString() == QLatin1String("share")) {
-            actor = object[QLatin1String("author")].toMap();
-            const QVariantList shares = object[QLatin1String("shares")].toMap().value(QLatin1String("items")).toList();
-            for (const QVariant &element: shares) {
-                p->shares.append(element.toMap().value(QLatin1String("id")).toString());
+        p->postId = object.value(QLatin1String("id")).toString();
+        p->conversationId = var.value(QLatin1String("id")).toString();
+
+        QJsonObject actor;
+        if (verb == QLatin1String("share")) {
+            actor = object.value(QLatin1String("author")).toObject();
+            const QJsonArray shares = object.value(QLatin1String("shares")).toObject().value(QLatin1String("items")).toArray();
+            for (const QJsonValue &element: shares) {
+                p->shares.append(element.toObject().value(QLatin1String("id")).toString());
             }
         } else {
-            actor = var[author].toMap();
+            const QJsonValue author = var.value(QLatin1String("author"));
+            actor = isMissing(author) ? var.value(QLatin1String("actor")).toObject() : author.toObject();
         }
-        const QString userId = actor[QLatin1String("id")].toString();
-        const QString homePageUrl = actor[QLatin1String("url")].toString();
+        const QString userId = actor.value(QLatin1String("id")).toString();
+        const QString homePageUrl = actor.value(QLatin1String("url")).toString();
         p->author.userId = userId;
-        p->author.userName = actor[QLatin1String("preferredUsername")].toString();
-        p->author.realName = actor[QLatin1String("displayName")].toString();
+        p->author.userName = actor.value(QLatin1String("preferredUsername")).toString();
+        p->author.realName = actor.value(QLatin1String("displayName")).toString();
         p->author.homePageUrl = homePageUrl;
-        p->author.location = actor[QLatin1String("location")].toMap().value(QLatin1String("displayName")).toString();
-        p->author.description = actor[QLatin1String("summary")].toString();
+        p->author.location = actor.value(QLatin1String("location")).toObject().value(QLatin1String("displayName")).toString();
+        p->author.description = actor.value(QLatin1String("summary")).toString();
 
-        const QString profileImageUrl = actor[QLatin1String("image")].toMap().value(QLatin1String("url")).toString();
+        const QString profileImageUrl = actor.value(QLatin1String("image")).toObject().value(QLatin1String("url")).toString();
         if (!profileImageUrl.isEmpty()) {
             p->author.profileImageUrl = profileImageUrl;
-        } else if (actor[QLatin1String("objectType")].toString() == QLatin1String("service")) {
+        } else if (actor.value(QLatin1String("objectType")).toString() == QLatin1String("service")) {
             p->author.profileImageUrl = homePageUrl + QLatin1String("images/default.png");
         } else {
             p->author.profileImageUrl = QStringLiteral("https://%1/images/default.png").arg(hostFromAcct(userId));
         }
 
-        if (!var[QLatin1String("generator")].isNull()) {
-            p->source = var[QLatin1String("generator")].toMap().value(QLatin1String("displayName")).toString();
-        }
-
-        const QVariantList to = var[QLatin1String("to")].toList();
-        for (const QVariant &element: to) {
-            QVariantMap toElementMap = element.toMap();
-            QString toElementType = toElementMap.value(QLatin1String("objectType")).toString();
-            if (toElementType == QLatin1String("person") || toElementType == QLatin1String("collection")) {
-                const QString toId = toElementMap.value(QLatin1String("id")).toString();
-
-                if (toId.compare(QLatin1String("acct:")) != 0) {
-                    p->to.append(toId);
-                }
-            }
+        const QJsonValue generator = var.value(QLatin1String("generator"));
+        if (!isMissing(generator)) {
+            p->source = generator.toObject().value(QLatin1String("displayName")).toString();
         }
 
-        const QVariantList cc = var[QLatin1String("cc")].toList();
-        for (const QVariant &element: cc) {
-            QVariantMap ccElementMap = element.toMap();
-            QString ccElementType = ccElementMap.value(QLatin1String("objectType")).toString();
-            if (ccElementType == QLatin1String("person") || ccElementType == QLatin1String("collection")) {
-                const QString ccId = ccElementMap.value(QLatin1String("id")).toString();
-
-                if (ccId.compare(QLatin1String("acct:")) != 0) {
-                    p->cc.append(ccId);
-                }
-            }
-        }
+        readRecipients(var.value(QLatin1String("to")).toArray(), &p->to);
+        readRecipients(var.value(QLatin1String("cc")).toArray(), &p->cc);
 
-        const QVariantMap replies = object[QLatin1String("replies")].toMap();
-        if (replies.value(QLatin1String("pump_io")).isNull()) {
-            p->replies = replies[QLatin1String("url")].toString();
+        const QJsonObject replies = object.value(QLatin1String("replies")).toObject();
+        const QJsonValue repliesPumpIo = replies.value(QLatin1String("pump_io"));
+        if (isMissing(repliesPumpIo)) {
+            p->replies = replies.value(QLatin1String("url")).toString();
         } else {
-            p->replies = replies[QLatin1String("pump_io")].toMap().value(QLatin1String("proxyURL")).toString();
+            p->replies = repliesPumpIo.toObject().value(QLatin1String("proxyURL")).toString();
         }
 
         return p;
@@ -1253,14 +1282,14 @@ QList< Choqok::Post * > PumpIOMicroBlog::readTimeline(const QByteArray &buffer)
     QList<Choqok::Post * > posts;
     const QJsonDocument json = QJsonDocument::fromJson(buffer);
     if (!json.isNull()) {
-        const QVariantList list = json.toVariant().toMap().value(QLatin1String("items")).toList();
-        for (const QVariant &element: list) {
-            const QVariantMap elementMap = element.toMap();
-            if (!elementMap[QLatin1String("object")].toMap().value(QLatin1String("deleted")).isNull()) {
+        const QJsonArray list = json.object().value(QLatin1String("items")).toArray();
+        for (const QJsonValue &element: list) {
+            const QJsonObject elementObject = element.toObject();
+            if (!isMissing(elementObject.value(QLatin1String("object")).toObject().value(QLatin1String("deleted")))) {
                 // Skip deleted posts
                 continue;
             }
-            posts.prepend(readPost(elementMap, new PumpIOPost));
+            posts.prepend(readPost(elementObject, new PumpIOPost));
         }
     } else {
         qCDebug(CHOQOK) << "Cannot parse JSON reply";
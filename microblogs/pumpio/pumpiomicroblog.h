@@ -27,8 +27,14 @@
 
 #include "microblog.h"
 
+class QJsonObject;
 class QUrl;
 class KJob;
+
+namespace Choqok
+{
+class BackgroundJob;
+}
 class PumpIOAccount;
 class PumpIOPost;
 
@@ -74,13 +80,15 @@ public:
 
     virtual QUrl profileUrl(Choqok::Account *account, const Choqok::User &user) const override;
 
-    virtual void saveTimeline(Choqok::Account *account, const QString &timelineName,
-                              const QList< Choqok::UI::PostWidget * > &timeline) override;
+    virtual void savePosts(Choqok::Account *account, const QString &timelineName,
+                           const QList< Choqok::Post * > &timeline) override;
 
     virtual Choqok::TimelineInfo *timelineInfo(const QString &timelineName) override;
 
     virtual void updateTimelines(Choqok::Account *theAccount) override;
 
+    virtual bool updateTimeline(Choqok::Account *theAccount, const QString &timelineName) override;
+
     void createPost(Choqok::Account *theAccount, Choqok::Post *post,
                     const QVariantList &to, const QVariantList &cc = QVariantList());
 
@@ -121,6 +129,7 @@ protected Q_SLOTS:
     void slotShare(KJob *job);
     void slotUpdatePost(KJob *job);
     void slotUpdateTimeline(KJob *job);
+    void slotTimelineParsed(Choqok::BackgroundJob *job);
     void slotUpload(KJob *job);
 
 protected:
@@ -133,9 +142,15 @@ protected:
 
     QString lastTimelineId(Choqok::Account *theAccount, const QString &timeline) const;
 
-    Choqok::Post *readPost(const QVariantMap &var, Choqok::Post *post);
+    /**
+    Doesn't touch any member, so it's safe to call from a Choqok::BackgroundJob
+    */
+    static Choqok::Post *readPost(const QJsonObject &var, Choqok::Post *post);
 
-    QList<Choqok::Post * > readTimeline(const QByteArray &buffer);
+    /**
+    Doesn't touch any member, so it's safe to call from a Choqok::BackgroundJob
+    */
+    static QList<Choqok::Post * > readTimeline(const QByteArray &buffer);
 
     void setLastTimelineId(Choqok::Account *theAccount, const QString &timeline,
                            const QString &id);
@@ -155,6 +170,8 @@ protected:
     QHash<Choqok::Account *, QMap<QString, QString> > m_timelinesLatestIds;
     QHash<QString, QString> m_timelinesPaths;
     QMap<KJob *, QString> m_timelinesRequests;
+    QMap<Choqok::BackgroundJob *, Choqok::Account *> m_parserAccounts;
+    QMap<Choqok::BackgroundJob *, QString> m_parserTimelines;
 
 private:
     class Private;
@@ -43,6 +43,10 @@ const QIcon PumpIOPostWidget::unFavIcon(Choqok::MediaManager::convertToGrayScale
 class PumpIOPostWidget::Private
 {
 public:
+    Private()
+        : btnFavorite(0), btnReply(0)
+    {}
+
     QPushButton *btnFavorite;
     QPushButton *btnReply;
 };
@@ -258,6 +262,14 @@ void PumpIOPostWidget::slotReplyTo()
     }
 }
 
+void PumpIOPostWidget::slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes)
+{
+    Choqok::UI::PostWidget::slotPostChanged(theAccount, post, changes);
+    if (d->btnFavorite && theAccount == currentAccount() && post == currentPost()) {
+        updateFavStat();
+    }
+}
+
 void PumpIOPostWidget::updateFavStat()
 {
     d->btnFavorite->setChecked(currentPost()->isFavorited);
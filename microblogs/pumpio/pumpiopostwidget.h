@@ -48,6 +48,8 @@ protected Q_SLOTS:
 
     void slotToggleFavorite(Choqok::Account *, Choqok::Post *);
 
+    virtual void slotPostChanged(Choqok::Account *theAccount, Choqok::Post *post, int changes) override;
+
     void toggleFavorite();
 
 protected:
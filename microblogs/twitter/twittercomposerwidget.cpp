@@ -36,7 +36,6 @@
 #include "account.h"
 #include "choqoktextedit.h"
 #include "notifymanager.h"
-#include "shortenmanager.h"
 
 #include "twitterapiaccount.h"
 
@@ -84,18 +83,13 @@ TwitterComposerWidget::~TwitterComposerWidget()
     delete d;
 }
 
-void TwitterComposerWidget::submitPost(const QString &txt)
+void TwitterComposerWidget::sendPost(const QString &text)
 {
     if (d->mediumToAttach.isEmpty()) {
-        Choqok::UI::ComposerWidget::submitPost(txt);
+        Choqok::UI::ComposerWidget::sendPost(text);
     } else {
         qCDebug(CHOQOK);
         editorContainer()->setEnabled(false);
-        QString text = txt;
-        if (currentAccount()->postCharLimit() &&
-                text.size() > (int)currentAccount()->postCharLimit()) {
-            text = Choqok::ShortenManager::self()->parseText(text);
-        }
         setPostToSubmit(nullptr);
         setPostToSubmit(new Choqok::Post);
         postToSubmit()->content = text;
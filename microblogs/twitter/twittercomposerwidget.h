@@ -34,7 +34,7 @@ public:
     ~TwitterComposerWidget();
 
 protected Q_SLOTS:
-    virtual void submitPost(const QString &text) override;
+    virtual void sendPost(const QString &text) override;
     void slotPostMediaSubmitted(Choqok::Account *theAccount, Choqok::Post *post);
     void selectMediumToAttach();
     void cancelAttachMedium();
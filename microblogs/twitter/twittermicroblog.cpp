@@ -40,6 +40,7 @@ along with this program; if not, see http://www.gnu.org/licenses/
 #include "composerwidget.h"
 #include "editaccountwidget.h"
 #include "mediamanager.h"
+#include "multipartbody.h"
 #include "postwidget.h"
 #include "timelinewidget.h"
 
@@ -151,53 +152,34 @@ void TwitterMicroBlog::createPostWithAttachment(Choqok::Account *theAccount, Cho
         TwitterApiMicroBlog::createPost(theAccount, post);
     } else {
         const QUrl picUrl = QUrl::fromUserInput(mediumToAttach);
-        KIO::StoredTransferJob *picJob = KIO::storedGet(picUrl, KIO::Reload, KIO::HideProgressInfo);
-        picJob->exec();
-        if (picJob->error()) {
-            qCCritical(CHOQOK) << "Job error:" << picJob->errorString();
-            KMessageBox::detailedError(Choqok::UI::Global::mainWindow(),
-                                       i18n("Uploading medium failed: cannot read the medium file."),
-                                       picJob->errorString());
-            return;
-        }
-        const QByteArray picData = picJob->data();
-        if (picData.count() == 0) {
-            qCCritical(CHOQOK) << "Cannot read the media file, please check if it exists.";
-            KMessageBox::error(Choqok::UI::Global::mainWindow(),
-                               i18n("Uploading medium failed: cannot read the medium file."));
-            return;
-        }
 
         TwitterAccount *account = qobject_cast<TwitterAccount *>(theAccount);
         QUrl url = account->uploadUrl();
         url.setPath(url.path() + QStringLiteral("/statuses/update_with_media.%1").arg(format));
         const QMimeDatabase db;
-        QByteArray fileContentType = db.mimeTypeForUrl(picUrl).name().toUtf8();
+        const QByteArray fileContentType = db.mimeTypeForFile(picUrl.toLocalFile()).name().toUtf8();
 
-        QMap<QString, QByteArray> formdata;
-        formdata[QLatin1String("status")] = post->content.toUtf8();
+        Choqok::MultipartBody *body = new Choqok::MultipartBody;
+        body->addField(QLatin1String("status"), post->content.toUtf8());
         if (!post->replyToPostId.isEmpty()) {
-            formdata[QLatin1String("in_reply_to_status_id")] = post->replyToPostId.toLatin1();
+            body->addField(QLatin1String("in_reply_to_status_id"), post->replyToPostId.toLatin1());
         }
-        formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
+        body->addField(QLatin1String("source"), QCoreApplication::applicationName().toLatin1());
 
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media[]";
-        mediafile[QLatin1String("filename")] = picUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = fileContentType;
-        mediafile[QLatin1String("medium")] = picData;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+        // The file is read while it's sent
+        if (!body->addFile(QLatin1String("media[]"), picUrl.toLocalFile(), fileContentType)) {
+            qCCritical(CHOQOK) << "Cannot read the media file:" << body->errorString();
+            KMessageBox::detailedError(Choqok::UI::Global::mainWindow(),
+                                       i18n("Uploading medium failed: cannot read the medium file."),
+                                       body->errorString());
+            delete body;
+            return;
+        }
 
-        KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+        KIO::StoredTransferJob *job = Choqok::MediaManager::postMultipart(url, body);
         if (!job) {
-            qCCritical(CHOQOK) << "Cannot create a http POST request!";
             return;
         }
-        job->addMetaData(QStringLiteral("content-type"),
-                         QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
         job->addMetaData(QStringLiteral("customHTTPHeader"),
                          QStringLiteral("Authorization: ") +
                          QLatin1String(authorizationHeader(account, url, QNetworkAccessManager::PostOperation)));
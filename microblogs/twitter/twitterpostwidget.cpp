@@ -41,7 +41,6 @@
 #include "twittersearch.h"
 
 const QRegExp TwitterPostWidget::mTwitterUserRegExp(QLatin1String("([\\s\\W]|^)@([a-z0-9_]+){1,20}"), Qt::CaseInsensitive);
-const QRegExp TwitterPostWidget::mTwitterTagRegExp(QLatin1String("([\\s]|^)#([\\w_\\.\\-]+)"), Qt::CaseInsensitive);
 const QString TwitterPostWidget::mQuotedTextBase(QLatin1String("<div style=\"padding-top:5px;padding-bottom:3px;\"><table style=\"%4 border-style:groove;\" border=\"1\"><tr><td style=\"padding-top:4px;padding-bottom:4px;padding-left:3px;padding-right:3px;\"><table> <tr><td width=\"40\" style=\"padding-right:5px;\"><img src=\"img://quotedProfileImage\" width=\"40\" height=\"40\" /></td><td dir=\"%2\"><p><b><a>%3:</b>&nbsp;%1</p></td></tr></table></td></tr></table></div>"));
 const QUrl TwitterPostWidget::mQuotedAvatarResourceUrl(QLatin1String("img://quotedProfileImage"));
 TwitterPostWidget::TwitterPostWidget(Choqok::Account *account, Choqok::Post *post, QWidget *parent): TwitterApiPostWidget(account, post, parent)
@@ -88,12 +87,16 @@ void TwitterPostWidget::initUi()
     }
 }
 
-QString TwitterPostWidget::prepareStatus(const QString &text)
+QString TwitterPostWidget::entityToHtml(const Choqok::Entity &entity, const QString &text)
 {
-    QString res = TwitterApiPostWidget::prepareStatus(text);
-    res.replace(mTwitterUserRegExp, QLatin1String("\\1@<a href='user://\\2'>\\2</a>"));
-    res.replace(mTwitterTagRegExp, QLatin1String("\\1#<a href='tag://\\2'>\\2</a>"));
-    return res;
+    if (entity.type == Choqok::Entity::Mention) {
+        // Twitter has no users of other servers, the part after a second '@' is plain text
+        const QString name = text.mid(1).section(QLatin1Char('@'), 0, 0);
+        return QStringLiteral("@<a href='user://%1'>%1</a>").arg(name) + removeTags(text.mid(name.size() + 1));
+    } else if (entity.type == Choqok::Entity::Hashtag) {
+        return QStringLiteral("#<a href='tag://%1'>%1</a>").arg(text.mid(1));
+    }
+    return TwitterApiPostWidget::entityToHtml(entity, text);
 }
 
 bool TwitterPostWidget::isRemoveAvailable()
@@ -243,28 +246,16 @@ void TwitterPostWidget::checkAnchor(const QUrl &url)
 
 bool TwitterPostWidget::setupQuotedAvatar()
 {
-    QPixmap pix = Choqok::MediaManager::self()->fetchImage(currentPost()->quotedPost.profileImageUrl,
-                                                           Choqok::MediaManager::Async);
-    if (!pix.isNull()) {
-        quotedAvatarFetched(currentPost()->quotedPost.profileImageUrl, pix);
-        return true;
-    } else {
-        connect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                this, SLOT(quotedAvatarFetched(QString,QPixmap)));
-        connect(Choqok::MediaManager::self(), SIGNAL(fetchError(QString,QString)),
-                this, SLOT(quotedAvatarFetchError(QString,QString)));
-        return false;
-    }
+    return Choqok::MediaManager::self()->request(currentPost()->quotedPost.profileImageUrl, this,
+                                                 SLOT(quotedAvatarFetched(QString,QPixmap)),
+                                                 SLOT(quotedAvatarFetchError(QString,QString)),
+                                                 Choqok::MediaManager::AvatarImage);
 }
 
 void TwitterPostWidget::quotedAvatarFetched(const QString &remoteUrl, const QPixmap &pixmap)
 {
     if (remoteUrl == currentPost()->quotedPost.profileImageUrl) {
         _mainWidget->document()->addResource(QTextDocument::ImageResource, mQuotedAvatarResourceUrl, pixmap);
-        disconnect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                   this, SLOT(quotedAvatarFetched(QString,QPixmap)));
-        disconnect(Choqok::MediaManager::self(), SIGNAL(fetchError(QString,QString)),
-                   this, SLOT(quotedAvatarFetchError(QString,QString)));
     }
 }
 
@@ -272,7 +263,7 @@ void TwitterPostWidget::quotedAvatarFetchError(const QString &remoteUrl, const Q
 {
     Q_UNUSED(errMsg);
     if (remoteUrl == currentPost()->quotedPost.profileImageUrl) {
-        ///Avatar fetching is failed! but will not disconnect to get the img if it fetches later!
+        ///Avatar fetching is failed!
         _mainWidget->document()->addResource(QTextDocument::ImageResource, mQuotedAvatarResourceUrl,
                                              QIcon::fromTheme(QLatin1String("image-missing")).pixmap(40));
     }
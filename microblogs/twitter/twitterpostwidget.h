@@ -41,13 +41,12 @@ protected Q_SLOTS:
     void quotedAvatarFetchError(const QString &remoteUrl, const QString &errMsg);
 
 protected:
-    QString prepareStatus(const QString &text) override;
+    QString entityToHtml(const Choqok::Entity &entity, const QString &text) override;
     void checkAnchor(const QUrl &url) override;
     bool isRemoveAvailable() override;
     bool setupQuotedAvatar();
 
     static const QRegExp mTwitterUserRegExp;
-    static const QRegExp mTwitterTagRegExp;
     static const QString mQuotedTextBase;
     static const QUrl    mQuotedAvatarResourceUrl;
 private:
@@ -79,11 +79,11 @@ QSize Notification::sizeHint() const
 
 void Notification::init()
 {
-    QPixmap pix = Choqok::MediaManager::self()->fetchImage(post->currentPost()->author.profileImageUrl);
-    if (!pix) {
-        pix = QPixmap(Choqok::MediaManager::self()->defaultImage());
-    }
-    mainWidget.document()->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("img://profileImage")), pix);
+    mainWidget.document()->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("img://profileImage")),
+                                       Choqok::MediaManager::self()->defaultImage());
+    Choqok::MediaManager::self()->request(post->currentPost()->author.profileImageUrl, this,
+                                          SLOT(slotAvatarFetched(QString,QPixmap)), nullptr,
+                                          Choqok::MediaManager::AvatarImage);
     mainWidget.document()->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("icon://close")),
                                        QIcon::fromTheme(QLatin1String("dialog-close")).pixmap(16));
     mainWidget.setText(baseText.arg(post->currentPost()->author.userName)
@@ -114,6 +114,13 @@ void Notification::slotProcessAnchor(const QUrl &url)
     }
 }
 
+void Notification::slotAvatarFetched(const QString &remoteUrl, const QPixmap &pixmap)
+{
+    Q_UNUSED(remoteUrl);
+    mainWidget.document()->addResource(QTextDocument::ImageResource, QUrl(QLatin1String("img://profileImage")), pixmap);
+    mainWidget.viewport()->update();
+}
+
 void Notification::slotClicked()
 {
     post->setReadWithSignal();
@@ -46,6 +46,7 @@ Q_SIGNALS:
 protected Q_SLOTS:
     void slotProcessAnchor(const QUrl &url);
     void slotClicked();
+    void slotAvatarFetched(const QString &remoteUrl, const QPixmap &pixmap);
 
 protected:
     virtual void mouseMoveEvent(QMouseEvent *) override;
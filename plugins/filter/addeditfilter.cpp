@@ -27,7 +27,9 @@
 #include <QPushButton>
 
 #include <KLocalizedString>
+#include <KMessageBox>
 
+#include "filtermatcher.h"
 #include "filtersettings.h"
 
 AddEditFilter::AddEditFilter(QWidget *parent, Filter *filter)
@@ -77,6 +79,13 @@ void AddEditFilter::accept()
         (Filter::FilterAction) ui.filterAction->itemData(ui.filterAction->currentIndex()).toInt();
     QString fText = ui.filterText->text();
     bool dontHideReplies = ui.dontHideReplies->isChecked();
+    if (type == Filter::RegExp) {
+        const QRegularExpression regExp = FilterMatcher::regularExpression(fText);
+        if (!regExp.isValid()) {
+            KMessageBox::error(this, i18n("The regular expression is invalid: %1", regExp.errorString()));
+            return;
+        }
+    }
     if (currentFilter) {
         currentFilter->setFilterField(field);
         currentFilter->setFilterText(fText);
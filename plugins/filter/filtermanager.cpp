@@ -24,14 +24,15 @@
 #include "filtermanager.h"
 
 #include <QAction>
-#include <QTimer>
 
 #include <KActionCollection>
 #include <KLocalizedString>
 #include <KMessageBox>
 #include <KPluginFactory>
 
+#include "account.h"
 #include "choqokuiglobal.h"
+#include "entityscanner.h"
 #include "postwidget.h"
 #include "quickpost.h"
 #include "timelinewidget.h"
@@ -46,152 +47,110 @@ K_PLUGIN_FACTORY_WITH_JSON(FilterManagerFactory, "choqok_filter.json",
                            registerPlugin < FilterManager > ();)
 
 FilterManager::FilterManager(QObject *parent, const QList<QVariant> &)
-    : Choqok::Plugin(QLatin1String("choqok_filter"), parent), state(Stopped)
+    : Choqok::Plugin(QLatin1String("choqok_filter"), parent)
 {
     QAction *action = new QAction(i18n("Configure Filters..."), this);
     actionCollection()->addAction(QLatin1String("configureFilters"), action);
     connect(action, SIGNAL(triggered(bool)), SLOT(slotConfigureFilters()));
     setXMLFile(QLatin1String("filterui.rc"));
-    connect(Choqok::UI::Global::SessionManager::self(),
-            SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
-            SLOT(slotAddNewPostWidget(Choqok::UI::PostWidget*)));
 
     hidePost = new QAction(i18n("Hide Post"), this);
     Choqok::UI::PostWidget::addAction(hidePost);
     connect(hidePost, SIGNAL(triggered(bool)), SLOT(slotHidePost()));
-}
 
-FilterManager::~FilterManager()
-{
+    connect(FilterSettings::self(), SIGNAL(filtersChanged()), SLOT(compileFilters()));
+    compileFilters();
 
+    Choqok::UI::PostPipeline::self()->addProcessor(Choqok::UI::PostPipeline::FilterStage, this);
+    Choqok::UI::PostPipeline::self()->addFilter(this);
 }
 
-void FilterManager::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+FilterManager::~FilterManager()
 {
-    postsQueue.enqueue(newWidget);
-    if (state == Stopped) {
-        state = Running;
-        QTimer::singleShot(1000, this, SLOT(startParsing()));
-    }
+    Choqok::UI::PostPipeline::self()->removeFilter(this);
+    Choqok::UI::PostPipeline::self()->removeProcessor(this);
 }
 
-void FilterManager::startParsing()
+bool FilterManager::acceptPost(Choqok::Account *account, Choqok::Post *post)
 {
-    int i = 8;
-    while (!postsQueue.isEmpty() && i > 0) {
-        parse(postsQueue.dequeue());
-        --i;
-    }
-
-    if (postsQueue.isEmpty()) {
-        state = Stopped;
-    } else {
-        QTimer::singleShot(500, this, SLOT(startParsing()));
+    const FilterMatcher::Outcome outcome = parse(account, post);
+    if (outcome == FilterMatcher::Highlight) {
+        const Choqok::Annotation highlight(Choqok::Annotation::Highlight, -1);
+        if (!post->annotations.contains(highlight)) {
+            post->annotations.append(highlight);
+        }
     }
+    return outcome != FilterMatcher::Remove;
 }
 
-void FilterManager::parse(Choqok::UI::PostWidget *postToParse)
+void FilterManager::processPost(Choqok::UI::PostWidget *widget)
 {
-    if (!postToParse ||
-            postToParse->currentPost()->author.userName == postToParse->currentAccount()->username() ||
-            postToParse->isRead()) {
+    // Posts of timelines passed acceptPost() before their widget was created,
+    // this is left for the others, e.g. posts of conversations
+    if (!widget || widget->timelineWidget()) {
         return;
     }
-
-    if (parseSpecialRules(postToParse)) {
-        return;
+    const FilterMatcher::Outcome outcome = parse(widget->currentAccount(), widget->currentPost());
+    if (outcome == FilterMatcher::Remove) {
+        widget->close();
+    } else if (outcome == FilterMatcher::Highlight) {
+        widget->addAnnotation(Choqok::Annotation(Choqok::Annotation::Highlight, -1));
     }
+}
 
-    if (!postToParse) {
-        return;
+/// True if the content of @p post mentions @p username
+static bool mentions(Choqok::Post *post, const QString &username)
+{
+    if (post->entities.isEmpty()) {
+        post->entities = Choqok::EntityScanner::scan(post->content);
     }
-    //qDebug() << "Processing: "<<postToParse->content();
-    for (Filter *filter: FilterSettings::self()->filters()) {
-        if (filter->filterText().isEmpty()) {
-            return;
-        }
-        if (filter->filterAction() == Filter::Remove && filter->dontHideReplies() &&
-                (postToParse->currentPost()->replyToUserName.compare(postToParse->currentAccount()->username(),
-                        Qt::CaseInsensitive) == 0 ||
-                 postToParse->currentPost()->content.contains(QStringLiteral("@%1").arg(postToParse->currentAccount()->username())))
-           ) {
+    const QString &content = post->content;
+    for (const Choqok::Entity &entity: post->entities) {
+        if (entity.type != Choqok::Entity::Mention) {
             continue;
         }
-        switch (filter->filterField()) {
-        case Filter::Content:
-            doFiltering(postToParse, filterText(postToParse->currentPost()->content, filter));
-            break;
-        case Filter::AuthorUsername:
-            doFiltering(postToParse, filterText(postToParse->currentPost()->author.userName, filter));
-            break;
-        case Filter::ReplyToUsername:
-            doFiltering(postToParse, filterText(postToParse->currentPost()->replyToUserName, filter));
-            break;
-        case Filter::Source:
-            doFiltering(postToParse, filterText(postToParse->currentPost()->source, filter));
-            break;
-        default:
-            break;
-        };
+        // Without the server of @someone@example.org
+        QStringRef name = content.midRef(entity.start + 1, entity.length - 1);
+        const int at = name.indexOf(QLatin1Char('@'));
+        if (at >= 0) {
+            name = name.left(at);
+        }
+        if (name.compare(username, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
     }
+    return false;
 }
 
-Filter::FilterAction FilterManager::filterText(const QString &textToCheck, Filter *filter)
+FilterMatcher::Outcome FilterManager::parse(Choqok::Account *account, Choqok::Post *post)
 {
-    bool filtered = false;
-    switch (filter->filterType()) {
-    case Filter::ExactMatch:
-        if (textToCheck.compare(filter->filterText(), Qt::CaseInsensitive) == 0) {
-            //qDebug() << "ExactMatch:" << filter->filterText();
-            filtered = true;
-        }
-        break;
-    case Filter::RegExp:
-        if (textToCheck.contains(QRegExp(filter->filterText()))) {
-            //qDebug() << "RegExp:" << filter->filterText();
-            filtered = true;
-        }
-        break;
-    case Filter::Contain:
-        if (textToCheck.contains(filter->filterText(), Qt::CaseInsensitive)) {
-            //qDebug() << "Contain:" << filter->filterText();
-            filtered = true;
-        }
-        break;
-    case Filter::DoesNotContain:
-        if (!textToCheck.contains(filter->filterText(), Qt::CaseInsensitive)) {
-            //qDebug() << "DoesNotContain:" << filter->filterText();
-            filtered = true;
-        }
-        break;
-    default:
-        break;
+    if (!account || !post || post->author.userName == account->username() || post->isRead) {
+        return FilterMatcher::NoMatch;
     }
-    if (filtered) {
-        return filter->filterAction();
-    } else {
-        return Filter::None;
+
+    if (parseSpecialRules(account, post)) {
+        return FilterMatcher::Remove;
     }
+
+    const FilterMatcher::Outcomes outcomes = matcher.match(post);
+    bool remove = outcomes.testFlag(FilterMatcher::Remove);
+    if (!remove && outcomes.testFlag(FilterMatcher::RemoveUnlessRelated)) {
+        const QString username = account->username();
+        remove = post->replyToUserName.compare(username, Qt::CaseInsensitive) != 0 &&
+                 !mentions(post, username);
+    }
+    if (remove) {
+        //qDebug() << "Post removed:" << post->content;
+        return FilterMatcher::Remove;
+    } else if (outcomes.testFlag(FilterMatcher::Highlight)) {
+        return FilterMatcher::Highlight;
+    }
+    return FilterMatcher::NoMatch;
 }
 
-void FilterManager::doFiltering(Choqok::UI::PostWidget *postToFilter, Filter::FilterAction action)
+void FilterManager::compileFilters()
 {
-    QString css;
-    switch (action) {
-    case Filter::Remove:
-        //qDebug() << "Post removed:" << postToFilter->currentPost()->content;
-        postToFilter->close();
-        break;
-    case Filter::Highlight:
-        css = postToFilter->styleSheet();
-        css.replace(QLatin1String("border: 1px solid rgb(150,150,150)"), QLatin1String("border: 2px solid rgb(255,0,0)"));
-        postToFilter->setStyleSheet(css);
-        break;
-    case Filter::None:
-    default:
-        //Do nothing
-        break;
-    }
+    matcher.compile(FilterSettings::self()->filters());
 }
 
 void FilterManager::slotConfigureFilters()
@@ -200,13 +159,11 @@ void FilterManager::slotConfigureFilters()
     dlg->show();
 }
 
-bool FilterManager::parseSpecialRules(Choqok::UI::PostWidget *postToParse)
+bool FilterManager::parseSpecialRules(Choqok::Account *account, Choqok::Post *post)
 {
     if (FilterSettings::hideRepliesNotRelatedToMe()) {
-        if (!postToParse->currentPost()->replyToUserName.isEmpty() &&
-                postToParse->currentPost()->replyToUserName != postToParse->currentAccount()->username()) {
-            if (!postToParse->currentPost()->content.contains(postToParse->currentAccount()->username())) {
-                postToParse->close();
+        if (!post->replyToUserName.isEmpty() && post->replyToUserName != account->username()) {
+            if (!mentions(post, account->username())) {
 //                qDebug() << "NOT RELATE TO ME FILTERING......";
                 return true;
             }
@@ -214,14 +171,12 @@ bool FilterManager::parseSpecialRules(Choqok::UI::PostWidget *postToParse)
     }
 
     if (FilterSettings::hideNoneFriendsReplies()) {
-        TwitterApiAccount *acc = qobject_cast<TwitterApiAccount *>(postToParse->currentAccount());
+        TwitterApiAccount *acc = qobject_cast<TwitterApiAccount *>(account);
         if (!acc) {
             return false;
         }
-        if (!postToParse->currentPost()->replyToUserName.isEmpty() &&
-                !acc->friendsList().contains(postToParse->currentPost()->replyToUserName)) {
-            if (!postToParse->currentPost()->content.contains(postToParse->currentAccount()->username())) {
-                postToParse->close();
+        if (!post->replyToUserName.isEmpty() && !acc->friendsList().contains(post->replyToUserName)) {
+            if (!mentions(post, account->username())) {
 //                qDebug() << "NONE FRIEND FILTERING......";
                 return true;
             }
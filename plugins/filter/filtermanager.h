@@ -24,15 +24,18 @@
 #define FILTERMANAGER_H
 
 #include <QPointer>
-#include <QQueue>
 
 #include "plugin.h"
+#include "postpipeline.h"
 
 #include "filter.h"
+#include "filtermatcher.h"
 
 class QAction;
 namespace Choqok
 {
+class Account;
+class Post;
 namespace UI
 {
 class PostWidget;
@@ -44,32 +47,31 @@ Filter Manager
 
 @author Mehrdad Momeny \<mehrdad.momeny@gmail.com\>
 */
-class FilterManager : public Choqok::Plugin
+class FilterManager : public Choqok::Plugin, public Choqok::UI::PostProcessor, public Choqok::UI::PostFilter
 {
     Q_OBJECT
 public:
     FilterManager(QObject *parent, const QList< QVariant > &args);
     ~FilterManager();
 
+    void processPost(Choqok::UI::PostWidget *widget) override;
+    bool acceptPost(Choqok::Account *account, Choqok::Post *post) override;
+
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
-    void startParsing();
     void slotConfigureFilters();
     void slotHidePost();
+    void compileFilters();
 
 private:
-    enum ParserState { Stopped = 0, Running };
-    ParserState state;
-
-    Filter::FilterAction filterText(const QString &textToCheck, Filter *filter);
-    void doFiltering(Choqok::UI::PostWidget *postToFilter, Filter::FilterAction action);
-
-    void parse(Choqok::UI::PostWidget *postToParse);
-    QQueue< QPointer<Choqok::UI::PostWidget> > postsQueue;
+    /**
+    @return Remove, Highlight or NoMatch for @p post of @p account
+    */
+    FilterMatcher::Outcome parse(Choqok::Account *account, Choqok::Post *post);
 
-    bool parseSpecialRules(Choqok::UI::PostWidget *postToParse);
+    bool parseSpecialRules(Choqok::Account *account, Choqok::Post *post);
 
     QAction *hidePost;
+    FilterMatcher matcher;
 };
 
 #endif
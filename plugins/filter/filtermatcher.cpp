@@ -0,0 +1,249 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#include "filtermatcher.h"
+
+#include <QDebug>
+#include <QQueue>
+
+#include "choqoktypes.h"
+
+FilterMatcher::Automaton::Automaton()
+{
+    clear();
+}
+
+void FilterMatcher::Automaton::clear()
+{
+    gotos.clear();
+    patterns.clear();
+    fail = QVector<int>(1, 0);
+    output = QVector<int>(1, -1);
+    dictionary = QVector<int>(1, -1);
+}
+
+bool FilterMatcher::Automaton::isEmpty() const
+{
+    return patterns.isEmpty();
+}
+
+int FilterMatcher::Automaton::transition(int state, ushort c) const
+{
+    return gotos.value((quint64(state) << 16) | c, -1);
+}
+
+int FilterMatcher::Automaton::addPattern(const QString &pattern)
+{
+    QHash<QString, int>::const_iterator it = patterns.constFind(pattern);
+    if (it != patterns.constEnd()) {
+        return it.value();
+    }
+    int state = 0;
+    for (const QChar c: pattern) {
+        int next = transition(state, c.unicode());
+        if (next < 0) {
+            next = output.count();
+            output.append(-1);
+            gotos.insert((quint64(state) << 16) | c.unicode(), next);
+        }
+        state = next;
+    }
+    const int index = patterns.count();
+    patterns.insert(pattern, index);
+    output[state] = index;
+    return index;
+}
+
+void FilterMatcher::Automaton::build()
+{
+    const int stateCount = output.count();
+    fail = QVector<int>(stateCount, 0);
+    dictionary = QVector<int>(stateCount, -1);
+
+    // The children of each state, to visit them breadth first
+    QVector<QList<QPair<ushort, int> > > children(stateCount);
+    for (QHash<quint64, int>::const_iterator it = gotos.constBegin(); it != gotos.constEnd(); ++it) {
+        children[it.key() >> 16].append(qMakePair(ushort(it.key() & 0xffff), it.value()));
+    }
+
+    QQueue<int> queue;
+    queue.enqueue(0);
+    while (!queue.isEmpty()) {
+        const int state = queue.dequeue();
+        for (const QPair<ushort, int> &child: children.at(state)) {
+            int f = fail.at(state);
+            while (f != 0 && transition(f, child.first) < 0) {
+                f = fail.at(f);
+            }
+            const int target = transition(f, child.first);
+            const int failState = (target >= 0 && target != child.second) ? target : 0;
+            fail[child.second] = failState;
+            dictionary[child.second] = output.at(failState) >= 0 ? failState : dictionary.at(failState);
+            queue.enqueue(child.second);
+        }
+    }
+}
+
+void FilterMatcher::Automaton::scan(const QString &text, QSet<int> *found) const
+{
+    int state = 0;
+    for (const QChar c: text) {
+        int next;
+        while ((next = transition(state, c.unicode())) < 0 && state != 0) {
+            state = fail.at(state);
+        }
+        state = next < 0 ? 0 : next;
+
+        int match = output.at(state) >= 0 ? state : dictionary.at(state);
+        while (match >= 0) {
+            // The rest of the chain was reported together with it
+            if (found->contains(output.at(match))) {
+                break;
+            }
+            found->insert(output.at(match));
+            match = dictionary.at(match);
+        }
+    }
+}
+
+void FilterMatcher::FieldMatcher::clear()
+{
+    exact.clear();
+    automaton.clear();
+    containOutcomes.clear();
+    notContain.clear();
+    regExps.clear();
+}
+
+FilterMatcher::Outcomes FilterMatcher::FieldMatcher::match(const QString &text) const
+{
+    Outcomes outcomes;
+    if (!exact.isEmpty() || !automaton.isEmpty()) {
+        const QString folded = text.toCaseFolded();
+        outcomes |= exact.value(folded);
+        if (!automaton.isEmpty()) {
+            QSet<int> found;
+            automaton.scan(folded, &found);
+            for (const int pattern: found) {
+                outcomes |= containOutcomes.at(pattern);
+            }
+            for (const QPair<int, Outcomes> &filter: notContain) {
+                if (!found.contains(filter.first)) {
+                    outcomes |= filter.second;
+                }
+            }
+        }
+    }
+    for (const QPair<QRegularExpression, Outcomes> &filter: regExps) {
+        if (filter.first.match(text).hasMatch()) {
+            outcomes |= filter.second;
+        }
+    }
+    return outcomes;
+}
+
+FilterMatcher::FilterMatcher()
+    : count(0)
+{
+}
+
+void FilterMatcher::compile(const QList<Filter *> &filters)
+{
+    for (FieldMatcher &field: fields) {
+        field.clear();
+    }
+    count = 0;
+
+    for (Filter *filter: filters) {
+        if (filter->filterText().isEmpty() || filter->filterField() < Filter::Content ||
+                filter->filterField() > Filter::Source) {
+            continue;
+        }
+        Outcomes outcome;
+        switch (filter->filterAction()) {
+        case Filter::Remove:
+            outcome = filter->dontHideReplies() ? RemoveUnlessRelated : Remove;
+            break;
+        case Filter::Highlight:
+            outcome = Highlight;
+            break;
+        default:
+            continue;
+        }
+
+        FieldMatcher &field = fields[filter->filterField()];
+        const QString folded = filter->filterText().toCaseFolded();
+        switch (filter->filterType()) {
+        case Filter::ExactMatch:
+            field.exact[folded] |= outcome;
+            break;
+        case Filter::Contain: {
+            const int pattern = field.automaton.addPattern(folded);
+            field.containOutcomes.resize(qMax(field.containOutcomes.count(), pattern + 1));
+            field.containOutcomes[pattern] |= outcome;
+            break;
+        }
+        case Filter::DoesNotContain: {
+            const int pattern = field.automaton.addPattern(folded);
+            field.containOutcomes.resize(qMax(field.containOutcomes.count(), pattern + 1));
+            field.notContain.append(qMakePair(pattern, outcome));
+            break;
+        }
+        case Filter::RegExp: {
+            QRegularExpression regExp = regularExpression(filter->filterText());
+            if (!regExp.isValid()) {
+                qWarning() << "Invalid regular expression" << filter->filterText() << regExp.errorString();
+                continue;
+            }
+            regExp.optimize();
+            field.regExps.append(qMakePair(regExp, outcome));
+            break;
+        }
+        default:
+            continue;
+        }
+        ++count;
+    }
+
+    for (FieldMatcher &field: fields) {
+        field.automaton.build();
+    }
+}
+
+FilterMatcher::Outcomes FilterMatcher::match(const Choqok::Post *post) const
+{
+    return fields[Filter::Content].match(post->content) |
+           fields[Filter::AuthorUsername].match(post->author.userName) |
+           fields[Filter::ReplyToUsername].match(post->replyToUserName) |
+           fields[Filter::Source].match(post->source);
+}
+
+int FilterMatcher::filterCount() const
+{
+    return count;
+}
+
+QRegularExpression FilterMatcher::regularExpression(const QString &pattern)
+{
+    return QRegularExpression(pattern, QRegularExpression::UseUnicodePropertiesOption);
+}
@@ -0,0 +1,133 @@
+/*
+    This file is part of Choqok, the KDE micro-blogging client
+
+    Copyright (C) 2026 Choqok Developers
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation; either version 2 of
+    the License or (at your option) version 3 or any later version
+    accepted by the membership of KDE e.V. (or its successor approved
+    by the membership of KDE e.V.), which shall act as a proxy
+    defined in Section 14 of version 3 of the license.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, see http://www.gnu.org/licenses/
+
+*/
+
+#ifndef FILTERMATCHER_H
+#define FILTERMATCHER_H
+
+#include <QFlags>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QRegularExpression>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "filter.h"
+
+namespace Choqok
+{
+class Post;
+}
+
+/**
+@brief The filters compiled for matching many posts
+
+Built once whenever the filters change, @ref match() then checks all filters of a field
+in one pass over its text:
+- Exact matches are looked up in a hash set.
+- Contain and Does Not Contain texts are found by one Aho-Corasick automaton per field.
+- Regular expressions are compiled once.
+
+Texts are compared case insensitively, except for regular expressions, like
+@ref Filter used to be checked one by one.
+
+Regular expressions use the QRegularExpression (PCRE) syntax. Filters saved for QRegExp
+mostly mean the same in it; \\w, \\d and \\b still match all letters and digits, not only
+ASCII ones. A saved pattern PCRE rejects is skipped with a warning, the filter dialog
+does not accept new ones.
+
+@author Choqok Developers
+*/
+class FilterMatcher
+{
+public:
+    enum Outcome {
+        NoMatch = 0,
+        Remove = 1,
+        RemoveUnlessRelated = 2,    ///< Remove, unless the post replies to or mentions the user
+        Highlight = 4
+    };
+    Q_DECLARE_FLAGS(Outcomes, Outcome)
+
+    FilterMatcher();
+
+    /**
+    Compile @p filters, replacing the ones compiled before
+    */
+    void compile(const QList<Filter *> &filters);
+
+    /**
+    @return what the filters matching @p post ask for
+    */
+    Outcomes match(const Choqok::Post *post) const;
+
+    int filterCount() const;
+
+    /**
+    @return the regular expression of a Filter::RegExp filter with @p pattern
+    */
+    static QRegularExpression regularExpression(const QString &pattern);
+
+private:
+    /// Finds all patterns in a text, at once
+    class Automaton
+    {
+    public:
+        Automaton();
+        void clear();
+        /// @return the index of @p pattern, the same for a pattern added twice
+        int addPattern(const QString &pattern);
+        void build();
+        bool isEmpty() const;
+        /// Add the index of every pattern found in @p text to @p found
+        void scan(const QString &text, QSet<int> *found) const;
+
+    private:
+        int transition(int state, ushort c) const;
+
+        QHash<quint64, int> gotos;  // (state << 16 | character) -> state
+        QVector<int> fail;
+        QVector<int> output;        // pattern ending at the state, or -1
+        QVector<int> dictionary;    // nearest state with an output along the fail links, or -1
+        QHash<QString, int> patterns;
+    };
+
+    struct FieldMatcher {
+        QHash<QString, Outcomes> exact;     // by case folded text
+        Automaton automaton;
+        QVector<Outcomes> containOutcomes;  // by pattern of the automaton
+        QList<QPair<int, Outcomes> > notContain;
+        QList<QPair<QRegularExpression, Outcomes> > regExps;
+
+        void clear();
+        Outcomes match(const QString &text) const;
+    };
+
+    FieldMatcher fields[4];
+    int count;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(FilterMatcher::Outcomes)
+
+#endif // FILTERMATCHER_H
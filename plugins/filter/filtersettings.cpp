@@ -94,11 +94,13 @@ void FilterSettings::readConfig()
 
     _hideNoneFriendsReplies = conf->readEntry("hideNoneFriendsReplies", false);
     _hideRepliesNotRelatedToMe = conf->readEntry("hideRepliesNotRelatedToMe", false);
+    Q_EMIT filtersChanged();
 }
 
 void FilterSettings::setFilters(const QList< Filter * > &filters)
 {
     _filters = filters;
+    Q_EMIT filtersChanged();
 }
 
 void FilterSettings::writeConfig()
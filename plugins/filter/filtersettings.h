@@ -59,6 +59,12 @@ public:
     static bool hideRepliesNotRelatedToMe();
     static void setHideRepliesNotRelatedToMe(bool enable = true);
 
+Q_SIGNALS:
+    /**
+    Emitted when the list of filters was read or set
+    */
+    void filtersChanged();
+
 private:
     FilterSettings();
     static FilterSettings *_self;
@@ -23,7 +23,8 @@
 
 #include "imagepreview.h"
 
-#include <QTimer>
+#include <QStringList>
+#include <QUrl>
 
 #include <KPluginFactory>
 
@@ -35,152 +36,95 @@
 K_PLUGIN_FACTORY_WITH_JSON(ImagePreviewFactory, "choqok_imagepreview.json",
                            registerPlugin < ImagePreview > ();)
 
-const QRegExp ImagePreview::mYFrogRegExp(QLatin1String("(http://yfrog.[^\\s<>\"]+[^!,\\.\\s<>'\\\"\\]])"));
-const QRegExp ImagePreview::mImgLyRegExp(QLatin1String("(http://img.ly/[^\\s<>\"]+[^!,\\.\\s<>'\"\\]])"));
-const QRegExp ImagePreview::mTwitgooRegExp(QLatin1String("(http://(([a-zA-Z0-9]+\\.)?)twitgoo.com/[^\\s<>\"]+[^!,\\.\\s<>'\"\\]])"));
-const QRegExp ImagePreview::mPumpIORegExp(QLatin1String("(https://([a-zA-Z0-9]+\\.)?[a-zA-Z0-9]+\\.[a-zA-Z]+/uploads/\\w+/\\d{4}/\\d{1,2}/\\d{1,2}/\\w+)(\\.[a-zA-Z]{3,4})"));
-
 ImagePreview::ImagePreview(QObject *parent, const QList< QVariant > &)
-    : Choqok::Plugin(QLatin1String("choqok_imagepreview"), parent), state(Stopped)
+    : Choqok::Plugin(QLatin1String("choqok_imagepreview"), parent)
 {
-    connect(Choqok::UI::Global::SessionManager::self(),
-            SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
-            this,
-            SLOT(slotAddNewPostWidget(Choqok::UI::PostWidget*)));
+    Choqok::UI::PostPipeline::self()->addProcessor(Choqok::UI::PostPipeline::PreviewStage, this);
 }
 
 ImagePreview::~ImagePreview()
 {
-
+    Choqok::UI::PostPipeline::self()->removeProcessor(this);
 }
 
-void ImagePreview::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+void ImagePreview::processPost(Choqok::UI::PostWidget *widget)
 {
-    postsQueue.enqueue(newWidget);
-    if (state == Stopped) {
-        state = Running;
-        QTimer::singleShot(1000, this, SLOT(startParsing()));
-    }
+    parse(widget);
 }
 
-void ImagePreview::startParsing()
+/// URL of the thumbnail of the image hosted at @p url, or an empty string
+static QString thumbnailUrl(const QString &url)
 {
-    int i = 8;
-    while (!postsQueue.isEmpty() && i > 0) {
-        parse(postsQueue.dequeue());
-        --i;
-    }
-
-    if (postsQueue.isEmpty()) {
-        state = Stopped;
-    } else {
-        QTimer::singleShot(500, this, SLOT(startParsing()));
-    }
-}
-
-void ImagePreview::parse(Choqok::UI::PostWidget *postToParse)
-{
-    if (!postToParse) {
-        return;
+    const QUrl link(url);
+    const QString host = link.host().toLower();
+    const QString path = link.path();
+    if (path.size() < 2) {
+        return QString();
     }
-    int pos = 0;
-    QStringList yfrogRedirectList;
-    QStringList ImgLyRedirectList;
-    QStringList TwitgooRedirectList;
-    QStringList PumpIORedirectList;
-    QString content = postToParse->currentPost()->content;
 
     //YFrog: http://code.google.com/p/imageshackapi/wiki/YFROGurls
     //       http://code.google.com/p/imageshackapi/wiki/YFROGthumbnails
-    pos = 0;
-    while ((pos = mYFrogRegExp.indexIn(content, pos)) != -1) {
-        pos += mYFrogRegExp.matchedLength();
-        yfrogRedirectList << mYFrogRegExp.cap(0);
-    }
-    for (const QString &url: yfrogRedirectList) {
-//         if( url.endsWith('j') || url.endsWith('p') || url.endsWith('g') ) //To check if it's Image or not!
-        connect(Choqok::MediaManager::self(),
-                SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
-        QString yfrogThumbnailUrl = url + QLatin1String(".th.jpg");
-        mParsingList.insert(yfrogThumbnailUrl, postToParse);
-        mBaseUrlMap.insert(yfrogThumbnailUrl, url);
-        Choqok::MediaManager::self()->fetchImage(yfrogThumbnailUrl, Choqok::MediaManager::Async);
+    if (host.startsWith(QLatin1String("yfrog."))) {
+        return url + QLatin1String(".th.jpg");
     }
 
     //Img.ly; http://img.ly/api/docs
-    pos = 0;
-    while ((pos = mImgLyRegExp.indexIn(content, pos)) != -1) {
-        pos += mImgLyRegExp.matchedLength();
-        ImgLyRedirectList << mImgLyRegExp.cap(0);
-    }
-    for (const QString &url: ImgLyRedirectList) {
-        connect(Choqok::MediaManager::self(),
-                SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
-        QString ImgLyUrl = QStringLiteral("http://img.ly/show/thumb%1").arg(QString(url).remove(QLatin1String("http://img.ly")));
-        mParsingList.insert(ImgLyUrl, postToParse);
-        mBaseUrlMap.insert(ImgLyUrl, url);
-        Choqok::MediaManager::self()->fetchImage(ImgLyUrl, Choqok::MediaManager::Async);
+    if (host == QLatin1String("img.ly")) {
+        return QLatin1String("http://img.ly/show/thumb") + path;
     }
 
     //Twitgoo; http://twitgoo.com/docs/TwitgooHelp.htm
-    pos = 0;
-    while ((pos = mTwitgooRegExp.indexIn(content, pos)) != -1) {
-        pos += mTwitgooRegExp.matchedLength();
-        TwitgooRedirectList << mTwitgooRegExp.cap(0);
+    if (host == QLatin1String("twitgoo.com") || host.endsWith(QLatin1String(".twitgoo.com"))) {
+        return url + QLatin1String("/thumb");
     }
-    for (const QString &url: TwitgooRedirectList) {
-        connect(Choqok::MediaManager::self(),
-                SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
-        QString TwitgooUrl = url + QLatin1String("/thumb");
-        mParsingList.insert(TwitgooUrl, postToParse);
-        mBaseUrlMap.insert(TwitgooUrl, url);
-        Choqok::MediaManager::self()->fetchImage(TwitgooUrl, Choqok::MediaManager::Async);
+
+    //PumpIO: https://example.org/uploads/user/2016/5/3/AbCdEf.png
+    const QStringList parts = path.split(QLatin1Char('/'));
+    if (link.scheme() == QLatin1String("https") && parts.size() == 7 && parts.at(1) == QLatin1String("uploads")) {
+        const int dot = url.lastIndexOf(QLatin1Char('.'));
+        const int extension = url.size() - dot - 1;
+        if (dot > url.lastIndexOf(QLatin1Char('/')) && extension >= 3 && extension <= 4) {
+            return url.left(dot) + QLatin1String("_thumb") + url.mid(dot);
+        }
     }
 
-    //PumpIO
-    pos = 0;
-    QString baseUrl;
-    QString imageExtension;
-    while ((pos = mPumpIORegExp.indexIn(content, pos)) != -1) {
-        pos += mPumpIORegExp.matchedLength();
-        PumpIORedirectList << mPumpIORegExp.cap(0);
-        baseUrl = mPumpIORegExp.cap(1);
-        imageExtension = mPumpIORegExp.cap(mPumpIORegExp.capturedTexts().length() - 1);
+    return QString();
+}
+
+void ImagePreview::parse(Choqok::UI::PostWidget *postToParse)
+{
+    if (!postToParse) {
+        return;
     }
-    for (const QString &url: PumpIORedirectList) {
-        connect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
-        const QString pumpIOUrl = baseUrl + QLatin1String("_thumb") + imageExtension;
-        mParsingList.insert(pumpIOUrl, postToParse);
-        mBaseUrlMap.insert(pumpIOUrl, url);
-        Choqok::MediaManager::self()->fetchImage(pumpIOUrl, Choqok::MediaManager::Async);
+    const QList<Choqok::Entity> entities = postToParse->entities();
+    for (int i = 0; i < entities.count(); ++i) {
+        const Choqok::Entity &entity = entities.at(i);
+        if (entity.type != Choqok::Entity::Url) {
+            continue;
+        }
+        const QString thumbnail = thumbnailUrl(entity.target);
+        if (thumbnail.isEmpty()) {
+            continue;
+        }
+        mParsingList.insert(thumbnail, postToParse);
+        mEntityMap.insert(thumbnail, i);
+        Choqok::MediaManager::self()->request(thumbnail, this, SLOT(slotImageFetched(QString,QPixmap)), nullptr,
+                                              Choqok::MediaManager::PreviewImage, postToParse);
     }
 }
 
 void ImagePreview::slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap)
 {
     Choqok::UI::PostWidget *postToParse = mParsingList.take(remoteUrl);
-    QString baseUrl = mBaseUrlMap.take(remoteUrl);
+    const int entity = mEntityMap.take(remoteUrl);
     if (!postToParse) {
         return;
     }
-    QString content = postToParse->content();
     QUrl imgU(remoteUrl);
     imgU.setScheme(QLatin1String("img"));
-//     imgUrl.replace("http://","img://");
-    QPixmap pix = pixmap;
-    if (pixmap.width() > 200) {
-        pix = pixmap.scaledToWidth(200);
-    } else if (pixmap.height() > 200) {
-        pix = pixmap.scaledToHeight(200);
-    }
-    postToParse->mainWidget()->document()->addResource(QTextDocument::ImageResource, imgU, pix);
-    content.replace(QRegExp(QLatin1Char('>') + baseUrl + QLatin1Char('<')), QStringLiteral("><img align='left' src='")
-                    + imgU.toDisplayString() + QStringLiteral("' /><"));
-    postToParse->setContent(content);
+    // Already scaled down to 200 pixels by MediaManager
+    postToParse->mainWidget()->document()->addResource(QTextDocument::ImageResource, imgU, pixmap);
+    postToParse->addAnnotation(Choqok::Annotation(Choqok::Annotation::Thumbnail, entity, QString(), remoteUrl));
 }
 
 #include "imagepreview.moc"
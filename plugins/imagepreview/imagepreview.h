@@ -24,11 +24,11 @@
 #ifndef IMAGEPREVIEW_H
 #define IMAGEPREVIEW_H
 
-#include <QQueue>
 #include <QPixmap>
 #include <QVariant>
 
 #include "plugin.h"
+#include "postpipeline.h"
 
 namespace Choqok
 {
@@ -38,32 +38,22 @@ class PostWidget;
 }
 }
 
-class ImagePreview : public Choqok::Plugin
+class ImagePreview : public Choqok::Plugin, public Choqok::UI::PostProcessor
 {
     Q_OBJECT
 public:
     ImagePreview(QObject *parent, const QList< QVariant > &args);
     ~ImagePreview();
 
+    void processPost(Choqok::UI::PostWidget *widget) override;
+
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
-    void startParsing();
     void slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap);
 
 private:
-    enum ParserState { Running = 0, Stopped };
-    ParserState state;
-
     void parse(Choqok::UI::PostWidget *postToParse);
-    QQueue< QPointer<Choqok::UI::PostWidget> > postsQueue;
     QMap<QString, QPointer<Choqok::UI::PostWidget> > mParsingList;//remoteUrl, Post
-    QMap<QString, QString> mBaseUrlMap;//remoteUrl, BaseUrl
-
-    static const QRegExp mYFrogRegExp;
-    static const QRegExp mPlixiRegExp;
-    static const QRegExp mImgLyRegExp;
-    static const QRegExp mTwitgooRegExp;
-    static const QRegExp mPumpIORegExp;
+    QMap<QString, int> mEntityMap;//remoteUrl, index of the link in the entities of the post
 };
 
 #endif // IMAGEPREVIEW_H
@@ -26,7 +26,6 @@
 #include <QDebug>
 #include <QJsonDocument>
 #include <QSharedPointer>
-#include <QTimer>
 
 #include <KIO/TransferJob>
 #include <KPluginFactory>
@@ -41,48 +40,64 @@ const QString baseLongUrlDorComUrl = QLatin1String("http://api.longurl.org/v2/")
 
 LongUrl::LongUrl(QObject *parent, const QList< QVariant > &)
     : Choqok::Plugin(QLatin1String("choqok_longurl"), parent)
-    , state(Stopped), mServicesAreFetched(false)
+    , mServicesAreFetched(false)
 {
     sheduleSupportedServicesFetch();
-    connect(Choqok::UI::Global::SessionManager::self(),
-            SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
-            this,
-            SLOT(slotAddNewPostWidget(Choqok::UI::PostWidget*)));
+    Choqok::UI::PostPipeline::self()->addProcessor(Choqok::UI::PostPipeline::ExpandStage, this);
 }
 
 LongUrl::~LongUrl()
 {
+    Choqok::UI::PostPipeline::self()->removeProcessor(this);
     suspendJobs();
     mData.clear();
     mShortUrls.clear();
+    mJobs.clear();
     for (KJob *job: mParsingList.keys()) {
         job->kill();
     }
     mParsingList.clear();
 }
 
+void LongUrl::processPost(Choqok::UI::PostWidget *widget)
+{
+    if (mServicesAreFetched) {
+        // Parsed when the supported services are known
+        mPendingPosts.append(widget);
+    } else {
+        parse(widget);
+    }
+}
+
 void LongUrl::parse(QPointer< Choqok::UI::PostWidget > postToParse)
 {
     if (!postToParse) {
         return;
     }
-    QStringList redirectList, pureList = postToParse->urls();
-    QString content = postToParse->currentPost()->content;
-    for (int i = 0; i < pureList.count(); ++i) {
-        if (pureList[i].length() > 30) {
+    const QList<Choqok::Entity> entities = postToParse->entities();
+    for (int i = 0; i < entities.count(); ++i) {
+        const Choqok::Entity &entity = entities.at(i);
+        if (entity.type != Choqok::Entity::Url || entity.length > 30) {
             continue;
         }
-        if (!pureList[i].startsWith(QLatin1String("http"), Qt::CaseInsensitive)) {
-            pureList[i].prepend(QLatin1String("http://"));
+        // Expanded before by this or another plugin
+        QUrl expanded;
+        if (Choqok::ShortenManager::self()->findExpansion(QUrl(entity.target), &expanded)) {
+            if (!expanded.isEmpty()) {
+                replaceUrl(postToParse, i, QUrl(entity.target), expanded);
+            }
+            continue;
         }
-        redirectList << pureList[i];
-    }
-    for (const QString &url: redirectList) {
-        KJob *job = sheduleParsing(url);
-        if (job) {
-            mParsingList.insert(job, postToParse);
+        KJob *job = mJobs.value(entity.target);
+        if (!job) {
+            job = sheduleParsing(entity.target);
+            if (!job) {
+                continue;
+            }
+            mJobs.insert(entity.target, job);
             job->start();
         }
+        mParsingList[job].append(qMakePair(postToParse, i));
     }
 }
 
@@ -94,32 +109,20 @@ void LongUrl::processJobResults(KJob *job)
     }
     const QVariantMap m = json.toVariant().toMap();
     const QUrl longUrl = m.value(QLatin1String("long-url")).toUrl();
-    replaceUrl(takeJob(job), QUrl(mShortUrls.take(job)), longUrl);
-}
-
-void LongUrl::startParsing()
-{
-    int i = 8;
-    while (!postsQueue.isEmpty() && i > 0) {
-        parse(postsQueue.dequeue());
-        --i;
+    if (longUrl.isEmpty()) {
+        return;
     }
-
-    if (postsQueue.isEmpty()) {
-        state = Stopped;
-    } else {
-        QTimer::singleShot(500, this, SLOT(startParsing()));
+    const QUrl shortUrl(mShortUrls.value(job));
+    Choqok::ShortenManager::self()->addExpansion(shortUrl, longUrl);
+    for (const QPair<PostWidgetPointer, int> &post: mParsingList.value(job)) {
+        replaceUrl(post.first, post.second, shortUrl, longUrl);
     }
 }
 
-void LongUrl::replaceUrl(LongUrl::PostWidgetPointer post, const QUrl &fromUrl, const QUrl &toUrl)
+void LongUrl::replaceUrl(LongUrl::PostWidgetPointer post, int entity, const QUrl &fromUrl, const QUrl &toUrl)
 {
     if (post) {
-        QString content = post->content();
-        QString fromUrlStr = fromUrl.url();
-        content.replace(QRegExp(QLatin1String("title='") + fromUrlStr + QLatin1Char('\'')), QLatin1String("title='") + toUrl.url() + QLatin1Char('\''));
-        content.replace(QRegExp(QLatin1String("href='") + fromUrlStr + QLatin1Char('\'')), QLatin1String("href='") + toUrl.url() + QLatin1Char('\''));
-        post->setContent(content);
+        post->addAnnotation(Choqok::Annotation(Choqok::Annotation::ExpandedUrl, entity, toUrl.url()));
         Choqok::ShortenManager::self()->emitNewUnshortenedUrl(post, fromUrl, toUrl);
     }
 }
@@ -151,6 +154,10 @@ void LongUrl::servicesJobResult(KJob *job)
     }
     mServicesAreFetched = false;
     mServicesData.clear();
+    for (const PostWidgetPointer &post: mPendingPosts) {
+        parse(post);
+    }
+    mPendingPosts.clear();
 }
 
 bool LongUrl::isServiceSupported(const QString &host)
@@ -190,19 +197,10 @@ void LongUrl::jobResult(KJob *job)
         processJobResults(job);
     }
     mData.remove(job);
-    mShortUrls.remove(job);
+    mJobs.remove(mShortUrls.take(job));
     mParsingList.remove(job);
 }
 
-void LongUrl::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
-{
-    postsQueue.enqueue(newWidget);
-    if (state == Stopped && !mServicesAreFetched) {
-        state = Running;
-        QTimer::singleShot(1000, this, SLOT(startParsing()));
-    }
-}
-
 void LongUrl::aboutToUnload()
 {
     suspendJobs();
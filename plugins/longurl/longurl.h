@@ -24,14 +24,16 @@
 #ifndef CHOQOK_LONGURL_H
 #define CHOQOK_LONGURL_H
 
+#include <QHash>
+#include <QPair>
 #include <QPointer>
-#include <QQueue>
 #include <QSharedPointer>
 #include <QUrlQuery>
 
 #include <KIO/Job>
 
 #include "plugin.h"
+#include "postpipeline.h"
 
 class QUrl;
 
@@ -43,7 +45,7 @@ class PostWidget;
 }
 }
 
-class LongUrl : public Choqok::Plugin
+class LongUrl : public Choqok::Plugin, public Choqok::UI::PostProcessor
 {
     typedef Choqok::Plugin base;
     Q_OBJECT
@@ -51,18 +53,15 @@ public:
     LongUrl(QObject *parent, const QList< QVariant > &args);
     ~LongUrl();
 
+    void processPost(Choqok::UI::PostWidget *widget) override;
+
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
-    void startParsing();
     void dataReceived(KIO::Job *job, QByteArray data);
     void jobResult(KJob *job);
     virtual void aboutToUnload() override;
     void servicesDataReceived(KIO::Job *job, QByteArray data);
     void servicesJobResult(KJob *job);
 private:
-    enum ParserState { Running = 0, Stopped };
-    ParserState state;
-
     typedef QPointer<Choqok::UI::PostWidget> PostWidgetPointer;
 
     void sheduleSupportedServicesFetch();
@@ -73,25 +72,18 @@ private:
     KJob *sheduleParsing(const QString &shortUrl);
     void suspendJobs();
 
-    void replaceUrl(PostWidgetPointer post, const QUrl &fromUrl, const QUrl &toUrl);
-
-    PostWidgetPointer takeJob(KJob *job)
-    {
-        return mParsingList.take(job);
-    }
-
-    void insertJob(KJob *job, PostWidgetPointer post)
-    {
-        mParsingList.insert(job, post);
-    }
+    void replaceUrl(PostWidgetPointer post, int entity, const QUrl &fromUrl, const QUrl &toUrl);
 
-    QQueue< PostWidgetPointer > postsQueue;
-    QMap<KJob *, PostWidgetPointer > mParsingList;
+    // Posts and the index of the short URL in their entities, waiting for a job
+    typedef QList<QPair<PostWidgetPointer, int> > WaitingList;
+    QMap<KJob *, WaitingList> mParsingList;
+    QList<PostWidgetPointer> mPendingPosts;
     QStringList supportedServices;
     typedef QMap<KJob *, QByteArray> DataMap;
     DataMap mData;
     typedef QMap<KJob *, QString> UrlsMap;
     UrlsMap mShortUrls;
+    QHash<QString, KJob *> mJobs; // running job of each short URL
     QSharedPointer<QByteArray> mServicesData;
     bool mServicesAreFetched;
 };
@@ -43,7 +43,7 @@ Bit_ly::~Bit_ly()
 {
 }
 
-QString Bit_ly::shorten(const QString &url)
+KJob *Bit_ly::createShortenJob(const QString &url)
 {
     QString login = QCoreApplication::applicationName();
     QString apiKey = QLatin1String("R_bdd1ae8b6191dd36e13fc77ca1d4f27f");
@@ -67,11 +67,14 @@ QString Bit_ly::shorten(const QString &url)
     reqQuery.addQueryItem(QLatin1String("format"), QLatin1String("txt"));
     reqUrl.setQuery(reqQuery);
 
-    KIO::StoredTransferJob *job = KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
-    job->exec();
+    return KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
+}
 
+QString Bit_ly::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (!job->error()) {
-        const QByteArray data = job->data();
+        const QByteArray data = qobject_cast<KIO::StoredTransferJob *>(job)->data();
         QString output = QLatin1String(data);
         QRegExp rx(QLatin1String("(http://((.*)+)/([a-zA-Z0-9])+)"));
         rx.indexIn(output);
@@ -96,7 +99,7 @@ QString Bit_ly::shorten(const QString &url)
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1", job->errorString()),
                                      i18n("Bit.ly error"));
     }
-    return url;
+    return QString();
 }
 
 #include "bit_ly.moc"
@@ -39,7 +39,9 @@ public:
     Bit_ly(QObject *parent, const QVariantList &args);
     ~Bit_ly();
 
-    virtual QString shorten(const QString &url) override;
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif //BIT_LY_H
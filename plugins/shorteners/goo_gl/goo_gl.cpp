@@ -42,7 +42,7 @@ Goo_gl::~Goo_gl()
 {
 }
 
-QString Goo_gl::shorten(const QString &url)
+KJob *Goo_gl::createShortenJob(const QString &url)
 {
     QVariantMap req;
     req.insert(QLatin1String("longUrl"), url);
@@ -50,19 +50,23 @@ QString Goo_gl::shorten(const QString &url)
     KIO::StoredTransferJob *job = KIO::storedHttpPost(json, QUrl(QLatin1String("https://www.googleapis.com/urlshortener/v1/url")), KIO::HideProgressInfo) ;
     if (!job) {
         Choqok::NotifyManager::error(i18n("Error when creating job"), i18n("Goo.gl Error"));
-        return url;
+        return 0;
     }
     job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: application/json"));
-    job->exec();
+    return job;
+}
 
+QString Goo_gl::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (!job->error()) {
-        const QJsonDocument json = QJsonDocument::fromJson(job->data());
+        const QJsonDocument json = QJsonDocument::fromJson(qobject_cast<KIO::StoredTransferJob *>(job)->data());
         if (!json.isNull()) {
             const QVariantMap map = json.toVariant().toMap();
             const QVariantMap error = map[QLatin1String("error")].toMap();
             if (!error.isEmpty()) {
                 Choqok::NotifyManager::error(error[QLatin1String("message")].toString(), i18n("Goo.gl Error"));
-                return url;
+                return QString();
             }
             return map[ QLatin1String("id") ].toString();
         }
@@ -70,7 +74,7 @@ QString Goo_gl::shorten(const QString &url)
     } else {
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1", job->errorString()), i18n("Goo.gl Error"));
     }
-    return url;
+    return QString();
 }
 
 #include "goo_gl.moc"
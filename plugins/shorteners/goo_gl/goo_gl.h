@@ -37,7 +37,10 @@ class Goo_gl : public Choqok::Shortener
 public:
     Goo_gl(QObject *parent, const QVariantList &args);
     ~Goo_gl();
-    virtual QString shorten(const QString &url) override;
+
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif //GOO_GL_H
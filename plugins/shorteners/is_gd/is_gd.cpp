@@ -22,7 +22,6 @@
 
 #include "is_gd.h"
 
-#include <QEventLoop>
 #include <QJsonDocument>
 
 #include <KIO/StoredTransferJob>
@@ -44,7 +43,7 @@ Is_gd::~Is_gd()
 {
 }
 
-QString Is_gd::shorten(const QString &url)
+KJob *Is_gd::createShortenJob(const QString &url)
 {
     Is_gd_Settings::self()->load();
 
@@ -57,21 +56,21 @@ QString Is_gd::shorten(const QString &url)
     }
 
     reqUrl.setQuery(reqQuery);
-    QEventLoop loop;
-    KIO::StoredTransferJob *job = KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
-    connect(job, SIGNAL(result(KJob*)), &loop, SLOT(quit()));
-    job->start();
-    loop.exec();
+    return KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
+}
 
+QString Is_gd::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (job->error() == KJob::NoError) {
 
-        const QJsonDocument json = QJsonDocument::fromJson(job->data());
+        const QJsonDocument json = QJsonDocument::fromJson(qobject_cast<KIO::StoredTransferJob *>(job)->data());
         if (!json.isNull()) {
             const QVariantMap map = json.toVariant().toMap();
 
             if (!map[ QLatin1String("errorcode") ].toString().isEmpty()) {
                 Choqok::NotifyManager::error(map[ QLatin1String("errormessage") ].toString(), i18n("is.gd Error"));
-                return url;
+                return QString();
             }
             QString shorturl = map[ QLatin1String("shorturl") ].toString();
             if (!shorturl.isEmpty()) {
@@ -83,7 +82,7 @@ QString Is_gd::shorten(const QString &url)
     } else {
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1", job->errorString()), i18n("is.gd Error"));
     }
-    return url;
+    return QString();
 }
 
 #include "is_gd.moc"
@@ -39,8 +39,9 @@ public:
     Is_gd(QObject *parent, const QVariantList &args);
     ~Is_gd();
 
-    virtual QString shorten(const QString &url) override;
-
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif //IS_GD_H
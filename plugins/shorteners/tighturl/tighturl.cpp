@@ -22,7 +22,6 @@ along with this program; if not, see http://www.gnu.org/licenses/
 
 #include "tighturl.h"
 
-#include <QEventLoop>
 #include <QUrl>
 
 #include <KIO/StoredTransferJob>
@@ -39,22 +38,21 @@ TightUrl::TightUrl(QObject *parent, const QVariantList &)
 {
 }
 
-QString TightUrl::shorten(const QString &url)
+KJob *TightUrl::createShortenJob(const QString &url)
 {
     QUrl reqUrl(QLatin1String("http://2tu.us/"));
     QUrlQuery reqQuery;
     reqQuery.addQueryItem(QLatin1String("save"), QLatin1String("y"));
     reqQuery.addQueryItem(QLatin1String("url"), QUrl(url).url());
     reqUrl.setQuery(reqQuery);
+    return KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
+}
 
-    QEventLoop loop;
-    KIO::StoredTransferJob *job = KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
-    connect(job, SIGNAL(result(KJob*)), &loop, SLOT(quit()));
-    job->start();
-    loop.exec();
-
+QString TightUrl::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (job->error() == KJob::NoError) {
-        QString output(QLatin1String(job->data()));
+        QString output(QLatin1String(qobject_cast<KIO::StoredTransferJob *>(job)->data()));
         QRegExp rx(QLatin1String("<code>(.+)</code>"));
         rx.setMinimal(true);
         rx.indexIn(output);
@@ -69,7 +67,7 @@ QString TightUrl::shorten(const QString &url)
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1",
                                           job->errorString()), i18n("TightUrl Error"));
     }
-    return url;
+    return QString();
 }
 
 TightUrl::~TightUrl()
@@ -36,7 +36,9 @@ public:
     TightUrl(QObject *parent, const QVariantList &args);
     ~TightUrl();
 
-    virtual QString shorten(const QString &url) override;
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif
@@ -42,7 +42,7 @@ Tinyarro_ws::~Tinyarro_ws()
 {
 }
 
-QString Tinyarro_ws::shorten(const QString &url)
+KJob *Tinyarro_ws::createShortenJob(const QString &url)
 {
     QUrl reqUrl(QLatin1String("http://tinyarro.ws/api-create.php"));
     QUrlQuery reqQuery;
@@ -57,11 +57,14 @@ QString Tinyarro_ws::shorten(const QString &url)
     reqQuery.addQueryItem(QLatin1String("url"), QUrl(url).url());
     reqUrl.setQuery(reqQuery);
 
-    KIO::StoredTransferJob *job = KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
-    job->exec();
+    return KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
+}
 
+QString Tinyarro_ws::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (!job->error()) {
-        QString output = QString::fromUtf8(job->data());
+        QString output = QString::fromUtf8(qobject_cast<KIO::StoredTransferJob *>(job)->data());
 
         if (!output.isEmpty()) {
             if (output.startsWith(QLatin1String("http://"))) {
@@ -72,7 +75,7 @@ QString Tinyarro_ws::shorten(const QString &url)
     } else {
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1", job->errorString()));
     }
-    return url;
+    return QString();
 }
 
 #include "tinyarro_ws.moc"
\ No newline at end of file
@@ -39,7 +39,9 @@ public:
     Tinyarro_ws(QObject *parent, const QVariantList &args);
     ~Tinyarro_ws();
 
-    virtual QString shorten(const QString &url) override;
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif
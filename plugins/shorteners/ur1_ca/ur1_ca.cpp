@@ -21,7 +21,6 @@ along with this program; if not, see http://www.gnu.org/licenses/
 */
 #include "ur1_ca.h"
 
-#include <QEventLoop>
 #include <QUrl>
 
 #include <KIO/StoredTransferJob>
@@ -42,7 +41,7 @@ Ur1_ca::~Ur1_ca()
 {
 }
 
-QString Ur1_ca::shorten(const QString &url)
+KJob *Ur1_ca::createShortenJob(const QString &url)
 {
     QUrl reqUrl(QLatin1String("http://ur1.ca/"));
     QString temp;
@@ -51,15 +50,16 @@ QString Ur1_ca::shorten(const QString &url)
     QByteArray parg("longurl=");
     parg.append(temp.toLatin1());
 
-    QEventLoop loop;
     KIO::StoredTransferJob *job = KIO::storedHttpPost(parg, reqUrl, KIO::HideProgressInfo);
     job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: application/x-www-form-urlencoded"));
-    connect(job, SIGNAL(result(KJob*)), &loop, SLOT(quit()));
-    job->start();
-    loop.exec();
+    return job;
+}
 
+QString Ur1_ca::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (job->error() == KJob::NoError) {
-        QString output(QLatin1String(job->data()));
+        QString output(QLatin1String(qobject_cast<KIO::StoredTransferJob *>(job)->data()));
         QRegExp rx(QLatin1String("<p class=[\'\"]success[\'\"]>(.*)</p>"));
         rx.setMinimal(true);
         rx.indexIn(output);
@@ -73,7 +73,7 @@ QString Ur1_ca::shorten(const QString &url)
     } else {
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1", job->errorString()), i18n("ur1.ca Error"));
     }
-    return url;
+    return QString();
 }
 
 #include "ur1_ca.moc"
\ No newline at end of file
@@ -36,7 +36,9 @@ public:
     Ur1_ca(QObject *parent, const QVariantList &args);
     ~Ur1_ca();
 
-    virtual QString shorten(const QString &url) override;
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif
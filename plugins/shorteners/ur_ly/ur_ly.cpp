@@ -44,18 +44,21 @@ Ur_ly::~Ur_ly()
 {
 }
 
-QString Ur_ly::shorten(const QString &url)
+KJob *Ur_ly::createShortenJob(const QString &url)
 {
     QUrl reqUrl(QLatin1String("http://ur.ly/new.json"));
     QUrlQuery reqQuery;
     reqQuery.addQueryItem(QLatin1String("href"), QUrl(url).url());
     reqUrl.setQuery(reqQuery);
 
-    KIO::StoredTransferJob *job = KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
-    job->exec();
+    return KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
+}
 
+QString Ur_ly::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (!job->error()) {
-        const QByteArray data = job->data();
+        const QByteArray data = qobject_cast<KIO::StoredTransferJob *>(job)->data();
         const QJsonDocument json = QJsonDocument::fromJson(data);
         if (!json.isNull()) {
             const QVariantMap result = json.toVariant().toMap();
@@ -64,7 +67,7 @@ QString Ur_ly::shorten(const QString &url)
                 return QStringLiteral("http://ur.ly/%1").arg(result.value(QLatin1String("code")).toString());
             }
         } else {
-            qCritical() << "Ur_ly::shorten: Parse error, Job error:" << job->errorString();
+            qCritical() << "Ur_ly::shortUrlFromJob: Parse error, Job error:" << job->errorString();
             qCritical() << "Data:" << data;
             Choqok::NotifyManager::error(i18n("Malformed response"), i18n("Ur.ly Error"));
         }
@@ -73,7 +76,7 @@ QString Ur_ly::shorten(const QString &url)
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1",
                                           job->errorString()), i18n("Ur.ly Error"));
     }
-    return url;
+    return QString();
 }
 
 #include "ur_ly.moc"
@@ -38,7 +38,9 @@ public:
     Ur_ly(QObject *parent, const QVariantList &args);
     ~Ur_ly();
 
-    virtual QString shorten(const QString &url);
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 };
 
 #endif
@@ -47,7 +47,7 @@ Yourls::Yourls(QObject *parent, const QVariantList &)
 Yourls::~Yourls()
 {}
 
-QString Yourls::shorten(const QString &url)
+KJob *Yourls::createShortenJob(const QString &url)
 {
     QUrl reqUrl(YourlsSettings::yourlsHost());
     QUrlQuery reqQuery;
@@ -62,11 +62,14 @@ QString Yourls::shorten(const QString &url)
     }
 
     reqUrl.setQuery(reqQuery);
-    KIO::StoredTransferJob *job = KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
-    job->exec();
+    return KIO::storedGet(reqUrl, KIO::Reload, KIO::HideProgressInfo);
+}
 
+QString Yourls::shortUrlFromJob(KJob *job, const QString &url)
+{
+    Q_UNUSED(url);
     if (!job->error()) {
-        const QByteArray data = job->data();                            /* output field */
+        const QByteArray data = qobject_cast<KIO::StoredTransferJob *>(job)->data();                            /* output field */
         QString output = QLatin1String(data);
 
         QRegExp rx(QLatin1String("<shorturl>(.+)</shorturl>"));
@@ -89,7 +92,7 @@ QString Yourls::shorten(const QString &url)
         Choqok::NotifyManager::error(i18n("Cannot create a short URL.\n%1",
                                           job->errorString()));
     }
-    return url;
+    return QString();
 }
 
 void Yourls::reloadConfigs()
@@ -40,7 +40,9 @@ public:
     Yourls(QObject *parent, const QVariantList &args);
     ~Yourls();
 
-    virtual QString shorten(const QString &url) override;
+protected:
+    virtual KJob *createShortenJob(const QString &url) override;
+    virtual QString shortUrlFromJob(KJob *job, const QString &url) override;
 
 private Q_SLOTS:
     void reloadConfigs();
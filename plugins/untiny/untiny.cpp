@@ -24,9 +24,6 @@
 
 #include "untiny.h"
 
-#include <QTimer>
-
-#include <KIO/MimetypeJob>
 #include <KPluginFactory>
 
 #include "choqokuiglobal.h"
@@ -40,87 +37,52 @@ K_PLUGIN_FACTORY_WITH_JSON(UnTinyFactory, "choqok_untiny.json",
 
 UnTiny::UnTiny(QObject* parent, const QList< QVariant >& )
     : Choqok::Plugin(QLatin1String("choqok_untiny"), parent)
-    , state(Stopped)
 {
-    connect( Choqok::UI::Global::SessionManager::self(),
-             &Choqok::UI::Global::SessionManager::newPostWidgetAdded,
-             this,
-             &UnTiny::slotAddNewPostWidget );
+    Choqok::UI::PostPipeline::self()->addProcessor(Choqok::UI::PostPipeline::ExpandStage, this);
 }
 
 UnTiny::~UnTiny()
 {
-
-}
-
-void UnTiny::slotAddNewPostWidget(Choqok::UI::PostWidget* newWidget)
-{
-    postsQueue.enqueue(newWidget);
-    if(state == Stopped){
-        state = Running;
-        QTimer::singleShot(1000, this, SLOT(startParsing()));
-    }
+    Choqok::UI::PostPipeline::self()->removeProcessor(this);
 }
 
-void UnTiny::startParsing()
+void UnTiny::processPost(Choqok::UI::PostWidget *widget)
 {
-    int i = 8;
-    while( !postsQueue.isEmpty() && i>0 ){
-        parse(postsQueue.dequeue());
-        --i;
-    }
-
-    if(postsQueue.isEmpty())
-        state = Stopped;
-    else
-        QTimer::singleShot(500, this, SLOT(startParsing()));
+    parse(widget);
 }
 
 void UnTiny::parse(QPointer<Choqok::UI::PostWidget> postToParse)
 {
     if(!postToParse)
         return;
-    QStringList redirectList, pureList = postToParse->urls();
-    QString content = postToParse->currentPost()->content;
-    for (int i=0; i < pureList.count(); ++i) {
-        if(pureList[i].length() > 30){
+    const QList<Choqok::Entity> entities = postToParse->entities();
+    for (int i = 0; i < entities.count(); ++i) {
+        const Choqok::Entity &entity = entities.at(i);
+        if (entity.type != Choqok::Entity::Url || entity.length > 30) {
             continue;
         }
-        if(!pureList[i].startsWith(QLatin1String("http"), Qt::CaseInsensitive)){
-            pureList[i].prepend(QLatin1String("http://"));
-        }
-        redirectList << pureList[i];
-    }
-    for (const QString &url: redirectList) {
-        KIO::MimetypeJob *job = KIO::mimetype( QUrl::fromUserInput(url), KIO::HideProgressInfo );
-        if ( !job ) {
-            qCritical() << "Cannot create a http header request!";
-            break;
+        const QUrl url = QUrl::fromUserInput(entity.target);
+        const QString key = url.toString();
+        const bool waiting = mWaiting.contains(key);
+        mWaiting.insert(key, qMakePair(postToParse, i));
+        if (!waiting) {
+            // Answered right away if the expansion is cached
+            Choqok::ShortenManager::self()->expandUrl(url, this, SLOT(slotExpanded(QUrl,QUrl)));
         }
-        connect( job, &KIO::MimetypeJob::permanentRedirection, this, &UnTiny::slot301Redirected );
-        mParsingList.insert(job, postToParse);
-        job->start();
     }
 }
 
-void UnTiny::slot301Redirected(KIO::Job* job, QUrl fromUrl, QUrl toUrl)
+void UnTiny::slotExpanded(const QUrl &fromUrl, const QUrl &toUrl)
 {
-    QPointer<Choqok::UI::PostWidget> postToParse = mParsingList.take(job);
-    job->kill();
-    if(postToParse){
-        QString content = postToParse->content();
-        QString fromUrlStr = fromUrl.url();
-        content.replace(QRegExp(QStringLiteral("title='%1\'").arg(fromUrlStr)), QStringLiteral("title='%1\'").arg(toUrl.url()));
-        content.replace(QRegExp(QStringLiteral("href='%1\'").arg(fromUrlStr)), QStringLiteral("href='%1\'").arg(toUrl.url()));
-        postToParse->setContent(content);
-        Choqok::ShortenManager::self()->emitNewUnshortenedUrl(postToParse, fromUrl, toUrl);
-        if (toUrl.url().length() < 30 && fromUrl.host() == QLatin1String("t.co")){
-            KIO::TransferJob *job = KIO::mimetype( toUrl, KIO::HideProgressInfo );
-            if ( job ) {
-                connect( job, &KIO::MimetypeJob::permanentRedirection, this, &UnTiny::slot301Redirected );
-                mParsingList.insert(job, postToParse);
-                job->start();
-            }
+    const QList<QPair<QPointer<Choqok::UI::PostWidget>, int> > waiting = mWaiting.values(fromUrl.toString());
+    mWaiting.remove(fromUrl.toString());
+    if (toUrl.isEmpty()) {
+        return;
+    }
+    for (const QPair<QPointer<Choqok::UI::PostWidget>, int> &post: waiting) {
+        if (post.first) {
+            post.first->addAnnotation(Choqok::Annotation(Choqok::Annotation::ExpandedUrl, post.second, toUrl.url()));
+            Choqok::ShortenManager::self()->emitNewUnshortenedUrl(post.first, fromUrl, toUrl);
         }
     }
 }
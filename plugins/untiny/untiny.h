@@ -26,42 +26,35 @@
 #define UNTINY_H
 
 #include "plugin.h"
+#include "postpipeline.h"
 
-#include <QQueue>
-#include <QUrl>
+#include <QMultiHash>
+#include <QPair>
 #include <QPointer>
+#include <QUrl>
 
-namespace KIO {
-class Job;
-}
-
-class KJob;
 namespace Choqok {
 namespace UI {
     class PostWidget;
 }
 }
 
-class UnTiny : public Choqok::Plugin
+class UnTiny : public Choqok::Plugin, public Choqok::UI::PostProcessor
 {
     Q_OBJECT
 public:
     UnTiny( QObject* parent, const QList< QVariant >& args );
     ~UnTiny();
 
+    void processPost(Choqok::UI::PostWidget *widget) override;
+
 protected Q_SLOTS:
-    void slotAddNewPostWidget( Choqok::UI::PostWidget *newWidget );
-    void slot301Redirected(KIO::Job*,QUrl,QUrl);
-    void startParsing();
+    void slotExpanded(const QUrl &fromUrl, const QUrl &toUrl);
 
 private:
-    enum ParserState{ Running = 0, Stopped };
-    ParserState state;
-
     void parse( QPointer< Choqok::UI::PostWidget > postToParse );
-    QQueue< QPointer<Choqok::UI::PostWidget> > postsQueue;
-    QMap<KJob*, QPointer<Choqok::UI::PostWidget> > mParsingList;
-    QMap<KJob*, QString> mShortUrlsList;
+    // Posts and the index of the entity waiting for the expansion of a short URL
+    QMultiHash<QString, QPair<QPointer<Choqok::UI::PostWidget>, int> > mWaiting;
 };
 
 #endif //UNTINY_H
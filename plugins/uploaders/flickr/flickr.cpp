@@ -31,7 +31,7 @@
 #include <KIO/StoredTransferJob>
 #include <KPluginFactory>
 
-#include "mediamanager.h"
+#include "multipartbody.h"
 #include "passwordmanager.h"
 
 #include "flickrsettings.h"
@@ -52,74 +52,69 @@ Flickr::~Flickr()
 {
 }
 
-void Flickr::upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType)
+void Flickr::upload(const QUrl &localUrl, const QByteArray &mediumType)
 {
     QUrl url(QLatin1String("https://api.flickr.com/services/upload/"));
     FlickrSettings::self()->load();
     QString token = Choqok::PasswordManager::self()->readPassword(QStringLiteral("flickr_%1")
                     .arg(FlickrSettings::username()));
-    QMap<QString, QByteArray> formdata;
-    formdata[QLatin1String("api_key")] = apiKey.toUtf8();
-    formdata[QLatin1String("auth_token")] = token.toUtf8();
+    Choqok::MultipartBody *body = new Choqok::MultipartBody;
+    body->addField(QLatin1String("api_key"), apiKey.toUtf8());
+    body->addField(QLatin1String("auth_token"), token.toUtf8());
 
     QString preSign;
     if (FlickrSettings::hidefromsearch()) {
-        formdata[QLatin1String("hidden")] = QByteArray("2");
+        body->addField(QLatin1String("hidden"), QByteArray("2"));
         preSign.append(QLatin1String("hidden2"));
     } else {
-        formdata[QLatin1String("hidden")] = QByteArray("1");
+        body->addField(QLatin1String("hidden"), QByteArray("1"));
         preSign.append(QLatin1String("hidden1"));
     }
 
     if (FlickrSettings::forprivate()) {
 
         if (FlickrSettings::forfamily()) {
-            formdata[QLatin1String("is_family")] = QByteArray("1");
+            body->addField(QLatin1String("is_family"), QByteArray("1"));
             preSign.append(QLatin1String("is_family1"));
         }
 
         if (FlickrSettings::forfriends()) {
-            formdata[QLatin1String("is_friend")] = QByteArray("1");
+            body->addField(QLatin1String("is_friend"), QByteArray("1"));
             preSign.append(QLatin1String("is_friend1"));
         }
-        formdata[QLatin1String("is_public")] = QByteArray("0");
+        body->addField(QLatin1String("is_public"), QByteArray("0"));
         preSign.append(QLatin1String("is_public0"));
     } else if (FlickrSettings::forpublic()) {
-        formdata[QLatin1String("is_public")] = QByteArray("1");
+        body->addField(QLatin1String("is_public"), QByteArray("1"));
         preSign.append(QLatin1String("is_public1"));
     }
 
     if (FlickrSettings::safe()) {
-        formdata[QLatin1String("safety_level")] = QByteArray("1");
+        body->addField(QLatin1String("safety_level"), QByteArray("1"));
         preSign.append(QLatin1String("safety_level1"));
     }
     if (FlickrSettings::moderate()) {
-        formdata[QLatin1String("safety_level")] = QByteArray("2");
+        body->addField(QLatin1String("safety_level"), QByteArray("2"));
         preSign.append(QLatin1String("safety_level2"));
     }
     if (FlickrSettings::restricted()) {
-        formdata[QLatin1String("safety_level")] = QByteArray("3");
+        body->addField(QLatin1String("safety_level"), QByteArray("3"));
         preSign.append(QLatin1String("safety_level3"));
     }
 
-    formdata[QLatin1String("api_sig")] = createSign("auth_token" + token.toUtf8() + preSign.toUtf8());
+    body->addField(QLatin1String("api_sig"), createSign("auth_token" + token.toUtf8() + preSign.toUtf8()));
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile[QLatin1String("name")] = "photo";
-    mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-    mediafile[QLatin1String("mediumType")] = mediumType;
-    mediafile[QLatin1String("medium")] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    if (!body->addFile(QLatin1String("photo"), localUrl.toLocalFile(), mediumType)) {
+        Q_EMIT uploadingFailed(localUrl, body->errorString());
+        delete body;
+        return;
+    }
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = post(localUrl, url, body);
     if (!job) {
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
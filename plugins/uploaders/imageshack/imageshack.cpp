@@ -31,7 +31,7 @@
 #include <KLocalizedString>
 #include <KPluginFactory>
 
-#include "mediamanager.h"
+#include "multipartbody.h"
 
 const static QString apiKey = QLatin1String("ZMWLXQBOfb570310607355f90c601148a3203f0f");
 
@@ -47,33 +47,28 @@ ImageShack::~ImageShack()
 {
 }
 
-void ImageShack::upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType)
+void ImageShack::upload(const QUrl &localUrl, const QByteArray &mediumType)
 {
     if (!mediumType.startsWith(QByteArray("image/"))) {
         Q_EMIT uploadingFailed(localUrl, i18n("Just supporting image uploading"));
         return;
     }
     QUrl url(QLatin1String("https://www.imageshack.us/upload_api.php"));
-    QMap<QString, QByteArray> formdata;
-    formdata[QLatin1String("key")] = apiKey.toLatin1();
-    formdata[QLatin1String("rembar")] = "1";
+    Choqok::MultipartBody *body = new Choqok::MultipartBody;
+    body->addField(QLatin1String("key"), apiKey.toLatin1());
+    body->addField(QLatin1String("rembar"), "1");
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile[QLatin1String("name")] = "fileupload";
-    mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-    mediafile[QLatin1String("mediumType")] = mediumType;
-    mediafile[QLatin1String("medium")] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    if (!body->addFile(QLatin1String("fileupload"), localUrl.toLocalFile(), mediumType)) {
+        Q_EMIT uploadingFailed(localUrl, body->errorString());
+        delete body;
+        return;
+    }
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = post(localUrl, url, body);
     if (!job) {
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QLatin1String("content-type"), QLatin1String("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
@@ -39,7 +39,7 @@ public:
     ImageShack(QObject *parent, const QList< QVariant > &args);
     ~ImageShack();
 
-    virtual void upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType) override;
+    virtual void upload(const QUrl &localUrl, const QByteArray &mediumType) override;
 
 protected Q_SLOTS:
     void slotUpload(KJob *job);
@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartbody.h"
 #include "passwordmanager.h"
 
 #include "twitterapiaccount.h"
@@ -50,7 +50,7 @@ Mobypicture::~Mobypicture()
 {
 }
 
-void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType)
+void Mobypicture::upload(const QUrl &localUrl, const QByteArray &mediumType)
 {
     MobypictureSettings::self()->load();
     KIO::StoredTransferJob *job = 0;
@@ -69,21 +69,17 @@ void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const Q
 
         QUrl url(QLatin1String("https://api.mobypicture.com/2.0/upload"));
 
-        QMap<QString, QByteArray> formdata;
-        formdata[QLatin1String("key")] = apiKey;
-        formdata[QLatin1String("message")] = QString().toUtf8();
+        Choqok::MultipartBody *body = new Choqok::MultipartBody;
+        body->addField(QLatin1String("key"), apiKey);
+        body->addField(QLatin1String("message"), QString().toUtf8());
 
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media";
-        mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = mediumType;
-        mediafile[QLatin1String("medium")] = medium;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+        if (!body->addFile(QLatin1String("media"), localUrl.toLocalFile(), mediumType)) {
+            Q_EMIT uploadingFailed(localUrl, body->errorString());
+            delete body;
+            return;
+        }
 
-        job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
+        job = post(localUrl, url, body);
         QUrl requrl(QLatin1String("https://api.twitter.com/1/account/verify_credentials.json"));
         QByteArray credentials = acc->oauthInterface()->authorizationHeader(requrl, QNetworkAccessManager::GetOperation);
 
@@ -95,23 +91,20 @@ void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const Q
         QString login = MobypictureSettings::login();
         QString pass = Choqok::PasswordManager::self()->readPassword(QStringLiteral("mobypicture_%1")
                        .arg(MobypictureSettings::login()));
-        QMap<QString, QByteArray> formdata;
-        formdata[QLatin1String("k")] = apiKey;
-        formdata[QLatin1String("u")] = login.toUtf8();
-        formdata[QLatin1String("p")] = pass.toUtf8();
-        formdata[QLatin1String("s")] = "none";
-        formdata[QLatin1String("format")] = "json";
-
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "i";
-        mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = mediumType;
-        mediafile[QLatin1String("medium")] = medium;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
-
-        job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+        Choqok::MultipartBody *body = new Choqok::MultipartBody;
+        body->addField(QLatin1String("k"), apiKey);
+        body->addField(QLatin1String("u"), login.toUtf8());
+        body->addField(QLatin1String("p"), pass.toUtf8());
+        body->addField(QLatin1String("s"), "none");
+        body->addField(QLatin1String("format"), "json");
+
+        if (!body->addFile(QLatin1String("i"), localUrl.toLocalFile(), mediumType)) {
+            Q_EMIT uploadingFailed(localUrl, body->errorString());
+            delete body;
+            return;
+        }
+
+        job = post(localUrl, url, body);
         job->addMetaData(QLatin1String("Authorization"),
                          QLatin1String("Basic ") + QLatin1String(QStringLiteral("%1:%2").arg(login).arg(pass).toUtf8().toBase64()));
     }
@@ -120,8 +113,6 @@ void Mobypicture::upload(const QUrl &localUrl, const QByteArray &medium, const Q
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QLatin1String("content-type"),
-                     QLatin1String("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
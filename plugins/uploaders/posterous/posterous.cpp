@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartbody.h"
 #include "passwordmanager.h"
 
 #include "twitterapiaccount.h"
@@ -79,7 +79,7 @@ QString Posterous::getAuthToken(const QUrl &localUrl)
     return QString();
 }
 
-void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType)
+void Posterous::upload(const QUrl &localUrl, const QByteArray &mediumType)
 {
     PosterousSettings::self()->load();
     KIO::StoredTransferJob *job = 0;
@@ -89,23 +89,19 @@ void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QBy
         QString token = getAuthToken(localUrl);
         if (!token.isEmpty()) {
             QUrl url(QLatin1String("http://posterous.com/api/2/users/me/sites/primary/posts"));
-            QMap<QString, QByteArray> formdata;
-            formdata[QLatin1String("post[title]")] = QByteArray();
-            formdata[QLatin1String("post[body]")] = QByteArray();
-            formdata[QLatin1String("autopost")] = "0";
-            formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
-            formdata[QLatin1String("api_token")] = token.toUtf8();
-
-            QMap<QString, QByteArray> mediafile;
-            mediafile[QLatin1String("name")] = "media";
-            mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-            mediafile[QLatin1String("mediumType")] = mediumType;
-            mediafile[QLatin1String("medium")] = medium;
-            QList< QMap<QString, QByteArray> > listMediafiles;
-            listMediafiles.append(mediafile);
-
-            QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
-            job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
+            Choqok::MultipartBody *body = new Choqok::MultipartBody;
+            body->addField(QLatin1String("post[title]"), QByteArray());
+            body->addField(QLatin1String("post[body]"), QByteArray());
+            body->addField(QLatin1String("autopost"), "0");
+            body->addField(QLatin1String("source"), QCoreApplication::applicationName().toLatin1());
+            body->addField(QLatin1String("api_token"), token.toUtf8());
+
+            if (!body->addFile(QLatin1String("media"), localUrl.toLocalFile(), mediumType)) {
+                Q_EMIT uploadingFailed(localUrl, body->errorString());
+                delete body;
+                return;
+            }
+            job = post(localUrl, url, body);
             job->addMetaData(QLatin1String("customHTTPHeader"),
                              QLatin1String("Authorization: Basic ") +
                              QLatin1String(QStringLiteral("%1:%2").arg(login).arg(pass).toUtf8().toBase64()));
@@ -124,21 +120,17 @@ void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QBy
 
         QUrl url(QLatin1String("http://posterous.com/api2/upload.json"));
 
-        QMap<QString, QByteArray> formdata;
-        formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
-        formdata[QLatin1String("sourceLink")] = "http://choqok.gnufolks.org/";
-
-        QMap<QString, QByteArray> mediafile;
-        mediafile[QLatin1String("name")] = "media";
-        mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-        mediafile[QLatin1String("mediumType")] = mediumType;
-        mediafile[QLatin1String("medium")] = medium;
-        QList< QMap<QString, QByteArray> > listMediafiles;
-        listMediafiles.append(mediafile);
+        Choqok::MultipartBody *body = new Choqok::MultipartBody;
+        body->addField(QLatin1String("source"), QCoreApplication::applicationName().toLatin1());
+        body->addField(QLatin1String("sourceLink"), "http://choqok.gnufolks.org/");
 
-        QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+        if (!body->addFile(QLatin1String("media"), localUrl.toLocalFile(), mediumType)) {
+            Q_EMIT uploadingFailed(localUrl, body->errorString());
+            delete body;
+            return;
+        }
 
-        KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo);
+        job = post(localUrl, url, body);
         QUrl requrl(QLatin1String("https://api.twitter.com/1/account/verify_credentials.json"));
         QByteArray credentials = acc->oauthInterface()->authorizationHeader(requrl, QNetworkAccessManager::GetOperation);
 
@@ -150,8 +142,6 @@ void Posterous::upload(const QUrl &localUrl, const QByteArray &medium, const QBy
         qCritical() << "Cannot create a http POST request!";
         return;
     }
-    job->addMetaData(QStringLiteral("content-type"),
-                     QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartbody.h"
 #include "passwordmanager.h"
 
 #include "twitterapiaccount.h"
@@ -50,7 +50,7 @@ Twitgoo::~Twitgoo()
 {
 }
 
-void Twitgoo::upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType)
+void Twitgoo::upload(const QUrl &localUrl, const QByteArray &mediumType)
 {
     TwitgooSettings::self()->load();
     QString alias = TwitgooSettings::alias();
@@ -66,33 +66,27 @@ void Twitgoo::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
 
     QUrl url(QLatin1String("http://twitgoo.com/api/upload"));
 
-    QMap<QString, QByteArray> formdata;
-    formdata[QLatin1String("source")] = QCoreApplication::applicationName().toLatin1();
-    formdata[QLatin1String("format")] = "json";
+    Choqok::MultipartBody *body = new Choqok::MultipartBody;
+    body->addField(QLatin1String("source"), QCoreApplication::applicationName().toLatin1());
+    body->addField(QLatin1String("format"), "json");
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile[QLatin1String("name")] = "media";
-    mediafile[QLatin1String("filename")] = localUrl.fileName().toUtf8();
-    mediafile[QLatin1String("mediumType")] = mediumType;
-    mediafile[QLatin1String("medium")] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    if (!body->addFile(QLatin1String("media"), localUrl.toLocalFile(), mediumType)) {
+        Q_EMIT uploadingFailed(localUrl, body->errorString());
+        delete body;
+        return;
+    }
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = post(localUrl, url, body);
+    if (!job) {
+        qCritical() << "Cannot create a http POST request!";
+        return;
+    }
     job->addMetaData(QStringLiteral("customHTTPHeader"),
                      QStringLiteral("X-Auth-Service-Provider: https://api.twitter.com/1/account/verify_credentials.json"));
     QUrl requrl(QLatin1String("https://api.twitter.com/1/account/verify_credentials.json"));
     QByteArray credentials = acc->oauthInterface()->authorizationHeader(requrl, QNetworkAccessManager::GetOperation);
     job->addMetaData(QStringLiteral("customHTTPHeader"),
                      QStringLiteral("X-Verify-Credentials-Authorization: ") + QLatin1String(credentials));
-    if (!job) {
-        qCritical() << "Cannot create a http POST request!";
-        return;
-    }
-    job->addMetaData(QStringLiteral("content-type"),
-                     QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
@@ -35,7 +35,7 @@ public:
     Twitgoo(QObject *parent, const QList< QVariant > &args);
     ~Twitgoo();
 
-    virtual void upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType) override;
+    virtual void upload(const QUrl &localUrl, const QByteArray &mediumType) override;
 
 protected Q_SLOTS:
     void slotUpload(KJob *job);
@@ -30,7 +30,7 @@
 #include <KPluginFactory>
 
 #include "accountmanager.h"
-#include "mediamanager.h"
+#include "multipartbody.h"
 
 #include <QtOAuth/QtOAuth>
 
@@ -51,7 +51,7 @@ Twitpic::~Twitpic()
 {
 }
 
-void Twitpic::upload(const QUrl &localUrl, const QByteArray &medium, const QByteArray &mediumType)
+void Twitpic::upload(const QUrl &localUrl, const QByteArray &mediumType)
 {
     TwitpicSettings::self()->load();
     QString alias = TwitpicSettings::alias();
@@ -67,20 +67,20 @@ void Twitpic::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
     ///Documentation: http://dev.twitpic.com/
     QUrl url("http://api.twitpic.com/2/upload.json");
 
-    QMap<QString, QByteArray> formdata;
-    formdata["key"] = "b66d1f2dc90b53ca1fcd75319cda0b72";
+    Choqok::MultipartBody *body = new Choqok::MultipartBody;
+    body->addField("key", "b66d1f2dc90b53ca1fcd75319cda0b72");
 
-    QMap<QString, QByteArray> mediafile;
-    mediafile["name"] = "media";
-    mediafile["filename"] = localUrl.fileName().toUtf8();
-    mediafile["mediumType"] = mediumType;
-    mediafile["medium"] = medium;
-    QList< QMap<QString, QByteArray> > listMediafiles;
-    listMediafiles.append(mediafile);
-
-    QByteArray data = Choqok::MediaManager::createMultipartFormData(formdata, listMediafiles);
+    if (!body->addFile(QLatin1String("media"), localUrl.toLocalFile(), mediumType)) {
+        Q_EMIT uploadingFailed(localUrl, body->errorString());
+        delete body;
+        return;
+    }
 
-    KIO::StoredTransferJob *job = KIO::storedHttpPost(data, url, KIO::HideProgressInfo) ;
+    KIO::StoredTransferJob *job = post(localUrl, url, body);
+    if (!job) {
+        qCritical() << "Cannot create a http POST request!";
+        return;
+    }
     job->addMetaData(QStringLiteral("customHTTPHeader"),
                      QStringLiteral("X-Auth-Service-Provider: https://api.twitter.com/1/account/verify_credentials.json"));
     QOAuth::ParamMap params;
@@ -96,12 +96,6 @@ void Twitpic::upload(const QUrl &localUrl, const QByteArray &medium, const QByte
     job->addMetaData(QStringLiteral("customHTTPHeader"),
                      QStringLiteral("X-Verify-Credentials-Authorization: ") +
                      credentials);
-    if (!job) {
-        qCritical() << "Cannot create a http POST request!";
-        return;
-    }
-    job->addMetaData(QStringLiteral("content-type"),
-                     QStringLiteral("Content-Type: multipart/form-data; boundary=AaB03x"));
     mUrlMap[job] = localUrl;
     connect(job, SIGNAL(result(KJob*)),
             SLOT(slotUpload(KJob*)));
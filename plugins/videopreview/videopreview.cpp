@@ -24,16 +24,22 @@
 */
 #include "videopreview.h"
 
+#include <QDataStream>
 #include <QDebug>
+#include <QDir>
 #include <QDomDocument>
 #include <QDomElement>
-#include <QEventLoop>
-#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 #include <KIO/StoredTransferJob>
 #include <KJobWidgets>
 #include <KPluginFactory>
 
+#include <algorithm>
+
 #include "choqokuiglobal.h"
 #include "postwidget.h"
 #include "notifymanager.h"
@@ -44,229 +50,301 @@
 K_PLUGIN_FACTORY_WITH_JSON(VideoPreviewFactory, "choqok_videopreview.json",
                            registerPlugin < VideoPreview > ();)
 
-const QRegExp VideoPreview::mYouTuRegExp(QLatin1String("(https?://youtu.[^\\s<>\"]+[^!,\\.\\s<>'\\\"\\]])"));
-const QRegExp VideoPreview::mYouTubeRegExp(QLatin1String("(https?://www.youtube.[^\\s<>\"]+[^!,\\.\\s<>'\\\"\\]])"));
-const QRegExp VideoPreview::mVimeoRegExp(QLatin1String("(https?://(.+)?vimeo.com/(.+)[&]?)"));
+static const quint32 CACHE_MAGIC = 0x43485650; // "CHVP"
+static const quint8 CACHE_VERSION = 1;
+/// Days the metadata of a video is kept on disk
+static const int CACHE_MAX_AGE = 14;
+static const int CACHE_MAX_VIDEOS = 2000;
+
+static QString cacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/videopreviews");
+}
 
-const QRegExp VideoPreview::mYouTuCode(QLatin1String("youtu.(.+)/(.+)[?&]?"));
+/// YouTube video id of @p url, or an empty string
+static QString youtubeId(const QUrl &url)
+{
+    const QString host = url.host().toLower();
+    if (host.startsWith(QLatin1String("youtu."))) {
+        return url.path().section(QLatin1Char('/'), 1, 1);
+    } else if (host.startsWith(QLatin1String("www.youtube."))) {
+        return QUrlQuery(url).queryItemValue(QLatin1String("v"));
+    }
+    return QString();
+}
+
+/// Vimeo video id of @p url, or an empty string
+static QString vimeoId(const QUrl &url)
+{
+    const QString host = url.host().toLower();
+    if (host == QLatin1String("vimeo.com") || host.endsWith(QLatin1String(".vimeo.com"))) {
+        return url.path().section(QLatin1Char('/'), -1);
+    }
+    return QString();
+}
 
 VideoPreview::VideoPreview(QObject *parent, const QList< QVariant > &)
     : Choqok::Plugin(QLatin1String("choqok_videopreview"), parent)
-    , state(Stopped)
+    , mCacheChanged(false)
 {
-    connect(Choqok::UI::Global::SessionManager::self(),
-            SIGNAL(newPostWidgetAdded(Choqok::UI::PostWidget*,Choqok::Account*,QString)),
-            this,
-            SLOT(slotAddNewPostWidget(Choqok::UI::PostWidget*)));
+    loadCache();
     connect(Choqok::ShortenManager::self(),
             SIGNAL(newUnshortenedUrl(Choqok::UI::PostWidget*,QUrl,QUrl)),
             this,
             SLOT(slotNewUnshortenedUrl(Choqok::UI::PostWidget*,QUrl,QUrl)));
+    Choqok::UI::PostPipeline::self()->addProcessor(Choqok::UI::PostPipeline::PreviewStage, this);
 }
 
 VideoPreview::~VideoPreview()
 {
-
+    Choqok::UI::PostPipeline::self()->removeProcessor(this);
+    saveCache();
 }
 
-void VideoPreview::slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget)
+void VideoPreview::processPost(Choqok::UI::PostWidget *widget)
 {
-    postsQueue.enqueue(newWidget);
-    if (state == Stopped) {
-        state = Running;
-        QTimer::singleShot(1000, this, SLOT(startParsing()));
-    }
+    parse(widget);
 }
 
 void VideoPreview::slotNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const QUrl &fromUrl, const QUrl &toUrl)
 {
     Q_UNUSED(fromUrl)
-    if (mYouTubeRegExp.indexIn(toUrl.toDisplayString()) != -1) {
-        QUrl thisurl(mYouTubeRegExp.cap(0));
-        QUrlQuery thisurlQuery(thisurl);
-        QString thumbUrl = parseYoutube(thisurlQuery.queryItemValue(QLatin1String("v")), widget);
-        connect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
-        Choqok::MediaManager::self()->fetchImage(thumbUrl, Choqok::MediaManager::Async);
-    } else if (mVimeoRegExp.indexIn(toUrl.toDisplayString()) != -1) {
-        QString thumbUrl = parseVimeo(mVimeoRegExp.cap(3), widget);
-        connect(Choqok::MediaManager::self(), SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
-        Choqok::MediaManager::self()->fetchImage(thumbUrl, Choqok::MediaManager::Async);
-    }
-
+    parseUrl(toUrl, widget);
 }
 
-void VideoPreview::startParsing()
+void VideoPreview::parse(QPointer<Choqok::UI::PostWidget> postToParse)
 {
-    int i = 8;
-    while (!postsQueue.isEmpty() && i > 0) {
-        parse(postsQueue.dequeue());
-        --i;
+    if (!postToParse) {
+        return;
     }
-
-    if (postsQueue.isEmpty()) {
-        state = Stopped;
-    } else {
-        QTimer::singleShot(500, this, SLOT(startParsing()));
+    for (const Choqok::Entity &entity: postToParse->entities()) {
+        if (entity.type == Choqok::Entity::Url) {
+            parseUrl(QUrl(entity.target), postToParse);
+        }
     }
 }
 
-void VideoPreview::parse(QPointer<Choqok::UI::PostWidget> postToParse)
+void VideoPreview::parseUrl(const QUrl &url, QPointer<Choqok::UI::PostWidget> postToParse)
 {
-    if (!postToParse) {
+    if (url.scheme() != QLatin1String("http") && url.scheme() != QLatin1String("https")) {
         return;
     }
-    int pos = 0;
-    int pos1 = 0;
-    int pos2 = 0;
-    int pos3 = 0;
-    QStringList thumbList;
-
-    QString content = postToParse->currentPost()->content;
-
-    while (((pos1 = mYouTuRegExp.indexIn(content, pos)) != -1) |
-            ((pos2 = mYouTubeRegExp.indexIn(content, pos)) != -1) |
-            ((pos3 = mVimeoRegExp.indexIn(content, pos)) != -1)) {
-
-        if (pos1 >= 0) {
-            pos = pos1 + mYouTuRegExp.matchedLength();
-            if (mYouTuCode.indexIn(mYouTuRegExp.cap(0)) != -1) {
-                thumbList << parseYoutube(mYouTuCode.cap(2), postToParse);
-            }
-        } else if (pos2 >= 0) {
-            pos = pos2 + mYouTubeRegExp.matchedLength();
-            QUrl thisurl(mYouTubeRegExp.cap(0));
-            QUrlQuery thisurlQuery(thisurl);
-            thumbList << parseYoutube(thisurlQuery.queryItemValue(QLatin1String("v")), postToParse);
-        } else if (pos3 >= 0) {
-            pos = pos3 + mVimeoRegExp.matchedLength();
-            thumbList << parseVimeo(mVimeoRegExp.cap(3), postToParse);
+    QString key;
+    QUrl apiUrl;
+    const QString youtube = youtubeId(url);
+    if (!youtube.isEmpty()) {
+        key = QLatin1String("youtube:") + youtube;
+        apiUrl = QUrl(QStringLiteral("https://gdata.youtube.com/feeds/api/videos/%1").arg(youtube));
+    } else {
+        const QString vimeo = vimeoId(url);
+        if (vimeo.isEmpty()) {
+            return;
         }
+        key = QLatin1String("vimeo:") + vimeo;
+        apiUrl = QUrl(QStringLiteral("https://vimeo.com/api/v2/video/%1.xml").arg(vimeo));
     }
 
-    for (const QString &thumb_url: thumbList) {
-        connect(Choqok::MediaManager::self(),
-                SIGNAL(imageFetched(QString,QPixmap)),
-                SLOT(slotImageFetched(QString,QPixmap)));
+    if (mVideos.contains(key)) {
+        showPreview(key, postToParse);
+        return;
+    }
+    QList<PostWidgetPointer> &waiting = mWaitingForMetadata[key];
+    waiting.append(postToParse);
+    if (waiting.count() > 1) {
+        // Already requested
+        return;
+    }
+    KIO::StoredTransferJob *job = KIO::storedGet(apiUrl, KIO::NoReload, KIO::HideProgressInfo);
+    KJobWidgets::setWindow(job, Choqok::UI::Global::mainWindow());
+    mJobs.insert(job, key);
+    connect(job, SIGNAL(result(KJob*)), SLOT(slotMetadataReceived(KJob*)));
+}
 
-        Choqok::MediaManager::self()->fetchImage(thumb_url, Choqok::MediaManager::Async);
+void VideoPreview::slotMetadataReceived(KJob *job)
+{
+    const QString key = mJobs.take(job);
+    const QString id = key.section(QLatin1Char(':'), 1);
+    const bool isYoutube = key.startsWith(QLatin1String("youtube:"));
+
+    Video video;
+    video.url = isYoutube ? QLatin1String("https://www.youtube.com/watch?v=") + id
+                : QLatin1String("https://vimeo.com/") + id;
+    video.fetched = QDateTime::currentDateTimeUtc();
+    if (!job->error()) {
+        const QByteArray data = qobject_cast<KIO::StoredTransferJob *>(job)->data();
+        if (isYoutube ? parseYoutube(data, &video) : parseVimeo(data, &video)) {
+            mCacheChanged = true;
+        } else {
+            qCritical() << "Cannot read the metadata of" << key;
+        }
+    } else {
+        qCritical() << "Cannot fetch the metadata of" << key << job->errorString();
     }
+    // Failures are kept too, so the video isn't requested again in this session
+    mVideos.insert(key, video);
 
+    for (const PostWidgetPointer &post: mWaitingForMetadata.take(key)) {
+        showPreview(key, post);
+    }
 }
 
-QString VideoPreview::parseYoutube(QString videoid, QPointer< Choqok::UI::PostWidget > postToParse)
+bool VideoPreview::parseYoutube(const QByteArray &data, Video *video)
 {
-    QString youtubeUrl = QStringLiteral("https://gdata.youtube.com/feeds/api/videos/%1").arg(videoid);
-    QUrl th_url(youtubeUrl);
-    KIO::StoredTransferJob *job = KIO::storedGet(th_url, KIO::NoReload, KIO::HideProgressInfo);
-    KJobWidgets::setWindow(job, Choqok::UI::Global::mainWindow());
-    QString title, description, thumb_url;
+    QDomDocument document;
+    document.setContent(data);
+    QDomElement root = document.documentElement();
+    if (!root.isNull()) {
+        QDomElement node;
+        node = root.firstChildElement(QLatin1String("title"));
+        if (!node.isNull()) {
+            video->title = QString(node.text());
+        }
+        node = root.firstChildElement(QLatin1String("media:group"));
+        node = node.firstChildElement(QLatin1String("media:description"));
+        if (!node.isNull()) {
+            video->description = QString(node.text()).left(70);
+        }
 
-    job->exec();
-    if (!job->error()) {
-        QDomDocument document;
-        document.setContent(job->data());
-        QDomElement root = document.documentElement();
-        if (!root.isNull()) {
+        node = node.nextSiblingElement(QLatin1String("media:thumbnail"));
+        if (!node.isNull()) {
+            video->thumbnail = QString(node.attributeNode(QLatin1String("url")).value());
+        }
+    }
+    return !video->thumbnail.isEmpty();
+}
+
+bool VideoPreview::parseVimeo(const QByteArray &data, Video *video)
+{
+    QDomDocument document;
+    document.setContent(data);
+    QDomElement root = document.documentElement();
+    if (!root.isNull()) {
+        QDomElement videotag;
+        videotag = root.firstChildElement(QLatin1String("video"));
+        if (!videotag.isNull()) {
             QDomElement node;
-            node = root.firstChildElement(QLatin1String("title"));
+            node = videotag.firstChildElement(QLatin1String("title"));
             if (!node.isNull()) {
-                title = QString(node.text());
+                video->title = QString(node.text());
             }
-            node = root.firstChildElement(QLatin1String("media:group"));
-            node = node.firstChildElement(QLatin1String("media:description"));
+            node = videotag.firstChildElement(QLatin1String("description"));
             if (!node.isNull()) {
-                description = QString(node.text());
+                video->description = QString(node.text()).left(70);
             }
-
-            node = node.nextSiblingElement(QLatin1String("media:thumbnail"));
+            node = videotag.firstChildElement(QLatin1String("thumbnail_small"));
             if (!node.isNull()) {
-                thumb_url = QString(node.attributeNode(QLatin1String("url")).value());
+                video->thumbnail = QString(node.text());
             }
         }
-
-        description = description.left(70);
-
-        mParsingList.insert(thumb_url, postToParse);
-        mBaseUrlMap.insert(thumb_url, QLatin1String("https://www.youtube.com/watch?v=") + videoid);
-        mTitleVideoMap.insert(thumb_url, title);
-        mDescriptionVideoMap.insert(thumb_url, description);
-    } else {
-        qCritical() << "Youtube XML response is NULL!";
     }
+    return !video->thumbnail.isEmpty();
+}
 
-    return thumb_url;
+void VideoPreview::showPreview(const QString &key, PostWidgetPointer post)
+{
+    const QString thumbnail = mVideos.value(key).thumbnail;
+    if (!post || thumbnail.isEmpty()) {
+        return;
+    }
+    // The thumbnail may be delivered right away
+    mWaitingForThumbnail.insert(thumbnail, qMakePair(post, key));
+    Choqok::MediaManager::self()->request(thumbnail, this, SLOT(slotImageFetched(QString,QPixmap)),
+                                          SLOT(slotImageFailed(QString,QString)),
+                                          Choqok::MediaManager::PreviewImage, post.data());
 }
 
-QString VideoPreview::parseVimeo(QString videoid, QPointer< Choqok::UI::PostWidget > postToParse)
+void VideoPreview::slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap)
 {
-    QString vimeoUrl = QStringLiteral("https://vimeo.com/api/v2/video/%1.xml").arg(videoid);
-    QUrl th_url(vimeoUrl);
-    QEventLoop loop;
-    KIO::StoredTransferJob *job = KIO::storedGet(th_url, KIO::NoReload, KIO::HideProgressInfo);
-    KJobWidgets::setWindow(job, Choqok::UI::Global::mainWindow());
-    QString title, description, thumb_url;
+    const QList<QPair<PostWidgetPointer, QString> > waiting = mWaitingForThumbnail.values(remoteUrl);
+    mWaitingForThumbnail.remove(remoteUrl);
 
-    job->exec();
-    if (!job->error()) {
-        QDomDocument document;
-        document.setContent(job->data());
-        QDomElement root = document.documentElement();
-        if (!root.isNull()) {
-            QDomElement videotag;
-            videotag = root.firstChildElement(QLatin1String("video"));
-            if (!videotag.isNull()) {
-                QDomElement node;
-                node = videotag.firstChildElement(QLatin1String("title"));
-                if (!node.isNull()) {
-                    title = QString(node.text());
-                }
-                node = videotag.firstChildElement(QLatin1String("description"));
-                if (!node.isNull()) {
-                    description = QString(node.text());
-                }
-                node = videotag.firstChildElement(QLatin1String("thumbnail_small"));
-                if (!node.isNull()) {
-                    thumb_url = QString(node.text());
-                }
-            }
+    QUrl imgU(remoteUrl);
+    imgU.setScheme(QLatin1String("img"));
+    for (const QPair<PostWidgetPointer, QString> &entry: waiting) {
+        Choqok::UI::PostWidget *postToParse = entry.first;
+        if (!postToParse) {
+            continue;
         }
-        description = description.left(70);
+        const Video video = mVideos.value(entry.second);
+        postToParse->mainWidget()->document()->addResource(QTextDocument::ImageResource, imgU, pixmap);
 
-        mParsingList.insert(thumb_url, postToParse);
-        mBaseUrlMap.insert(thumb_url, QLatin1String("https://vimeo.com/") + videoid);
-        mTitleVideoMap.insert(thumb_url, title);
-        mDescriptionVideoMap.insert(thumb_url, description);
-    } else {
-        qCritical() << "Vimeo XML response is NULL!";
+        Choqok::Annotation preview(Choqok::Annotation::Preview, -1, video.url, remoteUrl);
+        preview.title = video.title;
+        preview.description = video.description;
+        postToParse->addAnnotation(preview);
     }
-
-    return thumb_url;
 }
 
-void VideoPreview::slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap)
+void VideoPreview::slotImageFailed(const QString &remoteUrl, const QString &errMsg)
 {
-    Choqok::UI::PostWidget *postToParse = mParsingList.take(remoteUrl);
-    QString baseUrl = mBaseUrlMap.take(remoteUrl);
-    QString title = mTitleVideoMap.take(remoteUrl);
-    QString description = mDescriptionVideoMap.take(remoteUrl);
+    Q_UNUSED(errMsg);
+    mWaitingForThumbnail.remove(remoteUrl);
+}
 
-    if (!postToParse) {
+void VideoPreview::loadCache()
+{
+    QFile file(cacheFile());
+    if (!file.open(QIODevice::ReadOnly)) {
         return;
     }
-    QString content = postToParse->content();
-    QUrl imgU(remoteUrl);
-    imgU.setScheme(QLatin1String("img"));
-    postToParse->mainWidget()->document()->addResource(QTextDocument::ImageResource, imgU, pixmap);
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    quint32 magic;
+    quint8 version;
+    stream >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        return;
+    }
+    const QDateTime oldest = QDateTime::currentDateTimeUtc().addDays(-CACHE_MAX_AGE);
+    QString key;
+    Video video;
+    while (!stream.atEnd()) {
+        stream >> key >> video.url >> video.title >> video.description >> video.thumbnail >> video.fetched;
+        if (stream.status() != QDataStream::Ok) {
+            break;
+        }
+        if (video.fetched > oldest) {
+            mVideos.insert(key, video);
+        } else {
+            mCacheChanged = true;
+        }
+    }
+}
 
-    QString temp(QLatin1String("<br/><table><tr><td rowspan=2><img align='left' height=64 src='")
-                 + imgU.toDisplayString() + QLatin1String("' /></td>"));
-    temp.append(QLatin1String("<td><a href='") + baseUrl + QLatin1String("' title='") + baseUrl + QLatin1String("'><b>") + title + QLatin1String("</b></a></td></tr>"));
-    temp.append(QLatin1String("<tr><font size=\"-1\">") + description + QLatin1String("</font></tr></table>"));
+void VideoPreview::saveCache()
+{
+    if (!mCacheChanged) {
+        return;
+    }
+    // Keep the most recently fetched videos which have a preview
+    QList<QPair<QDateTime, QString> > keys;
+    for (QHash<QString, Video>::const_iterator it = mVideos.constBegin(); it != mVideos.constEnd(); ++it) {
+        if (!it->thumbnail.isEmpty()) {
+            keys.append(qMakePair(it->fetched, it.key()));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    if (keys.count() > CACHE_MAX_VIDEOS) {
+        keys = keys.mid(keys.count() - CACHE_MAX_VIDEOS);
+    }
 
-    content.append(temp);
-    postToParse->setContent(content);
+    const QString path = cacheFile();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Cannot write" << path << file.errorString();
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << CACHE_MAGIC << CACHE_VERSION;
+    for (const QPair<QDateTime, QString> &key: keys) {
+        const Video &video = mVideos[key.second];
+        stream << key.second << video.url << video.title << video.description << video.thumbnail << video.fetched;
+    }
+    if (file.commit()) {
+        mCacheChanged = false;
+    }
 }
 
 #include "videopreview.moc"
@@ -25,16 +25,21 @@
 #ifndef VIDEOPREVIEW_H
 #define VIDEOPREVIEW_H
 
+#include <QDateTime>
+#include <QHash>
 #include <QMap>
+#include <QMultiHash>
+#include <QPair>
 #include <QPixmap>
 #include <QPointer>
-#include <QQueue>
-#include <QRegExp>
 #include <QVariant>
 #include <QUrl>
 #include <QUrlQuery>
 
 #include "plugin.h"
+#include "postpipeline.h"
+
+class KJob;
 
 namespace Choqok
 {
@@ -44,39 +49,47 @@ class PostWidget;
 }
 }
 
-class VideoPreview : public Choqok::Plugin
+class VideoPreview : public Choqok::Plugin, public Choqok::UI::PostProcessor
 {
     Q_OBJECT
 public:
     VideoPreview(QObject *parent, const QList< QVariant > &args);
     ~VideoPreview();
 
+    void processPost(Choqok::UI::PostWidget *widget) override;
+
 protected Q_SLOTS:
-    void slotAddNewPostWidget(Choqok::UI::PostWidget *newWidget);
-    void startParsing();
     void slotImageFetched(const QString &remoteUrl, const QPixmap &pixmap);
+    void slotImageFailed(const QString &remoteUrl, const QString &errMsg);
     void slotNewUnshortenedUrl(Choqok::UI::PostWidget *widget, const QUrl &fromUrl, const QUrl &toUrl);
+    void slotMetadataReceived(KJob *job);
 
 private:
-    enum ParserState { Running = 0, Stopped };
-    ParserState state;
-
-    void parse(QPointer< Choqok::UI::PostWidget > postToParse);
-    QString parseYoutube(QString videoid , QPointer< Choqok::UI::PostWidget > postToParse);
-    QString parseVimeo(QString videoid , QPointer< Choqok::UI::PostWidget > postToParse);
-
-    QQueue< QPointer<Choqok::UI::PostWidget> > postsQueue;
-    QMap<QString, QPointer<Choqok::UI::PostWidget> > mParsingList;//remoteUrl, Post
-    QMap<QString, QString> mBaseUrlMap;//remoteUrl, BaseUrl
-    QMap<QString, QString> mTitleVideoMap;//remoteUrl, TitleVideo
-    QMap<QString, QString> mDescriptionVideoMap;//remoteUrl, DescriptionVideo
+    typedef QPointer<Choqok::UI::PostWidget> PostWidgetPointer;
 
-    static const QRegExp mYouTubeRegExp;
-    static const QRegExp mYouTuRegExp;
-    static const QRegExp mVimeoRegExp;
-    static const QRegExp mYouTuCode;
+    /// What the preview of a video shows, no thumbnail if the metadata could not be read
+    struct Video {
+        QString url;
+        QString title;
+        QString description;
+        QString thumbnail;
+        QDateTime fetched;
+    };
 
-    //static const QRegExp mYFrogRegExp;
+    void parse(QPointer< Choqok::UI::PostWidget > postToParse);
+    void parseUrl(const QUrl &url, QPointer< Choqok::UI::PostWidget > postToParse);
+    static bool parseYoutube(const QByteArray &data, Video *video);
+    static bool parseVimeo(const QByteArray &data, Video *video);
+    void showPreview(const QString &key, PostWidgetPointer post);
+
+    void loadCache();
+    void saveCache();
+
+    QHash<QString, Video> mVideos; // by "youtube:<id>" or "vimeo:<id>"
+    QHash<QString, QList<PostWidgetPointer> > mWaitingForMetadata; // by video
+    QMap<KJob *, QString> mJobs; // video of each metadata request
+    QMultiHash<QString, QPair<PostWidgetPointer, QString> > mWaitingForThumbnail; // post and video by thumbnail URL
+    bool mCacheChanged;
 };
 
 #endif //VIDEOPREVIEW_H